@@ -234,6 +234,7 @@ static void avconv_cleanup(int ret)
     if (vstats_file)
         fclose(vstats_file);
     av_free(vstats_filename);
+    av_free(filter_thread_type);
 
     av_freep(&input_streams);
     av_freep(&input_files);
@@ -463,6 +463,9 @@ extern int        nb_filtergraphs;
 
 extern char *vstats_filename;
 
+extern int   filter_nbthreads;
+extern char *filter_thread_type;
+
 extern float audio_drift_threshold;
 extern float dts_delta_threshold;
 
@@ -70,6 +70,9 @@ HWDevice *filter_hw_device;
 
 char *vstats_filename;
 
+int   filter_nbthreads = 0;
+char *filter_thread_type;
+
 float audio_drift_threshold = 0.1;
 float dts_delta_threshold   = 10;
 
@@ -2211,6 +2214,13 @@ static int opt_target(void *optctx, const char *opt, const char *arg)
     return 0;
 }
 
+static int opt_filter_thread_type(void *optctx, const char *opt, const char *arg)
+{
+    av_free(filter_thread_type);
+    filter_thread_type = av_strdup(arg);
+    return filter_thread_type ? 0 : AVERROR(ENOMEM);
+}
+
 static int opt_vstats_file(void *optctx, const char *opt, const char *arg)
 {
     av_free (vstats_filename);
@@ -2639,6 +2649,10 @@ const OptionDef options[] = {
         "create a complex filtergraph", "graph_description" },
     { "filter_complex_script", HAS_ARG | OPT_EXPERT,                 { .func_arg = opt_filter_complex_script },
         "read complex filtergraph description from a file", "filename" },
+    { "filter_threads", HAS_ARG | OPT_INT | OPT_EXPERT,              { &filter_nbthreads },
+        "number of threads used by each filtergraph", "count" },
+    { "filter_thread_type", HAS_ARG | OPT_EXPERT,                    { .func_arg = opt_filter_thread_type },
+        "threading types allowed in the filtergraphs", "slice|frame" },
     { "stats",          OPT_BOOL,                                    { &print_stats },
         "print progress report during encoding", },
     { "attach",         HAS_ARG | OPT_PERFILE | OPT_EXPERT |
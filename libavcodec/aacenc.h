@@ -78,6 +78,8 @@ typedef struct AACEncContext {
     struct {
         float *samples;
     } buffer;
+
+    struct AACEncContext *thread_ctx;            ///< per-thread copies used by the channel element jobs
 } AACEncContext;
 
 extern float ff_aac_pow34sf_tab[428];
@@ -867,6 +867,8 @@ typedef struct RcOverride{
 #define AV_CODEC_CAP_CHANNEL_CONF        (1 << 10)
 /**
  * Codec supports frame-level multithreading.
+ * Encoders may only set it if every frame is encoded independently of the
+ * others, each thread then runs its own instance of the encoder.
  */
 #define AV_CODEC_CAP_FRAME_THREADS       (1 << 12)
 /**
@@ -2405,14 +2407,15 @@ typedef struct AVCodecContext {
 
     /**
      * Which multithreading methods to use.
-     * Use of FF_THREAD_FRAME will increase decoding delay by one frame per thread,
-     * so clients which cannot provide future frames should not use it.
+     * Use of FF_THREAD_FRAME will increase decoding and encoding delay by one
+     * frame per thread, so clients which cannot provide future frames should
+     * not use it.
      *
      * - encoding: Set by user, otherwise the default is used.
      * - decoding: Set by user, otherwise the default is used.
      */
     int thread_type;
-#define FF_THREAD_FRAME   1 ///< Decode more than one frame at once
+#define FF_THREAD_FRAME   1 ///< Decode or encode more than one frame at once
 #define FF_THREAD_SLICE   2 ///< Decode more than one part of a single frame at once
 
     /**
@@ -27,6 +27,7 @@
 
 #include "avcodec.h"
 #include "internal.h"
+#include "thread.h"
 
 int ff_alloc_packet(AVPacket *avpkt, int size)
 {
@@ -204,6 +205,9 @@ int attribute_align_arg avcodec_encode_video2(AVCodecContext *avctx,
 {
     int ret;
     int user_packet = !!avpkt->data;
+    /* the frame threads delay the output of any encoder */
+    int threaded    = HAVE_THREADS &&
+                      avctx->active_thread_type & FF_THREAD_FRAME;
 
     *got_packet_ptr = 0;
 
@@ -212,7 +216,8 @@ int attribute_align_arg avcodec_encode_video2(AVCodecContext *avctx,
         return AVERROR(ENOSYS);
     }
 
-    if (!(avctx->codec->capabilities & AV_CODEC_CAP_DELAY) && !frame) {
+    if (!(avctx->codec->capabilities & AV_CODEC_CAP_DELAY) && !frame &&
+        !threaded) {
         av_packet_unref(avpkt);
         av_init_packet(avpkt);
         avpkt->size = 0;
@@ -224,11 +229,14 @@ int attribute_align_arg avcodec_encode_video2(AVCodecContext *avctx,
 
     av_assert0(avctx->codec->encode2);
 
-    ret = avctx->codec->encode2(avctx, avpkt, frame, got_packet_ptr);
+    if (threaded)
+        ret = ff_thread_video_encode_frame(avctx, avpkt, frame, got_packet_ptr);
+    else
+        ret = avctx->codec->encode2(avctx, avpkt, frame, got_packet_ptr);
     if (!ret) {
         if (!*got_packet_ptr)
             avpkt->size = 0;
-        else if (!(avctx->codec->capabilities & AV_CODEC_CAP_DELAY))
+        else if (!(avctx->codec->capabilities & AV_CODEC_CAP_DELAY) && !threaded)
             avpkt->pts = avpkt->dts = frame->pts;
 
         if (!user_packet && avpkt->size) {
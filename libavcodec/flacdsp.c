@@ -85,6 +85,16 @@ static void flac_lpc_32_c(int32_t *decoded, const int coeffs[32],
 
 }
 
+static uint64_t flac_sum_residual_c(const int32_t *res, int len)
+{
+    uint64_t sum = 0;
+    int i;
+
+    for (i = 0; i < len; i++)
+        sum += (2U * res[i]) ^ (res[i] >> 31);
+    return sum;
+}
+
 av_cold void ff_flacdsp_init(FLACDSPContext *c, enum AVSampleFormat fmt,
                              int bps)
 {
@@ -95,6 +105,7 @@ av_cold void ff_flacdsp_init(FLACDSPContext *c, enum AVSampleFormat fmt,
         c->lpc            = flac_lpc_16_c;
         c->lpc_encode     = flac_lpc_encode_c_16;
     }
+    c->sum_residual       = flac_sum_residual_c;
 
     switch (fmt) {
     case AV_SAMPLE_FMT_S32:
@@ -128,4 +139,6 @@ av_cold void ff_flacdsp_init(FLACDSPContext *c, enum AVSampleFormat fmt,
 
     if (ARCH_ARM)
         ff_flacdsp_init_arm(c, fmt, bps);
+    if (ARCH_X86)
+        ff_flacdsp_init_x86(c, fmt, bps);
 }
@@ -29,9 +29,15 @@ typedef struct FLACDSPContext {
                 int qlevel, int len);
     void (*lpc_encode)(int32_t *res, const int32_t *smp, int len, int order,
                        const int32_t *coefs, int shift);
+    /**
+     * Sum the residual samples folded to unsigned values, as they are
+     * Rice coded. Used to estimate the coding cost of a partition.
+     */
+    uint64_t (*sum_residual)(const int32_t *res, int len);
 } FLACDSPContext;
 
 void ff_flacdsp_init(FLACDSPContext *c, enum AVSampleFormat fmt, int bps);
 void ff_flacdsp_init_arm(FLACDSPContext *c, enum AVSampleFormat fmt, int bps);
+void ff_flacdsp_init_x86(FLACDSPContext *c, enum AVSampleFormat fmt, int bps);
 
 #endif /* AVCODEC_FLACDSP_H */
@@ -67,7 +67,6 @@ typedef struct RiceContext {
     enum CodingMode coding_mode;
     int porder;
     int params[MAX_PARTITIONS];
-    uint32_t udata[FLAC_MAX_BLOCKSIZE];
 } RiceContext;
 
 typedef struct FlacSubframe {
@@ -92,6 +91,15 @@ typedef struct FlacFrame {
     int verbatim_only;
 } FlacFrame;
 
+typedef struct FlacEncodeJob {
+    AVFrame *frame;             ///< queued input samples
+    int64_t pts;
+    int nb_samples;
+    uint8_t *buf;               ///< encoded frame
+    unsigned int buf_size;
+    int size;                   ///< size of the encoded frame or error code
+} FlacEncodeJob;
+
 typedef struct FlacEncodeContext {
     AVClass *class;
     PutBitContext pb;
@@ -118,6 +126,13 @@ typedef struct FlacEncodeContext {
 
     int flushed;
     int64_t next_pts;
+
+    struct FlacEncodeContext *thread_ctx; ///< per-thread contexts for the frame jobs
+    FlacEncodeJob *jobs;        ///< frames encoded together
+    int nb_jobs;                ///< number of frames encoded together
+    int nb_queued;              ///< number of frames waiting to be encoded
+    int nb_encoded;             ///< number of frames in the last encoded batch
+    int next_out;               ///< next frame of the batch to output
 } FlacEncodeContext;
 
 
@@ -422,14 +437,46 @@ FF_ENABLE_DEPRECATION_WARNINGS
 
     ret = ff_lpc_init(&s->lpc_ctx, avctx->frame_size,
                       s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+    if (ret < 0)
+        return ret;
 
     ff_bswapdsp_init(&s->bdsp);
     ff_flacdsp_init(&s->flac_dsp, avctx->sample_fmt,
                     avctx->bits_per_raw_sample);
 
+    /* frames are independent, with slice threading each thread encodes
+     * one of the queued frames */
+    s->nb_jobs = 1;
+    if (avctx->active_thread_type & FF_THREAD_SLICE) {
+        s->nb_jobs    = avctx->thread_count;
+        s->thread_ctx = av_malloc_array(avctx->thread_count,
+                                        sizeof(*s->thread_ctx));
+        if (!s->thread_ctx)
+            return AVERROR(ENOMEM);
+        for (i = 0; i < avctx->thread_count; i++) {
+            s->thread_ctx[i] = *s;
+            memset(&s->thread_ctx[i].lpc_ctx, 0, sizeof(s->lpc_ctx));
+        }
+        for (i = 0; i < avctx->thread_count; i++) {
+            ret = ff_lpc_init(&s->thread_ctx[i].lpc_ctx, avctx->frame_size,
+                              s->options.max_prediction_order,
+                              FF_LPC_TYPE_LEVINSON);
+            if (ret < 0)
+                return ret;
+        }
+    }
+    s->jobs = av_mallocz_array(s->nb_jobs, sizeof(*s->jobs));
+    if (!s->jobs)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < s->nb_jobs; i++) {
+        s->jobs[i].frame = av_frame_alloc();
+        if (!s->jobs[i].frame)
+            return AVERROR(ENOMEM);
+    }
+
     dprint_compression_options(s);
 
-    return ret;
+    return 0;
 }
 
 
@@ -605,22 +652,21 @@ static uint64_t calc_optimal_rice_params(RiceContext *rc, int porder,
 }
 
 
-static void calc_sums(int pmin, int pmax, uint32_t *data, int n, int pred_order,
+static void calc_sums(FLACDSPContext *dsp, int pmin, int pmax,
+                      const int32_t *data, int n, int pred_order,
                       uint64_t sums[][MAX_PARTITIONS])
 {
     int i, j;
     int parts;
-    uint32_t *res, *res_end;
+    const int32_t *res, *res_end;
 
     /* sums for highest level */
     parts   = (1 << pmax);
     res     = &data[pred_order];
     res_end = &data[n >> pmax];
     for (i = 0; i < parts; i++) {
-        uint64_t sum = 0;
-        while (res < res_end)
-            sum += *(res++);
-        sums[pmax][i] = sum;
+        sums[pmax][i] = dsp->sum_residual(res, res_end - res);
+        res      = res_end;
         res_end += n >> pmax;
     }
     /* sums for lower levels */
@@ -632,8 +678,9 @@ static void calc_sums(int pmin, int pmax, uint32_t *data, int n, int pred_order,
 }
 
 
-static uint64_t calc_rice_params(RiceContext *rc, int pmin, int pmax,
-                                 int32_t *data, int n, int pred_order)
+static uint64_t calc_rice_params(FLACDSPContext *dsp, RiceContext *rc,
+                                 int pmin, int pmax, const int32_t *data,
+                                 int n, int pred_order)
 {
     int i;
     uint64_t bits[MAX_PARTITION_ORDER+1];
@@ -647,10 +694,7 @@ static uint64_t calc_rice_params(RiceContext *rc, int pmin, int pmax,
 
     tmp_rc.coding_mode = rc->coding_mode;
 
-    for (i = 0; i < n; i++)
-        rc->udata[i] = (2 * data[i]) ^ (data[i] >> 31);
-
-    calc_sums(pmin, pmax, rc->udata, n, pred_order, sums);
+    calc_sums(dsp, pmin, pmax, data, n, pred_order, sums);
 
     opt_porder = pmin;
     bits[pmin] = UINT32_MAX;
@@ -686,7 +730,7 @@ static uint64_t find_subframe_rice_params(FlacEncodeContext *s,
     uint64_t bits = 8 + pred_order * sub->obits + 2 + sub->rc.coding_mode;
     if (sub->type == FLAC_SUBFRAME_LPC)
         bits += 4 + 5 + pred_order * s->options.lpc_coeff_precision;
-    bits += calc_rice_params(&sub->rc, pmin, pmax, sub->residual,
+    bits += calc_rice_params(&s->flac_dsp, &sub->rc, pmin, pmax, sub->residual,
                              s->frame.blocksize, pred_order);
     return bits;
 }
@@ -1174,9 +1218,9 @@ static void write_frame_footer(FlacEncodeContext *s)
 }
 
 
-static int write_frame(FlacEncodeContext *s, AVPacket *avpkt)
+static int write_frame(FlacEncodeContext *s, uint8_t *buf, int buf_size)
 {
-    init_put_bits(&s->pb, avpkt->data, avpkt->size);
+    init_put_bits(&s->pb, buf, buf_size);
     write_frame_header(s);
     write_subframes(s);
     write_frame_footer(s);
@@ -1184,10 +1228,11 @@ static int write_frame(FlacEncodeContext *s, AVPacket *avpkt)
 }
 
 
-static int update_md5_sum(FlacEncodeContext *s, const void *samples)
+static int update_md5_sum(FlacEncodeContext *s, const void *samples,
+                          int nb_samples)
 {
     const uint8_t *buf;
-    int buf_size = s->frame.blocksize * s->channels *
+    int buf_size = nb_samples * s->channels *
                    ((s->avctx->bits_per_raw_sample + 7) / 8);
 
     if (s->avctx->bits_per_raw_sample > 16 || HAVE_BIGENDIAN) {
@@ -1208,7 +1253,7 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
         const int32_t *samples0 = samples;
         uint8_t *tmp            = s->md5_buffer;
 
-        for (i = 0; i < s->frame.blocksize * s->channels; i++) {
+        for (i = 0; i < nb_samples * s->channels; i++) {
             int32_t v = samples0[i] >> 8;
             *tmp++    = (v      ) & 0xFF;
             *tmp++    = (v >>  8) & 0xFF;
@@ -1222,95 +1267,146 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
 }
 
 
-static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
-                             const AVFrame *frame, int *got_packet_ptr)
+static int encode_frame_job(AVCodecContext *avctx, void *arg,
+                            int jobnr, int threadnr)
 {
-    FlacEncodeContext *s;
-    int frame_bytes, out_bytes, ret;
+    FlacEncodeContext *s = avctx->priv_data;
+    FlacEncodeContext *t = s->thread_ctx ? &s->thread_ctx[threadnr] : s;
+    FlacEncodeJob *job   = &s->jobs[jobnr];
+    const AVFrame *frame = job->frame;
+    int max_framesize    = s->max_framesize;
+    int frame_bytes;
 
-    s = avctx->priv_data;
+    /* change max_framesize for small final frame */
+    if (frame->nb_samples < s->max_blocksize)
+        max_framesize = ff_flac_get_max_frame_size(frame->nb_samples,
+                                                   s->channels,
+                                                   avctx->bits_per_raw_sample);
 
-    /* when the last block is reached, update the header in extradata */
-    if (!frame) {
-        s->max_framesize = s->max_encoded_framesize;
-        av_md5_final(s->md5ctx, s->md5sum);
-        write_streaminfo(s, avctx->extradata);
+    /* the previous frames are all output when a batch is encoded */
+    t->frame_count = s->frame_count + jobnr;
 
-#if FF_API_SIDEDATA_ONLY_PKT
-FF_DISABLE_DEPRECATION_WARNINGS
-        if (avctx->side_data_only_packets && !s->flushed) {
-FF_ENABLE_DEPRECATION_WARNINGS
-#else
-        if (!s->flushed) {
-#endif
-            uint8_t *side_data = av_packet_new_side_data(avpkt, AV_PKT_DATA_NEW_EXTRADATA,
-                                                         avctx->extradata_size);
-            if (!side_data)
-                return AVERROR(ENOMEM);
-            memcpy(side_data, avctx->extradata, avctx->extradata_size);
+    init_frame(t, frame->nb_samples);
 
-            avpkt->pts = s->next_pts;
+    copy_samples(t, frame->data[0]);
 
-            *got_packet_ptr = 1;
-            s->flushed = 1;
-        }
+    channel_decorrelation(t);
 
-        return 0;
-    }
+    remove_wasted_bits(t);
 
-    /* change max_framesize for small final frame */
-    if (frame->nb_samples < s->frame.blocksize) {
-        s->max_framesize = ff_flac_get_max_frame_size(frame->nb_samples,
-                                                      s->channels,
-                                                      avctx->bits_per_raw_sample);
+    frame_bytes = encode_frame(t);
+
+    /* Fall back on verbatim mode if the compressed frame is larger than it
+       would be if encoded uncompressed. */
+    if (frame_bytes < 0 || frame_bytes > max_framesize) {
+        t->frame.verbatim_only = 1;
+        frame_bytes = encode_frame(t);
+        if (frame_bytes < 0) {
+            av_log(avctx, AV_LOG_ERROR, "Bad frame count\n");
+            job->size = frame_bytes;
+            return 0;
+        }
     }
 
-    init_frame(s, frame->nb_samples);
+    av_fast_malloc(&job->buf, &job->buf_size, frame_bytes);
+    if (!job->buf) {
+        job->size = AVERROR(ENOMEM);
+        return 0;
+    }
 
-    copy_samples(s, frame->data[0]);
+    job->size = write_frame(t, job->buf, frame_bytes);
+    return 0;
+}
 
-    channel_decorrelation(s);
 
-    remove_wasted_bits(s);
+static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
+                             const AVFrame *frame, int *got_packet_ptr)
+{
+    FlacEncodeContext *s;
+    FlacEncodeJob *job;
+    int i, ret;
 
-    frame_bytes = encode_frame(s);
+    s = avctx->priv_data;
 
-    /* Fall back on verbatim mode if the compressed frame is larger than it
-       would be if encoded uncompressed. */
-    if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
-        s->frame.verbatim_only = 1;
-        frame_bytes = encode_frame(s);
-        if (frame_bytes < 0) {
-            av_log(avctx, AV_LOG_ERROR, "Bad frame count\n");
-            return frame_bytes;
+    if (frame) {
+        job = &s->jobs[s->nb_queued];
+        if ((ret = av_frame_ref(job->frame, frame)) < 0)
+            return ret;
+        job->pts         = frame->pts;
+        job->nb_samples  = frame->nb_samples;
+        s->nb_queued++;
+
+        if ((ret = update_md5_sum(s, frame->data[0], frame->nb_samples)) < 0) {
+            av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
+            return ret;
         }
     }
 
-    if ((ret = ff_alloc_packet(avpkt, frame_bytes))) {
-        av_log(avctx, AV_LOG_ERROR, "Error getting output packet\n");
-        return ret;
+    /* encode the queued frames together once the previous ones are output */
+    if (s->next_out == s->nb_encoded && s->nb_queued &&
+        (s->nb_queued == s->nb_jobs || !frame)) {
+        avctx->execute2(avctx, encode_frame_job, NULL, NULL, s->nb_queued);
+        for (i = 0; i < s->nb_queued; i++)
+            av_frame_unref(s->jobs[i].frame);
+        s->nb_encoded = s->nb_queued;
+        s->nb_queued  = 0;
+        s->next_out   = 0;
     }
 
-    out_bytes = write_frame(s, avpkt);
+    if (s->next_out < s->nb_encoded) {
+        job = &s->jobs[s->next_out++];
+        if (job->size < 0)
+            return job->size;
 
-    s->frame_count++;
-    s->sample_count += frame->nb_samples;
-    if ((ret = update_md5_sum(s, frame->data[0])) < 0) {
-        av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
-        return ret;
+        if ((ret = ff_alloc_packet(avpkt, job->size))) {
+            av_log(avctx, AV_LOG_ERROR, "Error getting output packet\n");
+            return ret;
+        }
+        memcpy(avpkt->data, job->buf, job->size);
+
+        s->frame_count++;
+        s->sample_count += job->nb_samples;
+        if (job->size > s->max_encoded_framesize)
+            s->max_encoded_framesize = job->size;
+        if (job->size < s->min_framesize)
+            s->min_framesize = job->size;
+
+        avpkt->pts      = job->pts;
+        avpkt->duration = ff_samples_to_time_base(avctx, job->nb_samples);
+
+        s->next_pts = avpkt->pts + avpkt->duration;
+
+        *got_packet_ptr = 1;
+        return 0;
     }
-    if (out_bytes > s->max_encoded_framesize)
-        s->max_encoded_framesize = out_bytes;
-    if (out_bytes < s->min_framesize)
-        s->min_framesize = out_bytes;
 
-    avpkt->pts      = frame->pts;
-    avpkt->duration = ff_samples_to_time_base(avctx, frame->nb_samples);
-    avpkt->size     = out_bytes;
+    if (frame)
+        return 0;
+
+    /* when the last block is reached, update the header in extradata */
+    s->max_framesize = s->max_encoded_framesize;
+    av_md5_final(s->md5ctx, s->md5sum);
+    write_streaminfo(s, avctx->extradata);
+
+#if FF_API_SIDEDATA_ONLY_PKT
+FF_DISABLE_DEPRECATION_WARNINGS
+    if (avctx->side_data_only_packets && !s->flushed) {
+FF_ENABLE_DEPRECATION_WARNINGS
+#else
+    if (!s->flushed) {
+#endif
+        uint8_t *side_data = av_packet_new_side_data(avpkt, AV_PKT_DATA_NEW_EXTRADATA,
+                                                     avctx->extradata_size);
+        if (!side_data)
+            return AVERROR(ENOMEM);
+        memcpy(side_data, avctx->extradata, avctx->extradata_size);
+
+        avpkt->pts = s->next_pts;
 
-    s->next_pts = avpkt->pts + avpkt->duration;
+        *got_packet_ptr = 1;
+        s->flushed = 1;
+    }
 
-    *got_packet_ptr = 1;
     return 0;
 }
 
@@ -1319,9 +1415,22 @@ static av_cold int flac_encode_close(AVCodecContext *avctx)
 {
     if (avctx->priv_data) {
         FlacEncodeContext *s = avctx->priv_data;
+        int i;
         av_freep(&s->md5ctx);
         av_freep(&s->md5_buffer);
         ff_lpc_end(&s->lpc_ctx);
+        if (s->thread_ctx) {
+            for (i = 0; i < avctx->thread_count; i++)
+                ff_lpc_end(&s->thread_ctx[i].lpc_ctx);
+            av_freep(&s->thread_ctx);
+        }
+        if (s->jobs) {
+            for (i = 0; i < s->nb_jobs; i++) {
+                av_frame_free(&s->jobs[i].frame);
+                av_freep(&s->jobs[i].buf);
+            }
+            av_freep(&s->jobs);
+        }
     }
     av_freep(&avctx->extradata);
     avctx->extradata_size = 0;
@@ -1374,7 +1483,8 @@ AVCodec ff_flac_encoder = {
     .init           = flac_encode_init,
     .encode2        = flac_encode_frame,
     .close          = flac_encode_close,
-    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY,
+    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_S16,
                                                      AV_SAMPLE_FMT_S32,
                                                      AV_SAMPLE_FMT_NONE },
@@ -0,0 +1,376 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Frame multithreading support for intra-only encoders
+ *
+ * Every thread owns a complete copy of the encoder. Input frames are queued
+ * in submission order, picked up by the first idle thread and the packets
+ * are handed back to the caller in the same order, delayed by at most
+ * thread_count frames.
+ */
+
+#include "config.h"
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#elif HAVE_W32THREADS
+#include "compat/w32pthreads.h"
+#endif
+
+#include "avcodec.h"
+#include "internal.h"
+#include "pthread_internal.h"
+#include "thread.h"
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/frame.h"
+#include "libavutil/internal.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+
+typedef struct EncodeTask {
+    AVFrame  *frame;    ///< Input frame, unreferenced once encoded.
+    AVPacket *pkt;      ///< Output packet.
+    int got_packet;
+    int result;
+    int finished;
+} EncodeTask;
+
+typedef struct EncodeThread {
+    struct FrameThreadEncoderContext *parent;
+    AVCodecContext *avctx;          ///< Private encoder instance of this thread.
+    pthread_t thread;
+    int thread_init;
+} EncodeThread;
+
+/**
+ * Context stored in the client AVCodecInternal thread_ctx.
+ */
+typedef struct FrameThreadEncoderContext {
+    EncodeThread *threads;
+    int nb_threads;
+
+    /**
+     * Ring buffer of nb_threads tasks. Tasks in [finished_task, next_task)
+     * are being encoded or done, tasks in [next_task, submitted_task) wait
+     * for an idle thread.
+     */
+    EncodeTask *tasks;
+    unsigned submitted_task;
+    unsigned next_task;
+    unsigned finished_task;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t  task_cond;      ///< Signalled when a task is submitted or on exit.
+    pthread_cond_t  finished_cond;  ///< Signalled when a task is finished.
+
+    int die;
+} FrameThreadEncoderContext;
+
+static attribute_align_arg void *frame_encoder_thread(void *arg)
+{
+    EncodeThread              *t = arg;
+    FrameThreadEncoderContext *c = t->parent;
+
+    pthread_mutex_lock(&c->mutex);
+    for (;;) {
+        EncodeTask *task;
+        int ret, got_packet;
+
+        while (c->next_task == c->submitted_task && !c->die)
+            pthread_cond_wait(&c->task_cond, &c->mutex);
+        if (c->die)
+            break;
+
+        task = &c->tasks[c->next_task++ % c->nb_threads];
+        pthread_mutex_unlock(&c->mutex);
+
+FF_DISABLE_DEPRECATION_WARNINGS
+        ret = avcodec_encode_video2(t->avctx, task->pkt, task->frame,
+                                    &got_packet);
+FF_ENABLE_DEPRECATION_WARNINGS
+        av_frame_unref(task->frame);
+
+        pthread_mutex_lock(&c->mutex);
+        task->result     = ret;
+        task->got_packet = got_packet;
+        task->finished   = 1;
+        pthread_cond_broadcast(&c->finished_cond);
+    }
+    pthread_mutex_unlock(&c->mutex);
+
+    return NULL;
+}
+
+/**
+ * Set up an encoder instance for one thread, as a copy of the still
+ * unopened main context.
+ */
+static int open_thread_context(AVCodecContext *avctx, AVCodecContext **out)
+{
+    const AVCodec *codec = avctx->codec;
+    AVCodecContext *copy;
+    void *priv_data;
+    int ret;
+
+    copy = avcodec_alloc_context3(codec);
+    if (!copy)
+        return AVERROR(ENOMEM);
+
+    priv_data = copy->priv_data;
+    *copy = *avctx;
+    copy->priv_data          = priv_data;
+    copy->internal           = NULL;
+    copy->extradata          = NULL;
+    copy->extradata_size     = 0;
+    copy->coded_side_data    = NULL;
+    copy->nb_coded_side_data = 0;
+    copy->hw_frames_ctx      = NULL;
+    copy->hw_device_ctx      = NULL;
+    copy->stats_out          = NULL;
+    copy->thread_count       = 1;
+    copy->active_thread_type = 0;
+    *out = copy;
+
+    if (codec->priv_class) {
+        ret = av_opt_copy(copy->priv_data, avctx->priv_data);
+        if (ret < 0)
+            return ret;
+    } else if (codec->priv_data_size) {
+        memcpy(copy->priv_data, avctx->priv_data, codec->priv_data_size);
+    }
+
+    return avcodec_open2(copy, codec, NULL);
+}
+
+int ff_frame_thread_encoder_supported(AVCodecContext *avctx)
+{
+    int64_t context = 0;
+
+    switch (avctx->codec_id) {
+    case AV_CODEC_ID_FFV1:
+        /* the coder state is kept from a keyframe to the next */
+        if (avctx->gop_size > 1)
+            return 0;
+        break;
+    case AV_CODEC_ID_FFVHUFF:
+        /* the per-frame huffman tables are built from the previous frames */
+        av_opt_get_int(avctx->priv_data, "context", 0, &context);
+#if FF_API_PRIVATE_OPT
+FF_DISABLE_DEPRECATION_WARNINGS
+        if (avctx->context_model == 1)
+            context = 1;
+FF_ENABLE_DEPRECATION_WARNINGS
+#endif
+        if (context)
+            return 0;
+        break;
+    }
+
+    /* the first pass statistics are accumulated over all the frames */
+    if (avctx->flags & AV_CODEC_FLAG_PASS1 &&
+        (avctx->codec_id == AV_CODEC_ID_FFV1    ||
+         avctx->codec_id == AV_CODEC_ID_HUFFYUV ||
+         avctx->codec_id == AV_CODEC_ID_FFVHUFF))
+        return 0;
+
+    return 1;
+}
+
+int ff_frame_thread_encoder_init(AVCodecContext *avctx)
+{
+    FrameThreadEncoderContext *c;
+    int thread_count = avctx->thread_count;
+    int i, ret;
+
+    if (avctx->codec_type != AVMEDIA_TYPE_VIDEO) {
+        avctx->active_thread_type = 0;
+        return 0;
+    }
+
+    if (!thread_count) {
+        int nb_cpus = av_cpu_count();
+        av_log(avctx, AV_LOG_DEBUG, "detected %d logical cores\n", nb_cpus);
+        // use number of cores + 1 as thread count if there is more than one
+        if (nb_cpus > 1)
+            thread_count = avctx->thread_count = FFMIN(nb_cpus + 1, MAX_AUTO_THREADS);
+        else
+            thread_count = avctx->thread_count = 1;
+    }
+
+    if (thread_count <= 1) {
+        avctx->active_thread_type = 0;
+        return 0;
+    }
+
+    c = av_mallocz(sizeof(*c));
+    if (!c)
+        return AVERROR(ENOMEM);
+    avctx->internal->thread_ctx = c;
+
+    pthread_mutex_init(&c->mutex, NULL);
+    pthread_cond_init(&c->task_cond, NULL);
+    pthread_cond_init(&c->finished_cond, NULL);
+
+    c->threads = av_mallocz(sizeof(*c->threads) * thread_count);
+    c->tasks   = av_mallocz(sizeof(*c->tasks)   * thread_count);
+    if (!c->threads || !c->tasks) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    c->nb_threads = thread_count;
+
+    for (i = 0; i < thread_count; i++) {
+        c->tasks[i].frame = av_frame_alloc();
+        c->tasks[i].pkt   = av_packet_alloc();
+        if (!c->tasks[i].frame || !c->tasks[i].pkt) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+    }
+
+    for (i = 0; i < thread_count; i++) {
+        EncodeThread *t = &c->threads[i];
+
+        t->parent = c;
+        ret = open_thread_context(avctx, &t->avctx);
+        if (ret < 0) {
+            av_log(avctx, AV_LOG_ERROR,
+                   "Error opening the encoder for thread %d\n", i);
+            goto fail;
+        }
+
+        ret = pthread_create(&t->thread, NULL, frame_encoder_thread, t);
+        if (ret) {
+            ret = AVERROR(ret);
+            goto fail;
+        }
+        t->thread_init = 1;
+    }
+
+    return 0;
+
+fail:
+    ff_frame_thread_encoder_free(avctx);
+    avctx->active_thread_type = 0;
+    return ret;
+}
+
+void ff_frame_thread_encoder_free(AVCodecContext *avctx)
+{
+    FrameThreadEncoderContext *c = avctx->internal->thread_ctx;
+    int i;
+
+    if (!c)
+        return;
+
+    pthread_mutex_lock(&c->mutex);
+    c->die = 1;
+    pthread_cond_broadcast(&c->task_cond);
+    pthread_mutex_unlock(&c->mutex);
+
+    for (i = 0; i < c->nb_threads; i++) {
+        EncodeThread *t = &c->threads[i];
+
+        if (t->thread_init)
+            pthread_join(t->thread, NULL);
+        if (t->avctx) {
+            avcodec_close(t->avctx);
+            av_freep(&t->avctx);
+        }
+    }
+
+    if (c->tasks) {
+        for (i = 0; i < c->nb_threads; i++) {
+            av_frame_free(&c->tasks[i].frame);
+            av_packet_free(&c->tasks[i].pkt);
+        }
+    }
+    av_freep(&c->tasks);
+    av_freep(&c->threads);
+
+    pthread_cond_destroy(&c->finished_cond);
+    pthread_cond_destroy(&c->task_cond);
+    pthread_mutex_destroy(&c->mutex);
+
+    av_freep(&avctx->internal->thread_ctx);
+}
+
+int ff_thread_video_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
+                                 const AVFrame *frame, int *got_packet_ptr)
+{
+    FrameThreadEncoderContext *c = avctx->internal->thread_ctx;
+    EncodeTask *task;
+    int ret;
+
+    *got_packet_ptr = 0;
+
+    if (frame) {
+        task = &c->tasks[c->submitted_task % c->nb_threads];
+        ret  = av_frame_ref(task->frame, frame);
+        if (ret < 0)
+            return ret;
+        task->finished = 0;
+
+        pthread_mutex_lock(&c->mutex);
+        c->submitted_task++;
+        pthread_cond_signal(&c->task_cond);
+        pthread_mutex_unlock(&c->mutex);
+
+        // keep every thread busy before returning the first packet
+        if (c->submitted_task - c->finished_task < c->nb_threads)
+            return 0;
+    }
+
+    if (c->finished_task == c->submitted_task)
+        return 0;
+
+    task = &c->tasks[c->finished_task % c->nb_threads];
+    pthread_mutex_lock(&c->mutex);
+    while (!task->finished)
+        pthread_cond_wait(&c->finished_cond, &c->mutex);
+    pthread_mutex_unlock(&c->mutex);
+    c->finished_task++;
+
+    ret = task->result;
+    if (ret < 0 || !task->got_packet) {
+        av_packet_unref(task->pkt);
+        return ret;
+    }
+
+    if (pkt->data) {
+        /* user-supplied output buffer */
+        ret = ff_alloc_packet(pkt, task->pkt->size);
+        if (ret >= 0) {
+            memcpy(pkt->data, task->pkt->data, task->pkt->size);
+            ret = av_packet_copy_props(pkt, task->pkt);
+        }
+        av_packet_unref(task->pkt);
+        if (ret < 0)
+            return ret;
+    } else {
+        av_packet_move_ref(pkt, task->pkt);
+    }
+    *got_packet_ptr = 1;
+
+    return 0;
+}
@@ -72,7 +72,7 @@ static int chroma_tc(HEVCContext *s, int qp_y, int c_idx, int tc_offset)
 static int get_qPy_pred(HEVCContext *s, int xC, int yC,
                         int xBase, int yBase, int log2_cb_size)
 {
-    HEVCLocalContext *lc     = &s->HEVClc;
+    HEVCLocalContext *lc     = s->HEVClc;
     int ctb_size_mask        = (1 << s->ps.sps->log2_ctb_size) - 1;
     int MinCuQpDeltaSizeMask = (1 << (s->ps.sps->log2_ctb_size -
                                       s->ps.pps->diff_cu_qp_delta_depth)) - 1;
@@ -155,12 +155,12 @@ void ff_hevc_set_qPy(HEVCContext *s, int xC, int yC,
 {
     int qp_y = get_qPy_pred(s, xC, yC, xBase, yBase, log2_cb_size);
 
-    if (s->HEVClc.tu.cu_qp_delta != 0) {
+    if (s->HEVClc->tu.cu_qp_delta != 0) {
         int off = s->ps.sps->qp_bd_offset;
-        s->HEVClc.qp_y = FFUMOD(qp_y + s->HEVClc.tu.cu_qp_delta + 52 + 2 * off,
+        s->HEVClc->qp_y = FFUMOD(qp_y + s->HEVClc->tu.cu_qp_delta + 52 + 2 * off,
                                 52 + off) - off;
     } else
-        s->HEVClc.qp_y = qp_y;
+        s->HEVClc->qp_y = qp_y;
 }
 
 static int get_qPy(HEVCContext *s, int xC, int yC)
@@ -185,6 +185,193 @@ static void copy_CTB(uint8_t *dst, uint8_t *src,
 
 #define CTB(tab, x, y) ((tab)[(y) * s->ps.sps->ctb_width + (x)])
 
+static void copy_pixel(uint8_t *dst, const uint8_t *src, int pixel_shift)
+{
+    if (pixel_shift)
+        *(uint16_t *)dst = *(uint16_t *)src;
+    else
+        *dst = *src;
+}
+
+static void copy_vert(uint8_t *dst, const uint8_t *src, int pixel_shift,
+                      int height, ptrdiff_t stride)
+{
+    int i;
+
+    for (i = 0; i < height; i++) {
+        copy_pixel(dst, src, pixel_shift);
+        dst += stride;
+        src += stride;
+    }
+}
+
+static void copy_horiz(uint8_t *dst, const uint8_t *src, int pixel_shift,
+                       int start, int end)
+{
+    if (end > start)
+        memcpy(dst + (start << pixel_shift), src + (start << pixel_shift),
+               (end - start) << pixel_shift);
+}
+
+/**
+ * Get the area filtered for a given SAO class: the current CTB without its
+ * right and bottom margins, which are not deblocked yet (class 0), or the
+ * margins left over from the above (1), left (2) and above-left (3) CTBs.
+ * The offsets are relative to the top-left corner of the current CTB.
+ */
+static void sao_class_area(int class, int chroma, const int *borders,
+                           int *init_x, int *init_y, int *width, int *height)
+{
+    *init_x = *init_y = 0;
+
+    switch (class) {
+    case 0:
+        if (!borders[2])
+            *width  -= (8 >> chroma) + 2;
+        if (!borders[3])
+            *height -= (4 >> chroma) + 2;
+        break;
+    case 1:
+        *init_y = -(4 >> chroma) - 2;
+        if (!borders[2])
+            *width -= (8 >> chroma) + 2;
+        *height = (4 >> chroma) + 2;
+        break;
+    case 2:
+        *init_x = -(8 >> chroma) - 2;
+        *width  =  (8 >> chroma) + 2;
+        if (!borders[3])
+            *height -= (4 >> chroma) + 2;
+        break;
+    case 3:
+        *init_y = -(4 >> chroma) - 2;
+        *init_x = -(8 >> chroma) - 2;
+        *width  =  (8 >> chroma) + 2;
+        *height =  (4 >> chroma) + 2;
+        break;
+    }
+}
+
+static void sao_band_filter(HEVCContext *s, uint8_t *dst, uint8_t *src,
+                            ptrdiff_t stride, SAOParams *sao, int *borders,
+                            int width, int height, int c_idx, int class)
+{
+    int init_x, init_y;
+    ptrdiff_t offset;
+
+    sao_class_area(class, !!c_idx, borders, &init_x, &init_y, &width, &height);
+    offset = init_y * stride + (init_x << s->ps.sps->pixel_shift);
+
+    s->hevcdsp.sao_band_filter(dst + offset, src + offset, stride,
+                               sao->offset_val[c_idx],
+                               sao->band_position[c_idx], width, height);
+}
+
+static void sao_edge_filter(HEVCContext *s, uint8_t *dst, uint8_t *src,
+                            ptrdiff_t stride, SAOParams *sao, int *borders,
+                            int width, int height, int c_idx, int class,
+                            uint8_t vert_edge, uint8_t horiz_edge,
+                            uint8_t diag_edge)
+{
+    int pixel_shift  = s->ps.sps->pixel_shift;
+    int sao_eo_class = sao->eo_class[c_idx];
+    int init_x, init_y, x0 = 0, y0 = 0, save;
+    ptrdiff_t offset;
+
+    sao_class_area(class, !!c_idx, borders, &init_x, &init_y, &width, &height);
+    offset = init_y * stride + (init_x << pixel_shift);
+    dst   += offset;
+    src   += offset;
+
+    // The samples on the picture boundaries have no neighbour in the
+    // direction of the edge class; SaoOffsetVal[0] is always 0 for them.
+    if (sao_eo_class != SAO_EO_VERT && (class == 0 || class == 1)) {
+        if (borders[0]) {
+            copy_vert(dst, src, pixel_shift, height, stride);
+            x0 = 1;
+        }
+        if (borders[2]) {
+            offset = (width - 1) << pixel_shift;
+            copy_vert(dst + offset, src + offset, pixel_shift, height, stride);
+            width--;
+        }
+    }
+    if (sao_eo_class != SAO_EO_HORIZ && (class == 0 || class == 2)) {
+        if (borders[1]) {
+            copy_horiz(dst, src, pixel_shift, x0, width);
+            y0 = 1;
+        }
+        if (borders[3]) {
+            offset = (height - 1) * stride;
+            copy_horiz(dst + offset, src + offset, pixel_shift, x0, width);
+            height--;
+        }
+    }
+
+    if (width > x0 && height > y0) {
+        offset = y0 * stride + (x0 << pixel_shift);
+        s->hevcdsp.sao_edge_filter(dst + offset, src + offset, stride,
+                                   sao->offset_val[c_idx], sao_eo_class,
+                                   width - x0, height - y0);
+    }
+
+    // Restore the samples that can't be modified because their neighbours
+    // belong to a slice or tile filtered separately.
+    switch (class) {
+    case 0:
+        save = !diag_edge && sao_eo_class == SAO_EO_135D &&
+               !borders[0] && !borders[1];
+        if (vert_edge && sao_eo_class != SAO_EO_VERT) {
+            offset = (y0 + save) * stride;
+            copy_vert(dst + offset, src + offset, pixel_shift,
+                      height - y0 - save, stride);
+        }
+        if (horiz_edge && sao_eo_class != SAO_EO_HORIZ)
+            copy_horiz(dst, src, pixel_shift, x0 + save, width);
+        if (diag_edge && sao_eo_class == SAO_EO_135D)
+            copy_pixel(dst, src, pixel_shift);
+        break;
+    case 1:
+        save = !diag_edge && sao_eo_class == SAO_EO_45D && !borders[0];
+        offset = (height - 1) * stride;
+        if (vert_edge && sao_eo_class != SAO_EO_VERT)
+            copy_vert(dst, src, pixel_shift, height - save, stride);
+        if (horiz_edge && sao_eo_class != SAO_EO_HORIZ)
+            copy_horiz(dst + offset, src + offset, pixel_shift,
+                       x0 + save, width);
+        if (diag_edge && sao_eo_class == SAO_EO_45D)
+            copy_pixel(dst + offset, src + offset, pixel_shift);
+        break;
+    case 2:
+        save = !diag_edge && sao_eo_class == SAO_EO_45D && !borders[1];
+        offset = (width - 1) << pixel_shift;
+        if (vert_edge && sao_eo_class != SAO_EO_VERT)
+            copy_vert(dst + offset + (y0 + save) * stride,
+                      src + offset + (y0 + save) * stride, pixel_shift,
+                      height - y0 - save, stride);
+        if (horiz_edge && sao_eo_class != SAO_EO_HORIZ)
+            copy_horiz(dst, src, pixel_shift, 0, width - save);
+        if (diag_edge && sao_eo_class == SAO_EO_45D)
+            copy_pixel(dst + offset, src + offset, pixel_shift);
+        break;
+    case 3:
+        save = !diag_edge && sao_eo_class == SAO_EO_135D;
+        offset = (width - 1) << pixel_shift;
+        if (vert_edge && sao_eo_class != SAO_EO_VERT)
+            copy_vert(dst + offset, src + offset, pixel_shift,
+                      height - save, stride);
+        offset = (height - 1) * stride;
+        if (horiz_edge && sao_eo_class != SAO_EO_HORIZ)
+            copy_horiz(dst + offset, src + offset, pixel_shift,
+                       0, width - save);
+        if (diag_edge && sao_eo_class == SAO_EO_135D)
+            copy_pixel(dst + offset + ((width - 1) << pixel_shift),
+                       src + offset + ((width - 1) << pixel_shift),
+                       pixel_shift);
+        break;
+    }
+}
+
 static void sao_filter_CTB(HEVCContext *s, int x, int y)
 {
     //  TODO: This should be easily parallelizable
@@ -292,21 +479,17 @@ static void sao_filter_CTB(HEVCContext *s, int x, int y)
 
             switch (sao[class_index]->type_idx[c_idx]) {
             case SAO_BAND:
-                s->hevcdsp.sao_band_filter[classes[class_index]](dst, src,
-                                                                 stride,
-                                                                 sao[class_index],
-                                                                 edges, width,
-                                                                 height, c_idx);
+                sao_band_filter(s, dst, src, stride, sao[class_index],
+                                edges, width, height, c_idx,
+                                classes[class_index]);
                 break;
             case SAO_EDGE:
-                s->hevcdsp.sao_edge_filter[classes[class_index]](dst, src,
-                                                                 stride,
-                                                                 sao[class_index],
-                                                                 edges, width,
-                                                                 height, c_idx,
-                                                                 vert_edge[classes[class_index]],
-                                                                 horiz_edge[classes[class_index]],
-                                                                 diag_edge[classes[class_index]]);
+                sao_edge_filter(s, dst, src, stride, sao[class_index],
+                                edges, width, height, c_idx,
+                                classes[class_index],
+                                vert_edge[classes[class_index]],
+                                horiz_edge[classes[class_index]],
+                                diag_edge[classes[class_index]]);
                 break;
             }
         }
@@ -582,10 +765,69 @@ static int boundary_strength(HEVCContext *s, MvField *curr,
     return 1;
 }
 
+static void upper_boundary_strengths(HEVCContext *s, int x0, int y0,
+                                     int width, RefPicList *rpl_top)
+{
+    MvField *tab_mvf     = s->ref->tab_mvf;
+    int log2_min_pu_size = s->ps.sps->log2_min_pu_size;
+    int log2_min_tu_size = s->ps.sps->log2_min_tb_size;
+    int min_pu_width     = s->ps.sps->min_pu_width;
+    int min_tu_width     = s->ps.sps->min_tb_width;
+    int yp_pu = (y0 - 1) >> log2_min_pu_size;
+    int yq_pu =  y0      >> log2_min_pu_size;
+    int yp_tu = (y0 - 1) >> log2_min_tu_size;
+    int yq_tu =  y0      >> log2_min_tu_size;
+    int i, bs;
+
+    for (i = 0; i < width; i += 4) {
+        int x_pu = (x0 + i) >> log2_min_pu_size;
+        int x_tu = (x0 + i) >> log2_min_tu_size;
+        MvField *top  = &tab_mvf[yp_pu * min_pu_width + x_pu];
+        MvField *curr = &tab_mvf[yq_pu * min_pu_width + x_pu];
+        uint8_t top_cbf_luma  = s->cbf_luma[yp_tu * min_tu_width + x_tu];
+        uint8_t curr_cbf_luma = s->cbf_luma[yq_tu * min_tu_width + x_tu];
+
+        bs = boundary_strength(s, curr, curr_cbf_luma,
+                               top, top_cbf_luma, rpl_top, 1);
+        if (bs)
+            s->horizontal_bs[((x0 + i) + y0 * s->bs_width) >> 2] = bs;
+    }
+}
+
+static void left_boundary_strengths(HEVCContext *s, int x0, int y0,
+                                    int height, RefPicList *rpl_left)
+{
+    MvField *tab_mvf     = s->ref->tab_mvf;
+    int log2_min_pu_size = s->ps.sps->log2_min_pu_size;
+    int log2_min_tu_size = s->ps.sps->log2_min_tb_size;
+    int min_pu_width     = s->ps.sps->min_pu_width;
+    int min_tu_width     = s->ps.sps->min_tb_width;
+    int xp_pu = (x0 - 1) >> log2_min_pu_size;
+    int xq_pu =  x0      >> log2_min_pu_size;
+    int xp_tu = (x0 - 1) >> log2_min_tu_size;
+    int xq_tu =  x0      >> log2_min_tu_size;
+    int i, bs;
+
+    for (i = 0; i < height; i += 4) {
+        int y_pu      = (y0 + i) >> log2_min_pu_size;
+        int y_tu      = (y0 + i) >> log2_min_tu_size;
+        MvField *left = &tab_mvf[y_pu * min_pu_width + xp_pu];
+        MvField *curr = &tab_mvf[y_pu * min_pu_width + xq_pu];
+
+        uint8_t left_cbf_luma = s->cbf_luma[y_tu * min_tu_width + xp_tu];
+        uint8_t curr_cbf_luma = s->cbf_luma[y_tu * min_tu_width + xq_tu];
+
+        bs = boundary_strength(s, curr, curr_cbf_luma,
+                               left, left_cbf_luma, rpl_left, 1);
+        if (bs)
+            s->vertical_bs[(x0 >> 3) + ((y0 + i) >> 2) * s->bs_width] = bs;
+    }
+}
+
 void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                                            int log2_trafo_size)
 {
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     MvField *tab_mvf     = s->ref->tab_mvf;
     int log2_min_pu_size = s->ps.sps->log2_min_pu_size;
     int log2_min_tu_size = s->ps.sps->log2_min_tb_size;
@@ -601,7 +843,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
         ((!s->sh.slice_loop_filter_across_slices_enabled_flag &&
           lc->boundary_flags & BOUNDARY_UPPER_SLICE &&
           (y0 % (1 << s->ps.sps->log2_ctb_size)) == 0) ||
-         (!s->ps.pps->loop_filter_across_tiles_enabled_flag &&
+         ((!s->ps.pps->loop_filter_across_tiles_enabled_flag || s->defer_tile_bs) &&
           lc->boundary_flags & BOUNDARY_UPPER_TILE &&
           (y0 % (1 << s->ps.sps->log2_ctb_size)) == 0)))
         boundary_upper = 0;
@@ -611,24 +853,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                               ff_hevc_get_ref_list(s, s->ref, x0, y0 - 1) :
                               s->ref->refPicList;
 
-        int yp_pu = (y0 - 1) >> log2_min_pu_size;
-        int yq_pu =  y0      >> log2_min_pu_size;
-        int yp_tu = (y0 - 1) >> log2_min_tu_size;
-        int yq_tu =  y0      >> log2_min_tu_size;
-
-        for (i = 0; i < (1 << log2_trafo_size); i += 4) {
-            int x_pu = (x0 + i) >> log2_min_pu_size;
-            int x_tu = (x0 + i) >> log2_min_tu_size;
-            MvField *top  = &tab_mvf[yp_pu * min_pu_width + x_pu];
-            MvField *curr = &tab_mvf[yq_pu * min_pu_width + x_pu];
-            uint8_t top_cbf_luma  = s->cbf_luma[yp_tu * min_tu_width + x_tu];
-            uint8_t curr_cbf_luma = s->cbf_luma[yq_tu * min_tu_width + x_tu];
-
-            bs = boundary_strength(s, curr, curr_cbf_luma,
-                                   top, top_cbf_luma, rpl_top, 1);
-            if (bs)
-                s->horizontal_bs[((x0 + i) + y0 * s->bs_width) >> 2] = bs;
-        }
+        upper_boundary_strengths(s, x0, y0, 1 << log2_trafo_size, rpl_top);
     }
 
     // bs for TU internal horizontal PU boundaries
@@ -663,7 +888,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
         ((!s->sh.slice_loop_filter_across_slices_enabled_flag &&
           lc->boundary_flags & BOUNDARY_LEFT_SLICE &&
           (x0 % (1 << s->ps.sps->log2_ctb_size)) == 0) ||
-         (!s->ps.pps->loop_filter_across_tiles_enabled_flag &&
+         ((!s->ps.pps->loop_filter_across_tiles_enabled_flag || s->defer_tile_bs) &&
           lc->boundary_flags & BOUNDARY_LEFT_TILE &&
           (x0 % (1 << s->ps.sps->log2_ctb_size)) == 0)))
         boundary_left = 0;
@@ -673,25 +898,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                                ff_hevc_get_ref_list(s, s->ref, x0 - 1, y0) :
                                s->ref->refPicList;
 
-        int xp_pu = (x0 - 1) >> log2_min_pu_size;
-        int xq_pu =  x0      >> log2_min_pu_size;
-        int xp_tu = (x0 - 1) >> log2_min_tu_size;
-        int xq_tu =  x0      >> log2_min_tu_size;
-
-        for (i = 0; i < (1 << log2_trafo_size); i += 4) {
-            int y_pu      = (y0 + i) >> log2_min_pu_size;
-            int y_tu      = (y0 + i) >> log2_min_tu_size;
-            MvField *left = &tab_mvf[y_pu * min_pu_width + xp_pu];
-            MvField *curr = &tab_mvf[y_pu * min_pu_width + xq_pu];
-
-            uint8_t left_cbf_luma = s->cbf_luma[y_tu * min_tu_width + xp_tu];
-            uint8_t curr_cbf_luma = s->cbf_luma[y_tu * min_tu_width + xq_tu];
-
-            bs = boundary_strength(s, curr, curr_cbf_luma,
-                                   left, left_cbf_luma, rpl_left, 1);
-            if (bs)
-                s->vertical_bs[(x0 >> 3) + ((y0 + i) >> 2) * s->bs_width] = bs;
-        }
+        left_boundary_strengths(s, x0, y0, 1 << log2_trafo_size, rpl_left);
     }
 
     // bs for TU internal vertical PU boundaries
@@ -721,6 +928,44 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
     }
 }
 
+void ff_hevc_deblocking_tile_boundary_strengths(HEVCContext *s, int x_ctb,
+                                                int y_ctb)
+{
+    const HEVCSPS *sps = s->ps.sps;
+    const HEVCPPS *pps = s->ps.pps;
+    int ctb_size    = 1 << sps->log2_ctb_size;
+    int ctb_addr_rs = (y_ctb >> sps->log2_ctb_size) * sps->ctb_width +
+                      (x_ctb >> sps->log2_ctb_size);
+    int tile_id     = pps->tile_id[pps->ctb_addr_rs_to_ts[ctb_addr_rs]];
+
+    if (!pps->loop_filter_across_tiles_enabled_flag)
+        return;
+
+    if (y_ctb > 0) {
+        int up = ctb_addr_rs - sps->ctb_width;
+        int slice_edge = s->tab_slice_address[ctb_addr_rs] != s->tab_slice_address[up];
+
+        if (tile_id != pps->tile_id[pps->ctb_addr_rs_to_ts[up]] &&
+            (!slice_edge || s->sh.slice_loop_filter_across_slices_enabled_flag))
+            upper_boundary_strengths(s, x_ctb, y_ctb,
+                                     FFMIN(ctb_size, sps->width - x_ctb),
+                                     slice_edge ? ff_hevc_get_ref_list(s, s->ref, x_ctb, y_ctb - 1) :
+                                                  s->ref->refPicList);
+    }
+
+    if (x_ctb > 0) {
+        int left = ctb_addr_rs - 1;
+        int slice_edge = s->tab_slice_address[ctb_addr_rs] != s->tab_slice_address[left];
+
+        if (tile_id != pps->tile_id[pps->ctb_addr_rs_to_ts[left]] &&
+            (!slice_edge || s->sh.slice_loop_filter_across_slices_enabled_flag))
+            left_boundary_strengths(s, x_ctb, y_ctb,
+                                    FFMIN(ctb_size, sps->height - y_ctb),
+                                    slice_edge ? ff_hevc_get_ref_list(s, s->ref, x_ctb - 1, y_ctb) :
+                                                 s->ref->refPicList);
+    }
+}
+
 #undef LUMA
 #undef CB
 #undef CR
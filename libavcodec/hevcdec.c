@@ -465,7 +465,7 @@ fail:
 
 static int hls_slice_header(HEVCContext *s)
 {
-    GetBitContext *gb = &s->HEVClc.gb;
+    GetBitContext *gb = &s->HEVClc->gb;
     SliceHeader *sh   = &s->sh;
     int i, ret;
 
@@ -769,12 +769,31 @@ static int hls_slice_header(HEVCContext *s)
 
     sh->num_entry_point_offsets = 0;
     if (s->ps.pps->tiles_enabled_flag || s->ps.pps->entropy_coding_sync_enabled_flag) {
-        sh->num_entry_point_offsets = get_ue_golomb_long(gb);
+        unsigned num_entry_point_offsets = get_ue_golomb_long(gb);
+        if (num_entry_point_offsets >= s->ps.sps->ctb_width * s->ps.sps->ctb_height) {
+            av_log(s->avctx, AV_LOG_ERROR, "Invalid number of entry points: %u.\n",
+                   num_entry_point_offsets);
+            return AVERROR_INVALIDDATA;
+        }
+        sh->num_entry_point_offsets = num_entry_point_offsets;
         if (sh->num_entry_point_offsets > 0) {
             int offset_len = get_ue_golomb_long(gb) + 1;
 
+            if (offset_len > 32) {
+                av_log(s->avctx, AV_LOG_ERROR, "Invalid entry point offset length: %d.\n",
+                       offset_len);
+                return AVERROR_INVALIDDATA;
+            }
+
+            av_fast_malloc(&sh->entry_point_offset, &sh->entry_point_offset_allocated,
+                           sh->num_entry_point_offsets * sizeof(*sh->entry_point_offset));
+            if (!sh->entry_point_offset) {
+                sh->num_entry_point_offsets = 0;
+                return AVERROR(ENOMEM);
+            }
+
             for (i = 0; i < sh->num_entry_point_offsets; i++)
-                skip_bits(gb, offset_len);
+                sh->entry_point_offset[i] = get_bits_long(gb, offset_len) + 1U;
         }
     }
 
@@ -803,10 +822,10 @@ static int hls_slice_header(HEVCContext *s)
         return AVERROR_INVALIDDATA;
     }
 
-    s->HEVClc.first_qp_group = !s->sh.dependent_slice_segment_flag;
+    s->HEVClc->first_qp_group = !s->sh.dependent_slice_segment_flag;
 
     if (!s->ps.pps->cu_qp_delta_enabled_flag)
-        s->HEVClc.qp_y = FFUMOD(s->sh.slice_qp + 52 + 2 * s->ps.sps->qp_bd_offset,
+        s->HEVClc->qp_y = FFUMOD(s->sh.slice_qp + 52 + 2 * s->ps.sps->qp_bd_offset,
                                 52 + s->ps.sps->qp_bd_offset) - s->ps.sps->qp_bd_offset;
 
     s->slice_initialized = 1;
@@ -830,7 +849,7 @@ do {                                                    \
 
 static void hls_sao_param(HEVCContext *s, int rx, int ry)
 {
-    HEVCLocalContext *lc    = &s->HEVClc;
+    HEVCLocalContext *lc    = s->HEVClc;
     int sao_merge_left_flag = 0;
     int sao_merge_up_flag   = 0;
     int shift               = s->ps.sps->bit_depth - FFMIN(s->ps.sps->bit_depth, 10);
@@ -908,7 +927,7 @@ static void hls_residual_coding(HEVCContext *s, int x0, int y0,
         x_c = (scan_x_cg[offset >> 4] << 2) + scan_x_off[n];    \
         y_c = (scan_y_cg[offset >> 4] << 2) + scan_y_off[n];    \
     } while (0)
-    HEVCLocalContext *lc    = &s->HEVClc;
+    HEVCLocalContext *lc    = s->HEVClc;
     int transform_skip_flag = 0;
 
     int last_significant_coeff_x, last_significant_coeff_y;
@@ -1265,7 +1284,7 @@ static int hls_transform_unit(HEVCContext *s, int x0, int y0,
                               int log2_cb_size, int log2_trafo_size,
                               int blk_idx, int cbf_luma, int cbf_cb, int cbf_cr)
 {
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
 
     if (lc->cu.pred_mode == MODE_INTRA) {
         int trafo_size = 1 << log2_trafo_size;
@@ -1367,7 +1386,7 @@ static int hls_transform_tree(HEVCContext *s, int x0, int y0,
                               int trafo_depth, int blk_idx,
                               int cbf_cb, int cbf_cr)
 {
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     uint8_t split_transform_flag;
     int ret;
 
@@ -1461,7 +1480,7 @@ do {
 static int hls_pcm_sample(HEVCContext *s, int x0, int y0, int log2_cb_size)
 {
     //TODO: non-4:2:0 support
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     GetBitContext gb;
     int cb_size   = 1 << log2_cb_size;
     ptrdiff_t stride0 = s->frame->linesize[0];
@@ -1490,7 +1509,7 @@ static int hls_pcm_sample(HEVCContext *s, int x0, int y0, int log2_cb_size)
 
 static void hls_mvd_coding(HEVCContext *s, int x0, int y0, int log2_cb_size)
 {
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     int x = ff_hevc_abs_mvd_greater0_flag_decode(s);
     int y = ff_hevc_abs_mvd_greater0_flag_decode(s);
 
@@ -1529,7 +1548,7 @@ static void luma_mc(HEVCContext *s, int16_t *dst, ptrdiff_t dststride,
                     AVFrame *ref, const Mv *mv, int x_off, int y_off,
                     int block_w, int block_h, int pred_idx)
 {
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     uint8_t *src         = ref->data[0];
     ptrdiff_t srcstride  = ref->linesize[0];
     int pic_width        = s->ps.sps->width;
@@ -1583,7 +1602,7 @@ static void chroma_mc(HEVCContext *s, int16_t *dst1, int16_t *dst2,
                       ptrdiff_t dststride, AVFrame *ref, const Mv *mv,
                       int x_off, int y_off, int block_w, int block_h, int pred_idx)
 {
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     uint8_t *src1        = ref->data[1];
     uint8_t *src2        = ref->data[2];
     ptrdiff_t src1stride = ref->linesize[1];
@@ -1652,7 +1671,7 @@ static void hevc_luma_mv_mpv_mode(HEVCContext *s, int x0, int y0, int nPbW,
                                   int nPbH, int log2_cb_size, int part_idx,
                                   int merge_idx, MvField *mv)
 {
-    HEVCLocalContext *lc             = &s->HEVClc;
+    HEVCLocalContext *lc             = s->HEVClc;
     enum InterPredIdc inter_pred_idc = PRED_L0;
     int mvp_flag;
 
@@ -1704,7 +1723,7 @@ static void hls_prediction_unit(HEVCContext *s, int x0, int y0,
 #define POS(c_idx, x, y)                                                              \
     &s->frame->data[c_idx][((y) >> s->ps.sps->vshift[c_idx]) * s->frame->linesize[c_idx] + \
                            (((x) >> s->ps.sps->hshift[c_idx]) << s->ps.sps->pixel_shift)]
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     int merge_idx = 0;
     struct MvField current_mv = {{{ 0 }}};
 
@@ -1890,7 +1909,7 @@ static void hls_prediction_unit(HEVCContext *s, int x0, int y0,
 static int luma_intra_pred_mode(HEVCContext *s, int x0, int y0, int pu_size,
                                 int prev_intra_luma_pred_flag)
 {
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     int x_pu             = x0 >> s->ps.sps->log2_min_pu_size;
     int y_pu             = y0 >> s->ps.sps->log2_min_pu_size;
     int min_pu_width     = s->ps.sps->min_pu_width;
@@ -1991,7 +2010,7 @@ static av_always_inline void set_ct_depth(HEVCContext *s, int x0, int y0,
 static void intra_prediction_unit(HEVCContext *s, int x0, int y0,
                                   int log2_cb_size)
 {
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     static const uint8_t intra_chroma_table[4] = { 0, 26, 10, 1 };
     uint8_t prev_intra_luma_pred_flag[4];
     int split   = lc->cu.part_mode == PART_NxN;
@@ -2032,7 +2051,7 @@ static void intra_prediction_unit_default_value(HEVCContext *s,
                                                 int x0, int y0,
                                                 int log2_cb_size)
 {
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     int pb_size          = 1 << log2_cb_size;
     int size_in_pus      = pb_size >> s->ps.sps->log2_min_pu_size;
     int min_pu_width     = s->ps.sps->min_pu_width;
@@ -2053,7 +2072,7 @@ static void intra_prediction_unit_default_value(HEVCContext *s,
 static int hls_coding_unit(HEVCContext *s, int x0, int y0, int log2_cb_size)
 {
     int cb_size          = 1 << log2_cb_size;
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     int log2_min_cb_size = s->ps.sps->log2_min_cb_size;
     int length           = cb_size >> log2_min_cb_size;
     int min_cb_width     = s->ps.sps->min_cb_width;
@@ -2202,7 +2221,7 @@ static int hls_coding_unit(HEVCContext *s, int x0, int y0, int log2_cb_size)
 static int hls_coding_quadtree(HEVCContext *s, int x0, int y0,
                                int log2_cb_size, int cb_depth)
 {
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     const int cb_size    = 1 << log2_cb_size;
     int split_cu;
 
@@ -2253,7 +2272,7 @@ do {                                                                   \
 static void hls_decode_neighbour(HEVCContext *s, int x_ctb, int y_ctb,
                                  int ctb_addr_ts)
 {
-    HEVCLocalContext *lc  = &s->HEVClc;
+    HEVCLocalContext *lc  = s->HEVClc;
     int ctb_size          = 1 << s->ps.sps->log2_ctb_size;
     int ctb_addr_rs       = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
     int ctb_addr_in_slice = ctb_addr_rs - s->sh.slice_addr;
@@ -2300,34 +2319,305 @@ static void hls_decode_neighbour(HEVCContext *s, int x_ctb, int y_ctb,
     lc->ctb_up_left_flag = ((x_ctb > 0) && (y_ctb > 0)  && (ctb_addr_in_slice-1 >= s->ps.sps->ctb_width) && (s->ps.pps->tile_id[ctb_addr_ts] == s->ps.pps->tile_id[s->ps.pps->ctb_addr_rs_to_ts[ctb_addr_rs-1 - s->ps.sps->ctb_width]]));
 }
 
-static int hls_slice_data(HEVCContext *s)
+static int hls_decode_ctb(HEVCContext *s, int x_ctb, int y_ctb)
+{
+    int ctb_addr_rs = (y_ctb >> s->ps.sps->log2_ctb_size) * s->ps.sps->ctb_width +
+                      (x_ctb >> s->ps.sps->log2_ctb_size);
+    int ret;
+
+    hls_sao_param(s, x_ctb >> s->ps.sps->log2_ctb_size, y_ctb >> s->ps.sps->log2_ctb_size);
+
+    s->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
+    s->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
+    s->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
+
+    ret = hls_coding_quadtree(s, x_ctb, y_ctb, s->ps.sps->log2_ctb_size, 0);
+    if (ret < 0)
+        return ret;
+
+    return !ff_hevc_end_of_slice_flag_decode(s);
+}
+
+#if HAVE_THREADS
+/**
+ * Locate the substreams of the slice segment in the unescaped NAL unit.
+ * The entry points are given in bytes of the escaped slice data.
+ *
+ * @return 1 if the substreams are consistent with the slice segment,
+ *         0 if the slice segment has to be decoded serially
+ */
+static int hevc_init_substreams(HEVCContext *s, const H2645NAL *nal)
+{
+    const HEVCSPS *sps   = s->ps.sps;
+    const HEVCPPS *pps   = s->ps.pps;
+    GetBitContext *gb    = &s->HEVClc->gb;
+    const uint8_t *raw   = nal->raw_data;
+    int nb_substreams    = s->sh.num_entry_point_offsets + 1;
+    int size             = (gb->size_in_bits + 7) >> 3;
+    int escaped          = nal->data != nal->raw_data;
+    int raw_pos = 0, pos = 0, zeros = 0;
+    int64_t target;
+    int i, ctb_addr_ts;
+
+    av_fast_malloc(&s->substreams, &s->substreams_allocated,
+                   nb_substreams * sizeof(*s->substreams));
+    if (!s->substreams)
+        return AVERROR(ENOMEM);
+
+#define NEXT_BYTE()                                                     \
+    do {                                                                \
+        if (escaped && zeros >= 2 && raw[raw_pos] == 3) {               \
+            zeros = 0;                                                  \
+        } else {                                                        \
+            zeros = raw[raw_pos] ? 0 : zeros + 1;                       \
+            pos++;                                                      \
+        }                                                               \
+        raw_pos++;                                                      \
+    } while (0)
+
+    /* the slice data starts after the alignment bits of the header */
+    target = (get_bits_count(gb) + 8) >> 3;
+    while (pos < target && pos < size)
+        NEXT_BYTE();
+    target = raw_pos;
+
+    for (i = 0; i < nb_substreams; i++) {
+        if (i) {
+            target += s->sh.entry_point_offset[i - 1];
+            if (escaped) {
+                while (raw_pos < target && raw_pos < nal->raw_size)
+                    NEXT_BYTE();
+            } else {
+                pos = FFMIN(target, size);
+            }
+        }
+        if (pos >= size || (i && pos <= s->substreams[i - 1].data - nal->data))
+            return 0;
+        s->substreams[i].data = nal->data + pos;
+    }
+#undef NEXT_BYTE
+
+    for (i = 0; i < nb_substreams; i++) {
+        int end = i + 1 < nb_substreams ? s->substreams[i + 1].data - nal->data : size;
+        s->substreams[i].size = end - (s->substreams[i].data - nal->data);
+    }
+
+    ctb_addr_ts = pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+    s->substreams[0].ctb_addr_ts = ctb_addr_ts;
+    for (i = 1, ctb_addr_ts++; i < nb_substreams && ctb_addr_ts < sps->ctb_size; ctb_addr_ts++) {
+        if (pps->entropy_coding_sync_enabled_flag ?
+            ctb_addr_ts % sps->ctb_width == 0 :
+            pps->tile_id[ctb_addr_ts] != pps->tile_id[ctb_addr_ts - 1])
+            s->substreams[i++].ctb_addr_ts = ctb_addr_ts;
+    }
+
+    return i == nb_substreams;
+}
+
+static int hls_decode_substream(AVCodecContext *avctx, void *arg, int job,
+                                int thread)
+{
+    HEVCContext      *s0 = avctx->priv_data;
+    HEVCContext      *s  = &s0->slice_ctx[thread];
+    HEVCLocalContext *lc = s->HEVClc;
+    HEVCSubstream    *ss = &s0->substreams[job];
+    int nb_substreams = s->sh.num_entry_point_offsets + 1;
+    int wpp           = s->ps.pps->entropy_coding_sync_enabled_flag;
+    int log2_ctb_size = s->ps.sps->log2_ctb_size;
+    int ctb_size      = 1 << log2_ctb_size;
+    int end_ts        = job + 1 < nb_substreams ? ss[1].ctb_addr_ts : s->ps.sps->ctb_size;
+    int ctb_addr_ts   = ss->ctb_addr_ts;
+    int more_data     = 1;
+    int x_ctb         = 0;
+    int y_ctb         = 0;
+    int ret           = 0;
+
+    while (more_data && ctb_addr_ts < end_ts) {
+        int ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+
+        x_ctb = (ctb_addr_rs % s->ps.sps->ctb_width) << log2_ctb_size;
+        y_ctb = (ctb_addr_rs / s->ps.sps->ctb_width) << log2_ctb_size;
+        hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
+
+        /* the CTB above right must be decoded and the row above filtered
+         * up to it */
+        if (wpp && job)
+            ff_slice_thread_await_progress(avctx, job - 1, (x_ctb >> log2_ctb_size) + 2);
+        if (atomic_load(&s0->slice_thread_error))
+            break;
+
+        if (job && ctb_addr_ts == ss->ctb_addr_ts)
+            ff_hevc_cabac_init_substream(s, ss->data, ss->size);
+        else
+            ff_hevc_cabac_init(s, ctb_addr_ts);
+
+        more_data = hls_decode_ctb(s, x_ctb, y_ctb);
+        if (more_data < 0) {
+            ret = more_data;
+            break;
+        }
+
+        ctb_addr_ts++;
+        ff_hevc_save_states(s, ctb_addr_ts);
+        if (wpp) {
+            ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+            ff_slice_thread_report_progress(avctx, job, (x_ctb >> log2_ctb_size) + 1);
+        }
+    }
+
+    if (!ret && !more_data && job + 1 < nb_substreams) {
+        av_log(avctx, AV_LOG_ERROR, "Substream %d ended the slice segment.\n", job);
+        ret = AVERROR_INVALIDDATA;
+    }
+
+    if (ret < 0) {
+        atomic_store(&s0->slice_thread_error, 1);
+    } else if (wpp && x_ctb + ctb_size >= s->ps.sps->width &&
+               y_ctb + ctb_size >= s->ps.sps->height) {
+        ff_hevc_hls_filter(s, x_ctb, y_ctb);
+    }
+
+    if (wpp)
+        ff_slice_thread_report_progress(avctx, job, INT_MAX);
+
+    /* the following slice segments continue from the last substream */
+    if (job == nb_substreams - 1) {
+        memcpy(s0->HEVClc->cabac_state, lc->cabac_state, HEVC_CONTEXTS);
+        s0->HEVClc->qp_y             = lc->qp_y;
+        s0->HEVClc->start_of_tiles_x = lc->start_of_tiles_x;
+        s0->HEVClc->end_of_tiles_x   = lc->end_of_tiles_x;
+    }
+
+    ss->result = ret < 0 ? ret : ctb_addr_ts;
+
+    return 0;
+}
+
+/**
+ * Decode the substreams of a slice segment in parallel. CTB rows with
+ * WPP wait for the row above to be two CTBs ahead and run the in-loop
+ * filters as they go; tiles are independent, their edges and the in-loop
+ * filters are handled once all of them are decoded.
+ */
+static int hls_slice_data_threaded(HEVCContext *s)
+{
+    AVCodecContext *avctx = s->avctx;
+    const HEVCSPS *sps    = s->ps.sps;
+    const HEVCPPS *pps    = s->ps.pps;
+    int nb_substreams     = s->sh.num_entry_point_offsets + 1;
+    int wpp               = pps->entropy_coding_sync_enabled_flag;
+    int ctb_size          = 1 << sps->log2_ctb_size;
+    int start_ts          = s->substreams[0].ctb_addr_ts;
+    int ctb_addr_ts, end_ts, i, ret;
+
+    if (!s->slice_ctx) {
+        s->slice_ctx = av_mallocz_array(avctx->thread_count, sizeof(*s->slice_ctx));
+        s->slice_lc  = av_mallocz_array(avctx->thread_count, sizeof(*s->slice_lc));
+        if (!s->slice_ctx || !s->slice_lc) {
+            av_freep(&s->slice_ctx);
+            av_freep(&s->slice_lc);
+            return AVERROR(ENOMEM);
+        }
+        s->nb_slice_ctx = avctx->thread_count;
+    }
+
+    /* the first substream continues the state of the previous slice
+     * segment, the other ones reset it at their first CTB */
+    for (i = 0; i < s->nb_slice_ctx; i++) {
+        HEVCLocalContext *lc = &s->slice_lc[i];
+
+        memcpy(&s->slice_ctx[i], s, sizeof(*s));
+        s->slice_ctx[i].HEVClc        = lc;
+        s->slice_ctx[i].defer_tile_bs = !wpp;
+
+        lc->gb               = s->HEVClc->gb;
+        lc->first_qp_group   = s->HEVClc->first_qp_group;
+        lc->qp_y             = s->HEVClc->qp_y;
+        lc->start_of_tiles_x = s->HEVClc->start_of_tiles_x;
+        lc->end_of_tiles_x   = s->HEVClc->end_of_tiles_x;
+        memcpy(lc->cabac_state, s->HEVClc->cabac_state, HEVC_CONTEXTS);
+    }
+
+    if (!wpp) {
+        /* the neighbours in the other tiles may not be decoded yet when
+         * checking for slice boundaries */
+        end_ts = s->substreams[nb_substreams - 1].ctb_addr_ts + 1;
+        while (end_ts < sps->ctb_size && pps->tile_id[end_ts] == pps->tile_id[end_ts - 1])
+            end_ts++;
+        for (ctb_addr_ts = start_ts; ctb_addr_ts < end_ts; ctb_addr_ts++)
+            s->tab_slice_address[pps->ctb_addr_ts_to_rs[ctb_addr_ts]] = s->sh.slice_addr;
+    }
+
+    ret = ff_slice_thread_init_progress(avctx, nb_substreams);
+    if (ret < 0)
+        return ret;
+    atomic_init(&s->slice_thread_error, 0);
+
+    avctx->execute2(avctx, hls_decode_substream, NULL, NULL, nb_substreams);
+
+    for (i = 0; i < nb_substreams; i++)
+        if (s->substreams[i].result < 0)
+            return s->substreams[i].result;
+    end_ts = s->substreams[nb_substreams - 1].result;
+
+    if (!wpp) {
+        for (ctb_addr_ts = start_ts; ctb_addr_ts < end_ts; ctb_addr_ts++) {
+            int ctb_addr_rs = pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+            ff_hevc_deblocking_tile_boundary_strengths(s,
+                (ctb_addr_rs % sps->ctb_width) << sps->log2_ctb_size,
+                (ctb_addr_rs / sps->ctb_width) << sps->log2_ctb_size);
+        }
+        for (ctb_addr_ts = start_ts; ctb_addr_ts < end_ts; ctb_addr_ts++) {
+            int ctb_addr_rs = pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+            int x_ctb = (ctb_addr_rs % sps->ctb_width) << sps->log2_ctb_size;
+            int y_ctb = (ctb_addr_rs / sps->ctb_width) << sps->log2_ctb_size;
+
+            ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+            if (ctb_addr_ts == end_ts - 1 &&
+                x_ctb + ctb_size >= sps->width && y_ctb + ctb_size >= sps->height)
+                ff_hevc_hls_filter(s, x_ctb, y_ctb);
+        }
+    }
+
+    return end_ts;
+}
+#endif
+
+static int hls_slice_data(HEVCContext *s, const H2645NAL *nal)
 {
     int ctb_size    = 1 << s->ps.sps->log2_ctb_size;
     int more_data   = 1;
     int x_ctb       = 0;
     int y_ctb       = 0;
     int ctb_addr_ts = s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
-    int ret;
+
+#if HAVE_THREADS
+    if (s->avctx->active_thread_type & FF_THREAD_SLICE &&
+        s->sh.num_entry_point_offsets > 0 &&
+        !(s->ps.pps->tiles_enabled_flag &&
+          s->ps.pps->entropy_coding_sync_enabled_flag)) {
+        int ret = hevc_init_substreams(s, nal);
+        if (ret < 0)
+            return ret;
+        if (ret)
+            return hls_slice_data_threaded(s);
+        av_log(s->avctx, AV_LOG_DEBUG,
+               "Invalid entry points, decoding the slice serially.\n");
+    }
+#endif
 
     while (more_data && ctb_addr_ts < s->ps.sps->ctb_size) {
         int ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
 
-        x_ctb = (ctb_addr_rs % ((s->ps.sps->width + ctb_size - 1) >> s->ps.sps->log2_ctb_size)) << s->ps.sps->log2_ctb_size;
-        y_ctb = (ctb_addr_rs / ((s->ps.sps->width + ctb_size - 1) >> s->ps.sps->log2_ctb_size)) << s->ps.sps->log2_ctb_size;
+        x_ctb = (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        y_ctb = (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
         hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
 
         ff_hevc_cabac_init(s, ctb_addr_ts);
 
-        hls_sao_param(s, x_ctb >> s->ps.sps->log2_ctb_size, y_ctb >> s->ps.sps->log2_ctb_size);
-
-        s->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
-        s->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
-        s->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
-
-        ret = hls_coding_quadtree(s, x_ctb, y_ctb, s->ps.sps->log2_ctb_size, 0);
-        if (ret < 0)
-            return ret;
-        more_data = !ff_hevc_end_of_slice_flag_decode(s);
+        more_data = hls_decode_ctb(s, x_ctb, y_ctb);
+        if (more_data < 0)
+            return more_data;
 
         ctb_addr_ts++;
         ff_hevc_save_states(s, ctb_addr_ts);
@@ -2434,7 +2724,7 @@ static int set_side_data(HEVCContext *s)
 
 static int hevc_frame_start(HEVCContext *s)
 {
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     int ret;
 
     memset(s->horizontal_bs, 0, 2 * s->bs_width * (s->bs_height + 1));
@@ -2484,7 +2774,7 @@ fail:
 
 static int decode_nal_unit(HEVCContext *s, const H2645NAL *nal)
 {
-    HEVCLocalContext *lc = &s->HEVClc;
+    HEVCLocalContext *lc = s->HEVClc;
     GetBitContext *gb    = &lc->gb;
     int ctb_addr_ts, ret;
 
@@ -2591,7 +2881,7 @@ static int decode_nal_unit(HEVCContext *s, const H2645NAL *nal)
             if (ret < 0)
                 goto fail;
         } else {
-            ctb_addr_ts = hls_slice_data(s);
+            ctb_addr_ts = hls_slice_data(s, nal);
             if (ctb_addr_ts >= (s->ps.sps->ctb_width * s->ps.sps->ctb_height)) {
                 s->is_decoded = 1;
                 if ((s->ps.pps->transquant_bypass_enable_flag ||
@@ -2918,6 +3208,13 @@ static av_cold int hevc_decode_free(AVCodecContext *avctx)
 
     av_freep(&s->md5_ctx);
 
+    av_freep(&s->slice_ctx);
+    av_freep(&s->slice_lc);
+    av_freep(&s->substreams);
+    av_freep(&s->sh.entry_point_offset);
+    av_freep(&s->cabac_state);
+    av_freep(&s->HEVClc);
+
     av_frame_free(&s->tmp_frame);
     av_frame_free(&s->output_frame);
 
@@ -2945,6 +3242,14 @@ static av_cold int hevc_init_context(AVCodecContext *avctx)
 
     s->avctx = avctx;
 
+    s->HEVClc = av_mallocz(sizeof(*s->HEVClc));
+    if (!s->HEVClc)
+        goto fail;
+
+    s->cabac_state = av_malloc(HEVC_CONTEXTS);
+    if (!s->cabac_state)
+        goto fail;
+
     s->tmp_frame = av_frame_alloc();
     if (!s->tmp_frame)
         goto fail;
@@ -3118,7 +3423,7 @@ AVCodec ff_hevc_decoder = {
     .update_thread_context = hevc_update_thread_context,
     .init_thread_copy      = hevc_init_thread_copy,
     .capabilities          = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
-                             AV_CODEC_CAP_FRAME_THREADS,
+                             AV_CODEC_CAP_SLICE_THREADS | AV_CODEC_CAP_FRAME_THREADS,
     .profiles              = NULL_IF_CONFIG_SMALL(ff_hevc_profiles),
     .caps_internal         = FF_CODEC_CAP_EXPORTS_CROPPING | FF_CODEC_CAP_INIT_THREADSAFE,
     .hw_configs            = (const AVCodecHWConfigInternal*[]) {
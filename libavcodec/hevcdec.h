@@ -23,6 +23,7 @@
 #ifndef AVCODEC_HEVCDEC_H
 #define AVCODEC_HEVCDEC_H
 
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -281,6 +282,8 @@ typedef struct SliceHeader {
     unsigned int max_num_merge_cand; ///< 5 - 5_minus_max_num_merge_cand
 
     int num_entry_point_offsets;
+    unsigned int *entry_point_offset; ///< entry_point_offset_minus1 + 1
+    unsigned int entry_point_offset_allocated;
 
     int8_t slice_qp;
 
@@ -445,13 +448,45 @@ typedef struct HEVCLocalContext {
     int boundary_flags;
 } HEVCLocalContext;
 
+/**
+ * A substream of the slice data, i.e. a tile or a CTB row with WPP, as
+ * delimited by the entry points in the slice header.
+ */
+typedef struct HEVCSubstream {
+    const uint8_t *data;    ///< start of the substream in the unescaped NAL
+    int size;
+    int ctb_addr_ts;        ///< first CTB of the substream
+    int result;             ///< CTB reached by the decoding job or an error code
+} HEVCSubstream;
+
 typedef struct HEVCContext {
     const AVClass *c;  // needed by private avoptions
     AVCodecContext *avctx;
 
-    HEVCLocalContext HEVClc;
+    HEVCLocalContext *HEVClc;
 
-    uint8_t cabac_state[HEVC_CONTEXTS];
+    /**
+     * CABAC state saved after the second CTB of a row for WPP, shared with
+     * the slice thread contexts
+     */
+    uint8_t *cabac_state;
+
+    /**
+     * Slice threading: one copy of this context per thread, each with its
+     * own local context, refreshed before every slice decoded in parallel.
+     */
+    struct HEVCContext *slice_ctx;
+    HEVCLocalContext   *slice_lc;
+    int              nb_slice_ctx;
+    HEVCSubstream     *substreams;
+    unsigned int       substreams_allocated;
+    atomic_int         slice_thread_error;
+    /**
+     * Leave the boundary strengths of the edges between tiles to
+     * ff_hevc_deblocking_tile_boundary_strengths(), set while the tiles of a
+     * slice segment are decoded in parallel.
+     */
+    uint8_t defer_tile_bs;
 
     /** 1 if the independent slice segment header was successfully parsed */
     uint8_t slice_initialized;
@@ -564,6 +599,11 @@ int ff_hevc_slice_rpl(HEVCContext *s);
 
 void ff_hevc_save_states(HEVCContext *s, int ctb_addr_ts);
 void ff_hevc_cabac_init(HEVCContext *s, int ctb_addr_ts);
+/**
+ * Start decoding a substream other than the first one of a slice segment,
+ * i.e. a new tile or a new CTB row with WPP.
+ */
+void ff_hevc_cabac_init_substream(HEVCContext *s, const uint8_t *buf, int size);
 int ff_hevc_sao_merge_flag_decode(HEVCContext *s);
 int ff_hevc_sao_type_idx_decode(HEVCContext *s);
 int ff_hevc_sao_band_position_decode(HEVCContext *s);
@@ -644,12 +684,19 @@ void ff_hevc_set_qPy(HEVCContext *s, int xC, int yC, int xBase, int yBase,
                      int log2_cb_size);
 void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                                            int log2_trafo_size);
+/**
+ * Compute the boundary strengths of the edges of a CTB shared with another
+ * tile, skipped during the decoding when defer_tile_bs is set.
+ */
+void ff_hevc_deblocking_tile_boundary_strengths(HEVCContext *s, int x_ctb,
+                                                int y_ctb);
 int ff_hevc_cu_qp_delta_sign_flag(HEVCContext *s);
 int ff_hevc_cu_qp_delta_abs(HEVCContext *s);
 void ff_hevc_hls_filter(HEVCContext *s, int x, int y);
 void ff_hevc_hls_filters(HEVCContext *s, int x_ctb, int y_ctb, int ctb_size);
 
 void ff_hevc_pred_init(HEVCPredContext *hpc, int bit_depth);
+void ff_hevc_pred_init_x86(HEVCPredContext *hpc, int bit_depth);
 
 extern const uint8_t ff_hevc_qpel_extra_before[4];
 extern const uint8_t ff_hevc_qpel_extra_after[4];
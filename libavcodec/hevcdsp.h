@@ -33,7 +33,7 @@ typedef struct SAOParams {
 
     int eo_class[3];        ///< sao_eo_class
 
-    int offset_val[3][5];   ///<SaoOffsetVal
+    int16_t offset_val[3][5]; ///<SaoOffsetVal
 
     uint8_t type_idx[3];    ///< sao_type_idx
 } SAOParams;
@@ -49,13 +49,19 @@ typedef struct HEVCDSPContext {
     void (*idct[4])(int16_t *coeffs, int col_limit);
     void (*idct_dc[4])(int16_t *coeffs);
 
-    void (*sao_band_filter[4])(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
-                               struct SAOParams *sao, int *borders,
-                               int width, int height, int c_idx);
-    void (*sao_edge_filter[4])(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
-                               struct SAOParams *sao, int *borders, int width,
-                               int height, int c_idx, uint8_t vert_edge,
-                               uint8_t horiz_edge, uint8_t diag_edge);
+    /**
+     * Apply the SAO band offset to a width x height block.
+     */
+    void (*sao_band_filter)(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                            const int16_t *sao_offset_val, int sao_left_class,
+                            int width, int height);
+    /**
+     * Apply the SAO edge offset to a width x height block. The neighbours
+     * of the block in the direction of sao_eo_class are read from src.
+     */
+    void (*sao_edge_filter)(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                            const int16_t *sao_offset_val, int sao_eo_class,
+                            int width, int height);
 
     void (*put_hevc_qpel[2][2][8])(int16_t *dst, ptrdiff_t dststride, uint8_t *src,
                                    ptrdiff_t srcstride, int height,
@@ -20,6 +20,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
+
 #include "hevcdec.h"
 
 #define BIT_DEPTH 8
@@ -65,4 +67,7 @@ void ff_hevc_pred_init(HEVCPredContext *hpc, int bit_depth)
         HEVC_PRED(8);
         break;
     }
+
+    if (ARCH_X86)
+        ff_hevc_pred_init_x86(hpc, bit_depth);
 }
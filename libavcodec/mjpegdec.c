@@ -856,9 +856,9 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
     return 0;
 }
 
-static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
+static int mjpeg_decode_mcus(MJpegDecodeContext *s, int nb_components, int Ah,
                              int Al, const uint8_t *mb_bitmask,
-                             const AVFrame *reference)
+                             const AVFrame *reference, int mb_start, int mb_end)
 {
     int i, mb_x, mb_y;
     uint8_t *data[MAX_COMPONENTS];
@@ -866,21 +866,26 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
     int linesize[MAX_COMPONENTS];
     GetBitContext mb_bitmask_gb;
 
-    if (mb_bitmask)
+    if (mb_bitmask) {
         init_get_bits(&mb_bitmask_gb, mb_bitmask, s->mb_width * s->mb_height);
+        skip_bits_long(&mb_bitmask_gb, mb_start);
+    }
 
     for (i = 0; i < nb_components; i++) {
         int c   = s->comp_index[i];
         data[c] = s->picture_ptr->data[c];
         reference_data[c] = reference ? reference->data[c] : NULL;
         linesize[c] = s->linesize[c];
-        s->coefs_finished[c] |= 1;
     }
 
-    for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
-        for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
+    mb_x = mb_start % s->mb_width;
+    for (mb_y = mb_start / s->mb_width; mb_y < s->mb_height; mb_y++, mb_x = 0) {
+        for (; mb_x < s->mb_width; mb_x++) {
             const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
 
+            if (mb_y * s->mb_width + mb_x >= mb_end)
+                return 0;
+
             if (s->restart_interval && !s->restart_count)
                 s->restart_count = s->restart_interval;
 
@@ -969,6 +974,87 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
     return 0;
 }
 
+static int decode_restart_intervals(AVCodecContext *avctx, void *arg,
+                                    int jobnr, int threadnr)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    MJpegDecodeContext *t = &s->slice_ctx[jobnr];
+    int nb_components     = *(int *)arg;
+    int nb_intervals      = s->nb_restart_pos + 1;
+    int nb_jobs           = FFMIN(nb_intervals, 4 * avctx->thread_count);
+    int first             = nb_intervals *  jobnr      / nb_jobs;
+    int last              = nb_intervals * (jobnr + 1) / nb_jobs;
+    int start, i;
+
+    *t = *s;
+
+    start = first ? s->restart_pos[first - 1] : get_bits_count(&s->gb) >> 3;
+    init_get_bits(&t->gb, s->gb.buffer + start,
+                  s->gb.size_in_bits - start * 8);
+    for (i = 0; i < nb_components; i++)
+        t->last_dc[i] = 1024;
+    t->restart_count = 0;
+
+    t->slice_ret = mjpeg_decode_mcus(t, nb_components, 0, 0, NULL, NULL,
+                                     first * s->restart_interval,
+                                     FFMIN(last * s->restart_interval,
+                                           s->mb_width * s->mb_height));
+    return 0;
+}
+
+/**
+ * Decode the restart intervals of a sequential scan in parallel.
+ * The intervals are split in contiguous groups, each one decoded
+ * on a copy of the context starting right after a RSTn marker.
+ */
+static int mjpeg_decode_scan_slices(MJpegDecodeContext *s, int nb_components)
+{
+    AVCodecContext *avctx = s->avctx;
+    int nb_jobs = FFMIN(s->nb_restart_pos + 1, 4 * avctx->thread_count);
+    MJpegDecodeContext *last;
+    int i, ret = 0;
+
+    av_fast_malloc(&s->slice_ctx, &s->slice_ctx_size,
+                   nb_jobs * sizeof(*s->slice_ctx));
+    if (!s->slice_ctx)
+        return AVERROR(ENOMEM);
+
+    avctx->execute2(avctx, decode_restart_intervals, &nb_components,
+                    NULL, nb_jobs);
+
+    for (i = 0; i < nb_jobs; i++)
+        if (s->slice_ctx[i].slice_ret < 0)
+            ret = s->slice_ctx[i].slice_ret;
+
+    /* leave the reader at the end of the scan, as the serial decoding does */
+    last = &s->slice_ctx[nb_jobs - 1];
+    skip_bits_long(&s->gb, (last->gb.buffer - s->gb.buffer) * 8 +
+                           get_bits_count(&last->gb) - get_bits_count(&s->gb));
+
+    return ret;
+}
+
+static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
+                             int Al, const uint8_t *mb_bitmask,
+                             const AVFrame *reference)
+{
+    int i, nb_mbs = s->mb_width * s->mb_height;
+
+    for (i = 0; i < nb_components; i++)
+        s->coefs_finished[s->comp_index[i]] |= 1;
+
+    /* the restart intervals are independent as long as every RSTn marker
+     * is where it is expected */
+    if (s->avctx->active_thread_type & FF_THREAD_SLICE &&
+        !s->progressive && !mb_bitmask && s->restart_interval &&
+        s->nb_restart_pos > 0 &&
+        s->nb_restart_pos == (nb_mbs - 1) / s->restart_interval)
+        return mjpeg_decode_scan_slices(s, nb_components);
+
+    return mjpeg_decode_mcus(s, nb_components, Ah, Al, mb_bitmask, reference,
+                             0, nb_mbs);
+}
+
 static int mjpeg_decode_scan_progressive_ac(MJpegDecodeContext *s, int ss,
                                             int se, int Ah, int Al,
                                             const uint8_t *mb_bitmask,
@@ -1414,6 +1500,9 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
         const uint8_t *src = *buf_ptr;
         uint8_t *dst = s->buffer;
 
+        /* the restart markers positions allow decoding the scan in slices */
+        s->nb_restart_pos = s->avctx->active_thread_type & FF_THREAD_SLICE ? 0 : -1;
+
         while (src < buf_end) {
             uint8_t x = *(src++);
 
@@ -1423,9 +1512,20 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                     while (src < buf_end && x == 0xff)
                         x = *(src++);
 
-                    if (x >= 0xd0 && x <= 0xd7)
+                    if (x >= 0xd0 && x <= 0xd7) {
                         *(dst++) = x;
-                    else if (x)
+                        if (s->nb_restart_pos >= 0) {
+                            int *pos = av_fast_realloc(s->restart_pos,
+                                                       &s->restart_pos_size,
+                                                       (s->nb_restart_pos + 1) *
+                                                       sizeof(*pos));
+                            if (pos) {
+                                s->restart_pos = pos;
+                                pos[s->nb_restart_pos++] = dst - s->buffer;
+                            } else
+                                s->nb_restart_pos = -1;
+                        }
+                    } else if (x)
                         break;
                 }
             }
@@ -1703,6 +1803,8 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
 
     av_free(s->buffer);
     av_freep(&s->ljpeg_buffer);
+    av_freep(&s->restart_pos);
+    av_freep(&s->slice_ctx);
     s->ljpeg_buffer_size = 0;
 
     for (i = 0; i < 3; i++) {
@@ -1740,7 +1842,7 @@ AVCodec ff_mjpeg_decoder = {
     .init           = ff_mjpeg_decode_init,
     .close          = ff_mjpeg_decode_end,
     .decode         = ff_mjpeg_decode_frame,
-    .capabilities   = AV_CODEC_CAP_DR1,
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_SLICE_THREADS,
     .priv_class     = &mjpegdec_class,
     .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE,
 };
@@ -102,6 +102,13 @@ typedef struct MJpegDecodeContext {
 
     int restart_interval;
     int restart_count;
+    int *restart_pos;               ///< offsets of the data following each RSTn in the unescaped scan
+    unsigned int restart_pos_size;
+    int nb_restart_pos;             ///< number of entries in restart_pos, -1 if not tracked
+
+    struct MJpegDecodeContext *slice_ctx; ///< per-job contexts for slice threading
+    unsigned int slice_ctx_size;
+    int slice_ret;                  ///< return value of the job using this context
 
     int buggy_avid;
     int cs_itu601;
@@ -28,6 +28,7 @@
 #include "internal.h"
 #include "png.h"
 #include "pngdsp.h"
+#include "thread.h"
 
 /* TODO:
  * - add 2, 4 and 16 bit depth support
@@ -39,7 +40,8 @@ typedef struct PNGDecContext {
     PNGDSPContext dsp;
 
     GetByteContext gb;
-    AVFrame *prev;
+    ThreadFrame picture;
+    ThreadFrame last_picture;
 
     int state;
     int width, height;
@@ -412,7 +414,7 @@ static int decode_frame(AVCodecContext *avctx,
     PNGDecContext *const s = avctx->priv_data;
     const uint8_t *buf     = avpkt->data;
     int buf_size           = avpkt->size;
-    AVFrame *p             = data;
+    AVFrame *p;
     uint8_t *crow_buf_base = NULL;
     uint32_t tag, length;
     int ret;
@@ -436,6 +438,15 @@ static int decode_frame(AVCodecContext *avctx,
         return AVERROR_INVALIDDATA;
     }
 
+    /* the last decoded picture is the reference of this one */
+    if (s->picture.f->data[0]) {
+        ff_thread_release_buffer(avctx, &s->last_picture);
+        FFSWAP(ThreadFrame, s->picture, s->last_picture);
+    }
+    p = s->picture.f;
+    /* drop the side data left by a packet that failed to decode */
+    av_frame_unref(p);
+
     bytestream2_init(&s->gb, buf + 8, buf_size - 8);
     s->y = s->state = 0;
 
@@ -530,13 +541,15 @@ static int decode_frame(AVCodecContext *avctx,
                     goto fail;
                 }
 
-                if (ff_get_buffer(avctx, p, AV_GET_BUFFER_FLAG_REF) < 0) {
+                if (ff_thread_get_buffer(avctx, &s->picture,
+                                         AV_GET_BUFFER_FLAG_REF) < 0) {
                     av_log(avctx, AV_LOG_ERROR, "get_buffer() failed\n");
                     goto fail;
                 }
                 p->pict_type        = AV_PICTURE_TYPE_I;
                 p->key_frame        = 1;
                 p->interlaced_frame = !!s->interlace_type;
+                ff_thread_finish_setup(avctx);
 
                 /* compute the compressed row size */
                 if (!s->interlace_type) {
@@ -617,8 +630,14 @@ static int decode_frame(AVCodecContext *avctx,
         }
         break;
         case MKTAG('s', 'T', 'E', 'R'): {
-            int mode = bytestream2_get_byte(&s->gb);
-            AVStereo3D *stereo3d = av_stereo3d_create_side_data(p);
+            int mode;
+            AVStereo3D *stereo3d;
+
+            /* the picture may already be shared with other threads */
+            if (s->state & PNG_IDAT)
+                goto skip_tag;
+            mode     = bytestream2_get_byte(&s->gb);
+            stereo3d = av_stereo3d_create_side_data(p);
             if (!stereo3d)
                 goto the_end;
 
@@ -646,23 +665,27 @@ skip_tag:
     }
 exit_loop:
     /* handle P-frames only if a predecessor frame is available */
-    if (s->prev->data[0]) {
+    if (s->last_picture.f->data[0] &&
+        s->last_picture.f->width  == p->width  &&
+        s->last_picture.f->height == p->height &&
+        s->last_picture.f->format == p->format) {
         if (!(avpkt->flags & AV_PKT_FLAG_KEY)) {
             int i, j;
             uint8_t *pd      = p->data[0];
-            uint8_t *pd_last = s->prev->data[0];
+            uint8_t *pd_last = s->last_picture.f->data[0];
 
+            ff_thread_await_progress(&s->last_picture, INT_MAX, 0);
             for (j = 0; j < s->height; j++) {
-                for (i = 0; i < s->width * s->bpp; i++)
+                for (i = 0; i < s->row_size; i++)
                     pd[i] += pd_last[i];
                 pd      += s->image_linesize;
                 pd_last += s->image_linesize;
             }
         }
     }
+    ff_thread_report_progress(&s->picture, INT_MAX, 0);
 
-    av_frame_unref(s->prev);
-    if ((ret = av_frame_ref(s->prev, p)) < 0)
+    if ((ret = av_frame_ref(data, p)) < 0)
         goto fail;
 
     *got_frame = 1;
@@ -676,34 +699,114 @@ the_end:
     av_freep(&s->tmp_row);
     return ret;
 fail:
+    if (p->data[0]) {
+        ThreadFrame *last = &s->last_picture;
+        int have_last = last->f->data[0]            &&
+                        last->f->width  == p->width  &&
+                        last->f->height == p->height &&
+                        last->f->format == p->format;
+
+        if (avctx->active_thread_type & FF_THREAD_FRAME) {
+            /* The next thread may already hold the picture as its
+             * reference, so make it equivalent to the reference it failed
+             * to replace: a copy of it, or zeroes, which the inter-frame
+             * addition leaves unchanged, when there is none. */
+            if (have_last) {
+                ff_thread_await_progress(last, INT_MAX, 0);
+                av_image_copy_plane(p->data[0], p->linesize[0],
+                                    last->f->data[0], last->f->linesize[0],
+                                    s->row_size, s->height);
+            } else {
+                int y;
+                for (y = 0; y < s->height; y++)
+                    memset(p->data[0] + y * p->linesize[0], 0, s->row_size);
+            }
+            ff_thread_report_progress(&s->picture, INT_MAX, 0);
+        } else {
+            ff_thread_release_buffer(avctx, &s->picture);
+            /* a reference of another size cannot serve as such anymore,
+             * as with frame threads */
+            if (!have_last)
+                ff_thread_release_buffer(avctx, last);
+        }
+    }
     ret = -1;
     goto the_end;
 }
 
-static av_cold int png_dec_init(AVCodecContext *avctx)
+#if HAVE_THREADS
+static int update_thread_context(AVCodecContext *dst, const AVCodecContext *src)
 {
-    PNGDecContext *s = avctx->priv_data;
+    PNGDecContext *psrc = src->priv_data;
+    PNGDecContext *pdst = dst->priv_data;
+    ThreadFrame *ref;
+    int ret;
 
-    avctx->color_range = AVCOL_RANGE_JPEG;
+    if (dst == src)
+        return 0;
 
-    s->prev = av_frame_alloc();
-    if (!s->prev)
-        return AVERROR(ENOMEM);
+    memcpy(pdst->palette, psrc->palette, sizeof(pdst->palette));
 
-    ff_pngdsp_init(&s->dsp);
+    ff_thread_release_buffer(dst, &pdst->picture);
+    ff_thread_release_buffer(dst, &pdst->last_picture);
+    ref = psrc->picture.f->data[0] ? &psrc->picture : &psrc->last_picture;
+    if (ref->f->data[0]) {
+        ret = ff_thread_ref_frame(&pdst->picture, ref);
+        if (ret < 0)
+            return ret;
+    }
 
     return 0;
 }
+#endif
 
 static av_cold int png_dec_end(AVCodecContext *avctx)
 {
     PNGDecContext *s = avctx->priv_data;
 
-    av_frame_free(&s->prev);
+    if (s->picture.f)
+        ff_thread_release_buffer(avctx, &s->picture);
+    av_frame_free(&s->picture.f);
+    if (s->last_picture.f)
+        ff_thread_release_buffer(avctx, &s->last_picture);
+    av_frame_free(&s->last_picture.f);
+
+    return 0;
+}
+
+static av_cold int png_alloc_frames(AVCodecContext *avctx)
+{
+    PNGDecContext *s = avctx->priv_data;
+
+    s->picture.f      = av_frame_alloc();
+    s->last_picture.f = av_frame_alloc();
+    if (!s->picture.f || !s->last_picture.f) {
+        png_dec_end(avctx);
+        return AVERROR(ENOMEM);
+    }
 
     return 0;
 }
 
+static av_cold int png_dec_init(AVCodecContext *avctx)
+{
+    PNGDecContext *s = avctx->priv_data;
+
+    avctx->color_range = AVCOL_RANGE_JPEG;
+    avctx->internal->allocate_progress = 1;
+
+    ff_pngdsp_init(&s->dsp);
+
+    return png_alloc_frames(avctx);
+}
+
+#if HAVE_THREADS
+static av_cold int png_dec_init_thread_copy(AVCodecContext *avctx)
+{
+    return png_alloc_frames(avctx);
+}
+#endif
+
 AVCodec ff_png_decoder = {
     .name           = "png",
     .long_name      = NULL_IF_CONFIG_SMALL("PNG (Portable Network Graphics) image"),
@@ -713,6 +816,8 @@ AVCodec ff_png_decoder = {
     .init           = png_dec_init,
     .close          = png_dec_end,
     .decode         = decode_frame,
-    .capabilities   = AV_CODEC_CAP_DR1 /*| AV_CODEC_CAP_DRAW_HORIZ_BAND*/,
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(png_dec_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(update_thread_context),
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS /*| AV_CODEC_CAP_DRAW_HORIZ_BAND*/,
     .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE,
 };
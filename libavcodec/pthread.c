@@ -48,7 +48,9 @@ static void validate_thread_parameters(AVCodecContext *avctx)
     int frame_threading_supported = (avctx->codec->capabilities & AV_CODEC_CAP_FRAME_THREADS)
                                 && !(avctx->flags  & AV_CODEC_FLAG_TRUNCATED)
                                 && !(avctx->flags  & AV_CODEC_FLAG_LOW_DELAY)
-                                && !(avctx->flags2 & AV_CODEC_FLAG2_CHUNKS);
+                                && !(avctx->flags2 & AV_CODEC_FLAG2_CHUNKS)
+                                && (!av_codec_is_encoder(avctx->codec) ||
+                                    ff_frame_thread_encoder_supported(avctx));
     if (avctx->thread_count == 1) {
         avctx->active_thread_type = 0;
     } else if (frame_threading_supported && (avctx->thread_type & FF_THREAD_FRAME)) {
@@ -73,16 +75,22 @@ int ff_thread_init(AVCodecContext *avctx)
 
     if (avctx->active_thread_type&FF_THREAD_SLICE)
         return ff_slice_thread_init(avctx);
-    else if (avctx->active_thread_type&FF_THREAD_FRAME)
+    else if (avctx->active_thread_type&FF_THREAD_FRAME) {
+        if (av_codec_is_encoder(avctx->codec))
+            return ff_frame_thread_encoder_init(avctx);
         return ff_frame_thread_init(avctx);
+    }
 
     return 0;
 }
 
 void ff_thread_free(AVCodecContext *avctx)
 {
-    if (avctx->active_thread_type&FF_THREAD_FRAME)
-        ff_frame_thread_free(avctx, avctx->thread_count);
-    else
+    if (avctx->active_thread_type&FF_THREAD_FRAME) {
+        if (av_codec_is_encoder(avctx->codec))
+            ff_frame_thread_encoder_free(avctx);
+        else
+            ff_frame_thread_free(avctx, avctx->thread_count);
+    } else
         ff_slice_thread_free(avctx);
 }
@@ -31,4 +31,13 @@ void ff_slice_thread_free(AVCodecContext *avctx);
 int ff_frame_thread_init(AVCodecContext *avctx);
 void ff_frame_thread_free(AVCodecContext *avctx, int thread_count);
 
+int ff_frame_thread_encoder_init(AVCodecContext *avctx);
+void ff_frame_thread_encoder_free(AVCodecContext *avctx);
+
+/**
+ * Check that the encoder settings let every frame be encoded independently
+ * of the others.
+ */
+int ff_frame_thread_encoder_supported(AVCodecContext *avctx);
+
 #endif // AVCODEC_PTHREAD_INTERNAL_H
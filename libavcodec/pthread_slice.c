@@ -58,6 +58,11 @@ typedef struct SliceThreadContext {
     unsigned current_execute;
     int current_job;
     int done;
+
+    int *entries;
+    int entries_count;
+    pthread_mutex_t progress_mutex;
+    pthread_cond_t progress_cond;
 } SliceThreadContext;
 
 static void* attribute_align_arg worker(void *v)
@@ -112,6 +117,9 @@ void ff_slice_thread_free(AVCodecContext *avctx)
     pthread_mutex_destroy(&c->current_job_lock);
     pthread_cond_destroy(&c->current_job_cond);
     pthread_cond_destroy(&c->last_job_cond);
+    pthread_mutex_destroy(&c->progress_mutex);
+    pthread_cond_destroy(&c->progress_cond);
+    av_free(c->entries);
     av_free(c->workers);
     av_freep(&avctx->internal->thread_ctx);
 }
@@ -202,6 +210,8 @@ int ff_slice_thread_init(AVCodecContext *avctx)
     pthread_cond_init(&c->current_job_cond, NULL);
     pthread_cond_init(&c->last_job_cond, NULL);
     pthread_mutex_init(&c->current_job_lock, NULL);
+    pthread_mutex_init(&c->progress_mutex, NULL);
+    pthread_cond_init(&c->progress_cond, NULL);
     pthread_mutex_lock(&c->current_job_lock);
     for (i=0; i<thread_count; i++) {
         if(pthread_create(&c->workers[i], NULL, worker, avctx)) {
@@ -218,3 +228,40 @@ int ff_slice_thread_init(AVCodecContext *avctx)
     avctx->execute2 = thread_execute2;
     return 0;
 }
+
+int ff_slice_thread_init_progress(AVCodecContext *avctx, int nb_entries)
+{
+    SliceThreadContext *c = avctx->internal->thread_ctx;
+
+    if (nb_entries > c->entries_count) {
+        int *entries = av_realloc_array(c->entries, nb_entries,
+                                        sizeof(*c->entries));
+        if (!entries)
+            return AVERROR(ENOMEM);
+        c->entries       = entries;
+        c->entries_count = nb_entries;
+    }
+    memset(c->entries, 0, nb_entries * sizeof(*c->entries));
+
+    return 0;
+}
+
+void ff_slice_thread_report_progress(AVCodecContext *avctx, int entry, int n)
+{
+    SliceThreadContext *c = avctx->internal->thread_ctx;
+
+    pthread_mutex_lock(&c->progress_mutex);
+    c->entries[entry] = n;
+    pthread_cond_broadcast(&c->progress_cond);
+    pthread_mutex_unlock(&c->progress_mutex);
+}
+
+void ff_slice_thread_await_progress(AVCodecContext *avctx, int entry, int n)
+{
+    SliceThreadContext *c = avctx->internal->thread_ctx;
+
+    pthread_mutex_lock(&c->progress_mutex);
+    while (c->entries[entry] < n)
+        pthread_cond_wait(&c->progress_cond, &c->progress_mutex);
+    pthread_mutex_unlock(&c->progress_mutex);
+}
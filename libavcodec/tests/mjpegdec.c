@@ -0,0 +1,307 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Builds baseline 4:2:0 JPEG pictures with restart intervals and checks
+ * that decoding them with slice threads gives the serial output.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/frame.h"
+#include "libavutil/internal.h"
+#include "libavutil/lfg.h"
+#include "libavutil/md5.h"
+#include "libavutil/mem.h"
+
+#include "libavcodec/avcodec.h"
+#include "libavcodec/jpegtables.h"
+
+#define WIDTH    176
+#define HEIGHT   144
+#define MB_W     (WIDTH  / 16)
+#define MB_H     (HEIGHT / 16)
+#define BUF_SIZE (1 << 20)
+
+typedef struct JpegWriter {
+    uint8_t *buf;
+    int pos;
+    uint32_t bit_buf;
+    int bit_count;
+} JpegWriter;
+
+static uint8_t  dc_size[256], ac_size[256];
+static uint16_t dc_code[256], ac_code[256];
+
+static void put_byte(JpegWriter *w, int val)
+{
+    w->buf[w->pos++] = val;
+}
+
+static void put_be16(JpegWriter *w, int val)
+{
+    put_byte(w, val >> 8);
+    put_byte(w, val & 0xFF);
+}
+
+/* Entropy coded data, with an escape after each 0xFF byte. */
+static void put_code(JpegWriter *w, int size, unsigned code)
+{
+    w->bit_buf    = w->bit_buf << size | (code & ((1U << size) - 1));
+    w->bit_count += size;
+    while (w->bit_count >= 8) {
+        int byte = (w->bit_buf >> (w->bit_count - 8)) & 0xFF;
+        put_byte(w, byte);
+        if (byte == 0xFF)
+            put_byte(w, 0);
+        w->bit_count -= 8;
+    }
+}
+
+/* Pad the entropy coded data to a byte boundary with 1 bits. */
+static void align_code(JpegWriter *w)
+{
+    if (w->bit_count)
+        put_code(w, 8 - w->bit_count, 0xFF);
+}
+
+static void put_value(JpegWriter *w, const uint8_t *sizes,
+                      const uint16_t *codes, int run, int val)
+{
+    int size = val ? av_log2(FFABS(val)) + 1 : 0;
+
+    put_code(w, sizes[run << 4 | size], codes[run << 4 | size]);
+    if (size)
+        put_code(w, size, val < 0 ? val - 1 : val);
+}
+
+/* A block with a random DC level and a few random AC coefficients. */
+static void put_block(JpegWriter *w, AVLFG *lfg, int *last_dc)
+{
+    int i, run = 0, dc = (int)(av_lfg_get(lfg) % 121) - 60;
+
+    put_value(w, dc_size, dc_code, 0, dc - *last_dc);
+    *last_dc = dc;
+
+    for (i = 1; i < 64; i++) {
+        int val = av_lfg_get(lfg) % 8 ? 0 : (int)(av_lfg_get(lfg) % 63) - 31;
+        if (!val) {
+            run++;
+            continue;
+        }
+        for (; run > 15; run -= 16)
+            put_value(w, ac_size, ac_code, 15, 0);
+        put_value(w, ac_size, ac_code, run, val);
+        run = 0;
+    }
+    if (run)
+        put_value(w, ac_size, ac_code, 0, 0);
+}
+
+/* Write a picture with an RSTn marker after every restart_interval
+ * macroblocks, except for the one at skip_rst. */
+static int write_jpeg(uint8_t *buf, int restart_interval, int skip_rst)
+{
+    JpegWriter w = { buf };
+    AVLFG lfg;
+    int last_dc[3] = { 0 };
+    int i, j, mb, rst = 0;
+
+    av_lfg_init(&lfg, restart_interval);
+
+    put_be16(&w, 0xFFD8);
+
+    put_be16(&w, 0xFFDB);
+    put_be16(&w, 67);
+    put_byte(&w, 0);
+    for (i = 0; i < 64; i++)
+        put_byte(&w, 8);
+
+    put_be16(&w, 0xFFC0);
+    put_be16(&w, 17);
+    put_byte(&w, 8);
+    put_be16(&w, HEIGHT);
+    put_be16(&w, WIDTH);
+    put_byte(&w, 3);
+    for (i = 0; i < 3; i++) {
+        put_byte(&w, i + 1);
+        put_byte(&w, i ? 0x11 : 0x22);
+        put_byte(&w, 0);
+    }
+
+    put_be16(&w, 0xFFDD);
+    put_be16(&w, 4);
+    put_be16(&w, restart_interval);
+
+    put_be16(&w, 0xFFDA);
+    put_be16(&w, 12);
+    put_byte(&w, 3);
+    for (i = 0; i < 3; i++) {
+        put_byte(&w, i + 1);
+        put_byte(&w, 0);
+    }
+    put_byte(&w, 0);
+    put_byte(&w, 63);
+    put_byte(&w, 0);
+
+    for (mb = 0; mb < MB_W * MB_H; mb++) {
+        if (mb && !(mb % restart_interval)) {
+            align_code(&w);
+            if (rst != skip_rst) {
+                put_byte(&w, 0xFF);
+                put_byte(&w, 0xD0 + (rst & 7));
+            }
+            rst++;
+            memset(last_dc, 0, sizeof(last_dc));
+        }
+        for (i = 0; i < 3; i++)
+            for (j = 0; j < (i ? 1 : 4); j++)
+                put_block(&w, &lfg, &last_dc[i]);
+    }
+    align_code(&w);
+
+    put_be16(&w, 0xFFD9);
+    return w.pos;
+}
+
+static int decode(uint8_t *buf, int size, int threads, AVFrame *frame)
+{
+    AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_MJPEG);
+    AVCodecContext *avctx = avcodec_alloc_context3(codec);
+    AVPacket pkt;
+    int ret;
+
+    if (!avctx)
+        return AVERROR(ENOMEM);
+    avctx->thread_count = threads;
+    avctx->thread_type  = FF_THREAD_SLICE;
+
+    av_init_packet(&pkt);
+    pkt.data = buf;
+    pkt.size = size;
+
+    if ((ret = avcodec_open2(avctx, codec, NULL)) >= 0 &&
+        (ret = avcodec_send_packet(avctx, &pkt)) >= 0)
+        ret = avcodec_receive_frame(avctx, frame);
+
+    avcodec_free_context(&avctx);
+    return ret;
+}
+
+static int compare_frames(const AVFrame *a, const AVFrame *b)
+{
+    int i, y;
+
+    for (i = 0; i < 3; i++) {
+        int w = i ? WIDTH  / 2 : WIDTH;
+        int h = i ? HEIGHT / 2 : HEIGHT;
+        for (y = 0; y < h; y++)
+            if (memcmp(a->data[i] + y * a->linesize[i],
+                       b->data[i] + y * b->linesize[i], w))
+                return 1;
+    }
+    return 0;
+}
+
+static void print_md5(const AVFrame *frame)
+{
+    struct AVMD5 *md5 = av_md5_alloc();
+    uint8_t sum[16];
+    int i, y;
+
+    if (!md5)
+        return;
+    av_md5_init(md5);
+    for (i = 0; i < 3; i++)
+        for (y = 0; y < (i ? HEIGHT / 2 : HEIGHT); y++)
+            av_md5_update(md5, frame->data[i] + y * frame->linesize[i],
+                          i ? WIDTH / 2 : WIDTH);
+    av_md5_final(md5, sum);
+    for (i = 0; i < 16; i++)
+        printf("%02x", sum[i]);
+    av_free(md5);
+}
+
+static int test(uint8_t *buf, int restart_interval, int skip_rst)
+{
+    static const int threads[] = { 2, 3, 4, 8 };
+    AVFrame *ref = av_frame_alloc(), *frame = av_frame_alloc();
+    int i, size, ret = 0;
+
+    if (!ref || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    size = write_jpeg(buf, restart_interval, skip_rst);
+    if ((ret = decode(buf, size, 1, ref)) < 0) {
+        printf("restart interval %d: decoding failed\n", restart_interval);
+        goto end;
+    }
+    printf("restart interval %d%s: ", restart_interval,
+           skip_rst >= 0 ? ", missing RSTn" : "");
+    print_md5(ref);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(threads); i++) {
+        av_frame_unref(frame);
+        if ((ret = decode(buf, size, threads[i], frame)) < 0 ||
+            compare_frames(ref, frame)) {
+            printf(", %d threads mismatch\n", threads[i]);
+            ret = -1;
+            goto end;
+        }
+    }
+    printf(", threaded decoding matches\n");
+
+end:
+    av_frame_free(&ref);
+    av_frame_free(&frame);
+    return ret;
+}
+
+int main(void)
+{
+    uint8_t *buf = av_malloc(BUF_SIZE);
+    int ret = 0;
+
+    if (!buf)
+        return 1;
+
+    avcodec_register_all();
+    av_log_set_level(AV_LOG_QUIET);
+
+    ff_mjpeg_build_huffman_codes(dc_size, dc_code,
+                                 avpriv_mjpeg_bits_dc_luminance,
+                                 avpriv_mjpeg_val_dc);
+    ff_mjpeg_build_huffman_codes(ac_size, ac_code,
+                                 avpriv_mjpeg_bits_ac_luminance,
+                                 avpriv_mjpeg_val_ac_luminance);
+
+    /* one interval per macroblock, intervals that do not end on a row, one
+     * per row and a stream that must fall back to the serial decoder */
+    if (test(buf, 1, -1) < 0 ||
+        test(buf, 5, -1) < 0 ||
+        test(buf, MB_W, -1) < 0 ||
+        test(buf, 5, 7) < 0)
+        ret = 1;
+
+    av_free(buf);
+    return ret;
+}
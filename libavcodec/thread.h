@@ -60,6 +60,17 @@ void ff_thread_flush(AVCodecContext *avctx);
 int ff_thread_decode_frame(AVCodecContext *avctx, AVFrame *picture,
                            int *got_picture_ptr, AVPacket *avpkt);
 
+/**
+ * Submit a new frame to a frame-threaded encoder.
+ * Returns the next available packet in submission order, *got_packet_ptr
+ * will be 0 if none is available yet. Passing a NULL frame drains the
+ * remaining packets.
+ *
+ * Parameters are the same as avcodec_encode_video2().
+ */
+int ff_thread_video_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
+                                 const AVFrame *frame, int *got_packet_ptr);
+
 /**
  * If the codec defines update_thread_context(), call this
  * when they are ready for the next thread to start decoding
@@ -121,6 +132,30 @@ void ff_thread_release_buffer(AVCodecContext *avctx, ThreadFrame *f);
 
 int ff_thread_ref_frame(ThreadFrame *dst, ThreadFrame *src);
 
+/**
+ * Allocate nb_entries progress counters for the jobs of the next
+ * execute2() call and reset them to 0. Only valid with slice threading
+ * active.
+ *
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int ff_slice_thread_init_progress(AVCodecContext *avctx, int nb_entries);
+
+/**
+ * Set the progress of a job, in arbitrary increasing units, and wake up the
+ * jobs waiting for it.
+ *
+ * @param entry index of the progress counter, usually the job number
+ */
+void ff_slice_thread_report_progress(AVCodecContext *avctx, int entry, int n);
+
+/**
+ * Wait until the progress of entry reaches at least n.
+ * A job must only wait for jobs with a lower number, which are always
+ * started before it.
+ */
+void ff_slice_thread_await_progress(AVCodecContext *avctx, int entry, int n);
+
 int ff_thread_init(AVCodecContext *s);
 void ff_thread_free(AVCodecContext *s);
 
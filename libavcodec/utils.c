@@ -340,9 +340,35 @@ int avcodec_default_execute2(AVCodecContext *c, int (*func)(AVCodecContext *c2,
     return 0;
 }
 
+static int lock_avcodec(const AVCodec *codec)
+{
+    if (!(codec->caps_internal & FF_CODEC_CAP_INIT_THREADSAFE) && codec->init) {
+        if (lockmgr_cb) {
+            if ((*lockmgr_cb)(&codec_mutex, AV_LOCK_OBTAIN))
+                return -1;
+        }
+
+        entangled_thread_counter++;
+    }
+
+    return 0;
+}
+
+static void unlock_avcodec(const AVCodec *codec)
+{
+    if (!(codec->caps_internal & FF_CODEC_CAP_INIT_THREADSAFE) && codec->init) {
+        entangled_thread_counter--;
+
+        /* Release any user-supplied mutex. */
+        if (lockmgr_cb) {
+            (*lockmgr_cb)(&codec_mutex, AV_LOCK_RELEASE);
+        }
+    }
+}
+
 int attribute_align_arg avcodec_open2(AVCodecContext *avctx, const AVCodec *codec, AVDictionary **options)
 {
-    int ret = 0;
+    int ret = 0, codec_locked = 1;
     AVDictionary *tmp = NULL;
 
     if (avcodec_is_open(avctx))
@@ -367,13 +393,9 @@ int attribute_align_arg avcodec_open2(AVCodecContext *avctx, const AVCodec *code
         av_dict_copy(&tmp, *options, 0);
 
     /* If there is a user-supplied mutex locking routine, call it. */
+    if (lock_avcodec(codec) < 0)
+        return -1;
     if (!(codec->caps_internal & FF_CODEC_CAP_INIT_THREADSAFE) && codec->init) {
-        if (lockmgr_cb) {
-            if ((*lockmgr_cb)(&codec_mutex, AV_LOCK_OBTAIN))
-                return -1;
-        }
-
-        entangled_thread_counter++;
         if (entangled_thread_counter != 1) {
             av_log(avctx, AV_LOG_ERROR,
                    "Insufficient thread locking. At least %d threads are "
@@ -519,7 +541,21 @@ int attribute_align_arg avcodec_open2(AVCodecContext *avctx, const AVCodec *code
     }
 
     if (HAVE_THREADS) {
-        ret = ff_thread_init(avctx);
+        /* frame-threaded encoders open one instance of the codec per thread,
+         * so the codec lock must be released meanwhile */
+        if (av_codec_is_encoder(codec) &&
+            codec->capabilities & AV_CODEC_CAP_FRAME_THREADS) {
+            unlock_avcodec(codec);
+            ret = ff_thread_init(avctx);
+            if (lock_avcodec(codec) < 0) {
+                if (ret >= 0)
+                    ff_thread_free(avctx);
+                codec_locked = 0;
+                ret          = -1;
+            }
+        } else {
+            ret = ff_thread_init(avctx);
+        }
         if (ret < 0) {
             goto free_and_end;
         }
@@ -646,7 +682,8 @@ FF_ENABLE_DEPRECATION_WARNINGS
         }
     }
 
-    if (avctx->codec->init && !(avctx->active_thread_type & FF_THREAD_FRAME)) {
+    if (avctx->codec->init && (!(avctx->active_thread_type & FF_THREAD_FRAME) ||
+                               av_codec_is_encoder(avctx->codec))) {
         ret = avctx->codec->init(avctx);
         if (ret < 0) {
             goto free_and_end;
@@ -672,14 +709,8 @@ FF_ENABLE_DEPRECATION_WARNINGS
         }
     }
 end:
-    if (!(codec->caps_internal & FF_CODEC_CAP_INIT_THREADSAFE) && codec->init) {
-        entangled_thread_counter--;
-
-        /* Release any user-supplied mutex. */
-        if (lockmgr_cb) {
-            (*lockmgr_cb)(&codec_mutex, AV_LOCK_RELEASE);
-        }
-    }
+    if (codec_locked)
+        unlock_avcodec(codec);
 
     if (options) {
         av_dict_free(options);
@@ -1468,6 +1499,19 @@ void ff_thread_await_progress(ThreadFrame *f, int progress, int field)
 {
 }
 
+int ff_slice_thread_init_progress(AVCodecContext *avctx, int nb_entries)
+{
+    return 0;
+}
+
+void ff_slice_thread_report_progress(AVCodecContext *avctx, int entry, int n)
+{
+}
+
+void ff_slice_thread_await_progress(AVCodecContext *avctx, int entry, int n)
+{
+}
+
 #endif
 
 int avcodec_is_open(AVCodecContext *s)
@@ -83,6 +83,10 @@ typedef struct UtvideoContext {
     ptrdiff_t slice_stride;
     uint8_t *slice_bits, *slice_buffer[4];
     int      slice_bits_size;
+
+    uint64_t (*slice_counts)[256];  ///< encoder: usage of values per slice
+    uint32_t *slice_offsets;        ///< encoder: end offsets of the slices
+    uint8_t  *residuals;            ///< encoder: predicted plane
 } UtvideoContext;
 
 typedef struct HuffEntry {
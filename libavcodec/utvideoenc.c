@@ -38,6 +38,21 @@
 #include "utvideo.h"
 #include "huffman.h"
 
+/*
+ * Gap left between the residuals of two slices, as the median prediction
+ * may write a few bytes past the end of a row.
+ */
+#define SLICE_GAP 16
+
+/* Plane being encoded, shared by the slice jobs */
+typedef struct PlaneContext {
+    uint8_t  *src, *dst;
+    ptrdiff_t stride;
+    int       width, height;
+    uint8_t  *out;              ///< start of the coded slices in the packet
+    HuffEntry he[256];
+} PlaneContext;
+
 /* Compare huffentry symbols */
 static int huff_cmp_sym(const void *a, const void *b)
 {
@@ -50,7 +65,9 @@ static av_cold int utvideo_encode_close(AVCodecContext *avctx)
     UtvideoContext *c = avctx->priv_data;
     int i;
 
-    av_freep(&c->slice_bits);
+    av_freep(&c->slice_counts);
+    av_freep(&c->slice_offsets);
+    av_freep(&c->residuals);
     for (i = 0; i < 4; i++)
         av_freep(&c->slice_buffer[i]);
 
@@ -215,6 +232,17 @@ FF_ENABLE_DEPRECATION_WARNINGS
         c->slices = avctx->slices;
     }
 
+    c->slice_counts  = av_malloc_array(c->slices, sizeof(*c->slice_counts));
+    c->slice_offsets = av_malloc_array(c->slices, sizeof(*c->slice_offsets));
+    c->residuals     = av_malloc(avctx->width * avctx->height +
+                                 c->slices * SLICE_GAP +
+                                 AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!c->slice_counts || !c->slice_offsets || !c->residuals) {
+        av_log(avctx, AV_LOG_ERROR, "Cannot allocate slice tables.\n");
+        utvideo_encode_close(avctx);
+        return AVERROR(ENOMEM);
+    }
+
     /* Set compression mode */
     c->compression = COMP_HUFF;
 
@@ -387,46 +415,74 @@ static int write_huff_codes(uint8_t *src, uint8_t *dst, int dst_size,
     return count;
 }
 
+/* Predict a slice of the plane and count the usage of values in it */
+static int predict_slice(AVCodecContext *avctx, void *arg, int slice,
+                         int threadnr)
+{
+    UtvideoContext *c = avctx->priv_data;
+    PlaneContext   *p = arg;
+    int sstart = p->height *  slice      / c->slices;
+    int send   = p->height * (slice + 1) / c->slices;
+    uint8_t *src = p->src + sstart * p->stride;
+    uint8_t *dst = p->dst + sstart * p->width + slice * SLICE_GAP;
+
+    switch (c->frame_pred) {
+    case PRED_NONE:
+        av_image_copy_plane(dst, p->width, src, p->stride,
+                            p->width, send - sstart);
+        break;
+    case PRED_LEFT:
+        left_predict(src, dst, p->stride, p->width, send - sstart);
+        break;
+    case PRED_MEDIAN:
+        median_predict(c, src, dst, p->stride, p->width, send - sstart);
+        break;
+    }
+
+    memset(c->slice_counts[slice], 0, sizeof(c->slice_counts[slice]));
+    count_usage(dst, p->width, send - sstart, c->slice_counts[slice]);
+
+    return 0;
+}
+
+/* Write the huffman codes of a slice at its offset in the packet */
+static int write_slice(AVCodecContext *avctx, void *arg, int slice,
+                       int threadnr)
+{
+    UtvideoContext *c = avctx->priv_data;
+    PlaneContext   *p = arg;
+    int sstart = p->height *  slice      / c->slices;
+    int send   = p->height * (slice + 1) / c->slices;
+    uint32_t start = slice ? c->slice_offsets[slice - 1] : 0;
+    uint32_t size  = c->slice_offsets[slice] - start;
+
+    write_huff_codes(p->dst + sstart * p->width + slice * SLICE_GAP,
+                     p->out + start, size, p->width, send - sstart, p->he);
+
+    /* Byteswap the written huffman codes */
+    c->bdsp.bswap_buf((uint32_t *) (p->out + start),
+                      (uint32_t *) (p->out + start), size >> 2);
+
+    return 0;
+}
+
 static int encode_plane(AVCodecContext *avctx, uint8_t *src,
                         uint8_t *dst, ptrdiff_t stride,
                         int width, int height, PutByteContext *pb)
 {
     UtvideoContext *c        = avctx->priv_data;
+    PlaneContext    p        = { src, dst, stride, width, height };
     uint8_t  lengths[256];
     uint64_t counts[256]     = { 0 };
 
-    HuffEntry he[256];
-
-    uint32_t offset = 0, slice_len = 0;
-    int      i, sstart, send = 0;
+    uint32_t offset = 0;
+    int      i, j;
     int      symbol;
 
-    /* Do prediction / make planes */
     switch (c->frame_pred) {
     case PRED_NONE:
-        for (i = 0; i < c->slices; i++) {
-            sstart = send;
-            send   = height * (i + 1) / c->slices;
-            av_image_copy_plane(dst + sstart * width, width,
-                                src + sstart * stride, stride,
-                                width, send - sstart);
-        }
-        break;
     case PRED_LEFT:
-        for (i = 0; i < c->slices; i++) {
-            sstart = send;
-            send   = height * (i + 1) / c->slices;
-            left_predict(src + sstart * stride, dst + sstart * width,
-                         stride, width, send - sstart);
-        }
-        break;
     case PRED_MEDIAN:
-        for (i = 0; i < c->slices; i++) {
-            sstart = send;
-            send   = height * (i + 1) / c->slices;
-            median_predict(c, src + sstart * stride, dst + sstart * width,
-                           stride, width, send - sstart);
-        }
         break;
     default:
         av_log(avctx, AV_LOG_ERROR, "Unknown prediction mode: %d\n",
@@ -434,8 +490,12 @@ static int encode_plane(AVCodecContext *avctx, uint8_t *src,
         return AVERROR_OPTION_NOT_FOUND;
     }
 
-    /* Count the usage of values */
-    count_usage(dst, width, height, counts);
+    /* Do prediction / make planes and count the usage of values */
+    avctx->execute2(avctx, predict_slice, &p, NULL, c->slices);
+
+    for (i = 0; i < c->slices; i++)
+        for (j = 0; j < 256; j++)
+            counts[j] += c->slice_counts[i][j];
 
     /* Check for a special case where only one symbol was used */
     for (symbol = 0; symbol < 256; symbol++) {
@@ -476,52 +536,43 @@ static int encode_plane(AVCodecContext *avctx, uint8_t *src,
     for (i = 0; i < 256; i++) {
         bytestream2_put_byte(pb, lengths[i]);
 
-        he[i].len = lengths[i];
-        he[i].sym = i;
+        p.he[i].len = lengths[i];
+        p.he[i].sym = i;
     }
 
     /* Calculate the huffman codes themselves */
-    calculate_codes(he);
+    calculate_codes(p.he);
 
-    send = 0;
+    /*
+     * The size of every slice is known from its counts, so that the
+     * slices can be written in parallel at their final place.
+     */
     for (i = 0; i < c->slices; i++) {
-        sstart  = send;
-        send    = height * (i + 1) / c->slices;
-
-        /*
-         * Write the huffman codes to a buffer,
-         * get the offset in bits and convert to bytes.
-         */
-        offset += write_huff_codes(dst + sstart * width, c->slice_bits,
-                                   width * (send - sstart), width,
-                                   send - sstart, he) >> 3;
+        uint64_t bits = 0;
 
-        slice_len = offset - slice_len;
+        for (j = 0; j < 256; j++)
+            bits += c->slice_counts[i][j] * lengths[j];
 
-        /* Byteswap the written huffman codes */
-        c->bdsp.bswap_buf((uint32_t *) c->slice_bits,
-                          (uint32_t *) c->slice_bits,
-                          slice_len >> 2);
-
-        /* Write the offset to the stream */
-        bytestream2_put_le32(pb, offset);
-
-        /* Seek to the data part of the packet */
-        bytestream2_seek_p(pb, 4 * (c->slices - i - 1) +
-                           offset - slice_len, SEEK_CUR);
+        /* Slices are padded to a 32-bit boundary */
+        offset += FFALIGN(bits, 32) >> 3;
+        c->slice_offsets[i] = offset;
+    }
 
-        /* Write the slices' data into the output packet */
-        bytestream2_put_buffer(pb, c->slice_bits, slice_len);
+    if (4 * c->slices + offset > bytestream2_get_bytes_left_p(pb)) {
+        av_log(avctx, AV_LOG_ERROR, "Output buffer too small.\n");
+        return AVERROR_BUG;
+    }
 
-        /* Seek back to the slice offsets */
-        bytestream2_seek_p(pb, -4 * (c->slices - i - 1) - offset,
-                           SEEK_CUR);
+    /* Write the offsets to the stream */
+    for (i = 0; i < c->slices; i++)
+        bytestream2_put_le32(pb, c->slice_offsets[i]);
 
-        slice_len = offset;
-    }
+    /* Write the slices' data into the output packet */
+    p.out = pb->buffer;
+    avctx->execute2(avctx, write_slice, &p, NULL, c->slices);
 
     /* And at the end seek to the end of written slice(s) */
-    bytestream2_seek_p(pb, offset, SEEK_CUR);
+    bytestream2_skip_p(pb, offset);
 
     return 0;
 }
@@ -554,14 +605,6 @@ static int utvideo_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
 
     bytestream2_init_writer(&pb, dst, pkt->size);
 
-    av_fast_malloc(&c->slice_bits, &c->slice_bits_size,
-                   width * height + AV_INPUT_BUFFER_PADDING_SIZE);
-
-    if (!c->slice_bits) {
-        av_log(avctx, AV_LOG_ERROR, "Cannot allocate temporary buffer 2.\n");
-        return AVERROR(ENOMEM);
-    }
-
     /* In case of RGB, mangle the planes to Ut Video's format */
     if (avctx->pix_fmt == AV_PIX_FMT_RGBA || avctx->pix_fmt == AV_PIX_FMT_RGB24)
         mangle_rgb_planes(c->slice_buffer, c->slice_stride, pic->data[0],
@@ -573,7 +616,7 @@ static int utvideo_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     case AV_PIX_FMT_RGBA:
         for (i = 0; i < c->planes; i++) {
             ret = encode_plane(avctx, c->slice_buffer[i] + 2 * c->slice_stride,
-                               c->slice_buffer[i], c->slice_stride,
+                               c->residuals, c->slice_stride,
                                width, height, &pb);
 
             if (ret) {
@@ -584,7 +627,7 @@ static int utvideo_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
         break;
     case AV_PIX_FMT_YUV422P:
         for (i = 0; i < c->planes; i++) {
-            ret = encode_plane(avctx, pic->data[i], c->slice_buffer[0],
+            ret = encode_plane(avctx, pic->data[i], c->residuals,
                                pic->linesize[i], width >> !!i, height, &pb);
 
             if (ret) {
@@ -595,7 +638,7 @@ static int utvideo_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
         break;
     case AV_PIX_FMT_YUV420P:
         for (i = 0; i < c->planes; i++) {
-            ret = encode_plane(avctx, pic->data[i], c->slice_buffer[0],
+            ret = encode_plane(avctx, pic->data[i], c->residuals,
                                pic->linesize[i], width >> !!i, height >> !!i,
                                &pb);
 
@@ -668,6 +711,7 @@ AVCodec ff_utvideo_encoder = {
     .init           = utvideo_encode_init,
     .encode2        = utvideo_encode_frame,
     .close          = utvideo_encode_close,
+    .capabilities   = AV_CODEC_CAP_SLICE_THREADS | AV_CODEC_CAP_FRAME_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]) {
                           AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA, AV_PIX_FMT_YUV422P,
                           AV_PIX_FMT_YUV420P, AV_PIX_FMT_NONE
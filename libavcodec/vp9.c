@@ -116,7 +116,7 @@ static int update_size(AVCodecContext *avctx, int w, int h)
 {
     VP9Context *s = avctx->priv_data;
     uint8_t *p;
-    int nb_blocks, nb_superblocks;
+    int nb_blocks, nb_superblocks, lflvl_rows;
 
     if (s->above_partition_ctx && w == s->alloc_width && h == s->alloc_height)
         return 0;
@@ -133,10 +133,15 @@ static int update_size(AVCodecContext *avctx, int w, int h)
     s->cols       = (w +  7) >> 3;
     s->rows       = (h +  7) >> 3;
 
+    // with tile threading, the loop filter runs behind the decoding and
+    // needs the levels and masks of all the sb64 rows
+    lflvl_rows = avctx->active_thread_type & FF_THREAD_SLICE ? s->sb_rows : 1;
+
 #define assign(var, type, n) var = (type)p; p += s->sb_cols * n * sizeof(*var)
     av_free(s->above_partition_ctx);
     p = av_malloc(s->sb_cols *
-                  (240 + sizeof(*s->lflvl) + 16 * sizeof(*s->above_mv_ctx)));
+                  (240 + lflvl_rows * sizeof(*s->lflvl) +
+                   16 * sizeof(*s->above_mv_ctx)));
     if (!p)
         return AVERROR(ENOMEM);
     assign(s->above_partition_ctx, uint8_t *,     8);
@@ -154,7 +159,7 @@ static int update_size(AVCodecContext *avctx, int w, int h)
     assign(s->above_comp_ctx,      uint8_t *,     8);
     assign(s->above_ref_ctx,       uint8_t *,     8);
     assign(s->above_filter_ctx,    uint8_t *,     8);
-    assign(s->lflvl,               VP9Filter *,   1);
+    assign(s->lflvl,               VP9Filter *,   lflvl_rows);
     assign(s->above_mv_ctx,        VP56mv(*)[2], 16);
 #undef assign
 
@@ -164,6 +169,9 @@ static int update_size(AVCodecContext *avctx, int w, int h)
     if (avctx->active_thread_type & FF_THREAD_FRAME) {
         nb_blocks      = s->cols * s->rows;
         nb_superblocks = s->sb_cols * s->sb_rows;
+    } else if (avctx->active_thread_type & FF_THREAD_SLICE) {
+        // one block buffer for each tile thread
+        nb_blocks = nb_superblocks = avctx->thread_count;
     } else {
         nb_blocks = nb_superblocks = 1;
     }
@@ -408,10 +416,22 @@ static int decode_frame_header(AVCodecContext *avctx,
     /* loopfilter header data */
     s->filter.level = get_bits(&s->gb, 6);
     sharp           = get_bits(&s->gb, 3);
-    /* If sharpness changed, reinit lim/mblim LUTs. if it didn't change,
-     * keep the old cache values since they are still valid. */
-    if (s->filter.sharpness != sharp)
-        memset(s->filter.lim_lut, 0, sizeof(s->filter.lim_lut));
+    /* If sharpness changed, recompute the lim/mblim LUTs. if it didn't
+     * change, keep the old values since they are still valid. */
+    if (s->filter.sharpness != sharp) {
+        for (i = 1; i < FF_ARRAY_ELEMS(s->filter.lim_lut); i++) {
+            int limit = i;
+
+            if (sharp > 0) {
+                limit >>= (sharp + 3) >> 2;
+                limit   = FFMIN(limit, 9 - sharp);
+            }
+            limit = FFMAX(limit, 1);
+
+            s->filter.lim_lut[i]   = limit;
+            s->filter.mblim_lut[i] = 2 * (i + 2) + limit;
+        }
+    }
     s->filter.sharpness = sharp;
     if ((s->lf_delta.enabled = get_bits1(&s->gb))) {
         if (get_bits1(&s->gb)) {
@@ -528,16 +548,15 @@ static int decode_frame_header(AVCodecContext *avctx,
     }
     s->tiling.log2_tile_rows = decode012(&s->gb);
     s->tiling.tile_rows      = 1 << s->tiling.log2_tile_rows;
-    if (s->tiling.tile_cols != (1 << s->tiling.log2_tile_cols)) {
-        s->tiling.tile_cols = 1 << s->tiling.log2_tile_cols;
-        s->c_b              = av_fast_realloc(s->c_b, &s->c_b_size,
-                                              sizeof(VP56RangeCoder) *
-                                              s->tiling.tile_cols);
-        if (!s->c_b) {
-            av_log(avctx, AV_LOG_ERROR,
-                   "Ran out of memory during range coder init\n");
-            return AVERROR(ENOMEM);
-        }
+    s->tiling.tile_cols      = 1 << s->tiling.log2_tile_cols;
+    // tile threading sets up the range coders of all the tiles at once
+    s->c_b = av_fast_realloc(s->c_b, &s->c_b_size,
+                             sizeof(VP56RangeCoder) *
+                             s->tiling.tile_cols * s->tiling.tile_rows);
+    if (!s->c_b) {
+        av_log(avctx, AV_LOG_ERROR,
+               "Ran out of memory during range coder init\n");
+        return AVERROR(ENOMEM);
     }
 
     if (s->keyframe || s->errorres || s->intraonly) {
@@ -762,11 +781,10 @@ static int decode_frame_header(AVCodecContext *avctx,
     return (data2 - data) + size2;
 }
 
-static int decode_subblock(AVCodecContext *avctx, int row, int col,
+static int decode_subblock(VP9Context *s, int row, int col,
                            VP9Filter *lflvl,
                            ptrdiff_t yoff, ptrdiff_t uvoff, enum BlockLevel bl)
 {
-    VP9Context *s = avctx->priv_data;
     AVFrame    *f = s->frames[CUR_FRAME].tf.f;
     int c = ((s->above_partition_ctx[col]       >> (3 - bl)) & 1) |
             (((s->left_partition_ctx[row & 0x7] >> (3 - bl)) & 1) << 1);
@@ -778,49 +796,49 @@ static int decode_subblock(AVCodecContext *avctx, int row, int col,
 
     if (bl == BL_8X8) {
         bp  = vp8_rac_get_tree(&s->c, ff_vp9_partition_tree, p);
-        ret = ff_vp9_decode_block(avctx, row, col, lflvl, yoff, uvoff, bl, bp);
+        ret = ff_vp9_decode_block(s, row, col, lflvl, yoff, uvoff, bl, bp);
     } else if (col + hbs < s->cols) {
         if (row + hbs < s->rows) {
             bp = vp8_rac_get_tree(&s->c, ff_vp9_partition_tree, p);
             switch (bp) {
             case PARTITION_NONE:
-                ret = ff_vp9_decode_block(avctx, row, col, lflvl, yoff, uvoff,
+                ret = ff_vp9_decode_block(s, row, col, lflvl, yoff, uvoff,
                                           bl, bp);
                 break;
             case PARTITION_H:
-                ret = ff_vp9_decode_block(avctx, row, col, lflvl, yoff, uvoff,
+                ret = ff_vp9_decode_block(s, row, col, lflvl, yoff, uvoff,
                                           bl, bp);
                 if (!ret) {
                     yoff  += hbs * 8 * f->linesize[0];
                     uvoff += hbs * 4 * f->linesize[1];
-                    ret    = ff_vp9_decode_block(avctx, row + hbs, col, lflvl,
+                    ret    = ff_vp9_decode_block(s, row + hbs, col, lflvl,
                                                  yoff, uvoff, bl, bp);
                 }
                 break;
             case PARTITION_V:
-                ret = ff_vp9_decode_block(avctx, row, col, lflvl, yoff, uvoff,
+                ret = ff_vp9_decode_block(s, row, col, lflvl, yoff, uvoff,
                                           bl, bp);
                 if (!ret) {
                     yoff  += hbs * 8;
                     uvoff += hbs * 4;
-                    ret    = ff_vp9_decode_block(avctx, row, col + hbs, lflvl,
+                    ret    = ff_vp9_decode_block(s, row, col + hbs, lflvl,
                                                  yoff, uvoff, bl, bp);
                 }
                 break;
             case PARTITION_SPLIT:
-                ret = decode_subblock(avctx, row, col, lflvl,
+                ret = decode_subblock(s, row, col, lflvl,
                                       yoff, uvoff, bl + 1);
                 if (!ret) {
-                    ret = decode_subblock(avctx, row, col + hbs, lflvl,
+                    ret = decode_subblock(s, row, col + hbs, lflvl,
                                           yoff + 8 * hbs, uvoff + 4 * hbs,
                                           bl + 1);
                     if (!ret) {
                         yoff  += hbs * 8 * f->linesize[0];
                         uvoff += hbs * 4 * f->linesize[1];
-                        ret    = decode_subblock(avctx, row + hbs, col, lflvl,
+                        ret    = decode_subblock(s, row + hbs, col, lflvl,
                                                  yoff, uvoff, bl + 1);
                         if (!ret) {
-                            ret = decode_subblock(avctx, row + hbs, col + hbs,
+                            ret = decode_subblock(s, row + hbs, col + hbs,
                                                   lflvl, yoff + 8 * hbs,
                                                   uvoff + 4 * hbs, bl + 1);
                         }
@@ -828,48 +846,47 @@ static int decode_subblock(AVCodecContext *avctx, int row, int col,
                 }
                 break;
             default:
-                av_log(avctx, AV_LOG_ERROR, "Unexpected partition %d.", bp);
+                av_log(s->avctx, AV_LOG_ERROR, "Unexpected partition %d.", bp);
                 return AVERROR_INVALIDDATA;
             }
         } else if (vp56_rac_get_prob_branchy(&s->c, p[1])) {
             bp  = PARTITION_SPLIT;
-            ret = decode_subblock(avctx, row, col, lflvl, yoff, uvoff, bl + 1);
+            ret = decode_subblock(s, row, col, lflvl, yoff, uvoff, bl + 1);
             if (!ret)
-                ret = decode_subblock(avctx, row, col + hbs, lflvl,
+                ret = decode_subblock(s, row, col + hbs, lflvl,
                                       yoff + 8 * hbs, uvoff + 4 * hbs, bl + 1);
         } else {
             bp  = PARTITION_H;
-            ret = ff_vp9_decode_block(avctx, row, col, lflvl, yoff, uvoff,
+            ret = ff_vp9_decode_block(s, row, col, lflvl, yoff, uvoff,
                                       bl, bp);
         }
     } else if (row + hbs < s->rows) {
         if (vp56_rac_get_prob_branchy(&s->c, p[2])) {
             bp  = PARTITION_SPLIT;
-            ret = decode_subblock(avctx, row, col, lflvl, yoff, uvoff, bl + 1);
+            ret = decode_subblock(s, row, col, lflvl, yoff, uvoff, bl + 1);
             if (!ret) {
                 yoff  += hbs * 8 * f->linesize[0];
                 uvoff += hbs * 4 * f->linesize[1];
-                ret    = decode_subblock(avctx, row + hbs, col, lflvl,
+                ret    = decode_subblock(s, row + hbs, col, lflvl,
                                          yoff, uvoff, bl + 1);
             }
         } else {
             bp  = PARTITION_V;
-            ret = ff_vp9_decode_block(avctx, row, col, lflvl, yoff, uvoff,
+            ret = ff_vp9_decode_block(s, row, col, lflvl, yoff, uvoff,
                                       bl, bp);
         }
     } else {
         bp  = PARTITION_SPLIT;
-        ret = decode_subblock(avctx, row, col, lflvl, yoff, uvoff, bl + 1);
+        ret = decode_subblock(s, row, col, lflvl, yoff, uvoff, bl + 1);
     }
     s->counts.partition[bl][c][bp]++;
 
     return ret;
 }
 
-static int decode_superblock_mem(AVCodecContext *avctx, int row, int col, struct VP9Filter *lflvl,
+static int decode_superblock_mem(VP9Context *s, int row, int col, struct VP9Filter *lflvl,
                                  ptrdiff_t yoff, ptrdiff_t uvoff, enum BlockLevel bl)
 {
-    VP9Context *s = avctx->priv_data;
     VP9Block *b = s->b;
     ptrdiff_t hbs = 4 >> bl;
     AVFrame *f = s->frames[CUR_FRAME].tf.f;
@@ -878,43 +895,43 @@ static int decode_superblock_mem(AVCodecContext *avctx, int row, int col, struct
 
     if (bl == BL_8X8) {
         av_assert2(b->bl == BL_8X8);
-        res = ff_vp9_decode_block(avctx, row, col, lflvl, yoff, uvoff, b->bl, b->bp);
+        res = ff_vp9_decode_block(s, row, col, lflvl, yoff, uvoff, b->bl, b->bp);
     } else if (s->b->bl == bl) {
-        if ((res = ff_vp9_decode_block(avctx, row, col, lflvl, yoff, uvoff, b->bl, b->bp)) < 0)
+        if ((res = ff_vp9_decode_block(s, row, col, lflvl, yoff, uvoff, b->bl, b->bp)) < 0)
             return res;
         if (b->bp == PARTITION_H && row + hbs < s->rows) {
             yoff  += hbs * 8 * y_stride;
             uvoff += hbs * 4 * uv_stride;
-            res = ff_vp9_decode_block(avctx, row + hbs, col, lflvl, yoff, uvoff, b->bl, b->bp);
+            res = ff_vp9_decode_block(s, row + hbs, col, lflvl, yoff, uvoff, b->bl, b->bp);
         } else if (b->bp == PARTITION_V && col + hbs < s->cols) {
             yoff  += hbs * 8;
             uvoff += hbs * 4;
-            res = ff_vp9_decode_block(avctx, row, col + hbs, lflvl, yoff, uvoff, b->bl, b->bp);
+            res = ff_vp9_decode_block(s, row, col + hbs, lflvl, yoff, uvoff, b->bl, b->bp);
         }
     } else {
-        if ((res = decode_superblock_mem(avctx, row, col, lflvl, yoff, uvoff, bl + 1)) < 0)
+        if ((res = decode_superblock_mem(s, row, col, lflvl, yoff, uvoff, bl + 1)) < 0)
             return res;
         if (col + hbs < s->cols) { // FIXME why not <=?
             if (row + hbs < s->rows) {
-                if ((res = decode_superblock_mem(avctx, row, col + hbs, lflvl, yoff + 8 * hbs,
+                if ((res = decode_superblock_mem(s, row, col + hbs, lflvl, yoff + 8 * hbs,
                                                  uvoff + 4 * hbs, bl + 1)) < 0)
                     return res;
                 yoff  += hbs * 8 * y_stride;
                 uvoff += hbs * 4 * uv_stride;
-                if ((res = decode_superblock_mem(avctx, row + hbs, col, lflvl, yoff,
+                if ((res = decode_superblock_mem(s, row + hbs, col, lflvl, yoff,
                                                  uvoff, bl + 1)) < 0)
                     return res;
-                res = decode_superblock_mem(avctx, row + hbs, col + hbs, lflvl,
+                res = decode_superblock_mem(s, row + hbs, col + hbs, lflvl,
                                             yoff + 8 * hbs, uvoff + 4 * hbs, bl + 1);
             } else {
                 yoff  += hbs * 8;
                 uvoff += hbs * 4;
-                res = decode_superblock_mem(avctx, row, col + hbs, lflvl, yoff, uvoff, bl + 1);
+                res = decode_superblock_mem(s, row, col + hbs, lflvl, yoff, uvoff, bl + 1);
             }
         } else if (row + hbs < s->rows) {
             yoff  += hbs * 8 * y_stride;
             uvoff += hbs * 4 * uv_stride;
-            res = decode_superblock_mem(avctx, row + hbs, col, lflvl, yoff, uvoff, bl + 1);
+            res = decode_superblock_mem(s, row + hbs, col, lflvl, yoff, uvoff, bl + 1);
         }
     }
 
@@ -1172,6 +1189,226 @@ static void set_tile_offset(int *start, int *end, int idx, int log2_n, int n)
     *end   = FFMIN(sb_end,   n) << 3;
 }
 
+static void reset_left_ctx(VP9Context *s)
+{
+    memset(s->left_partition_ctx, 0, 8);
+    memset(s->left_skip_ctx, 0, 8);
+    if (s->keyframe || s->intraonly)
+        memset(s->left_mode_ctx, DC_PRED, 16);
+    else
+        memset(s->left_mode_ctx, NEARESTMV, 8);
+    memset(s->left_y_nnz_ctx, 0, 16);
+    memset(s->left_uv_nnz_ctx, 0, 16);
+    memset(s->left_segpred_ctx, 0, 8);
+}
+
+// backup pre-loopfilter reconstruction data of the columns [col_start,
+// col_end) for intra prediction of the next row of sb64s
+static void save_intra_pred_data(VP9Context *s, AVFrame *f,
+                                 ptrdiff_t yoff, ptrdiff_t uvoff,
+                                 int col_start, int col_end)
+{
+    memcpy(s->intra_pred_data[0] + col_start * 8,
+           f->data[0] + yoff + 63 * f->linesize[0] + col_start * 8,
+           8 * (col_end - col_start));
+    memcpy(s->intra_pred_data[1] + col_start * 4,
+           f->data[1] + uvoff + 31 * f->linesize[1] + col_start * 4,
+           4 * (col_end - col_start));
+    memcpy(s->intra_pred_data[2] + col_start * 4,
+           f->data[2] + uvoff + 31 * f->linesize[2] + col_start * 4,
+           4 * (col_end - col_start));
+}
+
+static void loopfilter_sbrow(AVCodecContext *avctx, VP9Filter *lflvl, int row,
+                             ptrdiff_t yoff, ptrdiff_t uvoff)
+{
+    VP9Context *s = avctx->priv_data;
+    int col;
+
+    for (col = 0; col < s->cols; col += 8, yoff += 64, uvoff += 32, lflvl++)
+        loopfilter_subblock(avctx, lflvl, row, col, yoff, uvoff);
+}
+
+#if HAVE_THREADS
+/**
+ * Init the range coders of all the tiles of the frame, in c_b in raster order.
+ */
+static int init_tiles(VP9Context *s, const uint8_t *data, int size)
+{
+    int tile_row, tile_col;
+
+    for (tile_row = 0; tile_row < s->tiling.tile_rows; tile_row++) {
+        for (tile_col = 0; tile_col < s->tiling.tile_cols; tile_col++) {
+            VP56RangeCoder *c = &s->c_b[tile_row * s->tiling.tile_cols + tile_col];
+            int64_t tile_size;
+
+            if (tile_col == s->tiling.tile_cols - 1 &&
+                tile_row == s->tiling.tile_rows - 1) {
+                tile_size = size;
+            } else {
+                if (size < 4)
+                    return AVERROR_INVALIDDATA;
+                tile_size = AV_RB32(data);
+                data     += 4;
+                size     -= 4;
+            }
+            if (tile_size > size)
+                return AVERROR_INVALIDDATA;
+            ff_vp56_init_range_decoder(c, data, tile_size);
+            if (vp56_rac_get_prob_branchy(c, 128)) // marker bit
+                return AVERROR_INVALIDDATA;
+            data += tile_size;
+            size -= tile_size;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Loop filter the sb64 rows as soon as all the tile columns are decoded
+ * past them.
+ */
+static void loopfilter_tile_rows(AVCodecContext *avctx)
+{
+    VP9Context *s = avctx->priv_data;
+    AVFrame    *f = s->frames[CUR_FRAME].tf.f;
+    int sb_row, tile_col;
+
+    for (sb_row = 0; sb_row < s->sb_rows; sb_row++) {
+        for (tile_col = 0; tile_col < s->tiling.tile_cols; tile_col++)
+            ff_slice_thread_await_progress(avctx, tile_col, sb_row + 1);
+        if (atomic_load(&s->tile_error))
+            return;
+
+        if (s->filter.level)
+            loopfilter_sbrow(avctx, s->lflvl + sb_row * s->sb_cols, sb_row << 3,
+                             sb_row * 64 * f->linesize[0],
+                             sb_row * 32 * f->linesize[1]);
+    }
+}
+
+/**
+ * Decode one tile column from top to bottom on a copy of the context, job
+ * tile_cols runs the loop filter.
+ */
+static int decode_tile_col(AVCodecContext *avctx, void *arg, int tile_col,
+                           int thread)
+{
+    VP9Context *s0 = avctx->priv_data;
+    VP9Context *s  = &s0->tile_ctx[thread];
+    AVFrame    *f  = s->frames[CUR_FRAME].tf.f;
+    int tile_row, row, col, ret = 0;
+
+    if (tile_col == s->tiling.tile_cols) {
+        loopfilter_tile_rows(avctx);
+        return 0;
+    }
+
+    set_tile_offset(&s->tiling.tile_col_start, &s->tiling.tile_col_end,
+                    tile_col, s->tiling.log2_tile_cols, s->sb_cols);
+
+    for (tile_row = 0; tile_row < s->tiling.tile_rows; tile_row++) {
+        set_tile_offset(&s->tiling.tile_row_start, &s->tiling.tile_row_end,
+                        tile_row, s->tiling.log2_tile_rows, s->sb_rows);
+
+        s->c = s0->c_b[tile_row * s->tiling.tile_cols + tile_col];
+        for (row = s->tiling.tile_row_start;
+             row < s->tiling.tile_row_end; row += 8) {
+            VP9Filter *lflvl = s->lflvl + (row >> 3) * s->sb_cols +
+                               (s->tiling.tile_col_start >> 3);
+            ptrdiff_t yoff   = (row >> 3) * 64 * f->linesize[0];
+            ptrdiff_t uvoff  = (row >> 3) * 32 * f->linesize[1];
+            ptrdiff_t yoff2  = yoff  + s->tiling.tile_col_start * 8;
+            ptrdiff_t uvoff2 = uvoff + s->tiling.tile_col_start * 4;
+
+            reset_left_ctx(s);
+            for (col = s->tiling.tile_col_start;
+                 col < s->tiling.tile_col_end;
+                 col += 8, yoff2 += 64, uvoff2 += 32, lflvl++) {
+                memset(lflvl->mask, 0, sizeof(lflvl->mask));
+                ret = decode_subblock(s, row, col, lflvl, yoff2, uvoff2,
+                                      BL_64X64);
+                if (ret < 0)
+                    goto end;
+            }
+
+            if (row + 8 < s->rows)
+                save_intra_pred_data(s, f, yoff, uvoff,
+                                     s->tiling.tile_col_start,
+                                     FFMIN(s->tiling.tile_col_end, s->cols));
+
+            ff_slice_thread_report_progress(avctx, tile_col, (row >> 3) + 1);
+        }
+    }
+
+end:
+    if (ret < 0)
+        atomic_store(&s0->tile_error, ret);
+    ff_slice_thread_report_progress(avctx, tile_col, INT_MAX);
+    return ret;
+}
+
+/**
+ * Decode the tile columns in parallel, with the loop filter running
+ * behind them.
+ */
+static int decode_tiles_threaded(AVCodecContext *avctx,
+                                 const uint8_t *data, int size)
+{
+    VP9Context *s = avctx->priv_data;
+    int i, j, ret;
+
+    ret = init_tiles(s, data, size);
+    if (ret < 0)
+        return ret;
+
+    if (!s->tile_ctx) {
+        s->tile_ctx = av_malloc_array(avctx->thread_count, sizeof(*s->tile_ctx));
+        if (!s->tile_ctx)
+            return AVERROR(ENOMEM);
+    }
+    for (i = 0; i < avctx->thread_count; i++) {
+        VP9Context *td = &s->tile_ctx[i];
+
+        memcpy(td, s, sizeof(*s));
+        memset(&td->counts, 0, sizeof(td->counts));
+        td->b          = s->b_base          + i;
+        td->block      = s->block_base      + i * 64 * 64;
+        td->uvblock[0] = s->uvblock_base[0] + i * 32 * 32;
+        td->uvblock[1] = s->uvblock_base[1] + i * 32 * 32;
+        td->eob        = s->eob_base        + i * 256;
+        td->uveob[0]   = s->uveob_base[0]   + i * 64;
+        td->uveob[1]   = s->uveob_base[1]   + i * 64;
+    }
+
+    ret = ff_slice_thread_init_progress(avctx, s->tiling.tile_cols);
+    if (ret < 0)
+        return ret;
+    atomic_init(&s->tile_error, 0);
+
+    avctx->execute2(avctx, decode_tile_col, NULL, NULL,
+                    s->tiling.tile_cols + 1);
+
+    ret = atomic_load(&s->tile_error);
+    if (ret < 0)
+        return ret;
+
+    if (s->refreshctx && !s->parallelmode) {
+        unsigned *counts = (unsigned *)&s->counts;
+
+        for (i = 0; i < avctx->thread_count; i++) {
+            const unsigned *td_counts = (const unsigned *)&s->tile_ctx[i].counts;
+
+            for (j = 0; j < sizeof(s->counts) / sizeof(*counts); j++)
+                counts[j] += td_counts[j];
+        }
+    }
+
+    return 0;
+}
+#endif
+
 static int update_refs(AVCodecContext *avctx)
 {
     VP9Context *s = avctx->priv_data;
@@ -1282,6 +1519,15 @@ static int vp9_decode_frame(AVCodecContext *avctx, void *output,
     memset(s->above_uv_nnz_ctx[1], 0, s->sb_cols * 8);
     memset(s->above_segpred_ctx, 0, s->cols);
 
+#if HAVE_THREADS
+    if (avctx->active_thread_type & FF_THREAD_SLICE) {
+        ret = decode_tiles_threaded(avctx, data, size);
+        if (ret >= 0 && s->refreshctx && !s->parallelmode)
+            ff_vp9_adapt_probs(s);
+        goto finish;
+    }
+#endif
+
     do {
         ptrdiff_t yoff = 0, uvoff = 0;
         s->b          = s->b_base;
@@ -1310,12 +1556,12 @@ static int vp9_decode_frame(AVCodecContext *avctx, void *output,
                     }
                     if (tile_size > size) {
                         ret = AVERROR_INVALIDDATA;
-                        goto fail;
+                        goto finish;
                     }
                     ff_vp56_init_range_decoder(&s->c_b[tile_col], data, tile_size);
                     if (vp56_rac_get_prob_branchy(&s->c_b[tile_col], 128)) { // marker bit
                         ret = AVERROR_INVALIDDATA;
-                        goto fail;
+                        goto finish;
                     }
                     data += tile_size;
                     size -= tile_size;
@@ -1334,16 +1580,7 @@ static int vp9_decode_frame(AVCodecContext *avctx, void *output,
                                     &s->tiling.tile_col_end,
                                     tile_col, s->tiling.log2_tile_cols, s->sb_cols);
 
-                    memset(s->left_partition_ctx, 0, 8);
-                    memset(s->left_skip_ctx, 0, 8);
-                    if (s->keyframe || s->intraonly)
-                        memset(s->left_mode_ctx, DC_PRED, 16);
-                    else
-                        memset(s->left_mode_ctx, NEARESTMV, 8);
-                    memset(s->left_y_nnz_ctx, 0, 16);
-                    memset(s->left_uv_nnz_ctx, 0, 16);
-                    memset(s->left_segpred_ctx, 0, 8);
-
+                    reset_left_ctx(s);
                     memcpy(&s->c, &s->c_b[tile_col], sizeof(s->c));
                     for (col = s->tiling.tile_col_start;
                          col < s->tiling.tile_col_end;
@@ -1354,14 +1591,14 @@ static int vp9_decode_frame(AVCodecContext *avctx, void *output,
                             memset(lflvl->mask, 0, sizeof(lflvl->mask));
 
                         if (s->pass == 2) {
-                            ret = decode_superblock_mem(avctx, row, col, lflvl,
+                            ret = decode_superblock_mem(s, row, col, lflvl,
                                                         yoff2, uvoff2, BL_64X64);
                         } else {
-                            ret = decode_subblock(avctx, row, col, lflvl,
+                            ret = decode_subblock(s, row, col, lflvl,
                                                   yoff2, uvoff2, BL_64X64);
                         }
                         if (ret < 0)
-                            goto fail;
+                            goto finish;
                     }
                     if (s->pass != 2)
                         memcpy(&s->c_b[tile_col], &s->c, sizeof(s->c));
@@ -1370,32 +1607,12 @@ static int vp9_decode_frame(AVCodecContext *avctx, void *output,
                 if (s->pass == 1)
                     continue;
 
-                // backup pre-loopfilter reconstruction data for intra
-                // prediction of next row of sb64s
-                if (row + 8 < s->rows) {
-                    memcpy(s->intra_pred_data[0],
-                           f->data[0] + yoff +
-                           63 * f->linesize[0],
-                           8 * s->cols);
-                    memcpy(s->intra_pred_data[1],
-                           f->data[1] + uvoff +
-                           31 * f->linesize[1],
-                           4 * s->cols);
-                    memcpy(s->intra_pred_data[2],
-                           f->data[2] + uvoff +
-                           31 * f->linesize[2],
-                           4 * s->cols);
-                }
+                if (row + 8 < s->rows)
+                    save_intra_pred_data(s, f, yoff, uvoff, 0, s->cols);
 
                 // loopfilter one row
-                if (s->filter.level) {
-                    yoff2  = yoff;
-                    uvoff2 = uvoff;
-                    lflvl  = s->lflvl;
-                    for (col = 0; col < s->cols;
-                         col += 8, yoff2 += 64, uvoff2 += 32, lflvl++)
-                        loopfilter_subblock(avctx, lflvl, row, col, yoff2, uvoff2);
-                }
+                if (s->filter.level)
+                    loopfilter_sbrow(avctx, s->lflvl, row, yoff, uvoff);
 
                 // FIXME maybe we can make this more finegrained by running the
                 // loopfilter per-block instead of after each sbrow
@@ -1412,7 +1629,7 @@ static int vp9_decode_frame(AVCodecContext *avctx, void *output,
             }
         }
     } while (s->pass++ == 1);
-fail:
+finish:
     ff_thread_report_progress(&s->frames[CUR_FRAME].tf, INT_MAX, 0);
     if (ret < 0)
         return ret;
@@ -1451,6 +1668,7 @@ static av_cold int vp9_decode_free(AVCodecContext *avctx)
     }
 
     av_freep(&s->c_b);
+    av_freep(&s->tile_ctx);
     av_freep(&s->above_partition_ctx);
     av_freep(&s->b_base);
     av_freep(&s->block_base);
@@ -1465,6 +1683,8 @@ static av_cold int vp9_decode_init(AVCodecContext *avctx)
 
     memset(s, 0, sizeof(*s));
 
+    s->avctx = avctx;
+
     avctx->internal->allocate_progress = 1;
 
     avctx->pix_fmt = AV_PIX_FMT_YUV420P;
@@ -1544,7 +1764,8 @@ AVCodec ff_vp9_decoder = {
     .decode                = vp9_decode_frame,
     .flush                 = vp9_decode_flush,
     .close                 = vp9_decode_free,
-    .capabilities          = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS,
+    .capabilities          = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                             AV_CODEC_CAP_SLICE_THREADS,
     .init_thread_copy      = vp9_decode_init,
     .update_thread_context = vp9_decode_update_thread_context,
     .bsfs                  = "vp9_superframe_split",
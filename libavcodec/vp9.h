@@ -24,6 +24,7 @@
 #ifndef AVCODEC_VP9_H
 #define AVCODEC_VP9_H
 
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -276,6 +277,7 @@ typedef struct VP9Block {
 } VP9Block;
 
 typedef struct VP9Context {
+    AVCodecContext *avctx;
     VP9DSPContext dsp;
     VideoDSPContext vdsp;
     GetBitContext gb;
@@ -429,6 +431,11 @@ typedef struct VP9Context {
     struct { int x, y; } min_mv, max_mv;
     DECLARE_ALIGNED(32, uint8_t, tmp_y)[64 * 64];
     DECLARE_ALIGNED(32, uint8_t, tmp_uv)[2][32 * 32];
+
+    // tile threading: one copy of this context per thread, refreshed for
+    // every frame
+    struct VP9Context *tile_ctx;
+    atomic_int tile_error;
 } VP9Context;
 
 extern const int8_t ff_vp9_subpel_filters[3][15][8];
@@ -443,7 +450,7 @@ void ff_vp9_fill_mv(VP9Context *s, VP56mv *mv, int mode, int sb);
 
 void ff_vp9_adapt_probs(VP9Context *s);
 
-int ff_vp9_decode_block(AVCodecContext *avctx, int row, int col,
+int ff_vp9_decode_block(VP9Context *s, int row, int col,
                         VP9Filter *lflvl, ptrdiff_t yoff, ptrdiff_t uvoff,
                         enum BlockLevel bl, enum BlockPartition bp);
 
@@ -0,0 +1,74 @@
+;******************************************************************************
+;* FLAC DSP functions
+;*
+;* This file is part of Libav.
+;*
+;* Libav is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* Libav is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with Libav; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+%if ARCH_X86_64
+;------------------------------------------------------------------------------
+; uint64_t ff_flac_sum_residual(const int32_t *res, int len)
+;------------------------------------------------------------------------------
+INIT_XMM sse2
+cglobal flac_sum_residual, 2, 5, 4, res, len, i, tmp, sign
+    movsxd           lenq, lend
+    pxor               m0, m0
+    pxor               m3, m3
+    xor                iq, iq
+
+    ; vector loop, 4 samples per iteration
+    mov              tmpq, lenq
+    and              tmpq, ~3
+    jmp .end_v
+.loop_v:
+    movu               m1, [resq+iq*4]
+    mova               m2, m1
+    paddd              m1, m1
+    psrad              m2, 31
+    pxor               m1, m2     ; (2 * res) ^ (res >> 31)
+    mova               m2, m1
+    punpckldq          m1, m3
+    punpckhdq          m2, m3
+    paddq              m0, m1
+    paddq              m0, m2
+    add                iq, 4
+.end_v:
+    cmp                iq, tmpq
+    jl .loop_v
+
+    pshufd             m1, m0, q3232
+    paddq              m0, m1
+    movq              rax, m0
+
+    ; scalar loop for leftover
+    jmp .end_s
+.loop_s:
+    mov              tmpd, [resq+iq*4]
+    mov             signd, tmpd
+    add              tmpd, tmpd
+    sar             signd, 31
+    xor              tmpd, signd
+    add               rax, tmpq
+    inc                iq
+.end_s:
+    cmp                iq, lenq
+    jl .loop_s
+    RET
+%endif
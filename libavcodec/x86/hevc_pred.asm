@@ -0,0 +1,571 @@
+;******************************************************************************
+;* SIMD optimized intra prediction functions for HEVC decoding
+;*
+;* This file is part of Libav.
+;*
+;* Libav is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* Libav is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with Libav; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+; (x + 16) >> 5 with pmulhrsw
+pw_1024:       times 16 dw 1024
+
+; (x + 1) weights of top[size]
+pw_planar_x1:  dw  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16
+               dw 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32
+
+; (size - 1 - x) weights of left[y]
+pw_planar_4:   dw  3,  2,  1,  0,  0,  0,  0,  0
+pw_planar_8:   dw  7,  6,  5,  4,  3,  2,  1,  0
+pw_planar_16:  dw 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0
+pw_planar_32:  dw 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16
+               dw 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0
+
+cextern pw_1
+cextern pw_4
+cextern pw_8
+cextern pw_16
+cextern pw_32
+
+SECTION .text
+
+%macro LOAD_PIXEL 3 ; dst gpr, src, bitdepth
+%if %3 == 8
+    movzx             %1, byte %2
+%else
+    movzx             %1, word %2
+%endif
+%endmacro
+
+%macro STORE_PIXEL 3 ; dst, src name, bitdepth
+%if %3 == 8
+    mov               %1, %2b
+%else
+    mov               %1, %2w
+%endif
+%endmacro
+
+; load 8 pixels as words
+%macro LOAD_WORDS 3 ; dst, src, bitdepth
+%if %3 == 8
+    pmovzxbw          %1, %2
+%else
+    movu              %1, %2
+%endif
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_hevc_pred_planar_<size>_<depth>_sse4(uint8_t *src, const uint8_t *top,
+;                                              const uint8_t *left,
+;                                              ptrdiff_t stride)
+;------------------------------------------------------------------------------
+
+; As in the C functions, the stride is given in pixels.
+
+; The prediction of row y is
+;     (base[x] + (size - 1 - x) * left[y]) >> (log2_size + 1)
+; with base[x] = (x + 1) * top[size] + (size - 1 - y) * top[x] +
+;                (y + 1) * left[size] + size,
+; which moves by left[size] - top[x] from one row to the next. All the terms
+; fit in unsigned words for bit depths up to 10.
+%macro PRED_PLANAR 3 ; size, log2_size, bitdepth
+%assign %%ps (%3 + 7) / 8
+%assign %%n (%1 + 7) / 8 ; word registers per row
+cglobal hevc_pred_planar_%1_%3, 4, 6, 11, src, top, left, stride, y, tmp
+%if %3 > 8
+    add          strideq, strideq
+%endif
+    LOAD_PIXEL      tmpd, [topq+%1*%%ps], %3
+    movd              m9, tmpd
+    SPLATW            m9, m9            ; top[size]
+    LOAD_PIXEL      tmpd, [leftq+%1*%%ps], %3
+    movd             m10, tmpd
+    SPLATW           m10, m10           ; left[size]
+%assign %%i 0
+%rep %%n
+%assign %%j %%i + 4
+    LOAD_WORDS  m %+ %%j, [topq+%%i*8*%%ps], %3
+    psllw             m8, m %+ %%j, %2
+    psubw             m8, m %+ %%j      ; (size - 1) * top[x]
+    psubw       m %+ %%j, m10           ; top[x] - left[size]
+    pmullw      m %+ %%i, m9, [pw_planar_x1+%%i*16]
+    paddw       m %+ %%i, m8
+    paddw       m %+ %%i, m10
+    paddw       m %+ %%i, [pw_%1]
+%assign %%i %%i + 1
+%endrep
+
+    mov               yd, %1
+.loop:
+    LOAD_PIXEL      tmpd, [leftq], %3
+    movd              m8, tmpd
+    SPLATW            m8, m8            ; left[y]
+%assign %%i 0
+%rep %%n
+%assign %%j %%i + 4
+%assign %%t 9 + (%%i & 1)
+    pmullw      m %+ %%t, m8, [pw_planar_%1+%%i*16]
+    paddw       m %+ %%t, m %+ %%i
+    psrlw       m %+ %%t, %2 + 1
+    psubw       m %+ %%i, m %+ %%j
+%if %3 > 8
+%if %1 == 4
+    movh           [srcq], m %+ %%t
+%else
+    movu   [srcq+%%i*16], m %+ %%t
+%endif
+%elif %1 == 4
+    packuswb          m9, m9
+    movd           [srcq], m9
+%elif %1 == 8
+    packuswb          m9, m9
+    movh           [srcq], m9
+%elif %%i & 1
+    packuswb          m9, m10
+    movu [srcq+(%%i-1)*8], m9
+%endif
+%assign %%i %%i + 1
+%endrep
+    add             srcq, strideq
+    add            leftq, %%ps
+    dec               yd
+    jg .loop
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_hevc_pred_dc_<size>_<depth>_sse4(uint8_t *src, const uint8_t *top,
+;                                          const uint8_t *left,
+;                                          ptrdiff_t stride, int c_idx)
+;------------------------------------------------------------------------------
+
+; sum the first size pixels of top and left into dcd
+%macro DC_SUM 2 ; size, bitdepth
+%if %2 == 8
+    pxor              m2, m2
+%if %1 == 4
+    movd              m0, [topq]
+    movd              m1, [leftq]
+    punpckldq         m0, m1
+    psadbw            m0, m2
+%elif %1 == 8
+    movh              m0, [topq]
+    movhps            m0, [leftq]
+    psadbw            m0, m2
+%else
+    movu              m0, [topq]
+    movu              m1, [leftq]
+    psadbw            m0, m2
+    psadbw            m1, m2
+    paddw             m0, m1
+%if %1 == 32
+    movu              m1, [topq+16]
+    movu              m3, [leftq+16]
+    psadbw            m1, m2
+    psadbw            m3, m2
+    paddw             m0, m1
+    paddw             m0, m3
+%endif
+%endif
+%if %1 > 4
+    pshufd            m1, m0, q0032
+    paddw             m0, m1
+%endif
+%else ; %2 > 8
+%if %1 == 4
+    movh              m0, [topq]
+    movhps            m0, [leftq]
+%else
+    pxor              m0, m0
+%assign %%i 0
+%rep %1 / 8
+    movu              m1, [topq+%%i]
+    movu              m2, [leftq+%%i]
+    paddw             m0, m1
+    paddw             m0, m2
+%assign %%i %%i + 16
+%endrep
+%endif
+    pmaddwd           m0, [pw_1]
+    pshufd            m1, m0, q0032
+    paddd             m0, m1
+    pshufd            m1, m0, q0001
+    paddd             m0, m1
+%endif
+    movd             dcd, m0
+%endmacro
+
+%macro PRED_DC 3 ; size, log2_size, bitdepth
+%assign %%ps (%3 + 7) / 8
+%assign %%rowsize %1 * %%ps
+cglobal hevc_pred_dc_%1_%3, 5, 8, 4, src, top, left, stride, c_idx, dc, tmp, dst
+%if %3 > 8
+    add          strideq, strideq
+%endif
+    DC_SUM            %1, %3
+    add              dcd, %1
+    shr              dcd, %2 + 1
+
+    movd              m0, dcd
+%if %3 == 8
+    pxor              m1, m1
+    pshufb            m0, m1
+%else
+    SPLATW            m0, m0
+%endif
+    mov             dstq, srcq
+    mov             tmpd, %1
+.loop:
+%if %%rowsize == 4
+    movd           [dstq], m0
+%elif %%rowsize == 8
+    movh           [dstq], m0
+%else
+%assign %%i 0
+%rep %%rowsize / 16
+    movu   [dstq+%%i], m0
+%assign %%i %%i + 16
+%endrep
+%endif
+    add             dstq, strideq
+    dec             tmpd
+    jg .loop
+
+%if %1 < 32
+    ; luma edge smoothing
+    test          c_idxd, c_idxd
+    jnz .end
+    lea             tmpd, [dcq*3+2]
+    movd              m1, tmpd
+    SPLATW            m1, m1
+%assign %%i 0
+%rep (%1 + 7) / 8
+%assign %%j %%i + 2
+    LOAD_WORDS  m %+ %%j, [topq+%%i*8*%%ps], %3
+    paddw       m %+ %%j, m1
+    psrlw       m %+ %%j, 2
+%assign %%i %%i + 1
+%endrep
+%if %3 == 8
+%if %1 == 16
+    packuswb          m2, m3
+    movu           [srcq], m2
+%else
+    packuswb          m2, m2
+%if %1 == 4
+    movd           [srcq], m2
+%else
+    movh           [srcq], m2
+%endif
+%endif
+%else
+%if %1 == 4
+    movh           [srcq], m2
+%else
+    movu           [srcq], m2
+%if %1 == 16
+    movu        [srcq+16], m3
+%endif
+%endif
+%endif
+
+    LOAD_PIXEL      tmpd, [topq], %3
+    LOAD_PIXEL      dstd, [leftq], %3
+    add             tmpd, dstd
+    lea             tmpd, [tmpq+dcq*2+2]
+    shr             tmpd, 2
+    STORE_PIXEL    [srcq], tmp, %3
+
+    lea              dcd, [dcq*3+2]
+    mov             dstd, %1 - 1
+.loop_left:
+    add             srcq, strideq
+    add            leftq, %%ps
+    LOAD_PIXEL      tmpd, [leftq], %3
+    add             tmpd, dcd
+    shr             tmpd, 2
+    STORE_PIXEL    [srcq], tmp, %3
+    dec             dstd
+    jg .loop_left
+.end:
+%endif
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_hevc_pred_angular_<v|h>_<size>_<depth>_<opt>(uint8_t *src,
+;                                                      const uint8_t *ref,
+;                                                      ptrdiff_t stride,
+;                                                      int angle)
+;------------------------------------------------------------------------------
+
+; The reference array ref[] is built by the C wrapper, which also applies the
+; edge filter of the pure horizontal and vertical modes. The v functions
+; predict row y from it, the h functions column x, which is transposed.
+;
+; With pos = (y + 1) * angle - 1, the samples are interpolated from
+; ref[idx + 1] and ref[idx + 2] with idx = pos >> 5 and the weights
+; 32 - fact and fact, fact = (pos & 31) + 1. A fact of 32 stands for the
+; whole sample positions, so that ref[2 * size] is the last sample read.
+
+; m%2 = splatted weights from posd, both as bytes for 8 bit, of ref[idx + 1]
+; for higher bit depths and m%3 those of ref[idx + 2]; idxq = idx
+%macro ANGULAR_WEIGHTS 3 ; bitdepth, weights, weights of ref[idx + 2]
+    mov             idxd, posd
+    and             idxd, 31
+%if %1 == 8
+    imul            idxd, 255
+    add             idxd, 287           ; fact << 8 | (32 - fact)
+    movd           xm%2, idxd
+    SPLATW          m%2, xm%2
+%else
+    inc             idxd
+    movd           xm%3, idxd
+    neg             idxd
+    add             idxd, 32
+    movd           xm%2, idxd
+    SPLATW          m%2, xm%2
+    SPLATW          m%3, xm%3
+%endif
+    mov             idxd, posd
+    sar             idxd, 5
+    movsxd          idxq, idxd
+%endmacro
+
+; m%1 = the words of the pixels idx + %7 + 1 onwards interpolated with the
+; weights m%3 and m%4 and rounded with m%5 = pw_1024, 4 of them if %8 is set
+; and a register of them otherwise
+%macro ANGULAR_INTERP 8 ; dst, tmp, weights, weights of ref[idx + 2], round, bitdepth, offset, half
+%if %6 == 8
+%if %8
+    movd            m%1, [refq+idxq+%7+1]
+    movd            m%2, [refq+idxq+%7+2]
+%else
+    movh            m%1, [refq+idxq+%7+1]
+    movh            m%2, [refq+idxq+%7+2]
+%endif
+    punpcklbw       m%1, m%2
+    pmaddubsw       m%1, m%3
+%else
+%if %8
+    movh            m%1, [refq+idxq*2+%7*2+2]
+    movh            m%2, [refq+idxq*2+%7*2+4]
+%else
+    movu            m%1, [refq+idxq*2+%7*2+2]
+    movu            m%2, [refq+idxq*2+%7*2+4]
+%endif
+    pmullw          m%1, m%3
+    pmullw          m%2, m%4
+    paddw           m%1, m%2
+%endif
+    pmulhrsw        m%1, m%5
+%endmacro
+
+%macro PRED_ANGULAR_V 2 ; size, bitdepth
+%assign %%ps (%2 + 7) / 8
+cglobal hevc_pred_angular_v_%1_%2, 4, 7, 6, src, ref, stride, angle, pos, idx, y
+%if %2 > 8
+    add          strideq, strideq
+%endif
+    mova              m5, [pw_1024]
+    lea             posd, [angleq-1]
+    mov               yd, %1
+.loop:
+    ANGULAR_WEIGHTS   %2, 3, 4
+%if %1 * %%ps <= 8
+    ANGULAR_INTERP     0, 1, 3, 4, 5, %2, 0, %1 == 4
+%if %2 == 8
+    packuswb          m0, m0
+%if %1 == 4
+    movd           [srcq], m0
+%else
+    movh           [srcq], m0
+%endif
+%else
+    movh           [srcq], m0
+%endif
+%else
+%assign %%i 0
+%rep %1 * %%ps / mmsize
+%if %2 == 8
+    movu              m0, [refq+idxq+%%i+1]
+    movu              m1, [refq+idxq+%%i+2]
+    punpckhbw         m2, m0, m1
+    punpcklbw         m0, m1
+    pmaddubsw         m0, m3
+    pmaddubsw         m2, m3
+    pmulhrsw          m0, m5
+    pmulhrsw          m2, m5
+    packuswb          m0, m2
+%else
+    ANGULAR_INTERP     0, 1, 3, 4, 5, %2, %%i / 2, 0
+%endif
+    movu   [srcq+%%i], m0
+%assign %%i %%i + mmsize
+%endrep
+%endif
+    add             srcq, strideq
+    add             posd, angled
+    dec               yd
+    jg .loop
+    RET
+%endmacro
+
+; predict column %1 of the block into m%1 and move to the next column
+%macro ANGULAR_COLUMN 7 ; column, tmp, weights, weights of ref[idx + 2], round, bitdepth, half
+    ANGULAR_WEIGHTS   %6, %3, %4
+    ANGULAR_INTERP    %1, %2, %3, %4, %5, %6, 0, %7
+    add             posd, angled
+%endmacro
+
+%macro PRED_ANGULAR_H 2 ; size, bitdepth
+%assign %%ps (%2 + 7) / 8
+%if %1 == 4
+cglobal hevc_pred_angular_h_4_%2, 4, 7, 8, src, ref, stride, angle, pos, idx, stride3
+%if %2 > 8
+    add          strideq, strideq
+%endif
+    mova              m4, [pw_1024]
+    lea             posd, [angleq-1]
+    lea         stride3q, [strideq*3]
+    ANGULAR_COLUMN     0, 7, 5, 6, 4, %2, 1
+    ANGULAR_COLUMN     1, 7, 5, 6, 4, %2, 1
+    ANGULAR_COLUMN     2, 7, 5, 6, 4, %2, 1
+    ANGULAR_COLUMN     3, 7, 5, 6, 4, %2, 1
+    ; rows 0 and 1 in m0, 2 and 3 in m1
+    punpcklwd         m0, m1
+    punpcklwd         m2, m3
+    punpckhdq         m1, m0, m2
+    punpckldq         m0, m2
+%if %2 == 8
+    packuswb          m0, m1
+    movd   [srcq+strideq*0], m0
+    pextrd [srcq+strideq*1], m0, 1
+    pextrd [srcq+strideq*2], m0, 2
+    pextrd [srcq+stride3q ], m0, 3
+%else
+    movh   [srcq+strideq*0], m0
+    movhps [srcq+strideq*1], m0
+    movh   [srcq+strideq*2], m1
+    movhps [srcq+stride3q ], m1
+%endif
+    RET
+%else
+cglobal hevc_pred_angular_h_%1_%2, 4, 10, 12, src, ref, stride, angle, pos, idx, x, y, dst, xpos
+%if %2 > 8
+    add          strideq, strideq
+%endif
+    mova             m10, [pw_1024]
+    lea            xposd, [angleq-1]
+    mov               xd, %1 / 8
+.loop_x:
+    mov             dstq, srcq
+    mov               yd, %1 / 8
+.loop_y:
+    ; the 8 columns of an 8x8 block, transposed into its rows
+    mov             posd, xposd
+    ANGULAR_COLUMN     0, 9, 11, 8, 10, %2, 0
+    ANGULAR_COLUMN     1, 9, 11, 8, 10, %2, 0
+    ANGULAR_COLUMN     2, 9, 11, 8, 10, %2, 0
+    ANGULAR_COLUMN     3, 9, 11, 8, 10, %2, 0
+    ANGULAR_COLUMN     4, 9, 11, 8, 10, %2, 0
+    ANGULAR_COLUMN     5, 9, 11, 8, 10, %2, 0
+    ANGULAR_COLUMN     6, 9, 11, 8, 10, %2, 0
+    ANGULAR_COLUMN     7, 9, 11, 8, 10, %2, 0
+    TRANSPOSE8x8W      0, 1, 2, 3, 4, 5, 6, 7, 8
+%if %2 == 8
+    packuswb          m0, m1
+    packuswb          m2, m3
+    packuswb          m4, m5
+    packuswb          m6, m7
+    movh   [dstq], m0
+    movhps [dstq+strideq], m0
+    lea             dstq, [dstq+strideq*2]
+    movh   [dstq], m2
+    movhps [dstq+strideq], m2
+    lea             dstq, [dstq+strideq*2]
+    movh   [dstq], m4
+    movhps [dstq+strideq], m4
+    lea             dstq, [dstq+strideq*2]
+    movh   [dstq], m6
+    movhps [dstq+strideq], m6
+    lea             dstq, [dstq+strideq*2]
+%else
+%assign %%i 0
+%rep 8
+    movu   [dstq], m %+ %%i
+    add             dstq, strideq
+%assign %%i %%i + 1
+%endrep
+%endif
+    add             refq, 8 * %%ps
+    dec               yd
+    jg .loop_y
+    sub             refq, %1 * %%ps
+    add             srcq, 8 * %%ps
+    lea            xposd, [xposq+angleq*8]
+    dec               xd
+    jg .loop_x
+    RET
+%endif
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse4
+PRED_PLANAR  4, 2, 8
+PRED_PLANAR  8, 3, 8
+PRED_PLANAR 16, 4, 8
+PRED_PLANAR 32, 5, 8
+PRED_PLANAR  4, 2, 10
+PRED_PLANAR  8, 3, 10
+PRED_PLANAR 16, 4, 10
+PRED_PLANAR 32, 5, 10
+
+PRED_DC  4, 2, 8
+PRED_DC  8, 3, 8
+PRED_DC 16, 4, 8
+PRED_DC 32, 5, 8
+PRED_DC  4, 2, 10
+PRED_DC  8, 3, 10
+PRED_DC 16, 4, 10
+PRED_DC 32, 5, 10
+
+PRED_ANGULAR_V  4, 8
+PRED_ANGULAR_V  8, 8
+PRED_ANGULAR_V 16, 8
+PRED_ANGULAR_V 32, 8
+PRED_ANGULAR_V  4, 10
+PRED_ANGULAR_V  8, 10
+PRED_ANGULAR_V 16, 10
+PRED_ANGULAR_V 32, 10
+PRED_ANGULAR_H  4, 8
+PRED_ANGULAR_H  8, 8
+PRED_ANGULAR_H 16, 8
+PRED_ANGULAR_H 32, 8
+PRED_ANGULAR_H  4, 10
+PRED_ANGULAR_H  8, 10
+PRED_ANGULAR_H 16, 10
+PRED_ANGULAR_H 32, 10
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+PRED_ANGULAR_V 32, 8
+PRED_ANGULAR_V 16, 10
+PRED_ANGULAR_V 32, 10
+%endif
+%endif
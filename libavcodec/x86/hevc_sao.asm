@@ -0,0 +1,266 @@
+;******************************************************************************
+;* SIMD optimized SAO functions for HEVC decoding
+;*
+;* This file is part of Libav.
+;*
+;* Libav is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* Libav is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with Libav; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pw_sao_2:        times 16 dw 2
+pw_sao_4:        times 16 dw 4
+pw_sao_31:       times 16 dw 31
+pw_sao_1023:     times 16 dw 1023
+
+; SaoOffsetVal index for each value of 2 + sign(c - a) + sign(c - b)
+pb_edge_idx:     db 1, 2, 0, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+
+; neighbour position (x, y) for each SAO edge class, the other neighbour
+; is at (-x, -y)
+sao_edge_pos:    db -1,  0
+                 db  0, -1
+                 db -1, -1
+                 db  1, -1
+
+SECTION .text
+
+; All the filters work on words, 8 pixels per xmm register and 16 pixels per
+; ymm register. The offsets are looked up with pshufb from a byte table.
+
+%macro LOAD_PIXELS 3 ; dst, src, bitdepth
+%if %3 == 8
+    pmovzxbw          %1, %2
+%else
+    movu              %1, %2
+%endif
+%endmacro
+
+; clip the words in m%1 and pack them to pixels, m5 must be zero for 10-bit
+%macro PACK_PIXELS 2 ; reg, bitdepth
+%if %2 == 8
+    packuswb         m%1, m%1
+%if mmsize == 32
+    vpermq           m%1, m%1, q3120
+%endif
+%else
+    CLIPW            m%1, m5, [pw_sao_1023]
+%endif
+%endmacro
+
+%macro STORE_PIXELS 3 ; dst, reg, bitdepth
+%if %3 == 8 && mmsize == 32
+    movu              %1, xm%2
+%elif %3 == 8
+    movh              %1, m%2
+%else
+    movu              %1, m%2
+%endif
+%endmacro
+
+; store the first tmpd (less than mmsize / 2) pixels of m%1 to [xq]
+%macro STORE_PARTIAL 2 ; reg, bitdepth
+%assign %%ps (%2 + 7) / 8
+%if mmsize == 32
+    test            tmpd, 8
+    jz %%store4
+%if %2 == 8
+    movq           [xq], xm%1
+    psrldq          xm%1, 8
+%else
+    movu           [xq], xm%1
+    vextracti128    xm%1, m%1, 1
+%endif
+    add               xq, 8 * %%ps
+%%store4:
+%endif
+    test            tmpd, 4
+    jz %%store2
+%if %2 == 8
+    movd           [xq], xm%1
+%else
+    movq           [xq], xm%1
+%endif
+    psrldq          xm%1, 4 * %%ps
+    add               xq, 4 * %%ps
+%%store2:
+    test            tmpd, 2
+    jz %%store1
+%if %2 == 8
+    pextrw         [xq], xm%1, 0
+%else
+    movd           [xq], xm%1
+%endif
+    psrldq          xm%1, 2 * %%ps
+    add               xq, 2 * %%ps
+%%store1:
+    test            tmpd, 1
+    jz %%end
+%if %2 == 8
+    pextrb         [xq], xm%1, 0
+%else
+    pextrw         [xq], xm%1, 0
+%endif
+%%end:
+%endmacro
+
+; add the offsets of the byte indices in m3 to the pixels in m2, m0 = table
+%macro ADD_OFFSETS 0
+    packuswb          m3, m3
+    pshufb            m4, m0, m3
+%if mmsize == 32
+    vpermq            m4, m4, q3120
+%endif
+    pmovsxbw          m4, xm4
+    paddw             m2, m4
+%endmacro
+
+; Loop over the rows of the block, processing mmsize / 2 pixels at a time;
+; the last pixels of each row are computed for a full register and only the
+; remaining ones are stored. %2 is the name of the macro computing the
+; filtered pixels at offset xq of the row in m2. If %3 is set, the
+; neighbour row pointers naq and nbq are advanced along with srcq.
+%macro SAO_LOOP 3 ; bitdepth, compute macro, edge
+%assign %%ps (%1 + 7) / 8
+%if %1 > 8
+    pxor              m5, m5
+%endif
+.loop_y:
+    xor               xq, xq
+    mov             tmpd, widthd
+    cmp             tmpd, mmsize / 2
+    jl .tail
+.loop_x:
+    %2                %1
+    PACK_PIXELS        2, %1
+    STORE_PIXELS [dstq+xq], 2, %1
+    add               xq, mmsize / 2 * %%ps
+    sub             tmpd, mmsize / 2
+    cmp             tmpd, mmsize / 2
+    jge .loop_x
+.tail:
+    test            tmpd, tmpd
+    jz .next
+    %2                %1
+    PACK_PIXELS        2, %1
+    add               xq, dstq
+    STORE_PARTIAL      2, %1
+.next:
+    add             dstq, strideq
+    add             srcq, strideq
+%if %3
+    add              naq, strideq
+    add              nbq, strideq
+%endif
+    dec          heightd
+    jg .loop_y
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_hevc_sao_band_filter_<depth>_<opt>(uint8_t *dst, uint8_t *src,
+;                                            ptrdiff_t stride,
+;                                            const int16_t *sao_offset_val,
+;                                            int sao_left_class,
+;                                            int width, int height)
+;------------------------------------------------------------------------------
+
+%macro SAO_BAND_COMPUTE 1 ; bitdepth
+    LOAD_PIXELS       m2, [srcq+xq], %1
+    psrlw             m3, m2, %1 - 5
+    psubw             m3, m1
+    pand              m3, [pw_sao_31]
+    pminsw            m3, [pw_sao_4]  ; bands outside of the 4 offsets map to 0
+    ADD_OFFSETS
+%endmacro
+
+%macro SAO_BAND_FILTER 1 ; bitdepth
+cglobal hevc_sao_band_filter_%1, 7, 9, 6, dst, src, stride, offset, left, width, height, x, tmp
+    movq             xm0, [offsetq+2]
+    packsswb         xm0, xm0
+    movd             xm1, leftd
+%if mmsize == 32
+    vpbroadcastq      m0, xm0
+%endif
+    SPLATW            m1, xm1
+    SAO_LOOP          %1, SAO_BAND_COMPUTE, 0
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_hevc_sao_edge_filter_<depth>_<opt>(uint8_t *dst, uint8_t *src,
+;                                            ptrdiff_t stride,
+;                                            const int16_t *sao_offset_val,
+;                                            int sao_eo_class,
+;                                            int width, int height)
+;------------------------------------------------------------------------------
+
+%macro SAO_EDGE_COMPUTE 1 ; bitdepth
+    LOAD_PIXELS       m2, [srcq+xq], %1
+    LOAD_PIXELS       m3, [naq+xq], %1
+    LOAD_PIXELS       m4, [nbq+xq], %1
+    pcmpgtw           m6, m2, m3
+    pcmpgtw           m3, m2
+    psubw             m3, m6        ; sign(c - a)
+    pcmpgtw           m6, m2, m4
+    pcmpgtw           m4, m2
+    psubw             m4, m6        ; sign(c - b)
+    paddw             m3, m4
+    paddw             m3, [pw_sao_2]
+    ADD_OFFSETS
+%endmacro
+
+%macro SAO_EDGE_FILTER 1 ; bitdepth
+cglobal hevc_sao_edge_filter_%1, 7, 11, 7, dst, src, stride, offset, eo, width, height, x, tmp, na, nb
+    movq             xm0, [offsetq]
+    pinsrw           xm0, [offsetq+8], 4
+    packsswb         xm0, xm0
+    pshufb           xm0, [pb_edge_idx]
+%if mmsize == 32
+    vpbroadcastq      m0, xm0
+%endif
+
+    lea             tmpq, [sao_edge_pos]
+    movsxd           eoq, eod
+    movsx            naq, byte [tmpq+eoq*2+1]
+    movsx            eoq, byte [tmpq+eoq*2]
+    imul             naq, strideq
+%if %1 > 8
+    add              eoq, eoq
+%endif
+    add              naq, eoq       ; offset of the first neighbour
+    mov              nbq, srcq
+    sub              nbq, naq
+    add              naq, srcq
+    SAO_LOOP          %1, SAO_EDGE_COMPUTE, 1
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse4
+SAO_BAND_FILTER 8
+SAO_BAND_FILTER 10
+SAO_EDGE_FILTER 8
+SAO_EDGE_FILTER 10
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SAO_BAND_FILTER 8
+SAO_BAND_FILTER 10
+SAO_EDGE_FILTER 8
+SAO_EDGE_FILTER 10
+%endif
+%endif
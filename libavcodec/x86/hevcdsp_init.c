@@ -110,6 +110,23 @@ void ff_hevc_add_residual_32_10_sse2(uint8_t *dst, int16_t *res, ptrdiff_t strid
 void ff_hevc_add_residual_16_10_avx2(uint8_t *dst, int16_t *res, ptrdiff_t stride);
 void ff_hevc_add_residual_32_10_avx2(uint8_t *dst, int16_t *res, ptrdiff_t stride);
 
+#define SAO_FUNCS(depth, opt)                                                           \
+void ff_hevc_sao_band_filter_ ## depth ## _ ## opt(uint8_t *dst, uint8_t *src,          \
+                                                  ptrdiff_t stride,                     \
+                                                  const int16_t *sao_offset_val,        \
+                                                  int sao_left_class,                   \
+                                                  int width, int height);               \
+void ff_hevc_sao_edge_filter_ ## depth ## _ ## opt(uint8_t *dst, uint8_t *src,          \
+                                                  ptrdiff_t stride,                     \
+                                                  const int16_t *sao_offset_val,        \
+                                                  int sao_eo_class,                     \
+                                                  int width, int height);
+
+SAO_FUNCS(8,  sse4)
+SAO_FUNCS(10, sse4)
+SAO_FUNCS(8,  avx2)
+SAO_FUNCS(10, avx2)
+
 #define GET_PIXELS(width, depth, cf)                                                                      \
 void ff_hevc_get_pixels_ ## width ## _ ## depth ## _ ## cf(int16_t *dst, ptrdiff_t dststride,             \
                                                            uint8_t *src, ptrdiff_t srcstride,             \
@@ -395,6 +412,8 @@ void ff_hevc_dsp_init_x86(HEVCDSPContext *c, const int bit_depth)
             SET_CHROMA_FUNCS(weighted_pred_chroma,     ff_hevc_put_weighted_pred,     8, sse4);
             SET_LUMA_FUNCS(weighted_pred_avg,          ff_hevc_put_weighted_pred_avg, 8, sse4);
             SET_CHROMA_FUNCS(weighted_pred_avg_chroma, ff_hevc_put_weighted_pred_avg, 8, sse4);
+            c->sao_band_filter = ff_hevc_sao_band_filter_8_sse4;
+            c->sao_edge_filter = ff_hevc_sao_edge_filter_8_sse4;
         }
 
         if (EXTERNAL_AVX(cpu_flags)) {
@@ -408,6 +427,8 @@ void ff_hevc_dsp_init_x86(HEVCDSPContext *c, const int bit_depth)
         if (EXTERNAL_AVX2(cpu_flags)) {
             c->idct_dc[2] = ff_hevc_idct_16x16_dc_8_avx2;
             c->idct_dc[3] = ff_hevc_idct_32x32_dc_8_avx2;
+            c->sao_band_filter = ff_hevc_sao_band_filter_8_avx2;
+            c->sao_edge_filter = ff_hevc_sao_edge_filter_8_avx2;
         }
     } else if (bit_depth == 10) {
         if (EXTERNAL_SSE2(cpu_flags)) {
@@ -423,6 +444,8 @@ void ff_hevc_dsp_init_x86(HEVCDSPContext *c, const int bit_depth)
             SET_CHROMA_FUNCS(weighted_pred_chroma,     ff_hevc_put_weighted_pred,     10, sse4);
             SET_LUMA_FUNCS(weighted_pred_avg,          ff_hevc_put_weighted_pred_avg, 10, sse4);
             SET_CHROMA_FUNCS(weighted_pred_avg_chroma, ff_hevc_put_weighted_pred_avg, 10, sse4);
+            c->sao_band_filter = ff_hevc_sao_band_filter_10_sse4;
+            c->sao_edge_filter = ff_hevc_sao_edge_filter_10_sse4;
         }
         if (EXTERNAL_AVX(cpu_flags)) {
 #if HAVE_AVX_EXTERNAL
@@ -439,6 +462,8 @@ void ff_hevc_dsp_init_x86(HEVCDSPContext *c, const int bit_depth)
         if (EXTERNAL_AVX2(cpu_flags)) {
             c->idct_dc[2] = ff_hevc_idct_16x16_dc_10_avx2;
             c->idct_dc[3] = ff_hevc_idct_32x32_dc_10_avx2;
+            c->sao_band_filter = ff_hevc_sao_band_filter_10_avx2;
+            c->sao_edge_filter = ff_hevc_sao_edge_filter_10_avx2;
         }
     }
 #endif /* ARCH_X86_64 */
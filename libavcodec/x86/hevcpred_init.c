@@ -0,0 +1,211 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "config.h"
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libavcodec/hevcdec.h"
+
+#define PRED_FUNCS(size, depth, opt)                                                    \
+void ff_hevc_pred_planar_ ## size ## _ ## depth ## _ ## opt(uint8_t *src,               \
+                                                            const uint8_t *top,         \
+                                                            const uint8_t *left,        \
+                                                            ptrdiff_t stride);          \
+void ff_hevc_pred_dc_ ## size ## _ ## depth ## _ ## opt(uint8_t *src,                   \
+                                                        const uint8_t *top,             \
+                                                        const uint8_t *left,            \
+                                                        ptrdiff_t stride, int c_idx);
+
+#define PRED_DC(depth, opt)                                                     \
+PRED_FUNCS(4,  depth, opt)                                                      \
+PRED_FUNCS(8,  depth, opt)                                                      \
+PRED_FUNCS(16, depth, opt)                                                      \
+PRED_FUNCS(32, depth, opt)                                                      \
+                                                                                \
+static void pred_dc_ ## depth ## _ ## opt(uint8_t *src, const uint8_t *top,     \
+                                          const uint8_t *left,                  \
+                                          ptrdiff_t stride,                     \
+                                          int log2_size, int c_idx)             \
+{                                                                               \
+    static void (* const pred_dc[4])(uint8_t *src, const uint8_t *top,          \
+                                     const uint8_t *left, ptrdiff_t stride,     \
+                                     int c_idx) = {                             \
+        ff_hevc_pred_dc_4_  ## depth ## _ ## opt,                               \
+        ff_hevc_pred_dc_8_  ## depth ## _ ## opt,                               \
+        ff_hevc_pred_dc_16_ ## depth ## _ ## opt,                               \
+        ff_hevc_pred_dc_32_ ## depth ## _ ## opt,                               \
+    };                                                                          \
+    pred_dc[log2_size - 2](src, top, left, stride, c_idx);                      \
+}
+
+#define ANGULAR_FUNC(dir, size, depth, opt)                                     \
+void ff_hevc_pred_angular_ ## dir ## _ ## size ## _ ## depth ## _ ## opt(       \
+    uint8_t *src, const uint8_t *ref, ptrdiff_t stride, int angle);
+
+#define PRED_ANGULAR(size, depth, opt_v, opt_h)                                 \
+static void pred_angular_ ## size ## _ ## depth ## _ ## opt_v(                  \
+    uint8_t *src, const uint8_t *top, const uint8_t *left,                      \
+    ptrdiff_t stride, int c_idx, int mode)                                      \
+{                                                                               \
+    pred_angular(src, top, left, stride, c_idx, mode, size, depth,              \
+                 ff_hevc_pred_angular_v_ ## size ## _ ## depth ## _ ## opt_v,   \
+                 ff_hevc_pred_angular_h_ ## size ## _ ## depth ## _ ## opt_h);  \
+}
+
+#define ANGULAR_FUNCS(depth, opt)                                               \
+ANGULAR_FUNC(v, 4,  depth, opt)                                                 \
+ANGULAR_FUNC(v, 8,  depth, opt)                                                 \
+ANGULAR_FUNC(v, 16, depth, opt)                                                 \
+ANGULAR_FUNC(v, 32, depth, opt)                                                 \
+ANGULAR_FUNC(h, 4,  depth, opt)                                                 \
+ANGULAR_FUNC(h, 8,  depth, opt)                                                 \
+ANGULAR_FUNC(h, 16, depth, opt)                                                 \
+ANGULAR_FUNC(h, 32, depth, opt)                                                 \
+PRED_ANGULAR(4,  depth, opt, opt)                                               \
+PRED_ANGULAR(8,  depth, opt, opt)                                               \
+PRED_ANGULAR(16, depth, opt, opt)                                               \
+PRED_ANGULAR(32, depth, opt, opt)
+
+#if ARCH_X86_64
+typedef void (*pred_angular_func)(uint8_t *src, const uint8_t *ref,
+                                  ptrdiff_t stride, int angle);
+
+/* Build the reference array as the C code does, the prediction itself is
+ * done by the v functions for the vertical modes and by the h functions,
+ * which transpose their output, for the horizontal ones. */
+static av_always_inline void pred_angular(uint8_t *src, const uint8_t *top,
+                                          const uint8_t *left,
+                                          ptrdiff_t stride, int c_idx,
+                                          int mode, int size, int bit_depth,
+                                          pred_angular_func pred_v,
+                                          pred_angular_func pred_h)
+{
+    static const int8_t intra_pred_angle[] = {
+         32,  26,  21,  17, 13,  9,  5, 2, 0, -2, -5, -9, -13, -17, -21, -26, -32,
+        -26, -21, -17, -13, -9, -5, -2, 0, 2,  5,  9, 13,  17,  21,  26,  32
+    };
+    static const int16_t inv_angle[] = {
+        -4096, -1638, -910, -630, -482, -390, -315, -256, -315, -390, -482,
+        -630, -910, -1638, -4096
+    };
+    uint16_t ref_array[3 * 32 + 1];
+    int pixel_shift   = bit_depth > 8;
+    int angle         = intra_pred_angle[mode - 2];
+    int last          = (size * angle) >> 5;
+    const uint8_t *ref  = (mode >= 18 ? top  : left) - (1 << pixel_shift);
+    const uint8_t *side = mode >= 18 ? left : top;
+    int i;
+
+    if (angle < 0 && last < -1) {
+        uint8_t *ref_tmp = (uint8_t *)ref_array + (size << pixel_shift);
+
+        memcpy(ref_tmp, ref, (size + 1) << pixel_shift);
+        for (i = last; i <= -1; i++) {
+            int pos = -1 + ((i * inv_angle[mode - 11] + 128) >> 8);
+            if (pixel_shift)
+                AV_WN16(ref_tmp + i * 2, AV_RN16(side + pos * 2));
+            else
+                ref_tmp[i] = side[pos];
+        }
+        ref = ref_tmp;
+    }
+
+    if (mode >= 18)
+        pred_v(src, ref, stride, angle);
+    else
+        pred_h(src, ref, stride, angle);
+
+    if ((mode == 26 || mode == 10) && c_idx == 0 && size < 32) {
+        /* the first column for mode 26, the first row for mode 10 */
+        ptrdiff_t step = mode == 26 ? stride : 1;
+        const uint8_t *edge = mode == 26 ? left : top;
+        const uint8_t *base = mode == 26 ? top  : left;
+
+        for (i = 0; i < size; i++) {
+            if (pixel_shift) {
+                int val = AV_RN16(base) + ((AV_RN16(edge + i * 2) -
+                                            AV_RN16(edge - 2)) >> 1);
+                AV_WN16(src + i * step * 2, av_clip_uintp2(val, bit_depth));
+            } else {
+                src[i * step] = av_clip_uint8(base[0] + ((edge[i] - edge[-1]) >> 1));
+            }
+        }
+    }
+}
+
+PRED_DC(8,  sse4)
+PRED_DC(10, sse4)
+ANGULAR_FUNCS(8,  sse4)
+ANGULAR_FUNCS(10, sse4)
+
+#if HAVE_AVX2_EXTERNAL
+/* only the rows of the vertical modes fill 256-bit registers */
+ANGULAR_FUNC(v, 32, 8,  avx2)
+ANGULAR_FUNC(v, 16, 10, avx2)
+ANGULAR_FUNC(v, 32, 10, avx2)
+PRED_ANGULAR(32, 8,  avx2, sse4)
+PRED_ANGULAR(16, 10, avx2, sse4)
+PRED_ANGULAR(32, 10, avx2, sse4)
+#endif
+#endif
+
+#define SET_PRED_FUNCS(depth, opt)                                        \
+    hpc->pred_planar[0]  = ff_hevc_pred_planar_4_  ## depth ## _ ## opt;  \
+    hpc->pred_planar[1]  = ff_hevc_pred_planar_8_  ## depth ## _ ## opt;  \
+    hpc->pred_planar[2]  = ff_hevc_pred_planar_16_ ## depth ## _ ## opt;  \
+    hpc->pred_planar[3]  = ff_hevc_pred_planar_32_ ## depth ## _ ## opt;  \
+    hpc->pred_dc         = pred_dc_ ## depth ## _ ## opt;                 \
+    hpc->pred_angular[0] = pred_angular_4_  ## depth ## _ ## opt;         \
+    hpc->pred_angular[1] = pred_angular_8_  ## depth ## _ ## opt;         \
+    hpc->pred_angular[2] = pred_angular_16_ ## depth ## _ ## opt;         \
+    hpc->pred_angular[3] = pred_angular_32_ ## depth ## _ ## opt
+
+av_cold void ff_hevc_pred_init_x86(HEVCPredContext *hpc, int bit_depth)
+{
+#if ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (bit_depth == 8) {
+        if (EXTERNAL_SSE4(cpu_flags)) {
+            SET_PRED_FUNCS(8, sse4);
+        }
+#if HAVE_AVX2_EXTERNAL
+        if (EXTERNAL_AVX2(cpu_flags)) {
+            hpc->pred_angular[3] = pred_angular_32_8_avx2;
+        }
+#endif
+    } else if (bit_depth == 10) {
+        if (EXTERNAL_SSE4(cpu_flags)) {
+            SET_PRED_FUNCS(10, sse4);
+        }
+#if HAVE_AVX2_EXTERNAL
+        if (EXTERNAL_AVX2(cpu_flags)) {
+            hpc->pred_angular[2] = pred_angular_16_10_avx2;
+            hpc->pred_angular[3] = pred_angular_32_10_avx2;
+        }
+#endif
+    }
+#endif /* ARCH_X86_64 */
+}
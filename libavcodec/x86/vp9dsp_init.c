@@ -241,6 +241,79 @@ lpf_funcs(88, 16, avx);
 
 #undef lpf_funcs
 
+#define ipred_func(type, sz, opt)                                               \
+void ff_vp9_ipred_ ## type ## _ ## sz ## x ## sz ## _ ## opt(uint8_t *dst,      \
+                                                             ptrdiff_t stride,  \
+                                                             const uint8_t *l,  \
+                                                             const uint8_t *a)
+
+#define ipred_dc_funcs(sz, opt) \
+    ipred_func(dc,      sz, opt); \
+    ipred_func(dc_left, sz, opt); \
+    ipred_func(dc_top,  sz, opt)
+
+#define ipred_dir_funcs(sz, opt) \
+    ipred_func(dl, sz, opt); \
+    ipred_func(dr, sz, opt); \
+    ipred_func(vl, sz, opt); \
+    ipred_func(vr, sz, opt); \
+    ipred_func(hd, sz, opt); \
+    ipred_func(hu, sz, opt)
+
+ipred_func(v, 16, sse);
+ipred_func(v, 32, sse);
+ipred_func(v, 32, avx);
+ipred_func(h,  4, ssse3);
+ipred_func(h,  8, sse2);
+ipred_func(h, 16, ssse3);
+ipred_func(h, 32, ssse3);
+ipred_func(h, 32, avx2);
+ipred_dc_funcs( 4, ssse3);
+ipred_dc_funcs( 8, ssse3);
+ipred_dc_funcs(16, ssse3);
+ipred_dc_funcs(32, ssse3);
+ipred_dc_funcs(32, avx2);
+ipred_func(tm,  4, ssse3);
+ipred_func(tm,  8, ssse3);
+ipred_func(tm, 16, ssse3);
+ipred_func(tm, 32, ssse3);
+ipred_func(tm, 32, avx2);
+ipred_dir_funcs( 4, ssse3);
+ipred_dir_funcs( 8, ssse3);
+ipred_dir_funcs(16, ssse3);
+ipred_dir_funcs(32, ssse3);
+ipred_dir_funcs(32, avx2);
+
+#undef ipred_dc_funcs
+#undef ipred_dir_funcs
+#undef ipred_func
+
+#define itxfm_func(typea, typeb, sz, opt)                                       \
+void ff_vp9_ ## typea ## _ ## typeb ## _ ## sz ## x ## sz ## _add_ ## opt(uint8_t *dst, \
+                                                                      ptrdiff_t stride, \
+                                                                      int16_t *block,   \
+                                                                      int eob)
+
+#define itxfm_funcs(sz, opt)              \
+    itxfm_func(idct,  idct,  sz, opt);    \
+    itxfm_func(iadst, idct,  sz, opt);    \
+    itxfm_func(idct,  iadst, sz, opt);    \
+    itxfm_func(iadst, iadst, sz, opt)
+
+itxfm_funcs(4, ssse3);
+#if ARCH_X86_64
+itxfm_funcs(8, ssse3);
+itxfm_funcs(16, ssse3);
+itxfm_func(idct, idct, 32, ssse3);
+#if HAVE_AVX2_EXTERNAL
+itxfm_funcs(16, avx2);
+itxfm_func(idct, idct, 32, avx2);
+#endif
+#endif
+
+#undef itxfm_funcs
+#undef itxfm_func
+
 #endif /* HAVE_X86ASM */
 
 av_cold void ff_vp9dsp_init_x86(VP9DSPContext *dsp)
@@ -291,6 +364,35 @@ av_cold void ff_vp9dsp_init_x86(VP9DSPContext *dsp)
     dsp->loop_filter_mix2[1][1][1] = ff_vp9_loop_filter_v_88_16_##opt; \
 } while (0)
 
+#define init_ipred_dc(tx, sz, opt) do { \
+    dsp->intra_pred[tx][DC_PRED]      = ff_vp9_ipred_dc_##sz##x##sz##_##opt;      \
+    dsp->intra_pred[tx][LEFT_DC_PRED] = ff_vp9_ipred_dc_left_##sz##x##sz##_##opt; \
+    dsp->intra_pred[tx][TOP_DC_PRED]  = ff_vp9_ipred_dc_top_##sz##x##sz##_##opt;  \
+} while (0)
+
+#define init_ipred_dir(tx, sz, opt) do { \
+    dsp->intra_pred[tx][DIAG_DOWN_LEFT_PRED]  = ff_vp9_ipred_dl_##sz##x##sz##_##opt; \
+    dsp->intra_pred[tx][DIAG_DOWN_RIGHT_PRED] = ff_vp9_ipred_dr_##sz##x##sz##_##opt; \
+    dsp->intra_pred[tx][VERT_LEFT_PRED]       = ff_vp9_ipred_vl_##sz##x##sz##_##opt; \
+    dsp->intra_pred[tx][VERT_RIGHT_PRED]      = ff_vp9_ipred_vr_##sz##x##sz##_##opt; \
+    dsp->intra_pred[tx][HOR_DOWN_PRED]        = ff_vp9_ipred_hd_##sz##x##sz##_##opt; \
+    dsp->intra_pred[tx][HOR_UP_PRED]          = ff_vp9_ipred_hu_##sz##x##sz##_##opt; \
+} while (0)
+
+#define init_itxfm(tx, sz, opt) do { \
+    dsp->itxfm_add[tx][DCT_DCT]   = ff_vp9_idct_idct_##sz##x##sz##_add_##opt;   \
+    dsp->itxfm_add[tx][ADST_DCT]  = ff_vp9_idct_iadst_##sz##x##sz##_add_##opt;  \
+    dsp->itxfm_add[tx][DCT_ADST]  = ff_vp9_iadst_idct_##sz##x##sz##_add_##opt;  \
+    dsp->itxfm_add[tx][ADST_ADST] = ff_vp9_iadst_iadst_##sz##x##sz##_add_##opt; \
+} while (0)
+
+#define init_idct(tx, sz, opt) do { \
+    dsp->itxfm_add[tx][DCT_DCT]   = \
+    dsp->itxfm_add[tx][ADST_DCT]  = \
+    dsp->itxfm_add[tx][DCT_ADST]  = \
+    dsp->itxfm_add[tx][ADST_ADST] = ff_vp9_idct_idct_##sz##x##sz##_add_##opt; \
+} while (0)
+
     if (EXTERNAL_MMX(cpu_flags)) {
         init_fpel(4, 0,  4, put, mmx);
         init_fpel(3, 0,  8, put, mmx);
@@ -307,6 +409,8 @@ av_cold void ff_vp9dsp_init_x86(VP9DSPContext *dsp)
         init_fpel(2, 0, 16, put, sse);
         init_fpel(1, 0, 32, put, sse);
         init_fpel(0, 0, 64, put, sse);
+        dsp->intra_pred[TX_16X16][VERT_PRED] = ff_vp9_ipred_v_16x16_sse;
+        dsp->intra_pred[TX_32X32][VERT_PRED] = ff_vp9_ipred_v_32x32_sse;
     }
 
     if (EXTERNAL_SSE2(cpu_flags)) {
@@ -316,27 +420,64 @@ av_cold void ff_vp9dsp_init_x86(VP9DSPContext *dsp)
         init_fpel(1, 1, 32, avg, sse2);
         init_fpel(0, 1, 64, avg, sse2);
         init_lpf(sse2);
+        dsp->intra_pred[TX_8X8][HOR_PRED] = ff_vp9_ipred_h_8x8_sse2;
     }
 
     if (EXTERNAL_SSSE3(cpu_flags)) {
         init_subpel3(0, put, ssse3);
         init_subpel3(1, avg, ssse3);
         init_lpf(ssse3);
+        dsp->intra_pred[TX_4X4][HOR_PRED]      = ff_vp9_ipred_h_4x4_ssse3;
+        dsp->intra_pred[TX_16X16][HOR_PRED]    = ff_vp9_ipred_h_16x16_ssse3;
+        dsp->intra_pred[TX_32X32][HOR_PRED]    = ff_vp9_ipred_h_32x32_ssse3;
+        dsp->intra_pred[TX_4X4][TM_VP8_PRED]   = ff_vp9_ipred_tm_4x4_ssse3;
+        dsp->intra_pred[TX_8X8][TM_VP8_PRED]   = ff_vp9_ipred_tm_8x8_ssse3;
+        dsp->intra_pred[TX_16X16][TM_VP8_PRED] = ff_vp9_ipred_tm_16x16_ssse3;
+        init_ipred_dc(TX_4X4,    4, ssse3);
+        init_ipred_dc(TX_8X8,    8, ssse3);
+        init_ipred_dc(TX_16X16, 16, ssse3);
+        init_ipred_dc(TX_32X32, 32, ssse3);
+        init_ipred_dir(TX_4X4,    4, ssse3);
+        init_ipred_dir(TX_8X8,    8, ssse3);
+        init_ipred_dir(TX_16X16, 16, ssse3);
+        init_itxfm(TX_4X4, 4, ssse3);
+        dsp->intra_pred[TX_32X32][DIAG_DOWN_LEFT_PRED]  = ff_vp9_ipred_dl_32x32_ssse3;
+        dsp->intra_pred[TX_32X32][DIAG_DOWN_RIGHT_PRED] = ff_vp9_ipred_dr_32x32_ssse3;
+        dsp->intra_pred[TX_32X32][VERT_LEFT_PRED]       = ff_vp9_ipred_vl_32x32_ssse3;
+        dsp->intra_pred[TX_32X32][VERT_RIGHT_PRED]      = ff_vp9_ipred_vr_32x32_ssse3;
+        dsp->intra_pred[TX_32X32][HOR_UP_PRED]          = ff_vp9_ipred_hu_32x32_ssse3;
+#if ARCH_X86_64
+        dsp->intra_pred[TX_32X32][TM_VP8_PRED]   = ff_vp9_ipred_tm_32x32_ssse3;
+        dsp->intra_pred[TX_32X32][HOR_DOWN_PRED] = ff_vp9_ipred_hd_32x32_ssse3;
+        init_itxfm(TX_8X8, 8, ssse3);
+        init_itxfm(TX_16X16, 16, ssse3);
+        init_idct(TX_32X32, 32, ssse3);
+#endif
     }
 
     if (EXTERNAL_AVX(cpu_flags)) {
         init_fpel(1, 0, 32, put, avx);
         init_fpel(0, 0, 64, put, avx);
         init_lpf(avx);
+        dsp->intra_pred[TX_32X32][VERT_PRED] = ff_vp9_ipred_v_32x32_avx;
     }
 
     if (EXTERNAL_AVX2(cpu_flags)) {
         init_fpel(1, 1, 32, avg, avx2);
         init_fpel(0, 1, 64, avg, avx2);
 
+#if HAVE_AVX2_EXTERNAL
+        dsp->intra_pred[TX_32X32][HOR_PRED]    = ff_vp9_ipred_h_32x32_avx2;
+        dsp->intra_pred[TX_32X32][TM_VP8_PRED] = ff_vp9_ipred_tm_32x32_avx2;
+        init_ipred_dc(TX_32X32, 32, avx2);
+        init_ipred_dir(TX_32X32, 32, avx2);
+#endif /* HAVE_AVX2_EXTERNAL */
+
 #if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
         init_subpel3_32_64(0, put, avx2);
         init_subpel3_32_64(1, avg, avx2);
+        init_itxfm(TX_16X16, 16, avx2);
+        init_idct(TX_32X32, 32, avx2);
 #endif /* ARCH_X86_64 && HAVE_AVX2_EXTERNAL */
     }
 
@@ -344,6 +485,11 @@ av_cold void ff_vp9dsp_init_x86(VP9DSPContext *dsp)
 #undef init_subpel1
 #undef init_subpel2
 #undef init_subpel3
+#undef init_lpf
+#undef init_ipred_dc
+#undef init_ipred_dir
+#undef init_itxfm
+#undef init_idct
 
 #endif /* HAVE_X86ASM */
 }
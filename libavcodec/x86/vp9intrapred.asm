@@ -0,0 +1,1313 @@
+;******************************************************************************
+;* VP9 intra prediction SIMD optimizations
+;*
+;* This file is part of Libav.
+;*
+;* Libav is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* Libav is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with Libav; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pb_1:                times 32 db 1
+pb_15to0:            times 2 db 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+
+; pshufb masks: splat bytes, or zero-extend them to splatted words
+pb_4x0_4x1_4x2_4x3:  db 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3
+pb_0_80:             times 8 db 0, 0x80
+pb_w4x0_4x1:         times 4 db 0, 0x80
+                     times 4 db 1, 0x80
+pb_w4x2_4x3:         times 4 db 2, 0x80
+                     times 4 db 3, 0x80
+
+; pshufb masks: shift down, repeating the last byte of the edge
+pb_1to15_15:         db 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 15
+pb_2to15_2x15:       db 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 15, 15
+pb_0to7_8x7:         db 0, 1, 2, 3, 4, 5, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7
+pb_0to3_12x3:        db 0, 1, 2, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3
+pb_0to5_10x7:        db 0, 1, 2, 3, 4, 5, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7
+pb_2to7_10x7:        db 2, 3, 4, 5, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7
+; pshufb mask: even bytes, then odd bytes
+pb_02468ACE_13579BDF: db 0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15
+
+cextern pw_2
+cextern pw_4
+cextern pw_8
+cextern pw_16
+cextern pw_32
+
+SECTION .text
+
+; The edges are not guaranteed to be aligned, the destination is aligned by
+; the transform size.
+
+INIT_XMM sse
+cglobal vp9_ipred_v_16x16, 4, 6, 1, dst, stride, l, a, stride3, cnt
+    movu            m0, [aq]
+    lea       stride3q, [strideq*3]
+    mov           cntd, 4
+.loop:
+    mova   [dstq+strideq*0], m0
+    mova   [dstq+strideq*1], m0
+    mova   [dstq+strideq*2], m0
+    mova   [dstq+stride3q ], m0
+    lea           dstq, [dstq+strideq*4]
+    dec           cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_v_32x32, 4, 6, 2, dst, stride, l, a, stride3, cnt
+    movu            m0, [aq]
+    movu            m1, [aq+16]
+    lea       stride3q, [strideq*3]
+    mov           cntd, 8
+.loop:
+    mova   [dstq+strideq*0+ 0], m0
+    mova   [dstq+strideq*0+16], m1
+    mova   [dstq+strideq*1+ 0], m0
+    mova   [dstq+strideq*1+16], m1
+    mova   [dstq+strideq*2+ 0], m0
+    mova   [dstq+strideq*2+16], m1
+    mova   [dstq+stride3q + 0], m0
+    mova   [dstq+stride3q +16], m1
+    lea           dstq, [dstq+strideq*4]
+    dec           cntd
+    jg .loop
+    RET
+
+INIT_YMM avx
+cglobal vp9_ipred_v_32x32, 4, 6, 1, dst, stride, l, a, stride3, cnt
+    movu            m0, [aq]
+    lea       stride3q, [strideq*3]
+    mov           cntd, 8
+.loop:
+    mova   [dstq+strideq*0], m0
+    mova   [dstq+strideq*1], m0
+    mova   [dstq+strideq*2], m0
+    mova   [dstq+stride3q ], m0
+    lea           dstq, [dstq+strideq*4]
+    dec           cntd
+    jg .loop
+    RET
+
+INIT_XMM ssse3
+cglobal vp9_ipred_h_4x4, 3, 4, 1, dst, stride, l, stride3
+    movd            m0, [lq]
+    lea       stride3q, [strideq*3]
+    pshufb          m0, [pb_4x0_4x1_4x2_4x3]
+    movd   [dstq+strideq*0], m0
+    psrldq          m0, 4
+    movd   [dstq+strideq*1], m0
+    psrldq          m0, 4
+    movd   [dstq+strideq*2], m0
+    psrldq          m0, 4
+    movd   [dstq+stride3q ], m0
+    RET
+
+INIT_XMM sse2
+cglobal vp9_ipred_h_8x8, 3, 4, 4, dst, stride, l, stride3
+    movq            m0, [lq]
+    lea       stride3q, [strideq*3]
+    punpcklbw       m0, m0
+    punpckhwd       m1, m0, m0
+    punpcklwd       m0, m0
+    punpckhdq       m2, m0, m0
+    punpckldq       m0, m0
+    punpckhdq       m3, m1, m1
+    punpckldq       m1, m1
+    movq   [dstq+strideq*0], m0
+    movhps [dstq+strideq*1], m0
+    movq   [dstq+strideq*2], m2
+    movhps [dstq+stride3q ], m2
+    lea           dstq, [dstq+strideq*4]
+    movq   [dstq+strideq*0], m1
+    movhps [dstq+strideq*1], m1
+    movq   [dstq+strideq*2], m3
+    movhps [dstq+stride3q ], m3
+    RET
+
+; splat the next 4 left pixels of m0 into full rows, lowest byte first
+%macro H_XMM_ROWS 1 ; row width
+    pshufb          m2, m0, m1
+    psrldq          m0, 1
+    pshufb          m3, m0, m1
+    psrldq          m0, 1
+    mova   [dstq+strideq*0], m2
+    mova   [dstq+strideq*1], m3
+%if %1 == 32
+    mova [dstq+strideq*0+16], m2
+    mova [dstq+strideq*1+16], m3
+%endif
+    pshufb          m2, m0, m1
+    psrldq          m0, 1
+    pshufb          m3, m0, m1
+    psrldq          m0, 1
+    mova   [dstq+strideq*2], m2
+    mova   [dstq+stride3q ], m3
+%if %1 == 32
+    mova [dstq+strideq*2+16], m2
+    mova [dstq+stride3q +16], m3
+%endif
+    lea           dstq, [dstq+strideq*4]
+%endmacro
+
+INIT_XMM ssse3
+cglobal vp9_ipred_h_16x16, 3, 5, 4, dst, stride, l, stride3, cnt
+    movu            m0, [lq]
+    pxor            m1, m1
+    lea       stride3q, [strideq*3]
+    mov           cntd, 4
+.loop:
+    H_XMM_ROWS      16
+    dec           cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_h_32x32, 3, 5, 4, dst, stride, l, stride3, cnt
+    pxor            m1, m1
+    lea       stride3q, [strideq*3]
+    mov           cntd, 8
+.loop:
+    test          cntd, 3
+    jnz .rows
+    movu            m0, [lq]
+    add             lq, 16
+.rows:
+    H_XMM_ROWS      32
+    dec           cntd
+    jg .loop
+    RET
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+cglobal vp9_ipred_h_32x32, 3, 5, 4, dst, stride, l, stride3, cnt
+    lea       stride3q, [strideq*3]
+    mov           cntd, 8
+.loop:
+    vpbroadcastb    m0, [lq+0]
+    vpbroadcastb    m1, [lq+1]
+    vpbroadcastb    m2, [lq+2]
+    vpbroadcastb    m3, [lq+3]
+    mova   [dstq+strideq*0], m0
+    mova   [dstq+strideq*1], m1
+    mova   [dstq+strideq*2], m2
+    mova   [dstq+stride3q ], m3
+    add             lq, 4
+    lea           dstq, [dstq+strideq*4]
+    dec           cntd
+    jg .loop
+    RET
+%endif
+
+; dc, dc_left and dc_top share everything but the loaded edges and rounding
+
+INIT_XMM ssse3
+%macro DC_4x4_FN 3 ; name, shift, rounding
+cglobal vp9_ipred_%1_4x4, 4, 5, 2, dst, stride, l, a, stride3
+%ifidn %1, dc
+    movd            m0, [lq]
+    movd            m1, [aq]
+    punpckldq       m0, m1
+%elifidn %1, dc_left
+    movd            m0, [lq]
+%else
+    movd            m0, [aq]
+%endif
+    pxor            m1, m1
+    lea       stride3q, [strideq*3]
+    psadbw          m0, m1
+    paddw           m0, [%3]
+    psrlw           m0, %2
+    pshufb          m0, m1
+    movd   [dstq+strideq*0], m0
+    movd   [dstq+strideq*1], m0
+    movd   [dstq+strideq*2], m0
+    movd   [dstq+stride3q ], m0
+    RET
+%endmacro
+
+DC_4x4_FN dc,      3, pw_4
+DC_4x4_FN dc_left, 2, pw_2
+DC_4x4_FN dc_top,  2, pw_2
+
+%macro DC_8x8_FN 3 ; name, shift, rounding
+cglobal vp9_ipred_%1_8x8, 4, 5, 3, dst, stride, l, a, stride3
+%ifidn %1, dc
+    movq            m0, [lq]
+    movhps          m0, [aq]
+%elifidn %1, dc_left
+    movq            m0, [lq]
+%else
+    movq            m0, [aq]
+%endif
+    pxor            m1, m1
+    lea       stride3q, [strideq*3]
+    psadbw          m0, m1
+%ifidn %1, dc
+    movhlps         m2, m0
+    paddw           m0, m2
+%endif
+    paddw           m0, [%3]
+    psrlw           m0, %2
+    pshufb          m0, m1
+    movq   [dstq+strideq*0], m0
+    movq   [dstq+strideq*1], m0
+    movq   [dstq+strideq*2], m0
+    movq   [dstq+stride3q ], m0
+    lea           dstq, [dstq+strideq*4]
+    movq   [dstq+strideq*0], m0
+    movq   [dstq+strideq*1], m0
+    movq   [dstq+strideq*2], m0
+    movq   [dstq+stride3q ], m0
+    RET
+%endmacro
+
+DC_8x8_FN dc,      4, pw_8
+DC_8x8_FN dc_left, 3, pw_4
+DC_8x8_FN dc_top,  3, pw_4
+
+; %1 = name, %2 = size, %3 = shift, %4 = rounding
+%macro DC_FN 4
+cglobal vp9_ipred_%1_%2x%2, 4, 6, 4, dst, stride, l, a, stride3, cnt
+    pxor            m1, m1
+%ifidn %1, dc_top
+    movu            m0, [aq]
+%else
+    movu            m0, [lq]
+%endif
+    psadbw          m0, m1
+%if %2 > mmsize
+%ifidn %1, dc_top
+    movu            m2, [aq+16]
+%else
+    movu            m2, [lq+16]
+%endif
+    psadbw          m2, m1
+    paddw           m0, m2
+%endif
+%ifidn %1, dc
+    movu            m2, [aq]
+    psadbw          m2, m1
+    paddw           m0, m2
+%if %2 > mmsize
+    movu            m2, [aq+16]
+    psadbw          m2, m1
+    paddw           m0, m2
+%endif
+%endif
+%if mmsize == 32
+    vextracti128   xm2, m0, 1
+    paddw          xm0, xm2
+%endif
+    punpckhqdq     xm2, xm0, xm0
+    paddw          xm0, xm2
+    paddw          xm0, [%4]
+    psrlw          xm0, %3
+%if mmsize == 32
+    vpbroadcastb    m0, xm0
+%else
+    pshufb          m0, m1
+%endif
+    lea       stride3q, [strideq*3]
+    mov           cntd, %2 / 4
+.loop:
+    mova   [dstq+strideq*0], m0
+    mova   [dstq+strideq*1], m0
+    mova   [dstq+strideq*2], m0
+    mova   [dstq+stride3q ], m0
+%if %2 > mmsize
+    mova [dstq+strideq*0+16], m0
+    mova [dstq+strideq*1+16], m0
+    mova [dstq+strideq*2+16], m0
+    mova [dstq+stride3q +16], m0
+%endif
+    lea           dstq, [dstq+strideq*4]
+    dec           cntd
+    jg .loop
+    RET
+%endmacro
+
+INIT_XMM ssse3
+DC_FN dc,      16, 5, pw_16
+DC_FN dc_left, 16, 4, pw_8
+DC_FN dc_top,  16, 4, pw_8
+DC_FN dc,      32, 6, pw_32
+DC_FN dc_left, 32, 5, pw_16
+DC_FN dc_top,  32, 5, pw_16
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+DC_FN dc,      32, 6, pw_32
+DC_FN dc_left, 32, 5, pw_16
+DC_FN dc_top,  32, 5, pw_16
+%endif
+
+; tm: clip(top[x] + left[y] - top[-1]), computed on words
+
+INIT_XMM ssse3
+cglobal vp9_ipred_tm_4x4, 4, 5, 5, dst, stride, l, a, stride3
+    pxor            m1, m1
+    movd            m0, [aq]
+    pinsrw          m2, [aq-1], 0
+    movd            m3, [lq]
+    lea       stride3q, [strideq*3]
+    punpcklbw       m0, m1
+    pshufb          m2, [pb_0_80]
+    psubw           m0, m2
+    punpcklqdq      m0, m0
+    pshufb          m4, m3, [pb_w4x0_4x1]
+    pshufb          m3, [pb_w4x2_4x3]
+    paddw           m4, m0
+    paddw           m3, m0
+    packuswb        m4, m3
+    movd   [dstq+strideq*0], m4
+    psrldq          m4, 4
+    movd   [dstq+strideq*1], m4
+    psrldq          m4, 4
+    movd   [dstq+strideq*2], m4
+    psrldq          m4, 4
+    movd   [dstq+stride3q ], m4
+    RET
+
+cglobal vp9_ipred_tm_8x8, 4, 5, 7, dst, stride, l, a, cnt
+    pxor            m1, m1
+    movq            m0, [aq]
+    pinsrw          m2, [aq-1], 0
+    movq            m3, [lq]
+    mova            m4, [pb_0_80]
+    mova            m5, [pb_1]
+    punpcklbw       m0, m1
+    pshufb          m2, m4
+    psubw           m0, m2
+    mov           cntd, 4
+.loop:
+    pshufb          m2, m3, m4
+    paddb           m4, m5
+    pshufb          m6, m3, m4
+    paddb           m4, m5
+    paddw           m2, m0
+    paddw           m6, m0
+    packuswb        m2, m6
+    movq   [dstq+strideq*0], m2
+    movhps [dstq+strideq*1], m2
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_tm_16x16, 4, 5, 8, dst, stride, l, a, cnt
+    pxor            m1, m1
+    movu            m2, [aq]
+    pinsrw          m3, [aq-1], 0
+    movu            m6, [lq]
+    mova            m4, [pb_0_80]
+    mova            m5, [pb_1]
+    punpckhbw       m0, m2, m1
+    punpcklbw       m2, m1
+    pshufb          m3, m4
+    psubw           m0, m3
+    psubw           m2, m3
+    mov           cntd, 8
+.loop:
+    pshufb          m3, m6, m4
+    paddb           m4, m5
+    pshufb          m7, m6, m4
+    paddb           m4, m5
+    paddw           m1, m3, m2
+    paddw           m3, m0
+    packuswb        m1, m3
+    paddw           m3, m7, m2
+    paddw           m7, m0
+    packuswb        m3, m7
+    mova   [dstq+strideq*0], m1
+    mova   [dstq+strideq*1], m3
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+%if ARCH_X86_64
+cglobal vp9_ipred_tm_32x32, 4, 6, 10, dst, stride, l, a, cnt, rows
+    pxor            m4, m4
+    movu            m1, [aq]
+    movu            m3, [aq+16]
+    pinsrw          m5, [aq-1], 0
+    mova            m6, [pb_0_80]
+    punpckhbw       m0, m1, m4
+    punpcklbw       m1, m4
+    punpckhbw       m2, m3, m4
+    punpcklbw       m3, m4
+    pshufb          m5, m6
+    psubw           m0, m5
+    psubw           m1, m5
+    psubw           m2, m5
+    psubw           m3, m5
+    mova            m5, [pb_1]
+    mov           cntd, 2
+.loop_half:
+    movu            m6, [lq]
+    mova            m4, [pb_0_80]
+    mov          rowsd, 16
+.loop:
+    pshufb          m7, m6, m4
+    paddb           m4, m5
+    paddw           m8, m7, m1
+    paddw           m9, m7, m0
+    packuswb        m8, m9
+    paddw           m9, m7, m3
+    paddw           m7, m2
+    packuswb        m9, m7
+    mova   [dstq+ 0], m8
+    mova   [dstq+16], m9
+    add           dstq, strideq
+    dec          rowsd
+    jg .loop
+    add             lq, 16
+    dec           cntd
+    jg .loop_half
+    RET
+%endif
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+cglobal vp9_ipred_tm_32x32, 4, 5, 7, dst, stride, l, a, cnt
+    pxor            m1, m1
+    movu            m0, [aq]
+    vpbroadcastb    m2, [aq-1]
+    punpckhbw       m3, m0, m1
+    punpcklbw       m0, m1
+    punpcklbw       m2, m1
+    psubw           m3, m2
+    psubw           m0, m2
+    mov           cntd, 16
+.loop:
+    vpbroadcastb    m2, [lq+0]
+    vpbroadcastb    m4, [lq+1]
+    punpcklbw       m2, m1
+    punpcklbw       m4, m1
+    paddw           m5, m2, m0
+    paddw           m2, m3
+    paddw           m6, m4, m0
+    paddw           m4, m3
+    packuswb        m5, m2
+    packuswb        m6, m4
+    mova   [dstq+strideq*0], m5
+    mova   [dstq+strideq*1], m6
+    add             lq, 2
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+%endif
+
+; Directional modes, built on the 3-tap filter of the edges:
+; %1 = (%2 + %3 * 2 + %4 + 2) >> 2 on bytes, %5 = temporary, %2 is clobbered
+%macro LOWPASS 5
+    pxor            %5, %2, %4
+    pavgb           %2, %4
+    pand            %5, [pb_1]
+    psubusb         %2, %5
+    pavgb           %1, %2, %3
+%endmacro
+
+; dl: top row filtered along the down-left diagonal, the right end repeated
+
+INIT_XMM ssse3
+cglobal vp9_ipred_dl_4x4, 4, 5, 4, dst, stride, l, a, stride3
+    movq            m1, [aq]
+    lea       stride3q, [strideq*3]
+    pshufb          m0, m1, [pb_0to5_10x7]
+    pshufb          m2, m1, [pb_2to7_10x7]
+    psrldq          m1, 1
+    LOWPASS         m0, m0, m1, m2, m3
+    movd   [dstq+strideq*0], m0
+    psrldq          m0, 1
+    movd   [dstq+strideq*1], m0
+    psrldq          m0, 1
+    movd   [dstq+strideq*2], m0
+    psrldq          m0, 1
+    movd   [dstq+stride3q ], m0
+    RET
+
+cglobal vp9_ipred_dl_8x8, 4, 5, 5, dst, stride, l, a, cnt
+    movq            m0, [aq]
+    mova            m4, [pb_1to15_15]
+    pshufb          m0, [pb_0to7_8x7]
+    pshufb          m1, m0, m4
+    pshufb          m2, m1, m4
+    LOWPASS         m0, m0, m1, m2, m3
+    mov           cntd, 4
+.loop:
+    movq   [dstq+strideq*0], m0
+    psrldq          m0, 1
+    movq   [dstq+strideq*1], m0
+    psrldq          m0, 1
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_dl_16x16, 4, 5, 5, dst, stride, l, a, cnt
+    movu            m0, [aq]
+    mova            m4, [pb_1to15_15]
+    pshufb          m1, m0, m4
+    pshufb          m2, m1, m4
+    LOWPASS         m0, m0, m1, m2, m3
+    mov           cntd, 8
+.loop:
+    mova   [dstq+strideq*0], m0
+    pshufb          m0, m4
+    mova   [dstq+strideq*1], m0
+    pshufb          m0, m4
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_dl_32x32, 4, 5, 6, dst, stride, l, a, cnt
+    movu            m0, [aq]
+    movu            m1, [aq+16]
+    mova            m5, [pb_1to15_15]
+    palignr         m2, m1, m0, 1
+    palignr         m3, m1, m0, 2
+    LOWPASS         m0, m0, m2, m3, m4
+    pshufb          m2, m1, m5
+    pshufb          m3, m2, m5
+    LOWPASS         m1, m1, m2, m3, m4
+    mov           cntd, 16
+.loop:
+    mova   [dstq+strideq*0+ 0], m0
+    mova   [dstq+strideq*0+16], m1
+    palignr         m2, m1, m0, 1
+    pshufb          m1, m5
+    mova   [dstq+strideq*1+ 0], m2
+    mova   [dstq+strideq*1+16], m1
+    palignr         m0, m1, m2, 1
+    pshufb          m1, m5
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+; vl: the even rows average two top pixels, the odd rows filter three
+
+cglobal vp9_ipred_vl_4x4, 4, 4, 5, dst, stride, l, a
+    movq            m0, [aq]
+    psrldq          m1, m0, 1
+    psrldq          m2, m0, 2
+    pavgb           m3, m0, m1
+    LOWPASS         m0, m0, m1, m2, m4
+    movd   [dstq+strideq*0], m3
+    movd   [dstq+strideq*1], m0
+    lea           dstq, [dstq+strideq*2]
+    psrldq          m3, 1
+    psrldq          m0, 1
+    movd   [dstq+strideq*0], m3
+    movd   [dstq+strideq*1], m0
+    RET
+
+cglobal vp9_ipred_vl_8x8, 4, 5, 5, dst, stride, l, a, cnt
+    movq            m0, [aq]
+    mova            m4, [pb_1to15_15]
+    pshufb          m0, [pb_0to7_8x7]
+    pshufb          m1, m0, m4
+    pshufb          m2, m1, m4
+    pavgb           m3, m0, m1
+    LOWPASS         m0, m0, m1, m2, m4
+    mov           cntd, 4
+.loop:
+    movq   [dstq+strideq*0], m3
+    movq   [dstq+strideq*1], m0
+    psrldq          m3, 1
+    psrldq          m0, 1
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_vl_16x16, 4, 5, 6, dst, stride, l, a, cnt
+    movu            m0, [aq]
+    mova            m4, [pb_1to15_15]
+    pshufb          m1, m0, m4
+    pshufb          m2, m1, m4
+    pavgb           m3, m0, m1
+    LOWPASS         m0, m0, m1, m2, m5
+    mov           cntd, 8
+.loop:
+    mova   [dstq+strideq*0], m3
+    mova   [dstq+strideq*1], m0
+    pshufb          m3, m4
+    pshufb          m0, m4
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+; hu: the left edge read downwards, interleaving averages of two pixels and
+; the 3-tap filter, the bottom pixel repeated
+
+cglobal vp9_ipred_hu_4x4, 3, 4, 5, dst, stride, l, stride3
+    movd            m0, [lq]
+    mova            m3, [pb_1to15_15]
+    lea       stride3q, [strideq*3]
+    pshufb          m0, [pb_0to3_12x3]
+    pshufb          m1, m0, m3
+    pshufb          m2, m1, m3
+    pavgb           m3, m0, m1
+    LOWPASS         m0, m0, m1, m2, m4
+    punpcklbw       m3, m0
+    movd   [dstq+strideq*0], m3
+    psrldq          m3, 2
+    movd   [dstq+strideq*1], m3
+    psrldq          m3, 2
+    movd   [dstq+strideq*2], m3
+    psrldq          m3, 2
+    movd   [dstq+stride3q ], m3
+    RET
+
+cglobal vp9_ipred_hu_8x8, 3, 4, 5, dst, stride, l, cnt
+    movq            m0, [lq]
+    mova            m3, [pb_1to15_15]
+    pshufb          m0, [pb_0to7_8x7]
+    pshufb          m1, m0, m3
+    pshufb          m2, m1, m3
+    pavgb           m3, m0, m1
+    LOWPASS         m0, m0, m1, m2, m4
+    mova            m4, [pb_2to15_2x15]
+    punpcklbw       m3, m0
+    mov           cntd, 4
+.loop:
+    movq   [dstq+strideq*0], m3
+    pshufb          m3, m4
+    movq   [dstq+strideq*1], m3
+    pshufb          m3, m4
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_hu_16x16, 3, 4, 5, dst, stride, l, cnt
+    movu            m0, [lq]
+    mova            m3, [pb_1to15_15]
+    pshufb          m1, m0, m3
+    pshufb          m2, m1, m3
+    pavgb           m3, m0, m1
+    LOWPASS         m0, m0, m1, m2, m4
+    mova            m4, [pb_2to15_2x15]
+    punpckhbw       m1, m3, m0
+    punpcklbw       m3, m0
+    mov           cntd, 8
+.loop:
+    mova   [dstq+strideq*0], m3
+    palignr         m2, m1, m3, 2
+    pshufb          m1, m4
+    mova   [dstq+strideq*1], m2
+    palignr         m3, m1, m2, 2
+    pshufb          m1, m4
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+; dr: the left edge read upwards, the top-left and the top edge, filtered
+; along the down-right diagonal
+
+cglobal vp9_ipred_dr_4x4, 4, 5, 4, dst, stride, l, a, stride3
+    movd            m0, [lq]
+    movq            m1, [aq-1]
+    lea       stride3q, [strideq*3]
+    pshufb          m0, [pb_15to0]
+    palignr         m1, m0, 12
+    psrldq          m2, m1, 1
+    psrldq          m3, m1, 2
+    LOWPASS         m1, m1, m2, m3, m0
+    movd   [dstq+stride3q ], m1
+    psrldq          m1, 1
+    movd   [dstq+strideq*2], m1
+    psrldq          m1, 1
+    movd   [dstq+strideq*1], m1
+    psrldq          m1, 1
+    movd   [dstq+strideq*0], m1
+    RET
+
+cglobal vp9_ipred_dr_8x8, 4, 6, 4, dst, stride, l, a, stride3, dst4
+    movq            m1, [lq]
+    movq            m0, [aq-1]
+    movq            m2, [aq]
+    lea       stride3q, [strideq*3]
+    lea          dst4q, [dstq+strideq*4]
+    pshufb          m1, [pb_15to0]
+    psrldq          m2, 7
+    palignr         m0, m1, 8
+    palignr         m3, m2, m0, 1
+    palignr         m2, m0, 2
+    LOWPASS         m0, m0, m3, m2, m1
+    movq   [dst4q+stride3q ], m0
+    psrldq          m0, 1
+    movq   [dst4q+strideq*2], m0
+    psrldq          m0, 1
+    movq   [dst4q+strideq*1], m0
+    psrldq          m0, 1
+    movq   [dst4q+strideq*0], m0
+    psrldq          m0, 1
+    movq   [dstq +stride3q ], m0
+    psrldq          m0, 1
+    movq   [dstq +strideq*2], m0
+    psrldq          m0, 1
+    movq   [dstq +strideq*1], m0
+    psrldq          m0, 1
+    movq   [dstq +strideq*0], m0
+    RET
+
+cglobal vp9_ipred_dr_16x16, 4, 5, 6, dst, stride, l, a, cnt
+    movu            m0, [lq]
+    movu            m1, [aq-1]
+    movu            m2, [aq]
+    pshufb          m0, [pb_15to0]
+    palignr         m3, m1, m0, 1
+    palignr         m4, m1, m0, 2
+    LOWPASS         m0, m0, m3, m4, m5
+    psrldq          m3, m2, 1
+    LOWPASS         m1, m1, m2, m3, m4
+    ; top row first, shifting the lower diagonals in from the left
+    palignr         m2, m1, m0, 15
+    pslldq          m0, 1
+    mov           cntd, 8
+.loop:
+    mova   [dstq+strideq*0], m2
+    palignr         m2, m0, 15
+    pslldq          m0, 1
+    mova   [dstq+strideq*1], m2
+    palignr         m2, m0, 15
+    pslldq          m0, 1
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+; vr: the even rows average two top pixels, the odd rows filter three, the
+; left edge filtered and shifted in every other row
+
+cglobal vp9_ipred_vr_4x4, 4, 5, 6, dst, stride, l, a, stride3
+    movd            m0, [lq]
+    movd            m1, [aq-1]
+    movd            m2, [aq]
+    lea       stride3q, [strideq*3]
+    pshufb          m0, [pb_15to0]
+    pslldq          m3, m0, 1
+    palignr         m4, m1, m0, 1
+    LOWPASS         m3, m3, m0, m4, m5
+    pshufb          m3, [pb_02468ACE_13579BDF]
+    palignr         m4, m1, m0, 15
+    LOWPASS         m4, m4, m1, m2, m5
+    pavgb           m1, m2
+    pslldq          m2, m3, 8
+    movd   [dstq+strideq*0], m1
+    movd   [dstq+strideq*1], m4
+    palignr         m1, m3, 15
+    palignr         m4, m2, 15
+    movd   [dstq+strideq*2], m1
+    movd   [dstq+stride3q ], m4
+    RET
+
+%macro VR_FN 1
+cglobal vp9_ipred_vr_%1x%1, 4, 5, 7, dst, stride, l, a, cnt
+%if %1 == 8
+    movq            m0, [lq]
+    movq            m1, [aq-1]
+    movq            m2, [aq]
+%else
+    movu            m0, [lq]
+    movu            m1, [aq-1]
+    movu            m2, [aq]
+%endif
+    pshufb          m0, [pb_15to0]
+    pslldq          m3, m0, 1
+    palignr         m4, m1, m0, 1
+    LOWPASS         m3, m3, m0, m4, m5
+    pshufb          m3, [pb_02468ACE_13579BDF]
+    palignr         m4, m1, m0, 15
+    LOWPASS         m4, m4, m1, m2, m5
+    pavgb           m1, m2
+    pslldq          m2, m3, 8
+    mov           cntd, %1 / 2
+.loop:
+%if %1 == 8
+    movq   [dstq+strideq*0], m1
+    movq   [dstq+strideq*1], m4
+%else
+    mova   [dstq+strideq*0], m1
+    mova   [dstq+strideq*1], m4
+%endif
+    palignr         m1, m3, 15
+    palignr         m4, m2, 15
+    pslldq          m3, 1
+    pslldq          m2, 1
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+%endmacro
+
+VR_FN  8
+VR_FN 16
+
+; hd: the left edge read upwards, interleaving averages of two pixels and
+; the 3-tap filter, followed by the filtered top edge
+
+cglobal vp9_ipred_hd_4x4, 4, 5, 6, dst, stride, l, a, stride3
+    movd            m0, [lq]
+    movd            m1, [aq-1]
+    lea       stride3q, [strideq*3]
+    pshufb          m0, [pb_15to0]
+    palignr         m1, m0, 12
+    psrldq          m2, m1, 1
+    psrldq          m3, m1, 2
+    pavgb           m4, m1, m2
+    LOWPASS         m1, m1, m2, m3, m5
+    punpcklbw       m4, m1
+    psrldq          m1, 4
+    punpcklqdq      m4, m1
+    movd   [dstq+stride3q ], m4
+    psrldq          m4, 2
+    movd   [dstq+strideq*2], m4
+    psrldq          m4, 2
+    movd   [dstq+strideq*1], m4
+    psrldq          m4, 2
+    movd   [dstq+strideq*0], m4
+    RET
+
+cglobal vp9_ipred_hd_8x8, 4, 5, 6, dst, stride, l, a, cnt
+    movq            m0, [lq]
+    movq            m1, [aq-1]
+    pshufb          m0, [pb_15to0]
+    palignr         m1, m0, 8
+    psrldq          m2, m1, 1
+    psrldq          m3, m1, 2
+    pavgb           m4, m1, m2
+    LOWPASS         m1, m1, m2, m3, m5
+    punpcklbw       m4, m1
+    psrldq          m1, 8
+    ; top row first, shifting the lower pairs in from the left
+    palignr         m2, m1, m4, 14
+    pslldq          m4, 2
+    mov           cntd, 4
+.loop:
+    movq   [dstq+strideq*0], m2
+    palignr         m2, m4, 14
+    pslldq          m4, 2
+    movq   [dstq+strideq*1], m2
+    palignr         m2, m4, 14
+    pslldq          m4, 2
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_hd_16x16, 4, 5, 6, dst, stride, l, a, cnt
+    movu            m0, [lq]
+    movu            m1, [aq-1]
+    pshufb          m0, [pb_15to0]
+    palignr         m2, m1, m0, 1
+    palignr         m3, m1, m0, 2
+    pavgb           m4, m0, m2
+    LOWPASS         m0, m0, m2, m3, m5
+    psrldq          m2, m1, 1
+    psrldq          m3, m1, 2
+    LOWPASS         m1, m1, m2, m3, m5
+    punpckhbw       m2, m4, m0
+    punpcklbw       m4, m0
+    palignr         m3, m1, m2, 14
+    palignr         m1, m2, m4, 14
+    pslldq          m4, 2
+    mov           cntd, 8
+.loop:
+    mova   [dstq+strideq*0], m3
+    palignr         m3, m1, 14
+    palignr         m1, m4, 14
+    pslldq          m4, 2
+    mova   [dstq+strideq*1], m3
+    palignr         m3, m1, 14
+    palignr         m1, m4, 14
+    pslldq          m4, 2
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_vl_32x32, 4, 6, 8, dst, stride, l, a, stride3, cnt
+    movu            m0, [aq]
+    movu            m1, [aq+16]
+    mova            m7, [pb_1to15_15]
+    lea       stride3q, [strideq*3]
+    palignr         m2, m1, m0, 1
+    palignr         m3, m1, m0, 2
+    pavgb           m4, m0, m2
+    LOWPASS         m0, m0, m2, m3, m5
+    pshufb          m2, m1, m7
+    pshufb          m3, m2, m7
+    pavgb           m5, m1, m2
+    LOWPASS         m1, m1, m2, m3, m6
+    mov           cntd, 8
+.loop:
+    mova   [dstq+strideq*0+ 0], m4
+    mova   [dstq+strideq*0+16], m5
+    mova   [dstq+strideq*1+ 0], m0
+    mova   [dstq+strideq*1+16], m1
+    palignr         m2, m5, m4, 1
+    palignr         m3, m1, m0, 1
+    pshufb          m5, m7
+    pshufb          m1, m7
+    mova   [dstq+strideq*2+ 0], m2
+    mova   [dstq+strideq*2+16], m5
+    mova   [dstq+stride3q + 0], m3
+    mova   [dstq+stride3q +16], m1
+    palignr         m4, m5, m2, 1
+    palignr         m0, m1, m3, 1
+    pshufb          m5, m7
+    pshufb          m1, m7
+    lea           dstq, [dstq+strideq*4]
+    dec           cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_hu_32x32, 3, 4, 8, dst, stride, l, cnt
+    movu            m0, [lq]
+    movu            m1, [lq+16]
+    palignr         m2, m1, m0, 1
+    palignr         m3, m1, m0, 2
+    pavgb           m4, m0, m2
+    LOWPASS         m0, m0, m2, m3, m5
+    punpcklbw       m2, m4, m0
+    punpckhbw       m4, m0
+    mova            m7, [pb_1to15_15]
+    pshufb          m3, m1, m7
+    pshufb          m5, m3, m7
+    pavgb           m6, m1, m3
+    LOWPASS         m1, m1, m3, m5, m0
+    punpcklbw       m3, m6, m1
+    punpckhbw       m6, m1
+    mova            m7, [pb_2to15_2x15]
+    SWAP             0, 2
+    SWAP             1, 4
+    SWAP             2, 3
+    SWAP             3, 6
+    mov           cntd, 16
+.loop:
+    mova   [dstq+strideq*0+ 0], m0
+    mova   [dstq+strideq*0+16], m1
+    palignr         m4, m1, m0, 2
+    palignr         m5, m2, m1, 2
+    palignr         m6, m3, m2, 2
+    pshufb          m3, m7
+    mova   [dstq+strideq*1+ 0], m4
+    mova   [dstq+strideq*1+16], m5
+    palignr         m0, m5, m4, 2
+    palignr         m1, m6, m5, 2
+    palignr         m2, m3, m6, 2
+    pshufb          m3, m7
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_dr_32x32, 4, 5, 8, dst, stride, l, a, cnt
+    movu            m0, [lq+16]
+    movu            m1, [lq]
+    mova            m7, [pb_15to0]
+    pshufb          m0, m7
+    pshufb          m1, m7
+    palignr         m2, m1, m0, 1
+    palignr         m3, m1, m0, 2
+    LOWPASS         m0, m0, m2, m3, m4
+    movu            m2, [aq-1]
+    palignr         m3, m2, m1, 1
+    palignr         m4, m2, m1, 2
+    LOWPASS         m1, m1, m3, m4, m5
+    movu            m3, [aq]
+    movu            m4, [aq+1]
+    LOWPASS         m2, m2, m3, m4, m5
+    movu            m3, [aq+15]
+    movu            m4, [aq+16]
+    psrldq          m5, m4, 1
+    LOWPASS         m3, m3, m4, m5, m6
+    palignr         m4, m2, m1, 15
+    palignr         m5, m3, m2, 15
+    palignr         m6, m1, m0, 15
+    pslldq          m0, 1
+    mov           cntd, 32
+.loop:
+    mova   [dstq+ 0], m4
+    mova   [dstq+16], m5
+    palignr         m5, m4, 15
+    palignr         m4, m6, 15
+    palignr         m6, m0, 15
+    pslldq          m0, 1
+    add           dstq, strideq
+    dec           cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_vr_32x32, 4, 5, 8, dst, stride, l, a, cnt
+    movu            m0, [lq+16]
+    movu            m1, [lq]
+    movu            m2, [aq-1]
+    mova            m7, [pb_15to0]
+    pshufb          m0, m7
+    pshufb          m1, m7
+    palignr         m3, m1, m0, 15
+    palignr         m4, m2, m1, 1
+    LOWPASS         m3, m3, m1, m4, m5
+    palignr         m4, m1, m0, 1
+    pslldq          m5, m0, 1
+    LOWPASS         m5, m5, m0, m4, m6
+    mova            m6, [pb_02468ACE_13579BDF]
+    pshufb          m5, m6
+    pshufb          m3, m6
+    punpckhqdq      m4, m5, m3
+    punpcklqdq      m5, m3
+    palignr         m0, m2, m1, 15
+    movu            m1, [aq]
+    LOWPASS         m0, m0, m2, m1, m3
+    movu            m3, [aq+15]
+    palignr         m6, m3, m2, 15
+    pavgb           m2, m1
+    movu            m1, [aq+16]
+    LOWPASS         m6, m6, m3, m1, m7
+    pavgb           m3, m1
+    mov           cntd, 16
+.loop:
+    mova   [dstq+strideq*0+ 0], m2
+    mova   [dstq+strideq*0+16], m3
+    mova   [dstq+strideq*1+ 0], m0
+    mova   [dstq+strideq*1+16], m6
+    palignr         m3, m2, 15
+    palignr         m2, m4, 15
+    palignr         m6, m0, 15
+    palignr         m0, m5, 15
+    pslldq          m4, 1
+    pslldq          m5, 1
+    lea           dstq, [dstq+strideq*2]
+    dec           cntd
+    jg .loop
+    RET
+
+%if ARCH_X86_64
+cglobal vp9_ipred_hd_32x32, 4, 5, 15, dst, stride, l, a, cnt
+    movu            m0, [lq+16]
+    movu            m1, [lq]
+    movu            m2, [aq-1]
+    movu            m3, [aq+15]
+    mova            m4, [pb_15to0]
+    pshufb          m0, m4
+    pshufb          m1, m4
+    palignr         m4, m1, m0, 1
+    palignr         m5, m1, m0, 2
+    pavgb           m6, m0, m4
+    LOWPASS         m0, m0, m4, m5, m7
+    punpcklbw       m8, m6, m0
+    punpckhbw       m6, m0
+    palignr         m4, m2, m1, 1
+    palignr         m5, m2, m1, 2
+    pavgb           m7, m1, m4
+    LOWPASS         m1, m1, m4, m5, m0
+    punpcklbw       m9, m7, m1
+    punpckhbw       m7, m1
+    palignr         m4, m3, m2, 1
+    palignr         m5, m3, m2, 2
+    LOWPASS         m2, m2, m4, m5, m0
+    psrldq          m4, m3, 1
+    psrldq          m5, m3, 2
+    LOWPASS         m3, m3, m4, m5, m0
+    ; top row first, shifting the lower pairs in from the left
+    palignr        m10, m2, m7, 14
+    palignr        m11, m3, m2, 14
+    palignr        m12, m7, m9, 14
+    palignr        m13, m9, m6, 14
+    palignr        m14, m6, m8, 14
+    pslldq          m8, 2
+    mov           cntd, 32
+.loop:
+    mova   [dstq+ 0], m10
+    mova   [dstq+16], m11
+    palignr        m11, m10, 14
+    palignr        m10, m12, 14
+    palignr        m12, m13, 14
+    palignr        m13, m14, 14
+    palignr        m14, m8, 14
+    pslldq          m8, 2
+    add           dstq, strideq
+    dec           cntd
+    jg .loop
+    RET
+%endif
+
+%if HAVE_AVX2_EXTERNAL
+; m%1 = bytes %2 to %2 + 31 of the 32-byte chunks m%3, m%5 and m%7, m%4 and
+; m%6 being the 32 bytes across each pair of them
+%macro PALIGNR_YMM 7
+%if %2 < 16
+    vpalignr       m%1, m%4, m%3, %2
+%elif %2 < 32
+    vpalignr       m%1, m%5, m%4, (%2) - 16
+%elif %2 < 48
+    vpalignr       m%1, m%6, m%5, (%2) - 32
+%else
+    vpalignr       m%1, m%7, m%6, (%2) - 48
+%endif
+%endmacro
+
+; store %1 rows, row n being bytes %2 + %3 * n of the chunks %4-%8 of
+; PALIGNR_YMM, with m%9 and m%10 as temporaries
+%macro IPRED_ROWS_YMM 10
+    lea       stride3q, [strideq*3]
+%assign %%n 0
+%rep %1 / 4
+    PALIGNR_YMM     %9, %2 + %3 * (%%n + 0), %4, %5, %6, %7, %8
+    PALIGNR_YMM    %10, %2 + %3 * (%%n + 1), %4, %5, %6, %7, %8
+    mova   [dstq+strideq*0], m%9
+    mova   [dstq+strideq*1], m%10
+    PALIGNR_YMM     %9, %2 + %3 * (%%n + 2), %4, %5, %6, %7, %8
+    PALIGNR_YMM    %10, %2 + %3 * (%%n + 3), %4, %5, %6, %7, %8
+    mova   [dstq+strideq*2], m%9
+    mova   [dstq+stride3q ], m%10
+%assign %%n %%n + 4
+%if %%n < %1
+    lea           dstq, [dstq+strideq*4]
+%endif
+%endrep
+%endmacro
+
+INIT_YMM avx2
+cglobal vp9_ipred_dl_32x32, 4, 5, 6, dst, stride, l, a, stride3
+    movu            m0, [aq]
+    vpbroadcastb    m5, [aq+31]
+    vperm2i128      m4, m0, m5, 0x21
+    vpalignr        m1, m4, m0, 1
+    vpalignr        m2, m4, m0, 2
+    LOWPASS         m0, m0, m1, m2, m3
+    vperm2i128      m4, m0, m5, 0x21
+    IPRED_ROWS_YMM  32, 0, 1, 0, 4, 5, 5, 5, 1, 2
+    RET
+
+cglobal vp9_ipred_vl_32x32, 4, 6, 8, dst, stride, l, a, stride3, dst1
+    movu            m0, [aq]
+    vpbroadcastb    m7, [aq+31]
+    vperm2i128      m3, m0, m7, 0x21
+    vpalignr        m1, m3, m0, 1
+    vpalignr        m2, m3, m0, 2
+    pavgb           m4, m0, m1
+    LOWPASS         m0, m0, m1, m2, m3
+    vperm2i128      m5, m4, m7, 0x21
+    vperm2i128      m6, m0, m7, 0x21
+    lea          dst1q, [dstq+strideq]
+    add        strideq, strideq
+    ; the even rows, then the odd ones from dst + stride
+    IPRED_ROWS_YMM  16, 0, 1, 4, 5, 7, 7, 7, 1, 2
+    mov           dstq, dst1q
+    IPRED_ROWS_YMM  16, 0, 1, 0, 6, 7, 7, 7, 1, 2
+    RET
+
+cglobal vp9_ipred_hu_32x32, 3, 4, 8, dst, stride, l, stride3
+    movu            m0, [lq]
+    vpbroadcastb    m7, [lq+31]
+    vperm2i128      m3, m0, m7, 0x21
+    vpalignr        m1, m3, m0, 1
+    vpalignr        m2, m3, m0, 2
+    pavgb           m3, m0, m1
+    LOWPASS         m0, m0, m1, m2, m4
+    punpcklbw       m1, m3, m0
+    punpckhbw       m3, m0
+    vperm2i128      m4, m1, m3, 0x20
+    vperm2i128      m6, m1, m3, 0x31
+    vperm2i128      m5, m4, m6, 0x21
+    vperm2i128      m3, m6, m7, 0x21
+    IPRED_ROWS_YMM  32, 0, 2, 4, 5, 6, 3, 7, 1, 2
+    RET
+
+cglobal vp9_ipred_dr_32x32, 4, 5, 7, dst, stride, l, a, stride3
+    movu            m0, [lq]
+    movu            m1, [aq-1]
+    movu            m2, [aq]
+    pshufb          m0, [pb_15to0]
+    vpermq          m0, m0, q1032
+    vperm2i128      m3, m0, m1, 0x21
+    vpalignr        m4, m3, m0, 1
+    vpalignr        m5, m3, m0, 2
+    LOWPASS         m0, m0, m4, m5, m6
+    vperm2i128      m3, m2, m2, 0x81
+    vpalignr        m3, m3, m2, 1
+    LOWPASS         m1, m1, m2, m3, m6
+    vperm2i128      m2, m0, m1, 0x21
+    IPRED_ROWS_YMM  32, 31, -1, 0, 2, 1, 1, 1, 3, 4
+    RET
+
+cglobal vp9_ipred_vr_32x32, 4, 6, 8, dst, stride, l, a, stride3, dst1
+    movu           xm0, [lq+16]
+    movu           xm1, [lq]
+    movu            m2, [aq-1]
+    mova           xm7, [pb_15to0]
+    pshufb         xm0, xm7
+    pshufb         xm1, xm7
+    vpalignr       xm3, xm1, xm0, 15
+    vpalignr       xm4, xm2, xm1, 1
+    LOWPASS        xm3, xm3, xm1, xm4, xm5
+    vpalignr       xm4, xm1, xm0, 1
+    pslldq         xm5, xm0, 1
+    LOWPASS        xm5, xm5, xm0, xm4, xm6
+    mova           xm6, [pb_02468ACE_13579BDF]
+    pshufb         xm5, xm6
+    pshufb         xm3, xm6
+    punpckhqdq     xm4, xm5, xm3
+    punpcklqdq     xm5, xm3
+    vperm2i128      m0, m2, m1, 0x02
+    vpalignr        m0, m2, m0, 15
+    movu            m3, [aq]
+    LOWPASS         m0, m0, m2, m3, m6
+    pavgb           m2, m3
+    vinserti128     m4, m4, xm2, 1
+    vinserti128     m5, m5, xm0, 1
+    lea          dst1q, [dstq+strideq]
+    add        strideq, strideq
+    ; the even rows, then the odd ones from dst + stride
+    IPRED_ROWS_YMM  16, 16, -1, 4, 2, 2, 2, 2, 1, 3
+    mov           dstq, dst1q
+    IPRED_ROWS_YMM  16, 16, -1, 5, 0, 0, 0, 0, 1, 3
+    RET
+
+cglobal vp9_ipred_hd_32x32, 4, 5, 7, dst, stride, l, a, stride3
+    movu            m0, [lq]
+    movu            m1, [aq-1]
+    pshufb          m0, [pb_15to0]
+    vpermq          m0, m0, q1032
+    vperm2i128      m2, m0, m1, 0x21
+    vpalignr        m3, m2, m0, 1
+    vpalignr        m4, m2, m0, 2
+    pavgb           m2, m0, m3
+    LOWPASS         m0, m0, m3, m4, m5
+    punpcklbw       m3, m2, m0
+    punpckhbw       m2, m0
+    vperm2i128      m4, m3, m2, 0x20
+    vperm2i128      m5, m3, m2, 0x31
+    vperm2i128      m2, m1, m1, 0x81
+    vpalignr        m3, m2, m1, 1
+    vpalignr        m2, m2, m1, 2
+    LOWPASS         m1, m1, m3, m2, m0
+    vperm2i128      m0, m4, m5, 0x21
+    vperm2i128      m6, m5, m1, 0x21
+    IPRED_ROWS_YMM  32, 62, -2, 4, 0, 5, 6, 1, 2, 3
+    RET
+%endif
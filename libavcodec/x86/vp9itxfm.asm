@@ -0,0 +1,878 @@
+;******************************************************************************
+;* VP9 inverse transform SIMD optimizations
+;*
+;* This file is part of Libav.
+;*
+;* Libav is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* Libav is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with Libav; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pw_11585x2:         times 16 dw 23170
+pw_2048:            times 16 dw 2048
+pw_1024:            times 16 dw 1024
+pw_512:             times 16 dw 512
+pd_8192:            times 8 dd 8192
+
+; coefficient pairs for pmaddwd, the products of both words are summed
+pw_11585_11585:     times 8 dw  11585,  11585
+pw_11585_m11585:    times 8 dw  11585, -11585
+pw_m11585_m11585:   times 8 dw -11585, -11585
+pw_6270_m15137:     times 8 dw   6270, -15137
+pw_15137_6270:      times 8 dw  15137,   6270
+pw_15137_m6270:     times 8 dw  15137,  -6270
+pw_6270_15137:      times 8 dw   6270,  15137
+pw_m15137_m6270:    times 8 dw -15137,  -6270
+pw_3196_m16069:     times 8 dw   3196, -16069
+pw_16069_3196:      times 8 dw  16069,   3196
+pw_16069_m3196:     times 8 dw  16069,  -3196
+pw_3196_16069:      times 8 dw   3196,  16069
+pw_m16069_m3196:    times 8 dw -16069,  -3196
+pw_13623_m9102:     times 8 dw  13623,  -9102
+pw_9102_13623:      times 8 dw   9102,  13623
+pw_9102_m13623:     times 8 dw   9102, -13623
+pw_13623_9102:      times 8 dw  13623,   9102
+pw_m9102_m13623:    times 8 dw  -9102, -13623
+
+pw_5283_15212:      times 8 dw   5283,  15212
+pw_9929_13377:      times 8 dw   9929,  13377
+pw_9929_m5283:      times 8 dw   9929,  -5283
+pw_m15212_13377:    times 8 dw -15212,  13377
+pw_13377_m13377:    times 8 dw  13377, -13377
+pw_13377_0:         times 8 dw  13377,      0
+pw_15212_9929:      times 8 dw  15212,   9929
+pw_m5283_m13377:    times 8 dw  -5283, -13377
+
+pw_16305_1606:      times 8 dw  16305,   1606
+pw_1606_m16305:     times 8 dw   1606, -16305
+pw_14449_7723:      times 8 dw  14449,   7723
+pw_7723_m14449:     times 8 dw   7723, -14449
+pw_10394_12665:     times 8 dw  10394,  12665
+pw_12665_m10394:    times 8 dw  12665, -10394
+pw_4756_15679:      times 8 dw   4756,  15679
+pw_15679_m4756:     times 8 dw  15679,  -4756
+
+pw_16364_804:       times 8 dw  16364,    804
+pw_804_m16364:      times 8 dw    804, -16364
+pw_11003_12140:     times 8 dw  11003,  12140
+pw_12140_m11003:    times 8 dw  12140, -11003
+pw_15893_3981:      times 8 dw  15893,   3981
+pw_3981_m15893:     times 8 dw   3981, -15893
+pw_8423_14053:      times 8 dw   8423,  14053
+pw_14053_m8423:     times 8 dw  14053,  -8423
+pw_14811_7005:      times 8 dw  14811,   7005
+pw_7005_m14811:     times 8 dw   7005, -14811
+pw_5520_15426:      times 8 dw   5520,  15426
+pw_15426_m5520:     times 8 dw  15426,  -5520
+pw_13160_9760:      times 8 dw  13160,   9760
+pw_9760_m13160:     times 8 dw   9760, -13160
+pw_2404_16207:      times 8 dw   2404,  16207
+pw_16207_m2404:     times 8 dw  16207,  -2404
+
+cextern pw_m1
+
+SECTION .text
+
+; The transforms are bitexact with the C versions: all products are computed
+; on 32 bits with pmaddwd and rounded exactly as in vp9dsp.c. The first pass
+; works on the columns of the coefficient block, loaded as rows, so after one
+; transpose the second pass directly produces the rows of the residual.
+
+; (%1, %2) -> %1 = (%1 * c0 + %2 * c1 + 8192) >> 14,
+;             %2 = (%1 * c2 + %2 * c3 + 8192) >> 14
+; %3, %4 = temporaries, %5 = [c0, c1], %6 = [c2, c3]
+%macro VP9_UNPACK_MULSUB_2W_4X 6
+    punpckhwd      m%3, m%1, m%2
+    punpcklwd      m%1, m%2
+    pmaddwd        m%4, m%3, [%6]
+    pmaddwd        m%2, m%1, [%6]
+    pmaddwd        m%3, [%5]
+    pmaddwd        m%1, [%5]
+    paddd          m%4, [pd_8192]
+    paddd          m%2, [pd_8192]
+    paddd          m%3, [pd_8192]
+    paddd          m%1, [pd_8192]
+    psrad          m%4, 14
+    psrad          m%2, 14
+    psrad          m%3, 14
+    psrad          m%1, 14
+    packssdw       m%1, m%3
+    packssdw       m%2, m%4
+%endmacro
+
+; Same as above, but the unrounded dword products are kept: %3/%4 receive
+; the low/high halves of %1 * c0 + %2 * c1, %1/%2 those of %1 * c2 + %2 * c3.
+%macro VP9_UNPACK_MULSUB_2D_4X 6
+    punpckhwd      m%4, m%1, m%2
+    punpcklwd      m%1, m%2
+    pmaddwd        m%3, m%1, [%5]
+    pmaddwd        m%1, [%6]
+    pmaddwd        m%2, m%4, [%6]
+    pmaddwd        m%4, [%5]
+%endmacro
+
+; dword pairs x = (%1, %2), y = (%3, %4) ->
+; %3 = (x + y + 8192) >> 14, %1 = (x - y + 8192) >> 14, packed to words
+%macro VP9_RND_SH_SUMSUB_BA 5 ; x_lo, x_hi, y_lo, y_hi, tmp
+    SUMSUB_BA        d, %3, %1, %5
+    SUMSUB_BA        d, %4, %2, %5
+    paddd          m%3, [pd_8192]
+    paddd          m%4, [pd_8192]
+    paddd          m%1, [pd_8192]
+    paddd          m%2, [pd_8192]
+    psrad          m%3, 14
+    psrad          m%4, 14
+    psrad          m%1, 14
+    psrad          m%2, 14
+    packssdw       m%3, m%4
+    packssdw       m%1, m%2
+%endmacro
+
+;-------------------------------------------------------------------------------
+; 4x4
+;-------------------------------------------------------------------------------
+
+; The 4-point transforms take the coefficient pairs of all 4 lanes in m0
+; (in0, in2) and m1 (in1, in3 for idct, in3, in1 for iadst) and return
+; [out0, out1] in m0 and [out2, out3] in m1.
+%macro VP9_IDCT4_1D 0
+    pmaddwd         m2, m0, [pw_11585_11585]
+    pmaddwd         m0, [pw_11585_m11585]
+    pmaddwd         m3, m1, [pw_6270_m15137]
+    pmaddwd         m1, [pw_15137_6270]
+    paddd           m2, m4
+    paddd           m0, m4
+    paddd           m3, m4
+    paddd           m1, m4
+    psrad           m2, 14              ; t0
+    psrad           m0, 14              ; t1
+    psrad           m3, 14              ; t2
+    psrad           m1, 14              ; t3
+    packssdw        m2, m0              ; t0, t1
+    packssdw        m1, m3              ; t3, t2
+    SUMSUB_BA        w, 1, 2, 3         ; out0, out1 / out3, out2
+    pshufd          m2, m2, q1032
+    SWAP             0, 1, 2
+%endmacro
+
+%macro VP9_IADST4_1D 0
+    pmaddwd         m2, m0, [pw_5283_15212]
+    pmaddwd         m3, m1, [pw_9929_13377]
+    paddd           m2, m3              ; t0 + t3
+    pmaddwd         m3, m0, [pw_9929_m5283]
+    pmaddwd         m5, m1, [pw_m15212_13377]
+    paddd           m3, m5              ; t1 + t3
+    paddd           m2, m4
+    paddd           m3, m4
+    psrad           m2, 14
+    psrad           m3, 14
+    packssdw        m2, m3              ; out0, out1
+    pmaddwd         m3, m0, [pw_13377_m13377]
+    pmaddwd         m5, m1, [pw_13377_0]
+    paddd           m3, m5              ; t2
+    pmaddwd         m0, [pw_15212_9929]
+    pmaddwd         m1, [pw_m5283_m13377]
+    paddd           m0, m1              ; t0 + t1 - t3
+    paddd           m3, m4
+    paddd           m0, m4
+    psrad           m3, 14
+    psrad           m0, 14
+    packssdw        m3, m0              ; out2, out3
+    SWAP             0, 2
+    SWAP             1, 3
+%endmacro
+
+; rows [r0, r1] in m0 and [r2, r3] in m1 -> coefficient pairs of the columns
+; %1 = q3120 (in0, in2 / in1, in3) or q1320 (in0, in2 / in3, in1)
+%macro VP9_TRANSPOSE_4x4_PAIRS 1
+    pshuflw         m0, m0, %1
+    pshufhw         m0, m0, %1
+    pshuflw         m1, m1, %1
+    pshufhw         m1, m1, %1
+    punpckhdq       m2, m0, m1
+    punpckldq       m0, m1
+    punpckhdq       m1, m0, m2
+    punpckldq       m0, m2
+%endmacro
+
+%macro VP9_IDCT4_PAIRS 0
+    punpckhwd       m2, m0, m1
+    punpcklwd       m0, m1
+    SWAP             1, 2
+%endmacro
+
+%macro VP9_IADST4_PAIRS 0
+    punpckhwd       m2, m1, m0
+    punpcklwd       m0, m1
+    SWAP             1, 2
+%endmacro
+
+; add the residual rows [r0, r1] in m0 and [r2, r3] in m1 to dst
+%macro VP9_ADD_4x4 0
+    pxor            m5, m5
+    movd            m2, [dstq+strideq*0]
+    movd            m3, [dstq+strideq*1]
+    punpckldq       m2, m3
+    lea           eobq, [dstq+strideq*2]
+    movd            m3, [eobq+strideq*0]
+    movd            m4, [eobq+strideq*1]
+    punpckldq       m3, m4
+    punpcklbw       m2, m5
+    punpcklbw       m3, m5
+    paddw           m2, m0
+    paddw           m3, m1
+    packuswb        m2, m3
+    movd   [dstq+strideq*0], m2
+    pshufd          m2, m2, q0321
+    movd   [dstq+strideq*1], m2
+    pshufd          m2, m2, q0321
+    movd   [eobq+strideq*0], m2
+    pshufd          m2, m2, q0321
+    movd   [eobq+strideq*1], m2
+%endmacro
+
+%macro ITXFM_4x4_FN 2 ; first pass (columns), second pass (rows)
+cglobal vp9_%1_%2_4x4_add, 4, 4, 6, dst, stride, block, eob
+%ifidn %1_%2, idct_idct
+    cmp           eobd, 1
+    jg .full
+    movd            m0, [blockq]
+    mova            m1, [pw_11585x2]
+    pmulhrsw        m0, m1
+    pmulhrsw        m0, m1
+    pmulhrsw        m0, [pw_2048]
+    SPLATW          m0, m0
+    mova            m1, m0
+    mov word [blockq], 0
+    VP9_ADD_4x4
+    RET
+.full:
+%endif
+    mova            m0, [blockq+ 0]
+    mova            m1, [blockq+16]
+    mova            m4, [pd_8192]
+%ifidn %1, idct
+    VP9_IDCT4_PAIRS
+    VP9_IDCT4_1D
+%else
+    VP9_IADST4_PAIRS
+    VP9_IADST4_1D
+%endif
+%ifidn %2, idct
+    VP9_TRANSPOSE_4x4_PAIRS q3120
+    VP9_IDCT4_1D
+%else
+    VP9_TRANSPOSE_4x4_PAIRS q1320
+    VP9_IADST4_1D
+%endif
+    pxor            m2, m2
+    mova            m3, [pw_2048]
+    mova   [blockq+ 0], m2
+    mova   [blockq+16], m2
+    pmulhrsw        m0, m3
+    pmulhrsw        m1, m3
+    VP9_ADD_4x4
+    RET
+%endmacro
+
+INIT_XMM ssse3
+ITXFM_4x4_FN idct,  idct
+ITXFM_4x4_FN iadst, idct
+ITXFM_4x4_FN idct,  iadst
+ITXFM_4x4_FN iadst, iadst
+
+;-------------------------------------------------------------------------------
+; 8x8
+;-------------------------------------------------------------------------------
+
+%if ARCH_X86_64
+
+; m0-7: in0-7 of 8 lanes -> out0-7, m8-15 are clobbered
+%macro VP9_IDCT8_1D 0
+    VP9_UNPACK_MULSUB_2W_4X 0, 4, 8, 9, pw_11585_11585, pw_11585_m11585 ; t0a, t1a
+    VP9_UNPACK_MULSUB_2W_4X 2, 6, 8, 9, pw_6270_m15137, pw_15137_6270   ; t2a, t3a
+    VP9_UNPACK_MULSUB_2W_4X 1, 7, 8, 9, pw_3196_m16069, pw_16069_3196   ; t4a, t7a
+    VP9_UNPACK_MULSUB_2W_4X 5, 3, 8, 9, pw_13623_m9102, pw_9102_13623   ; t5a, t6a
+    SUMSUB_BA            w, 6, 0, 8     ; t0, t3
+    SUMSUB_BA            w, 2, 4, 8     ; t1, t2
+    SUMSUB_BA            w, 5, 1, 8     ; t4, t5a
+    SUMSUB_BA            w, 3, 7, 8     ; t7, t6a
+    VP9_UNPACK_MULSUB_2W_4X 7, 1, 8, 9, pw_11585_m11585, pw_11585_11585 ; t5, t6
+    SUMSUB_BA            w, 3, 6, 8     ; out0, out7
+    SUMSUB_BA            w, 1, 2, 8     ; out1, out6
+    SUMSUB_BA            w, 7, 4, 8     ; out2, out5
+    SUMSUB_BA            w, 5, 0, 8     ; out3, out4
+    SWAP                 0, 3
+    SWAP                 2, 7
+    SWAP                 3, 5
+    SWAP                 4, 5
+    SWAP                 6, 7
+%endmacro
+
+%macro VP9_IADST8_1D 0
+    VP9_UNPACK_MULSUB_2D_4X 7, 0, 8, 9, pw_16305_1606, pw_1606_m16305   ; t0a, t1a
+    VP9_UNPACK_MULSUB_2D_4X 3, 4, 10, 11, pw_10394_12665, pw_12665_m10394 ; t4a, t5a
+    VP9_RND_SH_SUMSUB_BA 8, 9, 10, 11, 12                                ; t0, t4
+    VP9_RND_SH_SUMSUB_BA 7, 0, 3, 4, 12                                  ; t1, t5
+    VP9_UNPACK_MULSUB_2D_4X 5, 2, 0, 4, pw_14449_7723, pw_7723_m14449    ; t2a, t3a
+    VP9_UNPACK_MULSUB_2D_4X 1, 6, 9, 11, pw_4756_15679, pw_15679_m4756   ; t6a, t7a
+    VP9_RND_SH_SUMSUB_BA 0, 4, 9, 11, 12                                 ; t2, t6
+    VP9_RND_SH_SUMSUB_BA 5, 2, 1, 6, 12                                  ; t3, t7
+
+    ; t0 = m10, t1 = m3, t2 = m9, t3 = m1, t4 = m8, t5 = m7, t6 = m0, t7 = m5
+    VP9_UNPACK_MULSUB_2D_4X 8, 7, 2, 4, pw_15137_6270, pw_6270_m15137    ; t4a, t5a
+    VP9_UNPACK_MULSUB_2D_4X 5, 0, 6, 11, pw_15137_m6270, pw_6270_15137   ; t6a, t7a
+    VP9_RND_SH_SUMSUB_BA 2, 4, 6, 11, 12                                 ; -out1, t6
+    VP9_RND_SH_SUMSUB_BA 8, 7, 5, 0, 12                                  ; out6, t7
+    SUMSUB_BA            w, 9, 10, 12   ; out0, t2
+    SUMSUB_BA            w, 1, 3, 12    ; -out7, t3
+    VP9_UNPACK_MULSUB_2W_4X 10, 3, 12, 13, pw_11585_11585, pw_11585_m11585 ; -out3, out4
+    VP9_UNPACK_MULSUB_2W_4X 2, 8, 12, 13, pw_11585_11585, pw_11585_m11585  ; out2, -out5
+    mova                m12, [pw_m1]
+    psignw               m6, m12
+    psignw               m1, m12
+    psignw              m10, m12
+    psignw               m8, m12
+    SWAP                 0, 9
+    SWAP                 1, 6
+    SWAP                 3, 10
+    SWAP                 4, 10
+    SWAP                 5, 8
+    SWAP                 6, 8
+    SWAP                 7, 8
+%endmacro
+
+; add the residual rows %1 and %2 to the next two rows of dst
+%macro VP9_ADD_8x2 5 ; row1, row2, tmp1, tmp2, zero
+    movh               m%3, [dstq+strideq*0]
+    movh               m%4, [dstq+strideq*1]
+    punpcklbw          m%3, m%5
+    punpcklbw          m%4, m%5
+    paddw              m%3, m%1
+    paddw              m%4, m%2
+    packuswb           m%3, m%4
+    movh   [dstq+strideq*0], m%3
+    movhps [dstq+strideq*1], m%3
+    lea                dstq, [dstq+strideq*2]
+%endmacro
+
+%macro ITXFM_8x8_FN 2 ; first pass (columns), second pass (rows)
+cglobal vp9_%1_%2_8x8_add, 4, 4, 16, dst, stride, block, eob
+%ifidn %1_%2, idct_idct
+    cmp               eobd, 1
+    jg .full
+    movd                m0, [blockq]
+    mova                m1, [pw_11585x2]
+    pmulhrsw            m0, m1
+    pmulhrsw            m0, m1
+    pmulhrsw            m0, [pw_1024]
+    SPLATW              m0, m0
+    pxor                m5, m5
+    mov       word [blockq], 0
+    VP9_ADD_8x2          0, 0, 1, 2, 5
+    VP9_ADD_8x2          0, 0, 1, 2, 5
+    VP9_ADD_8x2          0, 0, 1, 2, 5
+    VP9_ADD_8x2          0, 0, 1, 2, 5
+    RET
+.full:
+%endif
+    mova                m0, [blockq+  0]
+    mova                m1, [blockq+ 16]
+    mova                m2, [blockq+ 32]
+    mova                m3, [blockq+ 48]
+    mova                m4, [blockq+ 64]
+    mova                m5, [blockq+ 80]
+    mova                m6, [blockq+ 96]
+    mova                m7, [blockq+112]
+%ifidn %1, idct
+    VP9_IDCT8_1D
+%else
+    VP9_IADST8_1D
+%endif
+    TRANSPOSE8x8W        0, 1, 2, 3, 4, 5, 6, 7, 8
+%ifidn %2, idct
+    VP9_IDCT8_1D
+%else
+    VP9_IADST8_1D
+%endif
+    mova                m8, [pw_1024]
+    pxor                m9, m9
+%assign %%i 0
+%rep 8
+    pmulhrsw         m %+ %%i, m8
+    mova [blockq+%%i*16], m9
+%assign %%i %%i+1
+%endrep
+    VP9_ADD_8x2          0, 1, 10, 11, 9
+    VP9_ADD_8x2          2, 3, 10, 11, 9
+    VP9_ADD_8x2          4, 5, 10, 11, 9
+    VP9_ADD_8x2          6, 7, 10, 11, 9
+    RET
+%endmacro
+
+INIT_XMM ssse3
+ITXFM_8x8_FN idct,  idct
+ITXFM_8x8_FN iadst, idct
+ITXFM_8x8_FN idct,  iadst
+ITXFM_8x8_FN iadst, iadst
+
+%endif ; ARCH_X86_64
+
+;-------------------------------------------------------------------------------
+; 16x16 and 32x32
+;-------------------------------------------------------------------------------
+
+%if ARCH_X86_64
+
+; Each pass works on mmsize / 2 lanes at a time, 8 with SSSE3 and 16 with
+; AVX2. The 1D transforms read in[k] from [%1 + k * %2] and write out[k] to
+; the slot k of the scratch area at [rsp + o_base]. The first pass transposes
+; the slots into the buffer at [rsp], where the second pass reads its inputs.
+
+%macro VP9_LOAD_O 2 ; reg, slot
+    mova               m%1, [rsp+o_base+(%2)*mmsize]
+%endmacro
+
+%macro VP9_STORE_O 2 ; reg, slot
+    mova [rsp+o_base+(%2)*mmsize], m%1
+%endmacro
+
+; out[%2] = slot %2 + m%1, out[%4 - %2] = slot %2 - m%1, %3 = temporary
+%macro VP9_IDCT_OUT 4
+    VP9_LOAD_O          %3, %2
+    SUMSUB_BA            w, %1, %3
+    VP9_STORE_O         %1, %2
+    VP9_STORE_O         %3, %4-(%2)
+%endmacro
+
+%macro VP9_IDCT16_1D 2
+    ; the even half is an 8-point idct
+    mova                m0, [%1+ 0*%2]
+    mova                m1, [%1+ 2*%2]
+    mova                m2, [%1+ 4*%2]
+    mova                m3, [%1+ 6*%2]
+    mova                m4, [%1+ 8*%2]
+    mova                m5, [%1+10*%2]
+    mova                m6, [%1+12*%2]
+    mova                m7, [%1+14*%2]
+    VP9_IDCT8_1D
+    VP9_STORE_O          0, 0
+    VP9_STORE_O          1, 1
+    VP9_STORE_O          2, 2
+    VP9_STORE_O          3, 3
+    VP9_STORE_O          4, 4
+    VP9_STORE_O          5, 5
+    VP9_STORE_O          6, 6
+    VP9_STORE_O          7, 7
+
+    mova                m0, [%1+ 1*%2]
+    mova                m1, [%1+ 3*%2]
+    mova                m2, [%1+ 5*%2]
+    mova                m3, [%1+ 7*%2]
+    mova                m4, [%1+ 9*%2]
+    mova                m5, [%1+11*%2]
+    mova                m6, [%1+13*%2]
+    mova                m7, [%1+15*%2]
+    VP9_UNPACK_MULSUB_2W_4X 0, 7, 8, 9, pw_1606_m16305, pw_16305_1606   ; t8a, t15a
+    VP9_UNPACK_MULSUB_2W_4X 4, 3, 8, 9, pw_12665_m10394, pw_10394_12665 ; t9a, t14a
+    VP9_UNPACK_MULSUB_2W_4X 2, 5, 8, 9, pw_7723_m14449, pw_14449_7723   ; t10a, t13a
+    VP9_UNPACK_MULSUB_2W_4X 6, 1, 8, 9, pw_15679_m4756, pw_4756_15679   ; t11a, t12a
+    SUMSUB_BA            w, 4, 0, 8     ; t8, t9
+    SUMSUB_BA            w, 2, 6, 8     ; t11, t10
+    SUMSUB_BA            w, 5, 1, 8     ; t12, t13
+    SUMSUB_BA            w, 3, 7, 8     ; t15, t14
+    VP9_UNPACK_MULSUB_2W_4X 7, 0, 8, 9, pw_6270_m15137, pw_15137_6270   ; t9a, t14a
+    VP9_UNPACK_MULSUB_2W_4X 1, 6, 8, 9, pw_m15137_m6270, pw_6270_m15137 ; t10a, t13a
+    SUMSUB_BA            w, 2, 4, 8     ; t8a, t11a
+    SUMSUB_BA            w, 1, 7, 8     ; t9, t10
+    SUMSUB_BA            w, 5, 3, 8     ; t15a, t12a
+    SUMSUB_BA            w, 6, 0, 8     ; t14, t13
+    VP9_UNPACK_MULSUB_2W_4X 0, 7, 8, 9, pw_11585_m11585, pw_11585_11585 ; t10a, t13a
+    VP9_UNPACK_MULSUB_2W_4X 3, 4, 8, 9, pw_11585_m11585, pw_11585_11585 ; t11, t12
+    VP9_IDCT_OUT         5, 0, 8, 15
+    VP9_IDCT_OUT         6, 1, 8, 15
+    VP9_IDCT_OUT         7, 2, 8, 15
+    VP9_IDCT_OUT         4, 3, 8, 15
+    VP9_IDCT_OUT         3, 4, 8, 15
+    VP9_IDCT_OUT         0, 5, 8, 15
+    VP9_IDCT_OUT         1, 6, 8, 15
+    VP9_IDCT_OUT         2, 7, 8, 15
+%endmacro
+
+; t(%11)a and t(%11 + 1)a to the slots %11 and %11 + 1, t(%11 + 8)a and
+; t(%11 + 9)a to the slots %11 + 16 and %11 + 17
+%macro VP9_IADST16_STAGE1 11 ; src, stride, in[] indices, coefficient pairs, %11
+    mova                m0, [%1+%3*%2]
+    mova                m1, [%1+%4*%2]
+    mova                m2, [%1+%5*%2]
+    mova                m3, [%1+%6*%2]
+    VP9_UNPACK_MULSUB_2D_4X 0, 1, 4, 5, %7, %8
+    VP9_UNPACK_MULSUB_2D_4X 2, 3, 6, 7, %9, %10
+    VP9_RND_SH_SUMSUB_BA 4, 5, 6, 7, 8
+    VP9_RND_SH_SUMSUB_BA 0, 1, 2, 3, 8
+    VP9_STORE_O          6, %11
+    VP9_STORE_O          2, %11+1
+    VP9_STORE_O          4, %11+16
+    VP9_STORE_O          0, %11+17
+%endmacro
+
+%macro VP9_IADST16_1D 2
+    VP9_IADST16_STAGE1  %1, %2, 15,  0,  7,  8, pw_16364_804, pw_804_m16364, pw_11003_12140, pw_12140_m11003, 0
+    VP9_IADST16_STAGE1  %1, %2, 13,  2,  5, 10, pw_15893_3981, pw_3981_m15893, pw_8423_14053, pw_14053_m8423, 2
+    VP9_IADST16_STAGE1  %1, %2, 11,  4,  3, 12, pw_14811_7005, pw_7005_m14811, pw_5520_15426, pw_15426_m5520, 4
+    VP9_IADST16_STAGE1  %1, %2,  9,  6,  1, 14, pw_13160_9760, pw_9760_m13160, pw_2404_16207, pw_16207_m2404, 6
+
+    ; out0, 3, 4, 7, 8, 11, 12 and 15 from t0a-t7a
+    VP9_LOAD_O           0, 0
+    VP9_LOAD_O           1, 1
+    VP9_LOAD_O           2, 2
+    VP9_LOAD_O           3, 3
+    VP9_LOAD_O           4, 4
+    VP9_LOAD_O           5, 5
+    VP9_LOAD_O           6, 6
+    VP9_LOAD_O           7, 7
+    SUMSUB_BA            w, 4, 0, 8     ; t0, t4
+    SUMSUB_BA            w, 5, 1, 8     ; t1, t5
+    SUMSUB_BA            w, 6, 2, 8     ; t2, t6
+    SUMSUB_BA            w, 7, 3, 8     ; t3, t7
+    VP9_UNPACK_MULSUB_2D_4X 0, 1, 8, 9, pw_15137_6270, pw_6270_m15137    ; t4a, t5a
+    VP9_UNPACK_MULSUB_2D_4X 3, 2, 10, 11, pw_15137_m6270, pw_6270_15137  ; t6a, t7a
+    VP9_RND_SH_SUMSUB_BA 8, 9, 10, 11, 12                               ; -out3, t6
+    VP9_RND_SH_SUMSUB_BA 0, 1, 3, 2, 12                                 ; out12, t7
+    SUMSUB_BA            w, 6, 4, 12    ; out0, t2a
+    SUMSUB_BA            w, 7, 5, 12    ; -out15, t3a
+    VP9_UNPACK_MULSUB_2W_4X 4, 5, 1, 2, pw_m11585_m11585, pw_11585_m11585 ; out7, out8
+    VP9_UNPACK_MULSUB_2W_4X 0, 8, 1, 2, pw_11585_11585, pw_11585_m11585   ; out4, out11
+    pxor                m1, m1
+    pxor                m2, m2
+    psubw               m1, m10
+    psubw               m2, m7
+    VP9_STORE_O          6, 0
+    VP9_STORE_O          1, 3
+    VP9_STORE_O          0, 4
+    VP9_STORE_O          4, 7
+    VP9_STORE_O          5, 8
+    VP9_STORE_O          8, 11
+    VP9_STORE_O          3, 12
+    VP9_STORE_O          2, 15
+
+    ; out1, 2, 5, 6, 9, 10, 13 and 14 from t8a-t15a
+    VP9_LOAD_O           0, 16          ; t8a
+    VP9_LOAD_O           1, 17          ; t9a
+    VP9_LOAD_O           2, 21          ; t13a
+    VP9_LOAD_O           3, 20          ; t12a
+    VP9_UNPACK_MULSUB_2D_4X 0, 1, 4, 5, pw_16069_3196, pw_3196_m16069    ; t8, t9
+    VP9_UNPACK_MULSUB_2D_4X 2, 3, 6, 7, pw_16069_m3196, pw_3196_16069    ; t12, t13
+    VP9_RND_SH_SUMSUB_BA 4, 5, 6, 7, 8                                  ; t8a, t12a
+    VP9_RND_SH_SUMSUB_BA 0, 1, 2, 3, 8                                  ; t9a, t13a
+    VP9_LOAD_O           8, 18          ; t10a
+    VP9_LOAD_O           9, 19          ; t11a
+    VP9_LOAD_O          10, 23          ; t15a
+    VP9_LOAD_O          11, 22          ; t14a
+    VP9_UNPACK_MULSUB_2D_4X 8, 9, 12, 13, pw_9102_13623, pw_13623_m9102   ; t10, t11
+    VP9_UNPACK_MULSUB_2D_4X 10, 11, 14, 15, pw_9102_m13623, pw_13623_9102 ; t14, t15
+    VP9_RND_SH_SUMSUB_BA 12, 13, 14, 15, 1                              ; t10a, t14a
+    VP9_RND_SH_SUMSUB_BA 8, 9, 10, 11, 1                                ; t11a, t15a
+    VP9_UNPACK_MULSUB_2D_4X 4, 0, 1, 3, pw_15137_6270, pw_6270_m15137    ; t12, t13
+    VP9_UNPACK_MULSUB_2D_4X 8, 12, 5, 7, pw_15137_m6270, pw_6270_15137   ; t14, t15
+    VP9_RND_SH_SUMSUB_BA 1, 3, 5, 7, 9                                  ; out2, t14a
+    VP9_RND_SH_SUMSUB_BA 4, 0, 8, 12, 9                                 ; -out13, t15a
+    SUMSUB_BA            w, 14, 6, 9    ; -out1, t10
+    SUMSUB_BA            w, 10, 2, 9    ; out14, t11
+    VP9_UNPACK_MULSUB_2W_4X 2, 6, 0, 3, pw_11585_11585, pw_11585_m11585   ; out6, out9
+    VP9_UNPACK_MULSUB_2W_4X 1, 4, 0, 3, pw_m11585_m11585, pw_11585_m11585 ; out5, out10
+    pxor                m0, m0
+    pxor                m3, m3
+    psubw               m0, m14
+    psubw               m3, m8
+    VP9_STORE_O          0, 1
+    VP9_STORE_O          5, 2
+    VP9_STORE_O          1, 5
+    VP9_STORE_O          2, 6
+    VP9_STORE_O          6, 9
+    VP9_STORE_O          4, 10
+    VP9_STORE_O          3, 13
+    VP9_STORE_O         10, 14
+%endmacro
+
+%macro VP9_IDCT32_1D 2
+    VP9_IDCT16_1D       %1, 2*%2        ; the even half, in the slots 0-15
+
+    ; t16-t19 and t28-t31, kept in the slots 16-23
+    mova                m0, [%1+ 1*%2]
+    mova                m1, [%1+31*%2]
+    mova                m2, [%1+17*%2]
+    mova                m3, [%1+15*%2]
+    mova                m4, [%1+ 9*%2]
+    mova                m5, [%1+23*%2]
+    mova                m6, [%1+25*%2]
+    mova                m7, [%1+ 7*%2]
+    VP9_UNPACK_MULSUB_2W_4X 0, 1, 8, 9, pw_804_m16364, pw_16364_804     ; t16a, t31a
+    VP9_UNPACK_MULSUB_2W_4X 2, 3, 8, 9, pw_12140_m11003, pw_11003_12140 ; t17a, t30a
+    VP9_UNPACK_MULSUB_2W_4X 4, 5, 8, 9, pw_7005_m14811, pw_14811_7005   ; t18a, t29a
+    VP9_UNPACK_MULSUB_2W_4X 6, 7, 8, 9, pw_15426_m5520, pw_5520_15426   ; t19a, t28a
+    SUMSUB_BA            w, 2, 0, 8     ; t16, t17
+    SUMSUB_BA            w, 4, 6, 8     ; t19, t18
+    SUMSUB_BA            w, 5, 7, 8     ; t28, t29
+    SUMSUB_BA            w, 3, 1, 8     ; t31, t30
+    VP9_UNPACK_MULSUB_2W_4X 1, 0, 8, 9, pw_3196_m16069, pw_16069_3196   ; t17a, t30a
+    VP9_UNPACK_MULSUB_2W_4X 7, 6, 8, 9, pw_m16069_m3196, pw_3196_m16069 ; t18a, t29a
+    SUMSUB_BA            w, 4, 2, 8     ; t16a, t19a
+    SUMSUB_BA            w, 7, 1, 8     ; t17, t18
+    SUMSUB_BA            w, 5, 3, 8     ; t31a, t28a
+    SUMSUB_BA            w, 6, 0, 8     ; t30, t29
+    VP9_UNPACK_MULSUB_2W_4X 0, 1, 8, 9, pw_6270_m15137, pw_15137_6270   ; t18a, t29a
+    VP9_UNPACK_MULSUB_2W_4X 3, 2, 8, 9, pw_6270_m15137, pw_15137_6270   ; t19, t28
+    VP9_STORE_O          4, 16
+    VP9_STORE_O          7, 17
+    VP9_STORE_O          0, 18
+    VP9_STORE_O          3, 19
+    VP9_STORE_O          2, 20
+    VP9_STORE_O          1, 21
+    VP9_STORE_O          6, 22
+    VP9_STORE_O          5, 23
+
+    ; t20-t27
+    mova                m0, [%1+ 5*%2]
+    mova                m1, [%1+27*%2]
+    mova                m2, [%1+21*%2]
+    mova                m3, [%1+11*%2]
+    mova                m4, [%1+13*%2]
+    mova                m5, [%1+19*%2]
+    mova                m6, [%1+29*%2]
+    mova                m7, [%1+ 3*%2]
+    VP9_UNPACK_MULSUB_2W_4X 0, 1, 8, 9, pw_3981_m15893, pw_15893_3981   ; t20a, t27a
+    VP9_UNPACK_MULSUB_2W_4X 2, 3, 8, 9, pw_14053_m8423, pw_8423_14053   ; t21a, t26a
+    VP9_UNPACK_MULSUB_2W_4X 4, 5, 8, 9, pw_9760_m13160, pw_13160_9760   ; t22a, t25a
+    VP9_UNPACK_MULSUB_2W_4X 6, 7, 8, 9, pw_16207_m2404, pw_2404_16207   ; t23a, t24a
+    SUMSUB_BA            w, 2, 0, 8     ; t20, t21
+    SUMSUB_BA            w, 4, 6, 8     ; t23, t22
+    SUMSUB_BA            w, 5, 7, 8     ; t24, t25
+    SUMSUB_BA            w, 3, 1, 8     ; t27, t26
+    VP9_UNPACK_MULSUB_2W_4X 1, 0, 8, 9, pw_13623_m9102, pw_9102_13623   ; t21a, t26a
+    VP9_UNPACK_MULSUB_2W_4X 7, 6, 8, 9, pw_m9102_m13623, pw_13623_m9102 ; t22a, t25a
+    SUMSUB_BA            w, 2, 4, 8     ; t23a, t20a
+    SUMSUB_BA            w, 1, 7, 8     ; t22, t21
+    SUMSUB_BA            w, 3, 5, 8     ; t24a, t27a
+    SUMSUB_BA            w, 0, 6, 8     ; t25, t26
+    VP9_UNPACK_MULSUB_2W_4X 5, 4, 8, 9, pw_m15137_m6270, pw_6270_m15137 ; t20, t27
+    VP9_UNPACK_MULSUB_2W_4X 6, 7, 8, 9, pw_m15137_m6270, pw_6270_m15137 ; t21a, t26a
+
+    ; out[i] = slot i + (t31, t30a, t29, t28a, t27, t26a, t25, t24a, t23a,
+    ; t22, t21a, t20, t19a, t18, t17a, t16), out[31 - i] the difference
+    VP9_LOAD_O           8, 16
+    SUMSUB_BA            w, 2, 8        ; t16, t23
+    VP9_IDCT_OUT         2, 15, 9, 31
+    VP9_LOAD_O           9, 17
+    SUMSUB_BA            w, 1, 9        ; t17a, t22a
+    VP9_IDCT_OUT         1, 14, 2, 31
+    VP9_LOAD_O           2, 18
+    SUMSUB_BA            w, 6, 2        ; t18, t21
+    VP9_IDCT_OUT         6, 13, 1, 31
+    VP9_LOAD_O           1, 19
+    SUMSUB_BA            w, 5, 1        ; t19a, t20a
+    VP9_IDCT_OUT         5, 12, 6, 31
+    VP9_LOAD_O           6, 23
+    SUMSUB_BA            w, 3, 6        ; t31, t24
+    VP9_IDCT_OUT         3, 0, 5, 31
+    VP9_LOAD_O           5, 22
+    SUMSUB_BA            w, 0, 5        ; t30a, t25a
+    VP9_IDCT_OUT         0, 1, 3, 31
+    VP9_LOAD_O           3, 21
+    SUMSUB_BA            w, 7, 3        ; t29, t26
+    VP9_IDCT_OUT         7, 2, 0, 31
+    VP9_LOAD_O           0, 20
+    SUMSUB_BA            w, 4, 0        ; t28a, t27a
+    VP9_IDCT_OUT         4, 3, 7, 31
+    VP9_UNPACK_MULSUB_2W_4X 0, 1, 4, 7, pw_11585_m11585, pw_11585_11585 ; t20, t27
+    VP9_UNPACK_MULSUB_2W_4X 3, 2, 4, 7, pw_11585_m11585, pw_11585_11585 ; t21a, t26a
+    VP9_UNPACK_MULSUB_2W_4X 5, 9, 4, 7, pw_11585_m11585, pw_11585_11585 ; t22, t25
+    VP9_UNPACK_MULSUB_2W_4X 6, 8, 4, 7, pw_11585_m11585, pw_11585_11585 ; t23a, t24a
+    VP9_IDCT_OUT         1, 4, 7, 31
+    VP9_IDCT_OUT         2, 5, 7, 31
+    VP9_IDCT_OUT         9, 6, 7, 31
+    VP9_IDCT_OUT         8, 7, 7, 31
+    VP9_IDCT_OUT         6, 8, 7, 31
+    VP9_IDCT_OUT         5, 9, 7, 31
+    VP9_IDCT_OUT         3, 10, 7, 31
+    VP9_IDCT_OUT         0, 11, 7, 31
+%endmacro
+
+; transpose the %1 slots to the buffer rows at ptrq, %2 bytes apart
+%macro VP9_ITX_TRANSPOSE 2
+%assign %%q 0
+%rep %1 / 8
+    VP9_LOAD_O           0, %%q*8+0
+    VP9_LOAD_O           1, %%q*8+1
+    VP9_LOAD_O           2, %%q*8+2
+    VP9_LOAD_O           3, %%q*8+3
+    VP9_LOAD_O           4, %%q*8+4
+    VP9_LOAD_O           5, %%q*8+5
+    VP9_LOAD_O           6, %%q*8+6
+    VP9_LOAD_O           7, %%q*8+7
+    TRANSPOSE8x8W        0, 1, 2, 3, 4, 5, 6, 7, 8
+%assign %%j 0
+%rep 8
+%if mmsize == 32
+    mova   [ptrq+%%j*%2+%%q*16], xm %+ %%j
+    vextracti128 [ptrq+(%%j+8)*%2+%%q*16], m %+ %%j, 1
+%else
+    mova   [ptrq+%%j*%2+%%q*16], m %+ %%j
+%endif
+%assign %%j %%j+1
+%endrep
+%assign %%q %%q+1
+%endrep
+%endmacro
+
+; add the %1 slots, rounded, to the rows of dst at ptrq
+%macro VP9_ITX_ADD 1
+    mova                m8, [pw_512]
+    pxor                m9, m9
+%assign %%j 0
+%rep %1
+    VP9_LOAD_O           0, %%j
+    pmulhrsw            m0, m8
+%if mmsize == 32
+    movu               xm1, [ptrq]
+    vpmovzxbw           m1, xm1
+    paddw               m0, m1
+    vextracti128       xm1, m0, 1
+    packuswb           xm0, xm1
+    movu            [ptrq], xm0
+%else
+    movh                m1, [ptrq]
+    punpcklbw           m1, m9
+    paddw               m0, m1
+    packuswb            m0, m0
+    movh            [ptrq], m0
+%endif
+    add               ptrq, strideq
+%assign %%j %%j+1
+%endrep
+%endmacro
+
+; DC only: add the rounded dc of the %1x%1 block to dst
+%macro VP9_IDCT_DC_ADD 1
+    movd               xm0, [blockq]
+    mova               xm1, [pw_11585x2]
+    pmulhrsw           xm0, xm1
+    pmulhrsw           xm0, xm1
+    pmulhrsw           xm0, [pw_512]
+    mov       word [blockq], 0
+    SPLATW              m0, xm0
+    pxor                m1, m1
+    psubw               m1, m0
+    packuswb            m0, m0
+    packuswb            m1, m1
+    mov               eobd, %1
+.dc_loop:
+%if %1 < mmsize
+    movu               xm2, [dstq]
+    paddusb            xm2, xm0
+    psubusb            xm2, xm1
+    movu           [dstq], xm2
+%else
+%assign %%i 0
+%rep %1 / mmsize
+    movu                m2, [dstq+%%i*mmsize]
+    paddusb             m2, m0
+    psubusb             m2, m1
+    movu [dstq+%%i*mmsize], m2
+%assign %%i %%i+1
+%endrep
+%endif
+    add               dstq, strideq
+    dec               eobd
+    jg .dc_loop
+%endmacro
+
+; %1 = first pass (columns), %2 = second pass (rows), %3 = size
+%macro ITXFM_FN 3
+%assign o_base %3*%3*2
+cglobal vp9_%1_%2_%3x%3_add, 4, 6, 16, %3*%3*2+(%3+8)*mmsize, dst, stride, block, eob, src, ptr
+%ifidn %1_%2, idct_idct
+    cmp               eobd, 1
+    jg .full
+    VP9_IDCT_DC_ADD     %3
+    RET
+.full:
+%endif
+    mov               srcq, blockq
+    mov               ptrq, rsp
+    mov               eobd, %3 * 2 / mmsize
+.pass1:
+%ifidn %1, iadst
+    VP9_IADST16_1D    srcq, %3*2
+%elif %3 == 32
+    VP9_IDCT32_1D     srcq, %3*2
+%else
+    VP9_IDCT16_1D     srcq, %3*2
+%endif
+    VP9_ITX_TRANSPOSE   %3, %3*2
+    add               srcq, mmsize
+    add               ptrq, mmsize/2 * %3*2
+    dec               eobd
+    jg .pass1
+
+    pxor                m0, m0
+    mov               eobd, %3*%3*2 / (mmsize*4)
+.zero:
+    mova [blockq+mmsize*0], m0
+    mova [blockq+mmsize*1], m0
+    mova [blockq+mmsize*2], m0
+    mova [blockq+mmsize*3], m0
+    add             blockq, mmsize*4
+    dec               eobd
+    jg .zero
+
+    mov               srcq, rsp
+    mov               eobd, %3 * 2 / mmsize
+.pass2:
+%ifidn %2, iadst
+    VP9_IADST16_1D    srcq, %3*2
+%elif %3 == 32
+    VP9_IDCT32_1D     srcq, %3*2
+%else
+    VP9_IDCT16_1D     srcq, %3*2
+%endif
+    mov               ptrq, dstq
+    VP9_ITX_ADD         %3
+    add               srcq, mmsize
+    add               dstq, mmsize/2
+    dec               eobd
+    jg .pass2
+    RET
+%endmacro
+
+%macro ITXFM_FUNCS 0
+ITXFM_FN idct,  idct,  16
+ITXFM_FN iadst, idct,  16
+ITXFM_FN idct,  iadst, 16
+ITXFM_FN iadst, iadst, 16
+ITXFM_FN idct,  idct,  32
+%endmacro
+
+INIT_XMM ssse3
+ITXFM_FUNCS
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+ITXFM_FUNCS
+%endif
+
+%endif ; ARCH_X86_64
@@ -36,6 +36,7 @@
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
+#include "thread.h"
 #include "video.h"
 
 unsigned avfilter_version(void)
@@ -264,6 +265,13 @@ int ff_request_frame(AVFilterLink *link)
 {
     FF_DPRINTF_START(NULL, request_frame); ff_dlog_link(NULL, link, 1);
 
+    if (link->dst->internal->branch_input) {
+        /* frames already sent to the branch satisfy the request */
+        int ret = ff_branch_flush(link);
+        if (ret)
+            return FFMIN(ret, 0);
+    }
+
     if (link->srcpad->request_frame)
         return link->srcpad->request_frame(link);
     else if (link->src->inputs[0])
@@ -276,6 +284,12 @@ int ff_poll_frame(AVFilterLink *link)
 {
     int i, min = INT_MAX;
 
+    if (link->dst->internal->branch_input) {
+        int ret = ff_branch_flush(link);
+        if (ret < 0)
+            return ret;
+    }
+
     if (link->srcpad->poll_frame)
         return link->srcpad->poll_frame(link);
 
@@ -641,6 +655,14 @@ static int default_filter_frame(AVFilterLink *link, AVFrame *frame)
 }
 
 int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
+{
+    if (link->dst->internal->branch_input)
+        return ff_branch_filter_frame(link, frame);
+
+    return ff_filter_frame_direct(link, frame);
+}
+
+int ff_filter_frame_direct(AVFilterLink *link, AVFrame *frame)
 {
     int (*filter_frame)(AVFilterLink *, AVFrame *);
     AVFilterPad *dst = link->dstpad;
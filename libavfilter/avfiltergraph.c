@@ -43,6 +43,7 @@ static const AVOption filtergraph_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
         { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, FLAGS, "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = FLAGS, .unit = "thread_type" },
+        { "frame", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_FRAME }, .flags = FLAGS, .unit = "thread_type" },
     { "threads",     "Maximum number of threads", OFFSET(nb_threads),
         AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX, FLAGS },
     { NULL },
@@ -66,6 +67,34 @@ int ff_graph_thread_init(AVFilterGraph *graph)
     graph->nb_threads  = 1;
     return 0;
 }
+
+int ff_graph_branch_init(AVFilterGraph *graph)
+{
+    return 0;
+}
+
+void ff_graph_branch_free(AVFilterGraph *graph)
+{
+}
+
+int ff_branch_filter_frame(AVFilterLink *link, AVFrame *frame)
+{
+    av_frame_free(&frame);
+    return AVERROR(ENOSYS);
+}
+
+int ff_branch_flush(AVFilterLink *link)
+{
+    return AVERROR(ENOSYS);
+}
+
+void ff_branch_enter(AVFilterContext *ctx)
+{
+}
+
+void ff_branch_leave(AVFilterContext *ctx)
+{
+}
 #endif
 
 AVFilterGraph *avfilter_graph_alloc(void)
@@ -104,6 +133,8 @@ void avfilter_graph_free(AVFilterGraph **graph)
     if (!*graph)
         return;
 
+    ff_graph_branch_free(*graph);
+
     while ((*graph)->nb_filters)
         avfilter_free((*graph)->filters[0]);
 
@@ -798,5 +829,5 @@ int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
     if ((ret = graph_config_links(graphctx, log_ctx)))
         return ret;
 
-    return 0;
+    return ff_graph_branch_init(graphctx);
 }
@@ -34,6 +34,7 @@
 #include "avfilter.h"
 #include "buffersink.h"
 #include "internal.h"
+#include "thread.h"
 
 typedef struct BufferSinkContext {
     AVFrame *cur_frame;          ///< last frame delivered on the sink
@@ -59,8 +60,7 @@ static int filter_frame(AVFilterLink *link, AVFrame *frame)
     return 0;
 }
 
-int attribute_align_arg av_buffersink_get_frame(AVFilterContext *ctx,
-                                                AVFrame *frame)
+static int get_frame(AVFilterContext *ctx, AVFrame *frame)
 {
     BufferSinkContext *s    = ctx->priv;
     AVFilterLink      *link = ctx->inputs[0];
@@ -78,6 +78,18 @@ int attribute_align_arg av_buffersink_get_frame(AVFilterContext *ctx,
     return 0;
 }
 
+int attribute_align_arg av_buffersink_get_frame(AVFilterContext *ctx,
+                                                AVFrame *frame)
+{
+    int ret;
+
+    ff_branch_enter(ctx);
+    ret = get_frame(ctx, frame);
+    ff_branch_leave(ctx);
+
+    return ret;
+}
+
 static int read_from_fifo(AVFilterContext *ctx, AVFrame *frame,
                           int nb_samples)
 {
@@ -99,8 +111,7 @@ static int read_from_fifo(AVFilterContext *ctx, AVFrame *frame,
     return 0;
 }
 
-int attribute_align_arg av_buffersink_get_samples(AVFilterContext *ctx,
-                                                  AVFrame *frame, int nb_samples)
+static int get_samples(AVFilterContext *ctx, AVFrame *frame, int nb_samples)
 {
     BufferSinkContext *s = ctx->priv;
     AVFilterLink   *link = ctx->inputs[0];
@@ -137,6 +148,18 @@ int attribute_align_arg av_buffersink_get_samples(AVFilterContext *ctx,
     return ret;
 }
 
+int attribute_align_arg av_buffersink_get_samples(AVFilterContext *ctx,
+                                                  AVFrame *frame, int nb_samples)
+{
+    int ret;
+
+    ff_branch_enter(ctx);
+    ret = get_samples(ctx, frame, nb_samples);
+    ff_branch_leave(ctx);
+
+    return ret;
+}
+
 static const AVFilterPad avfilter_vsink_buffer_inputs[] = {
     {
         .name         = "default",
@@ -129,10 +129,23 @@ struct AVFilterPad {
 struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
+    void *branches;
 };
 
 struct AVFilterInternal {
     avfilter_execute_func *execute;
+
+    /**
+     * Branch of the graph this filter is run in, NULL if it is run by the
+     * caller thread.
+     */
+    struct ThreadBranch *branch;
+
+    /**
+     * Set on the first filter of a branch, the frames sent to its input
+     * are queued for the branch thread.
+     */
+    int branch_input;
 };
 
 /** Tell is a format is contained in the provided list terminated by -1. */
@@ -25,7 +25,9 @@
 
 #include "libavutil/common.h"
 #include "libavutil/cpu.h"
+#include "libavutil/frame.h"
 #include "libavutil/mem.h"
+#include "libavutil/slicethread.h"
 
 #include "avfilter.h"
 #include "internal.h"
@@ -40,8 +42,7 @@
 typedef struct ThreadContext {
     AVFilterGraph *graph;
 
-    int nb_threads;
-    pthread_t *workers;
+    AVSliceThread *pool;
     avfilter_action_func *func;
 
     /* per-execute parameters */
@@ -49,73 +50,52 @@ typedef struct ThreadContext {
     void *arg;
     int   *rets;
     int nb_rets;
-    int nb_jobs;
 
-    pthread_cond_t last_job_cond;
-    pthread_cond_t current_job_cond;
-    pthread_mutex_t current_job_lock;
-    int current_job;
-    unsigned int current_execute;
-    int done;
+    /* the filters of the graph branches may run concurrently, only one of
+     * them at a time can use the workers */
+    pthread_mutex_t execute_lock;
 } ThreadContext;
 
-static void* attribute_align_arg worker(void *v)
-{
-    ThreadContext *c = v;
-    int our_job      = c->nb_jobs;
-    int nb_threads   = c->nb_threads;
-    unsigned int last_execute = 0;
-    int self_id;
+#define BRANCH_QUEUE_SIZE 8
 
-    pthread_mutex_lock(&c->current_job_lock);
-    self_id = c->current_job++;
-    for (;;) {
-        while (our_job >= c->nb_jobs) {
-            if (c->current_job == nb_threads + c->nb_jobs)
-                pthread_cond_signal(&c->last_job_cond);
-
-            while (last_execute == c->current_execute && !c->done)
-                pthread_cond_wait(&c->current_job_cond, &c->current_job_lock);
-            last_execute = c->current_execute;
-            our_job = self_id;
-
-            if (c->done) {
-                pthread_mutex_unlock(&c->current_job_lock);
-                return NULL;
-            }
-        }
-        pthread_mutex_unlock(&c->current_job_lock);
+/**
+ * A part of the graph run by a dedicated thread. It is fed by a single link,
+ * all its filters have one input and it ends in sinks, so frames only enter
+ * it through the queue of that link and only leave it through the sinks.
+ */
+typedef struct ThreadBranch {
+    AVFilterLink *link; ///< input link of the branch
 
-        c->rets[our_job % c->nb_rets] = c->func(c->ctx, c->arg, our_job, c->nb_jobs);
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
 
-        pthread_mutex_lock(&c->current_job_lock);
-        our_job = c->current_job++;
-    }
-}
+    AVFrame *queue[BRANCH_QUEUE_SIZE];
+    int queue_start;
+    int nb_queued;
 
-static void slice_thread_uninit(ThreadContext *c)
-{
-    int i;
+    int busy;    ///< the thread is passing a frame down the branch
+    int entered; ///< the caller is running the filters of the branch
+    int error;   ///< first error returned by the filters of the branch
+    int done;
+} ThreadBranch;
 
-    pthread_mutex_lock(&c->current_job_lock);
-    c->done = 1;
-    pthread_cond_broadcast(&c->current_job_cond);
-    pthread_mutex_unlock(&c->current_job_lock);
+typedef struct BranchContext {
+    ThreadBranch **branches;
+    int nb_branches;
+} BranchContext;
 
-    for (i = 0; i < c->nb_threads; i++)
-         pthread_join(c->workers[i], NULL);
+static void run_job(void *priv, int jobnr, int nb_jobs)
+{
+    ThreadContext *c = priv;
 
-    pthread_mutex_destroy(&c->current_job_lock);
-    pthread_cond_destroy(&c->current_job_cond);
-    pthread_cond_destroy(&c->last_job_cond);
-    av_freep(&c->workers);
+    c->rets[jobnr % c->nb_rets] = c->func(c->ctx, c->arg, jobnr, nb_jobs);
 }
 
-static void slice_thread_park_workers(ThreadContext *c)
+static void slice_thread_uninit(ThreadContext *c)
 {
-    while (c->current_job != c->nb_threads + c->nb_jobs)
-        pthread_cond_wait(&c->last_job_cond, &c->current_job_lock);
-    pthread_mutex_unlock(&c->current_job_lock);
+    avpriv_slicethread_free(&c->pool);
+    pthread_mutex_destroy(&c->execute_lock);
 }
 
 static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
@@ -127,10 +107,8 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
     if (nb_jobs <= 0)
         return 0;
 
-    pthread_mutex_lock(&c->current_job_lock);
+    pthread_mutex_lock(&c->execute_lock);
 
-    c->current_job = c->nb_threads;
-    c->nb_jobs     = nb_jobs;
     c->ctx         = ctx;
     c->arg         = arg;
     c->func        = func;
@@ -141,18 +119,17 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
         c->rets    = &dummy_ret;
         c->nb_rets = 1;
     }
-    c->current_execute++;
 
-    pthread_cond_broadcast(&c->current_job_cond);
+    avpriv_slicethread_execute(c->pool, run_job, c, nb_jobs);
 
-    slice_thread_park_workers(c);
+    pthread_mutex_unlock(&c->execute_lock);
 
     return 0;
 }
 
 static int thread_init_internal(ThreadContext *c, int nb_threads)
 {
-    int i, ret;
+    int ret;
 
     if (!nb_threads) {
         int nb_cpus = av_cpu_count();
@@ -164,36 +141,11 @@ static int thread_init_internal(ThreadContext *c, int nb_threads)
             nb_threads = 1;
     }
 
-    if (nb_threads <= 1)
-        return 1;
+    ret = avpriv_slicethread_create(&c->pool, nb_threads);
+    if (ret > 1)
+        pthread_mutex_init(&c->execute_lock, NULL);
 
-    c->nb_threads = nb_threads;
-    c->workers = av_mallocz(sizeof(*c->workers) * nb_threads);
-    if (!c->workers)
-        return AVERROR(ENOMEM);
-
-    c->current_job = 0;
-    c->nb_jobs     = 0;
-    c->done        = 0;
-
-    pthread_cond_init(&c->current_job_cond, NULL);
-    pthread_cond_init(&c->last_job_cond,    NULL);
-
-    pthread_mutex_init(&c->current_job_lock, NULL);
-    pthread_mutex_lock(&c->current_job_lock);
-    for (i = 0; i < nb_threads; i++) {
-        ret = pthread_create(&c->workers[i], NULL, worker, c);
-        if (ret) {
-           pthread_mutex_unlock(&c->current_job_lock);
-           c->nb_threads = i;
-           slice_thread_uninit(c);
-           return AVERROR(ret);
-        }
-    }
-
-    slice_thread_park_workers(c);
-
-    return c->nb_threads;
+    return ret;
 }
 
 int ff_graph_thread_init(AVFilterGraph *graph)
@@ -229,3 +181,279 @@ void ff_graph_thread_free(AVFilterGraph *graph)
         slice_thread_uninit(graph->internal->thread);
     av_freep(&graph->internal->thread);
 }
+
+static AVFrame *branch_pop(ThreadBranch *b)
+{
+    AVFrame *frame = b->queue[b->queue_start];
+
+    b->queue_start = (b->queue_start + 1) % BRANCH_QUEUE_SIZE;
+    b->nb_queued--;
+
+    return frame;
+}
+
+static void* attribute_align_arg branch_worker(void *v)
+{
+    ThreadBranch *b = v;
+
+    pthread_mutex_lock(&b->lock);
+    for (;;) {
+        AVFrame *frame;
+        int ret;
+
+        while (!b->done && (!b->nb_queued || b->entered))
+            pthread_cond_wait(&b->cond, &b->lock);
+        if (b->done)
+            break;
+
+        frame   = branch_pop(b);
+        b->busy = 1;
+        pthread_cond_broadcast(&b->cond);
+        pthread_mutex_unlock(&b->lock);
+
+        ret = ff_filter_frame_direct(b->link, frame);
+
+        pthread_mutex_lock(&b->lock);
+        if (ret < 0 && !b->error)
+            b->error = ret;
+        b->busy = 0;
+        pthread_cond_broadcast(&b->cond);
+    }
+    pthread_mutex_unlock(&b->lock);
+
+    return NULL;
+}
+
+/* Pass the queued frames down the branch in the calling thread, which must
+ * have entered it. Return the number of frames passed or an error. */
+static int branch_flush(ThreadBranch *b)
+{
+    int nb_frames = 0, ret = 0;
+
+    for (;;) {
+        AVFrame *frame = NULL;
+        int err;
+
+        pthread_mutex_lock(&b->lock);
+        if (b->nb_queued)
+            frame = branch_pop(b);
+        pthread_cond_broadcast(&b->cond);
+        pthread_mutex_unlock(&b->lock);
+
+        if (!frame)
+            break;
+
+        err = ff_filter_frame_direct(b->link, frame);
+        if (err < 0 && !ret)
+            ret = err;
+        nb_frames++;
+    }
+
+    pthread_mutex_lock(&b->lock);
+    if (!ret)
+        ret = b->error;
+    b->error = 0;
+    pthread_mutex_unlock(&b->lock);
+
+    return ret < 0 ? ret : nb_frames;
+}
+
+int ff_branch_filter_frame(AVFilterLink *link, AVFrame *frame)
+{
+    ThreadBranch *b = link->dst->internal->branch;
+    int ret;
+
+    pthread_mutex_lock(&b->lock);
+    if (b->error) {
+        ret      = b->error;
+        b->error = 0;
+        pthread_mutex_unlock(&b->lock);
+        av_frame_free(&frame);
+        return ret;
+    }
+    if (b->entered) {
+        /* the caller is already inside the branch, so the frame is
+         * filtered right away as in the single-threaded case */
+        pthread_mutex_unlock(&b->lock);
+        ret = branch_flush(b);
+        if (ret < 0) {
+            av_frame_free(&frame);
+            return ret;
+        }
+        return ff_filter_frame_direct(link, frame);
+    }
+
+    while (b->nb_queued == BRANCH_QUEUE_SIZE)
+        pthread_cond_wait(&b->cond, &b->lock);
+    b->queue[(b->queue_start + b->nb_queued++) % BRANCH_QUEUE_SIZE] = frame;
+    pthread_cond_broadcast(&b->cond);
+    pthread_mutex_unlock(&b->lock);
+
+    return 0;
+}
+
+int ff_branch_flush(AVFilterLink *link)
+{
+    return branch_flush(link->dst->internal->branch);
+}
+
+void ff_branch_enter(AVFilterContext *ctx)
+{
+    ThreadBranch *b = ctx->internal->branch;
+
+    if (!b)
+        return;
+
+    pthread_mutex_lock(&b->lock);
+    while (b->busy)
+        pthread_cond_wait(&b->cond, &b->lock);
+    b->entered = 1;
+    pthread_mutex_unlock(&b->lock);
+}
+
+void ff_branch_leave(AVFilterContext *ctx)
+{
+    ThreadBranch *b = ctx->internal->branch;
+
+    if (!b)
+        return;
+
+    pthread_mutex_lock(&b->lock);
+    b->entered = 0;
+    pthread_cond_broadcast(&b->cond);
+    pthread_mutex_unlock(&b->lock);
+}
+
+/* Check that a filter and everything downstream of it can be moved to a
+ * branch: nothing but the branch input may feed them. */
+static int branch_check(AVFilterContext *ctx)
+{
+    int i;
+
+    if (ctx->nb_inputs != 1 || ctx->internal->branch)
+        return 0;
+
+    for (i = 0; i < ctx->nb_outputs; i++)
+        if (!branch_check(ctx->outputs[i]->dst))
+            return 0;
+
+    return 1;
+}
+
+static void branch_mark(AVFilterContext *ctx, ThreadBranch *b)
+{
+    int i;
+
+    ctx->internal->branch = b;
+    for (i = 0; i < ctx->nb_outputs; i++)
+        branch_mark(ctx->outputs[i]->dst, b);
+}
+
+static void branch_free(ThreadBranch **pb)
+{
+    ThreadBranch *b = *pb;
+
+    if (!b)
+        return;
+
+    pthread_mutex_lock(&b->lock);
+    b->done = 1;
+    pthread_cond_broadcast(&b->cond);
+    pthread_mutex_unlock(&b->lock);
+    pthread_join(b->thread, NULL);
+
+    while (b->nb_queued) {
+        AVFrame *frame = branch_pop(b);
+        av_frame_free(&frame);
+    }
+
+    pthread_mutex_destroy(&b->lock);
+    pthread_cond_destroy(&b->cond);
+    av_freep(pb);
+}
+
+static int branch_init(BranchContext *bc, AVFilterLink *link)
+{
+    ThreadBranch *b;
+    int ret;
+
+    b = av_mallocz(sizeof(*b));
+    if (!b)
+        return AVERROR(ENOMEM);
+    b->link = link;
+
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->cond, NULL);
+
+    ret = pthread_create(&b->thread, NULL, branch_worker, b);
+    if (ret) {
+        pthread_mutex_destroy(&b->lock);
+        pthread_cond_destroy(&b->cond);
+        av_free(b);
+        return AVERROR(ret);
+    }
+
+    bc->branches[bc->nb_branches++] = b;
+    branch_mark(link->dst, b);
+    link->dst->internal->branch_input = 1;
+
+    return 0;
+}
+
+int ff_graph_branch_init(AVFilterGraph *graph)
+{
+    BranchContext *bc;
+    int i, j, ret;
+
+    if (!(graph->thread_type & AVFILTER_THREAD_FRAME) ||
+        !graph->internal->thread || graph->internal->branches)
+        return 0;
+
+    bc = av_mallocz(sizeof(*bc));
+    if (!bc)
+        return AVERROR(ENOMEM);
+    bc->branches = av_mallocz_array(graph->nb_threads, sizeof(*bc->branches));
+    if (!bc->branches) {
+        av_free(bc);
+        return AVERROR(ENOMEM);
+    }
+    graph->internal->branches = bc;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *ctx = graph->filters[i];
+
+        if (ctx->nb_outputs < 2 || ctx->internal->branch)
+            continue;
+
+        for (j = 0; j < ctx->nb_outputs; j++) {
+            if (bc->nb_branches == graph->nb_threads)
+                break;
+            if (!branch_check(ctx->outputs[j]->dst))
+                continue;
+
+            ret = branch_init(bc, ctx->outputs[j]);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    if (bc->nb_branches)
+        av_log(graph, AV_LOG_VERBOSE, "Running %d branches of the graph "
+               "in separate threads.\n", bc->nb_branches);
+
+    return 0;
+}
+
+void ff_graph_branch_free(AVFilterGraph *graph)
+{
+    BranchContext *bc = graph->internal->branches;
+    int i;
+
+    if (!bc)
+        return;
+
+    for (i = 0; i < bc->nb_branches; i++)
+        branch_free(&bc->branches[i]);
+    av_freep(&bc->branches);
+    av_freep(&graph->internal->branches);
+}
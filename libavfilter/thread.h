@@ -25,4 +25,38 @@ int ff_graph_thread_init(AVFilterGraph *graph);
 
 void ff_graph_thread_free(AVFilterGraph *graph);
 
+/**
+ * Move the independent branches of a configured graph to separate threads.
+ */
+int ff_graph_branch_init(AVFilterGraph *graph);
+
+void ff_graph_branch_free(AVFilterGraph *graph);
+
+/**
+ * Queue a frame for the branch fed by link.
+ */
+int ff_branch_filter_frame(AVFilterLink *link, AVFrame *frame);
+
+/**
+ * Pass the frames queued on the input link of a branch down the branch in
+ * the calling thread.
+ *
+ * @return the number of frames passed or a negative error code
+ */
+int ff_branch_flush(AVFilterLink *link);
+
+/**
+ * Wait for the thread of the branch a filter belongs to to be idle and
+ * prevent it from running until ff_branch_leave(), so that the caller can
+ * run the filters of the branch itself.
+ */
+void ff_branch_enter(AVFilterContext *ctx);
+
+void ff_branch_leave(AVFilterContext *ctx);
+
+/**
+ * Same as ff_filter_frame(), but always run in the calling thread.
+ */
+int ff_filter_frame_direct(AVFilterLink *link, AVFrame *frame);
+
 #endif /* AVFILTER_THREAD_H */
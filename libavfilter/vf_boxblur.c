@@ -72,7 +72,9 @@ typedef struct BoxBlurContext {
     int hsub, vsub;
     int radius[4];
     int power[4];
-    uint8_t *temp[2]; ///< temporary buffer used in blur_power()
+    uint8_t *temp[2]; ///< temporary buffers used in blur_power(), one line per job
+    int temp_size;    ///< size of a temporary line
+    int nb_jobs;      ///< number of slices processed concurrently
 } BoxBlurContext;
 
 #define Y 0
@@ -139,11 +141,14 @@ static int config_input(AVFilterLink *inlink)
     char *expr;
     int ret;
 
+    s->nb_jobs   = FFMAX(ctx->graph->nb_threads, 1);
+    s->temp_size = FFMAX(w, h);
+
     av_freep(&s->temp[0]);
     av_freep(&s->temp[1]);
-    if (!(s->temp[0] = av_malloc(FFMAX(w, h))))
+    if (!(s->temp[0] = av_malloc_array(s->nb_jobs, s->temp_size)))
        return AVERROR(ENOMEM);
-    if (!(s->temp[1] = av_malloc(FFMAX(w, h)))) {
+    if (!(s->temp[1] = av_malloc_array(s->nb_jobs, s->temp_size))) {
         av_freep(&s->temp[0]);
         return AVERROR(ENOMEM);
     }
@@ -298,16 +303,70 @@ static void vblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_li
                    h, radius, power, temp);
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int w[4], h[4];
+} ThreadData;
+
+/* Each job blurs a band of rows horizontally, then a band of columns
+ * vertically, using its own temporary lines. */
+static int filter_hblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *in  = td->in;
+    AVFrame *out = td->out;
+    uint8_t *temp[2] = { s->temp[0] + jobnr * s->temp_size,
+                         s->temp[1] + jobnr * s->temp_size };
+    int plane;
+
+    for (plane = 0; in->data[plane] && plane < 4; plane++) {
+        int slice_start = td->h[plane] *  jobnr      / nb_jobs;
+        int slice_end   = td->h[plane] * (jobnr + 1) / nb_jobs;
+
+        hblur(out->data[plane] + slice_start * out->linesize[plane], out->linesize[plane],
+              in ->data[plane] + slice_start * in ->linesize[plane], in ->linesize[plane],
+              td->w[plane], slice_end - slice_start,
+              s->radius[plane], s->power[plane], temp);
+    }
+
+    return 0;
+}
+
+static int filter_vblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *out = td->out;
+    uint8_t *temp[2] = { s->temp[0] + jobnr * s->temp_size,
+                         s->temp[1] + jobnr * s->temp_size };
+    int plane;
+
+    for (plane = 0; out->data[plane] && plane < 4; plane++) {
+        int slice_start = td->w[plane] *  jobnr      / nb_jobs;
+        int slice_end   = td->w[plane] * (jobnr + 1) / nb_jobs;
+
+        vblur(out->data[plane] + slice_start, out->linesize[plane],
+              out->data[plane] + slice_start, out->linesize[plane],
+              slice_end - slice_start, td->h[plane],
+              s->radius[plane], s->power[plane], temp);
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     BoxBlurContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     AVFrame *out;
-    int plane;
     int cw = inlink->w >> s->hsub, ch = in->height >> s->vsub;
-    int w[4] = { inlink->w, cw, cw, inlink->w };
-    int h[4] = { in->height, ch, ch, in->height };
+    ThreadData td = {
+        .in = in,
+        .w  = { inlink->w, cw, cw, inlink->w },
+        .h  = { in->height, ch, ch, in->height },
+    };
 
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
@@ -315,18 +374,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         return AVERROR(ENOMEM);
     }
     av_frame_copy_props(out, in);
+    td.out = out;
 
-    for (plane = 0; in->data[plane] && plane < 4; plane++)
-        hblur(out->data[plane], out->linesize[plane],
-              in ->data[plane], in ->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp);
-
-    for (plane = 0; in->data[plane] && plane < 4; plane++)
-        vblur(out->data[plane], out->linesize[plane],
-              out->data[plane], out->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp);
+    ctx->internal->execute(ctx, filter_hblur_slice, &td, NULL, s->nb_jobs);
+    ctx->internal->execute(ctx, filter_vblur_slice, &td, NULL, s->nb_jobs);
 
     av_frame_free(&in);
 
@@ -384,4 +435,6 @@ AVFilter ff_vf_boxblur = {
 
     .inputs    = avfilter_vf_boxblur_inputs,
     .outputs   = avfilter_vf_boxblur_outputs,
+
+    .flags     = AVFILTER_FLAG_SLICE_THREADS,
 };
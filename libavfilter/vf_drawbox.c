@@ -92,13 +92,29 @@ static int config_input(AVFilterLink *inlink)
     return 0;
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+/* first row drawn by a job, the chroma rows are not shared between jobs */
+static int slice_row(DrawBoxContext *s, int y_start, int y_end,
+                     int jobnr, int nb_jobs)
 {
-    DrawBoxContext *s = inlink->dst->priv;
+    if (!jobnr)
+        return y_start;
+    if (jobnr == nb_jobs)
+        return y_end;
+    return FFMAX(y_start, (y_start + (y_end - y_start) * jobnr / nb_jobs) &
+                          ~((1 << s->vsub) - 1));
+}
+
+static int draw_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawBoxContext *s = ctx->priv;
+    AVFrame *frame = arg;
     int plane, x, y, xb = s->x, yb = s->y;
+    int y_start = FFMAX(yb, 0);
+    int y_end   = FFMIN(frame->height, yb + s->h);
+    int slice_end = slice_row(s, y_start, y_end, jobnr + 1, nb_jobs);
     unsigned char *row[4];
 
-    for (y = FFMAX(yb, 0); y < frame->height && y < (yb + s->h); y++) {
+    for (y = slice_row(s, y_start, y_end, jobnr, nb_jobs); y < slice_end; y++) {
         row[0] = frame->data[0] + y * frame->linesize[0];
 
         for (plane = 1; plane < 3; plane++)
@@ -117,7 +133,20 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
         }
     }
 
-    return ff_filter_frame(inlink->dst->outputs[0], frame);
+    return 0;
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+{
+    AVFilterContext *ctx = inlink->dst;
+    DrawBoxContext *s = ctx->priv;
+    int h = FFMIN(frame->height, s->y + s->h) - FFMAX(s->y, 0);
+
+    if (h > 0)
+        ctx->internal->execute(ctx, draw_slice, frame, NULL,
+                               FFMIN(h, ctx->graph->nb_threads));
+
+    return ff_filter_frame(ctx->outputs[0], frame);
 }
 
 #define OFFSET(x) offsetof(DrawBoxContext, x)
@@ -168,4 +197,5 @@ AVFilter ff_vf_drawbox = {
     .query_formats   = query_formats,
     .inputs    = avfilter_vf_drawbox_inputs,
     .outputs   = avfilter_vf_drawbox_outputs,
+    .flags     = AVFILTER_FLAG_SLICE_THREADS,
 };
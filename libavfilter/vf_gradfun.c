@@ -79,18 +79,41 @@ void ff_gradfun_blur_line_c(uint16_t *dc, uint16_t *buf, uint16_t *buf1, uint8_t
     }
 }
 
-static void filter(GradFunContext *ctx, uint8_t *dst, uint8_t *src, int width, int height, int dst_linesize, int src_linesize, int r)
+/**
+ * Filter the rows slice_start to slice_end - 1 of a plane. Every slice but
+ * the first one starts at an even row in [r, height - r).
+ */
+static void filter(GradFunContext *ctx, uint16_t *tmp_buf, uint8_t *dst, uint8_t *src,
+                   int width, int height, int dst_linesize, int src_linesize, int r,
+                   int slice_start, int slice_end)
 {
     int bstride = FFALIGN(width, 16) / 2;
     int y;
     uint32_t dc_factor = (1 << 21) / (r * r);
-    uint16_t *dc = ctx->buf + 16;
-    uint16_t *buf = ctx->buf + bstride + 32;
+    uint16_t *dc = tmp_buf + 16;
+    uint16_t *buf = tmp_buf + bstride + 32;
     int thresh = ctx->thresh;
 
+    if (slice_start >= slice_end)
+        return;
+
     memset(dc, 0, (bstride + 16) * sizeof(*buf));
-    for (y = 0; y < r; y++)
-        ctx->blur_line(dc, buf + y * bstride, buf + (y - 1) * bstride, src + 2 * y * src_linesize, src_linesize, width / 2);
+    if (!slice_start) {
+        for (y = 0; y < r; y++)
+            ctx->blur_line(dc, buf + y * bstride, buf + (y - 1) * bstride, src + 2 * y * src_linesize, src_linesize, width / 2);
+    } else {
+        /* The blurred rows only depend on the differences of the running
+         * sums over the last r row pairs, so the sums can be restarted from
+         * zero r row pairs before the first one needed by the slice. */
+        int start = (slice_start + r) / 2 - r;
+        for (y = start; y < start + r; y++) {
+            int mod = y % r;
+            uint16_t *buf1 = y == start ? buf - bstride :
+                             buf + (mod ? mod - 1 : r - 1) * bstride;
+            ctx->blur_line(dc, buf + mod * bstride, buf1, src + 2 * y * src_linesize, src_linesize, width / 2);
+        }
+        y = slice_start;
+    }
     for (;;) {
         if (y < height - r) {
             int mod = ((y + r) / 2) % r;
@@ -109,14 +132,16 @@ static void filter(GradFunContext *ctx, uint8_t *dst, uint8_t *src, int width, i
             for (x = -r / 2; x < 0; x++)
                 dc[x] = dc[0];
         }
-        if (y == r) {
+        if (y == r && !slice_start) {
             for (y = 0; y < r; y++)
                 ctx->filter_line(dst + y * dst_linesize, src + y * src_linesize, dc - r / 2, width, thresh, dither[y & 7]);
+            if (y >= slice_end)
+                break;
         }
         ctx->filter_line(dst + y * dst_linesize, src + y * src_linesize, dc - r / 2, width, thresh, dither[y & 7]);
-        if (++y >= height) break;
+        if (++y >= slice_end) break;
         ctx->filter_line(dst + y * dst_linesize, src + y * src_linesize, dc - r / 2, width, thresh, dither[y & 7]);
-        if (++y >= height) break;
+        if (++y >= slice_end) break;
     }
     emms_c();
 }
@@ -167,8 +192,11 @@ static int config_input(AVFilterLink *inlink)
     int hsub = desc->log2_chroma_w;
     int vsub = desc->log2_chroma_h;
 
+    s->nb_jobs  = FFMAX(inlink->dst->graph->nb_threads, 1);
+    s->buf_size = FFALIGN(inlink->w, 16) * (s->radius + 1) / 2 + 32;
+
     av_freep(&s->buf);
-    s->buf = av_mallocz((FFALIGN(inlink->w, 16) * (s->radius + 1) / 2 + 32) * sizeof(uint16_t));
+    s->buf = av_mallocz_array(s->nb_jobs, s->buf_size * sizeof(uint16_t));
     if (!s->buf)
         return AVERROR(ENOMEM);
 
@@ -179,14 +207,81 @@ static int config_input(AVFilterLink *inlink)
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
+/* first row of a slice, the rows whose blur depends on the top or bottom
+ * edge of the plane stay in the first and last slices */
+static int slice_row(int h, int r, int jobnr, int nb_jobs)
+{
+    if (!jobnr)
+        return 0;
+    if (jobnr == nb_jobs)
+        return h;
+    return r + ((h - 2 * r) * jobnr / nb_jobs & ~1);
+}
+
+static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    GradFunContext *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+    ThreadData *td = arg;
+    AVFrame *in  = td->in;
+    AVFrame *out = td->out;
+    int p;
+
+    for (p = 0; p < 4 && in->data[p]; p++) {
+        int w = inlink->w;
+        int h = inlink->h;
+        int r = s->radius;
+        int slice_start, slice_end, filtered;
+        if (p) {
+            w = s->chroma_w;
+            h = s->chroma_h;
+            r = s->chroma_r;
+        }
+        filtered = w;
+
+        if (FFMIN(w, h) > 2 * r) {
+            slice_start = slice_row(h, r, jobnr,     nb_jobs);
+            slice_end   = slice_row(h, r, jobnr + 1, nb_jobs);
+            filter(s, s->buf + jobnr * s->buf_size,
+                   out->data[p], in->data[p], w, h, out->linesize[p], in->linesize[p], r,
+                   slice_start, slice_end);
+        } else {
+            slice_start = h *  jobnr      / nb_jobs;
+            slice_end   = h * (jobnr + 1) / nb_jobs;
+            filtered    = 0;
+        }
+
+        /* copy what was not filtered, e.g. the second half of the
+         * interleaved chroma plane of nv12 */
+        if (out->data[p] != in->data[p] && slice_end > slice_start) {
+            int bytewidth = av_image_get_linesize(inlink->format, inlink->w, p);
+            av_image_copy_plane(out->data[p] + slice_start * out->linesize[p] + filtered,
+                                out->linesize[p],
+                                in->data[p]  + slice_start * in->linesize[p]  + filtered,
+                                in->linesize[p],
+                                bytewidth - filtered, slice_end - slice_start);
+        }
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
-    GradFunContext *s = inlink->dst->priv;
-    AVFilterLink *outlink = inlink->dst->outputs[0];
+    AVFilterContext *ctx = inlink->dst;
+    GradFunContext *s = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
+    ThreadData td;
     AVFrame *out;
-    int p, direct;
+    int direct;
 
-    if (av_frame_is_writable(in)) {
+    /* slices read the source rows around them, so they cannot be filtered
+     * in place */
+    if (av_frame_is_writable(in) && s->nb_jobs == 1) {
         direct = 1;
         out = in;
     } else {
@@ -202,21 +297,9 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         out->height = outlink->h;
     }
 
-    for (p = 0; p < 4 && in->data[p]; p++) {
-        int w = inlink->w;
-        int h = inlink->h;
-        int r = s->radius;
-        if (p) {
-            w = s->chroma_w;
-            h = s->chroma_h;
-            r = s->chroma_r;
-        }
-
-        if (FFMIN(w, h) > 2 * r)
-            filter(s, out->data[p], in->data[p], w, h, out->linesize[p], in->linesize[p], r);
-        else if (out->data[p] != in->data[p])
-            av_image_copy_plane(out->data[p], out->linesize[p], in->data[p], in->linesize[p], w, h);
-    }
+    td.in  = in;
+    td.out = out;
+    ctx->internal->execute(ctx, filter_slice, &td, NULL, s->nb_jobs);
 
     if (!direct)
         av_frame_free(&in);
@@ -268,4 +351,5 @@ AVFilter ff_vf_gradfun = {
 
     .inputs    = avfilter_vf_gradfun_inputs,
     .outputs   = avfilter_vf_gradfun_outputs,
+    .flags     = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -155,21 +155,40 @@ static int denoise_depth(HQDN3DContext *s,
 
 #define denoise(...)                                                          \
     do {                                                                      \
-        int ret = AVERROR_INVALIDDATA;                                        \
+        ret = AVERROR_INVALIDDATA;                                            \
         switch (s->depth) {                                                   \
             case  8: ret = denoise_depth(__VA_ARGS__,  8); break;             \
             case  9: ret = denoise_depth(__VA_ARGS__,  9); break;             \
             case 10: ret = denoise_depth(__VA_ARGS__, 10); break;             \
             case 16: ret = denoise_depth(__VA_ARGS__, 16); break;             \
         }                                                                     \
-        if (ret < 0) {                                                        \
-            av_frame_free(&out);                                              \
-            if (!direct)                                                      \
-                av_frame_free(&in);                                           \
-            return ret;                                                       \
-        }                                                                     \
     } while (0)
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
+/* Both the spatial and the temporal filters are recursive, so the planes are
+ * denoised concurrently, each one with its own line buffer. */
+static int denoise_plane(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    HQDN3DContext *s = ctx->priv;
+    ThreadData *td   = arg;
+    AVFrame *in  = td->in;
+    AVFrame *out = td->out;
+    int c = jobnr;
+    int ret;
+
+    denoise(s, in->data[c], out->data[c],
+            s->line[c], &s->frame_prev[c],
+            in->width  >> (!!c * s->hsub),
+            in->height >> (!!c * s->vsub),
+            in->linesize[c], out->linesize[c],
+            s->coefs[c?2:0], s->coefs[c?3:1]);
+
+    return ret;
+}
+
 static int16_t *precalc_coefs(double dist25, int depth)
 {
     int i;
@@ -223,7 +242,9 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->coefs[1]);
     av_freep(&s->coefs[2]);
     av_freep(&s->coefs[3]);
-    av_freep(&s->line);
+    av_freep(&s->line[0]);
+    av_freep(&s->line[1]);
+    av_freep(&s->line[2]);
     av_freep(&s->frame_prev[0]);
     av_freep(&s->frame_prev[1]);
     av_freep(&s->frame_prev[2]);
@@ -271,9 +292,11 @@ static int config_input(AVFilterLink *inlink)
     s->vsub  = desc->log2_chroma_h;
     s->depth = desc->comp[0].depth;
 
-    s->line = av_malloc(inlink->w * sizeof(*s->line));
-    if (!s->line)
-        return AVERROR(ENOMEM);
+    for (i = 0; i < 3; i++) {
+        s->line[i] = av_malloc(inlink->w * sizeof(*s->line[i]));
+        if (!s->line[i])
+            return AVERROR(ENOMEM);
+    }
 
     for (i = 0; i < 4; i++) {
         s->coefs[i] = precalc_coefs(s->strength[i], s->depth);
@@ -289,10 +312,11 @@ static int config_input(AVFilterLink *inlink)
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
-    HQDN3DContext *s = inlink->dst->priv;
-    AVFilterLink *outlink = inlink->dst->outputs[0];
+    AVFilterContext *ctx  = inlink->dst;
+    AVFilterLink *outlink = ctx->outputs[0];
+    ThreadData td;
     AVFrame *out;
-    int c, direct = av_frame_is_writable(in);
+    int c, ret[3], direct = av_frame_is_writable(in);
 
     if (direct) {
         out = in;
@@ -308,18 +332,20 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         out->height = outlink->h;
     }
 
-    for (c = 0; c < 3; c++) {
-        denoise(s, in->data[c], out->data[c],
-                s->line, &s->frame_prev[c],
-                in->width  >> (!!c * s->hsub),
-                in->height >> (!!c * s->vsub),
-                in->linesize[c], out->linesize[c],
-                s->coefs[c?2:0], s->coefs[c?3:1]);
-    }
+    td.in  = in;
+    td.out = out;
+    ctx->internal->execute(ctx, denoise_plane, &td, ret, 3);
 
     if (!direct)
         av_frame_free(&in);
 
+    for (c = 0; c < 3; c++) {
+        if (ret[c] < 0) {
+            av_frame_free(&out);
+            return ret[c];
+        }
+    }
+
     return ff_filter_frame(outlink, out);
 }
 
@@ -371,4 +397,6 @@ AVFilter ff_vf_hqdn3d = {
     .inputs    = avfilter_vf_hqdn3d_inputs,
 
     .outputs   = avfilter_vf_hqdn3d_outputs,
+
+    .flags     = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -195,11 +195,18 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
-static void blend_frame(AVFilterContext *ctx,
-                        AVFrame *dst, AVFrame *src,
-                        int x, int y)
+typedef struct ThreadData {
+    AVFrame *dst, *src;
+    int x, y;
+} ThreadData;
+
+static int blend_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     OverlayContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *dst = td->dst;
+    AVFrame *src = td->src;
+    int x = td->x, y = td->y;
     int i, j, k;
     int width, height;
     int overlay_end_y = y + src->height;
@@ -215,9 +222,13 @@ static void blend_frame(AVFilterContext *ctx,
         uint8_t *sp = src->data[0];
         int b = dst->format == AV_PIX_FMT_BGR24 ? 2 : 0;
         int r = dst->format == AV_PIX_FMT_BGR24 ? 0 : 2;
+        int slice_start = height *  jobnr      / nb_jobs;
+        int slice_end   = height * (jobnr + 1) / nb_jobs;
         if (y < 0)
             sp += -y * src->linesize[0];
-        for (i = 0; i < height; i++) {
+        dp += slice_start * dst->linesize[0];
+        sp += slice_start * src->linesize[0];
+        for (i = slice_start; i < slice_end; i++) {
             uint8_t *d = dp, *s = sp;
             for (j = 0; j < width; j++) {
                 d[r] = (d[r] * (0xff - s[3]) + s[0] * s[3] + 128) >> 8;
@@ -239,11 +250,16 @@ static void blend_frame(AVFilterContext *ctx,
             uint8_t *ap = src->data[3];
             int wp = FFALIGN(width, 1<<hsub) >> hsub;
             int hp = FFALIGN(height, 1<<vsub) >> vsub;
+            int slice_start = hp *  jobnr      / nb_jobs;
+            int slice_end   = hp * (jobnr + 1) / nb_jobs;
             if (y < 0) {
                 sp += ((-y) >> vsub) * src->linesize[i];
                 ap += -y * src->linesize[3];
             }
-            for (j = 0; j < hp; j++) {
+            dp += slice_start * dst->linesize[i];
+            sp += slice_start * src->linesize[i];
+            ap += slice_start * (1 << vsub) * src->linesize[3];
+            for (j = slice_start; j < slice_end; j++) {
                 uint8_t *d = dp, *s = sp, *a = ap;
                 for (k = 0; k < wp; k++) {
                     // average alpha for color components, improve quality
@@ -269,6 +285,18 @@ static void blend_frame(AVFilterContext *ctx,
             }
         }
     }
+
+    return 0;
+}
+
+static void blend_frame(AVFilterContext *ctx,
+                        AVFrame *dst, AVFrame *src,
+                        int x, int y)
+{
+    ThreadData td = { .dst = dst, .src = src, .x = x, .y = y };
+
+    ctx->internal->execute(ctx, blend_slice, &td, NULL,
+                           FFMIN(src->height, ctx->graph->nb_threads));
 }
 
 static int filter_frame_main(AVFilterLink *inlink, AVFrame *frame)
@@ -428,4 +456,6 @@ AVFilter ff_vf_overlay = {
 
     .inputs    = avfilter_vf_overlay_inputs,
     .outputs   = avfilter_vf_overlay_outputs,
+
+    .flags     = AVFILTER_FLAG_SLICE_THREADS,
 };
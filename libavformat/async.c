@@ -0,0 +1,488 @@
+/*
+ * Asynchronous read-ahead protocol
+ *
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Asynchronous read-ahead protocol
+ *
+ * The nested resource is read by a separate thread into a ring buffer, so
+ * that the latency of the underlying protocol is overlapped with the work
+ * of the caller. Up to back_size bytes already returned to the caller are
+ * kept in the buffer, so seeks within the buffered window are served
+ * without touching the nested resource.
+ *
+ * When writing, the data is queued in the ring buffer and written to the
+ * nested resource by the thread. Seeks wait for the queued data to be
+ * written, and errors of the thread are returned by the next call.
+ */
+
+#include "config.h"
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#elif HAVE_W32THREADS
+#include "compat/w32pthreads.h"
+#endif
+
+#include "libavutil/avstring.h"
+#include "libavutil/common.h"
+#include "libavutil/error.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+
+#include "avformat.h"
+#include "url.h"
+
+#define READ_CHUNK_SIZE 32768
+
+typedef struct AsyncContext {
+    const AVClass *class;
+    URLContext *inner;
+    int64_t inner_size;
+
+    int buffer_size;
+    int back_size;
+    int64_t underruns;
+    int64_t overruns;
+    int64_t buffer_seeks;
+    int64_t buffered;
+
+    /* ring buffer; byte position pos of the resource is stored at
+     * buf[pos % buffer_size] and [buf_start, buf_end) is valid; when
+     * writing, [buf_start, buf_end) is the data not written yet */
+    uint8_t *buf;
+    int64_t buf_start;
+    int64_t buf_end;
+    int64_t pos;
+
+    int eof;
+    int error;
+
+    int seek_request;
+    int64_t seek_pos;
+    int64_t seek_ret;
+
+    int abort_request;
+    AVIOInterruptCB interrupt_callback;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond_wakeup_thread;
+    pthread_cond_t cond_wakeup_main;
+} AsyncContext;
+
+static int async_check_interrupt(void *arg)
+{
+    URLContext *h   = arg;
+    AsyncContext *c = h->priv_data;
+    int abort_request;
+
+    pthread_mutex_lock(&c->mutex);
+    abort_request = c->abort_request;
+    pthread_mutex_unlock(&c->mutex);
+
+    return abort_request || ff_check_interrupt(&h->interrupt_callback);
+}
+
+static void *async_thread(void *arg)
+{
+    URLContext *h   = arg;
+    AsyncContext *c = h->priv_data;
+    int64_t seek_pos;
+    int size, ret;
+
+    pthread_mutex_lock(&c->mutex);
+    for (;;) {
+        while (!c->abort_request && !c->seek_request &&
+               (c->eof || c->error ||
+                c->buf_end - c->buf_start >= c->buffer_size))
+            pthread_cond_wait(&c->cond_wakeup_thread, &c->mutex);
+        if (c->abort_request)
+            break;
+
+        if (c->seek_request) {
+            seek_pos = c->seek_pos;
+            pthread_mutex_unlock(&c->mutex);
+            ret = ffurl_seek(c->inner, seek_pos, SEEK_SET);
+            pthread_mutex_lock(&c->mutex);
+
+            if (ret >= 0) {
+                c->buf_start = c->buf_end = c->pos = seek_pos;
+                c->eof   = 0;
+                c->error = 0;
+            }
+            c->seek_ret     = ret;
+            c->seek_request = 0;
+            pthread_cond_signal(&c->cond_wakeup_main);
+            continue;
+        }
+
+        /* the area after buf_end is not accessed by the reader */
+        size = c->buffer_size - (c->buf_end - c->buf_start);
+        size = FFMIN(size, c->buffer_size - c->buf_end % c->buffer_size);
+        size = FFMIN(size, READ_CHUNK_SIZE);
+        pthread_mutex_unlock(&c->mutex);
+        ret = ffurl_read(c->inner, c->buf + c->buf_end % c->buffer_size, size);
+        pthread_mutex_lock(&c->mutex);
+
+        /* data read before a seek request was issued is stale */
+        if (c->seek_request)
+            continue;
+        if (ret > 0)
+            c->buf_end += ret;
+        else if (!ret || ret == AVERROR_EOF)
+            c->eof = 1;
+        else
+            c->error = ret;
+        pthread_cond_signal(&c->cond_wakeup_main);
+    }
+    pthread_mutex_unlock(&c->mutex);
+
+    return NULL;
+}
+
+static void *async_write_thread(void *arg)
+{
+    URLContext *h   = arg;
+    AsyncContext *c = h->priv_data;
+    int size, ret;
+
+    pthread_mutex_lock(&c->mutex);
+    for (;;) {
+        while (!c->abort_request && !c->error && c->buf_end == c->buf_start)
+            pthread_cond_wait(&c->cond_wakeup_thread, &c->mutex);
+        if (c->abort_request || c->error)
+            break;
+
+        /* the caller only appends after buf_end */
+        size = c->buf_end - c->buf_start;
+        size = FFMIN(size, c->buffer_size - c->buf_start % c->buffer_size);
+        size = FFMIN(size, READ_CHUNK_SIZE);
+        pthread_mutex_unlock(&c->mutex);
+        ret = ffurl_write(c->inner, c->buf + c->buf_start % c->buffer_size,
+                          size);
+        pthread_mutex_lock(&c->mutex);
+
+        if (ret < 0)
+            c->error = ret;
+        else
+            c->buf_start += size;
+        pthread_cond_signal(&c->cond_wakeup_main);
+    }
+    pthread_cond_signal(&c->cond_wakeup_main);
+    pthread_mutex_unlock(&c->mutex);
+
+    return NULL;
+}
+
+/* Wait until the thread has written all the queued data. */
+static int async_drain(URLContext *h)
+{
+    AsyncContext *c = h->priv_data;
+
+    while (c->buf_end != c->buf_start && !c->error) {
+        if (ff_check_interrupt(&h->interrupt_callback))
+            return AVERROR_EXIT;
+        pthread_cond_wait(&c->cond_wakeup_main, &c->mutex);
+    }
+
+    return c->error;
+}
+
+static int async_open(URLContext *h, const char *uri, int flags,
+                      AVDictionary **options)
+{
+    AsyncContext *c = h->priv_data;
+    const char *nested_url;
+    int ret;
+
+    if (!av_strstart(uri, "async:", &nested_url)) {
+        av_log(h, AV_LOG_ERROR, "Unsupported url %s\n", uri);
+        return AVERROR(EINVAL);
+    }
+
+    if ((flags & AVIO_FLAG_READ) && (flags & AVIO_FLAG_WRITE)) {
+        av_log(h, AV_LOG_ERROR,
+               "The async protocol does not support reading and writing\n");
+        return AVERROR(ENOSYS);
+    }
+
+    c->back_size = FFMIN(c->back_size, c->buffer_size / 2);
+
+    pthread_mutex_init(&c->mutex, NULL);
+    pthread_cond_init(&c->cond_wakeup_thread, NULL);
+    pthread_cond_init(&c->cond_wakeup_main, NULL);
+
+    c->interrupt_callback.callback = async_check_interrupt;
+    c->interrupt_callback.opaque   = h;
+
+    if ((ret = ffurl_open(&c->inner, nested_url, flags,
+                          &c->interrupt_callback, options,
+                          h->protocols, h)) < 0) {
+        av_log(h, AV_LOG_ERROR, "Unable to open resource: %s\n", nested_url);
+        goto fail;
+    }
+
+    /* packet boundaries are not preserved by the buffer */
+    if ((flags & AVIO_FLAG_WRITE) && c->inner->max_packet_size) {
+        av_log(h, AV_LOG_ERROR,
+               "Writing to packet based protocols is not supported\n");
+        ret = AVERROR(ENOSYS);
+        goto fail;
+    }
+
+    h->is_streamed = c->inner->is_streamed;
+    c->inner_size  = flags & AVIO_FLAG_WRITE ? -1 : ffurl_size(c->inner);
+
+    c->buf = av_malloc(c->buffer_size);
+    if (!c->buf) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    ret = pthread_create(&c->thread, NULL, flags & AVIO_FLAG_WRITE ?
+                         async_write_thread : async_thread, h);
+    if (ret) {
+        av_log(h, AV_LOG_ERROR, "pthread_create failed\n");
+        ret = AVERROR(ret);
+        goto fail;
+    }
+
+    return 0;
+fail:
+    av_freep(&c->buf);
+    ffurl_close(c->inner);
+    c->inner = NULL;
+    pthread_cond_destroy(&c->cond_wakeup_main);
+    pthread_cond_destroy(&c->cond_wakeup_thread);
+    pthread_mutex_destroy(&c->mutex);
+    return ret;
+}
+
+static int async_read(URLContext *h, unsigned char *buf, int size)
+{
+    AsyncContext *c = h->priv_data;
+    int64_t offset;
+    int len, ret = 0, waited = 0;
+
+    pthread_mutex_lock(&c->mutex);
+    while (!ret) {
+        if (c->buf_end > c->pos) {
+            while (ret < size && c->pos < c->buf_end) {
+                offset = c->pos % c->buffer_size;
+                len    = FFMIN(size - ret, c->buf_end - c->pos);
+                len    = FFMIN(len, c->buffer_size - offset);
+                memcpy(buf + ret, c->buf + offset, len);
+                ret    += len;
+                c->pos += len;
+            }
+            c->buf_start = FFMAX(c->buf_start, c->pos - c->back_size);
+            pthread_cond_signal(&c->cond_wakeup_thread);
+            break;
+        }
+
+        if (c->error) {
+            ret = c->error;
+            break;
+        }
+        if (c->eof) {
+            ret = AVERROR_EOF;
+            break;
+        }
+        if (ff_check_interrupt(&h->interrupt_callback)) {
+            ret = AVERROR_EXIT;
+            break;
+        }
+
+        if (!waited++)
+            c->underruns++;
+        pthread_cond_wait(&c->cond_wakeup_main, &c->mutex);
+    }
+    c->buffered = c->buf_end - c->pos;
+    pthread_mutex_unlock(&c->mutex);
+
+    return ret;
+}
+
+static int async_write(URLContext *h, const unsigned char *buf, int size)
+{
+    AsyncContext *c = h->priv_data;
+    int64_t offset;
+    int len, written = 0, waited = 0, ret = 0;
+
+    pthread_mutex_lock(&c->mutex);
+    while (written < size) {
+        if (c->error) {
+            ret = c->error;
+            break;
+        }
+
+        len = c->buffer_size - (c->buf_end - c->buf_start);
+        if (!len) {
+            if (ff_check_interrupt(&h->interrupt_callback)) {
+                ret = AVERROR_EXIT;
+                break;
+            }
+            if (!waited++)
+                c->overruns++;
+            pthread_cond_wait(&c->cond_wakeup_main, &c->mutex);
+            continue;
+        }
+
+        offset = c->buf_end % c->buffer_size;
+        len    = FFMIN(len, size - written);
+        len    = FFMIN(len, c->buffer_size - offset);
+        memcpy(c->buf + offset, buf + written, len);
+        c->buf_end += len;
+        written    += len;
+        pthread_cond_signal(&c->cond_wakeup_thread);
+    }
+    c->buffered = c->buf_end - c->buf_start;
+    pthread_mutex_unlock(&c->mutex);
+
+    return ret < 0 ? ret : written;
+}
+
+static int64_t async_write_seek(URLContext *h, int64_t pos, int whence)
+{
+    AsyncContext *c = h->priv_data;
+    int64_t ret;
+
+    /* the nested resource is only accessed by the thread while data is
+     * queued, so it can be used directly once everything is written */
+    pthread_mutex_lock(&c->mutex);
+    ret = async_drain(h);
+    if (!ret)
+        ret = ffurl_seek(c->inner, pos, whence);
+    if (ret >= 0 && whence != AVSEEK_SIZE)
+        c->buf_start = c->buf_end = ret;
+    pthread_mutex_unlock(&c->mutex);
+
+    return ret;
+}
+
+static int64_t async_seek(URLContext *h, int64_t pos, int whence)
+{
+    AsyncContext *c = h->priv_data;
+    int64_t ret;
+
+    if (h->flags & AVIO_FLAG_WRITE)
+        return async_write_seek(h, pos, whence);
+
+    if (whence == AVSEEK_SIZE)
+        return c->inner_size >= 0 ? c->inner_size : AVERROR(ENOSYS);
+
+    if (whence == SEEK_CUR) {
+        pos += c->pos;
+    } else if (whence == SEEK_END) {
+        if (c->inner_size < 0)
+            return AVERROR(ENOSYS);
+        pos += c->inner_size;
+    } else if (whence != SEEK_SET) {
+        return AVERROR(EINVAL);
+    }
+    if (pos < 0)
+        return AVERROR(EINVAL);
+
+    pthread_mutex_lock(&c->mutex);
+    if (pos >= c->buf_start && pos <= c->buf_end) {
+        /* release the data that is no longer within back_size, otherwise
+         * the thread could wait for space while we wait for data */
+        c->pos       = pos;
+        c->buf_start = FFMAX(c->buf_start, pos - c->back_size);
+        c->buffer_seeks++;
+        pthread_cond_signal(&c->cond_wakeup_thread);
+        ret = pos;
+    } else {
+        c->seek_request = 1;
+        c->seek_pos     = pos;
+        pthread_cond_signal(&c->cond_wakeup_thread);
+        while (c->seek_request)
+            pthread_cond_wait(&c->cond_wakeup_main, &c->mutex);
+        ret = c->seek_ret;
+    }
+    c->buffered = c->buf_end - c->pos;
+    pthread_mutex_unlock(&c->mutex);
+
+    return ret < 0 ? ret : pos;
+}
+
+static int async_close(URLContext *h)
+{
+    AsyncContext *c = h->priv_data;
+    int ret = 0, ret2;
+
+    pthread_mutex_lock(&c->mutex);
+    if (h->flags & AVIO_FLAG_WRITE) {
+        ret = async_drain(h);
+        if (ret < 0)
+            av_log(h, AV_LOG_ERROR, "Failed to write the queued data\n");
+    }
+    c->abort_request = 1;
+    pthread_cond_signal(&c->cond_wakeup_thread);
+    pthread_mutex_unlock(&c->mutex);
+
+    pthread_join(c->thread, NULL);
+
+    pthread_cond_destroy(&c->cond_wakeup_main);
+    pthread_cond_destroy(&c->cond_wakeup_thread);
+    pthread_mutex_destroy(&c->mutex);
+    av_freep(&c->buf);
+
+    if (h->flags & AVIO_FLAG_WRITE)
+        av_log(h, AV_LOG_VERBOSE, "%"PRId64" writes waited for the thread\n",
+               c->overruns);
+
+    ret2 = ffurl_close(c->inner);
+
+    return ret < 0 ? ret : ret2;
+}
+
+#define OFFSET(x) offsetof(AsyncContext, x)
+#define D AV_OPT_FLAG_DECODING_PARAM
+#define E AV_OPT_FLAG_ENCODING_PARAM
+#define X AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY
+static const AVOption options[] = {
+    { "buffer_size",  "Size of the buffer",                             OFFSET(buffer_size),  AV_OPT_TYPE_INT,   { .i64 = 4 << 20 }, 65536, INT_MAX,   D | E },
+    { "back_size",    "Amount of already read data kept for seeking",   OFFSET(back_size),    AV_OPT_TYPE_INT,   { .i64 = 256 << 10 }, 0, INT_MAX,     D },
+    { "buffered",     "Amount of data currently buffered",              OFFSET(buffered),     AV_OPT_TYPE_INT64, { .i64 = 0 },       0, INT64_MAX, D | E | X },
+    { "underruns",    "Number of reads that had to wait for data",      OFFSET(underruns),    AV_OPT_TYPE_INT64, { .i64 = 0 },       0, INT64_MAX, D | X },
+    { "buffer_seeks", "Number of seeks served from the buffer",         OFFSET(buffer_seeks), AV_OPT_TYPE_INT64, { .i64 = 0 },       0, INT64_MAX, D | X },
+    { "overruns",     "Number of writes that had to wait for space",    OFFSET(overruns),     AV_OPT_TYPE_INT64, { .i64 = 0 },       0, INT64_MAX, E | X },
+    { NULL }
+};
+
+static const AVClass async_class = {
+    .class_name = "async",
+    .item_name  = av_default_item_name,
+    .option     = options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
+const URLProtocol ff_async_protocol = {
+    .name            = "async",
+    .url_open2       = async_open,
+    .url_read        = async_read,
+    .url_write       = async_write,
+    .url_seek        = async_seek,
+    .url_close       = async_close,
+    .priv_data_size  = sizeof(AsyncContext),
+    .priv_data_class = &async_class,
+};
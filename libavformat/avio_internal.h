@@ -53,6 +53,20 @@ int ffio_init_context(AVIOContext *s,
  */
 int ffio_read_indirect(AVIOContext *s, unsigned char *buf, int size, const unsigned char **data);
 
+/**
+ * Read size bytes from AVIOContext without copying them, if the underlying
+ * resource is memory mapped and the bytes are followed by at least
+ * AV_INPUT_BUFFER_PADDING_SIZE bytes of the mapping. Unlike the padding of
+ * packets allocated by libavcodec, those bytes are not zeroed.
+ * @param s IO context
+ * @param size number of bytes requested
+ * @param buf set to a new read-only reference to the mapping
+ * @param data set to the first of the size bytes in the mapping
+ * @return size on success, AVERROR(ENOSYS) if the data is not mapped,
+ *         another AVERROR on failure
+ */
+int ffio_read_mapped(AVIOContext *s, int size, AVBufferRef **buf, uint8_t **data);
+
 void ffio_fill(AVIOContext *s, int b, int count);
 
 static av_always_inline void ffio_wfourcc(AVIOContext *pb, const uint8_t *s)
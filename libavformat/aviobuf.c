@@ -823,6 +823,46 @@ static int64_t io_read_seek(void *opaque, int stream_index, int64_t timestamp, i
     return internal->h->prot->url_read_seek(internal->h, stream_index, timestamp, flags);
 }
 
+int ffio_read_mapped(AVIOContext *s, int size, AVBufferRef **buf, uint8_t **data)
+{
+    AVIOInternal *internal = s->opaque;
+    int64_t pos, res;
+    AVBufferRef *map;
+    int ret;
+
+    /* the checksum has to be computed over the data read */
+    if (s->read_packet != io_read_packet || s->write_flag ||
+        s->update_checksum || size <= 0)
+        return AVERROR(ENOSYS);
+
+    if ((ret = ffurl_get_mapping(internal->h, &map)) < 0)
+        return ret;
+
+    pos = avio_tell(s);
+    if (pos < 0 || pos + size + AV_INPUT_BUFFER_PADDING_SIZE > map->size) {
+        av_buffer_unref(&map);
+        return AVERROR(ENOSYS);
+    }
+
+    if (s->buf_end - s->buf_ptr >= size) {
+        s->buf_ptr += size;
+    } else {
+        /* skip the data instead of reading it into the buffer */
+        if ((res = s->seek(s->opaque, pos + size, SEEK_SET)) < 0) {
+            av_buffer_unref(&map);
+            return res;
+        }
+        s->buf_end     = s->buffer;
+        s->buf_ptr     = s->buffer;
+        s->pos         = pos + size;
+        s->eof_reached = 0;
+    }
+
+    *buf  = map;
+    *data = map->data + pos;
+    return size;
+}
+
 int ffio_fdopen(AVIOContext **s, URLContext *h)
 {
     AVIOInternal *internal = NULL;
@@ -0,0 +1,295 @@
+/*
+ * Disk-backed caching protocol
+ *
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Disk-backed caching protocol
+ *
+ * Every range read from the nested resource is appended to a temporary
+ * file. A tree indexed by the position in the resource maps the cached
+ * ranges to their location in the file, so that data that was read once
+ * is served locally afterwards, whatever the seeks in between.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "libavutil/avstring.h"
+#include "libavutil/common.h"
+#include "libavutil/error.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/tree.h"
+
+#include "avformat.h"
+#include "os_support.h"
+#include "url.h"
+
+typedef struct CacheEntry {
+    int64_t logical_pos;
+    int64_t physical_pos;
+    int64_t size;
+} CacheEntry;
+
+typedef struct CacheContext {
+    const AVClass *class;
+    URLContext *inner;
+    int fd;
+    struct AVTreeNode *root;
+    int64_t logical_pos;
+    int64_t cache_pos;
+    int64_t inner_pos;
+    int64_t size;
+    int64_t cache_hit;
+    int64_t cache_miss;
+} CacheContext;
+
+static int cmp_pos(void *key, const void *node)
+{
+    int64_t pos             = *(const int64_t *)key;
+    const CacheEntry *entry = node;
+
+    return (pos > entry->logical_pos) - (pos < entry->logical_pos);
+}
+
+static int cache_open(URLContext *h, const char *uri, int flags,
+                      AVDictionary **options)
+{
+    CacheContext *c = h->priv_data;
+    const char *nested_url, *tmpdir;
+    char filename[1024];
+    int ret;
+
+    if (!av_strstart(uri, "cache:", &nested_url)) {
+        av_log(h, AV_LOG_ERROR, "Unsupported url %s\n", uri);
+        return AVERROR(EINVAL);
+    }
+
+    if (flags & AVIO_FLAG_WRITE) {
+        av_log(h, AV_LOG_ERROR, "The cache protocol only supports reading\n");
+        return AVERROR(ENOSYS);
+    }
+
+    tmpdir = getenv("TMPDIR");
+    snprintf(filename, sizeof(filename), "%s/avcacheXXXXXX",
+             tmpdir ? tmpdir : "/tmp");
+    c->fd = mkstemp(filename);
+    if (c->fd < 0) {
+        ret = AVERROR(errno);
+        av_log(h, AV_LOG_ERROR, "Failed to create the cache file %s\n",
+               filename);
+        return ret;
+    }
+    /* the file only has to live as long as the descriptor */
+    unlink(filename);
+
+    if ((ret = ffurl_open(&c->inner, nested_url, flags,
+                          &h->interrupt_callback, options,
+                          h->protocols, h)) < 0) {
+        av_log(h, AV_LOG_ERROR, "Unable to open resource: %s\n", nested_url);
+        close(c->fd);
+        return ret;
+    }
+
+    h->is_streamed = c->inner->is_streamed;
+    c->size        = -1;
+
+    return 0;
+}
+
+static int add_entry(URLContext *h, const unsigned char *buf, int size)
+{
+    CacheContext *c = h->priv_data;
+    CacheEntry *entry, *next[2] = { NULL, NULL };
+    struct AVTreeNode *node;
+    int64_t pos;
+    int ret, written = 0;
+
+    pos = lseek(c->fd, c->cache_pos, SEEK_SET);
+    if (pos < 0)
+        return AVERROR(errno);
+    while (written < size) {
+        ret = write(c->fd, buf + written, size - written);
+        if (ret < 0)
+            return AVERROR(errno);
+        written += ret;
+    }
+
+    /* extend the previous range if it is contiguous in the file as well */
+    entry = av_tree_find(c->root, &c->logical_pos, cmp_pos, (void **)next);
+    if (!entry)
+        entry = next[0];
+    if (entry &&
+        entry->logical_pos  + entry->size == c->logical_pos &&
+        entry->physical_pos + entry->size == c->cache_pos) {
+        entry->size += size;
+    } else {
+        entry = av_malloc(sizeof(*entry));
+        node  = av_tree_node_alloc();
+        if (!entry || !node) {
+            av_free(entry);
+            av_free(node);
+            return AVERROR(ENOMEM);
+        }
+        entry->logical_pos  = c->logical_pos;
+        entry->physical_pos = c->cache_pos;
+        entry->size         = size;
+        av_tree_insert(&c->root, entry, cmp_pos, &node);
+        if (node) {
+            av_free(entry);
+            av_free(node);
+            return AVERROR_BUG;
+        }
+    }
+    c->cache_pos += size;
+
+    return 0;
+}
+
+static int cache_read(URLContext *h, unsigned char *buf, int size)
+{
+    CacheContext *c = h->priv_data;
+    CacheEntry *entry, *next[2] = { NULL, NULL };
+    int64_t offset, pos;
+    int ret, cached = 0;
+
+    entry = av_tree_find(c->root, &c->logical_pos, cmp_pos, (void **)next);
+    if (!entry)
+        entry = next[0];
+
+    if (entry && c->logical_pos < entry->logical_pos + entry->size) {
+        offset = c->logical_pos - entry->logical_pos;
+        pos    = lseek(c->fd, entry->physical_pos + offset, SEEK_SET);
+        if (pos >= 0) {
+            ret = read(c->fd, buf, FFMIN(size, entry->size - offset));
+            if (ret > 0) {
+                c->logical_pos += ret;
+                c->cache_hit++;
+                return ret;
+            }
+        }
+        av_log(h, AV_LOG_WARNING, "Failed to read from the cache file\n");
+        /* fetch the range again, but do not add it to the cache twice */
+        size   = FFMIN(size, entry->size - offset);
+        cached = 1;
+    }
+
+    /* do not fetch again the data cached after the current position */
+    if (next[1])
+        size = FFMIN(size, next[1]->logical_pos - c->logical_pos);
+
+    if (c->inner_pos != c->logical_pos) {
+        pos = ffurl_seek(c->inner, c->logical_pos, SEEK_SET);
+        if (pos < 0) {
+            av_log(h, AV_LOG_ERROR, "Failed to seek the nested resource\n");
+            return pos;
+        }
+        c->inner_pos = pos;
+    }
+
+    ret = ffurl_read(c->inner, buf, size);
+    if (ret <= 0)
+        return ret;
+    c->inner_pos += ret;
+    c->cache_miss++;
+
+    if (!cached && add_entry(h, buf, ret) < 0)
+        av_log(h, AV_LOG_WARNING, "Failed to write to the cache file\n");
+    c->logical_pos += ret;
+
+    return ret;
+}
+
+static int64_t cache_seek(URLContext *h, int64_t pos, int whence)
+{
+    CacheContext *c = h->priv_data;
+
+    if (whence == AVSEEK_SIZE || whence == SEEK_END) {
+        if (c->size < 0)
+            c->size = ffurl_seek(c->inner, 0, AVSEEK_SIZE);
+        if (c->size < 0)
+            return AVERROR(ENOSYS);
+        if (whence == AVSEEK_SIZE)
+            return c->size;
+        pos += c->size;
+    } else if (whence == SEEK_CUR) {
+        pos += c->logical_pos;
+    } else if (whence != SEEK_SET) {
+        return AVERROR(EINVAL);
+    }
+    if (pos < 0)
+        return AVERROR(EINVAL);
+
+    /* the nested resource is only seeked when the data is not cached */
+    c->logical_pos = pos;
+
+    return pos;
+}
+
+static int free_entry(void *opaque, void *elem)
+{
+    av_free(elem);
+    return 0;
+}
+
+static int cache_close(URLContext *h)
+{
+    CacheContext *c = h->priv_data;
+
+    av_log(h, AV_LOG_VERBOSE, "%"PRId64" cache hits, %"PRId64" cache misses\n",
+           c->cache_hit, c->cache_miss);
+
+    close(c->fd);
+    av_tree_enumerate(c->root, NULL, NULL, free_entry);
+    av_tree_destroy(c->root);
+
+    return ffurl_close(c->inner);
+}
+
+#define OFFSET(x) offsetof(CacheContext, x)
+#define D AV_OPT_FLAG_DECODING_PARAM
+#define X AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY
+static const AVOption options[] = {
+    { "cache_hit",  "Number of reads served from the cache",      OFFSET(cache_hit),  AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, D | X },
+    { "cache_miss", "Number of reads from the nested resource",   OFFSET(cache_miss), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, D | X },
+    { NULL }
+};
+
+static const AVClass cache_class = {
+    .class_name = "cache",
+    .item_name  = av_default_item_name,
+    .option     = options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
+const URLProtocol ff_cache_protocol = {
+    .name            = "cache",
+    .url_open2       = cache_open,
+    .url_read        = cache_read,
+    .url_seek        = cache_seek,
+    .url_close       = cache_close,
+    .priv_data_size  = sizeof(CacheContext),
+    .priv_data_class = &cache_class,
+};
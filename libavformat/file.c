@@ -20,6 +20,7 @@
  */
 
 #include "libavutil/avstring.h"
+#include "libavutil/buffer.h"
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
 #include "avformat.h"
@@ -30,6 +31,9 @@
 #if HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #include <sys/stat.h>
 #include <stdlib.h>
 #include "os_support.h"
@@ -43,11 +47,15 @@ typedef struct FileContext {
     int fd;
     int trunc;
     int follow;
+    int use_mmap;
+    AVBufferRef *map;
+    int64_t map_pos;
 } FileContext;
 
 static const AVOption file_options[] = {
     { "truncate", "Truncate existing files on write", offsetof(FileContext, trunc), AV_OPT_TYPE_INT, { .i64 = 1 }, 0, 1, AV_OPT_FLAG_ENCODING_PARAM },
     { "follow", "Follow a file as it is being written", offsetof(FileContext, follow), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
+    { "mmap", "Map the file into memory to let demuxers avoid copies", offsetof(FileContext, use_mmap), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { NULL }
 };
 
@@ -61,7 +69,16 @@ static const AVClass file_class = {
 static int file_read(URLContext *h, unsigned char *buf, int size)
 {
     FileContext *c = h->priv_data;
-    int ret = read(c->fd, buf, size);
+    int ret;
+
+    if (c->map) {
+        size = FFMIN(size, FFMAX(c->map->size - c->map_pos, 0));
+        memcpy(buf, c->map->data + c->map_pos, size);
+        c->map_pos += size;
+        return size;
+    }
+
+    ret = read(c->fd, buf, size);
     if (ret == 0 && c->follow)
         return AVERROR(EAGAIN);
     return (ret == -1) ? AVERROR(errno) : ret;
@@ -100,6 +117,57 @@ static int file_check(URLContext *h, int mask)
 
 #if CONFIG_FILE_PROTOCOL
 
+#if HAVE_MMAP
+static void file_unmap(void *opaque, uint8_t *data)
+{
+    munmap(data, (size_t)(uintptr_t)opaque);
+}
+
+static int file_map(URLContext *h)
+{
+    FileContext *c = h->priv_data;
+    struct stat st;
+    void *ptr;
+
+    /* AVBufferRef sizes are ints */
+    if (fstat(c->fd, &st) < 0 || !S_ISREG(st.st_mode) ||
+        !st.st_size || st.st_size > INT_MAX) {
+        av_log(h, AV_LOG_VERBOSE, "Not mapping the file\n");
+        return 0;
+    }
+
+    /* private writable pages, so that the data can be modified in place
+     * without affecting the file */
+    ptr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+               c->fd, 0);
+    if (ptr == MAP_FAILED) {
+        av_log(h, AV_LOG_WARNING, "Cannot map the file: %s\n",
+               strerror(errno));
+        return 0;
+    }
+
+    c->map = av_buffer_create(ptr, st.st_size, file_unmap,
+                              (void *)(uintptr_t)st.st_size,
+                              AV_BUFFER_FLAG_READONLY);
+    if (!c->map) {
+        munmap(ptr, st.st_size);
+        return AVERROR(ENOMEM);
+    }
+
+    return 0;
+}
+
+static int file_get_mapping(URLContext *h, AVBufferRef **buf)
+{
+    FileContext *c = h->priv_data;
+
+    if (!c->map)
+        return AVERROR(ENOSYS);
+    *buf = av_buffer_ref(c->map);
+    return *buf ? 0 : AVERROR(ENOMEM);
+}
+#endif
+
 static int file_open(URLContext *h, const char *filename, int flags)
 {
     FileContext *c = h->priv_data;
@@ -126,6 +194,17 @@ static int file_open(URLContext *h, const char *filename, int flags)
     if (fd == -1)
         return AVERROR(errno);
     c->fd = fd;
+
+#if HAVE_MMAP
+    if (c->use_mmap && !(flags & AVIO_FLAG_WRITE) && !c->follow) {
+        int ret = file_map(h);
+        if (ret < 0) {
+            close(fd);
+            return ret;
+        }
+    }
+#endif
+
     return 0;
 }
 
@@ -135,6 +214,20 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
     FileContext *c = h->priv_data;
     int64_t ret;
 
+    if (c->map) {
+        if (whence == AVSEEK_SIZE)
+            return c->map->size;
+        if (whence == SEEK_CUR)
+            pos += c->map_pos;
+        else if (whence == SEEK_END)
+            pos += c->map->size;
+        else if (whence != SEEK_SET)
+            return AVERROR(EINVAL);
+        if (pos < 0)
+            return AVERROR(EINVAL);
+        return c->map_pos = pos;
+    }
+
     if (whence == AVSEEK_SIZE) {
         struct stat st;
 
@@ -150,6 +243,9 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
 static int file_close(URLContext *h)
 {
     FileContext *c = h->priv_data;
+
+    /* the mapping is released with the last packet referencing it */
+    av_buffer_unref(&c->map);
     return close(c->fd);
 }
 
@@ -162,6 +258,9 @@ const URLProtocol ff_file_protocol = {
     .url_close           = file_close,
     .url_get_file_handle = file_get_handle,
     .url_check           = file_check,
+#if HAVE_MMAP
+    .url_get_mapping     = file_get_mapping,
+#endif
     .priv_data_size      = sizeof(FileContext),
     .priv_data_class     = &file_class,
 };
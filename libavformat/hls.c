@@ -25,6 +25,14 @@
  * http://tools.ietf.org/html/draft-pantos-http-live-streaming
  */
 
+#include "config.h"
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#elif HAVE_W32THREADS
+#include "compat/w32pthreads.h"
+#endif
+
 #include "libavutil/avstring.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mathematics.h"
@@ -36,6 +44,7 @@
 #include "avio_internal.h"
 
 #define INITIAL_BUFFER_SIZE 32768
+#define PREFETCH_CHUNK_SIZE 32768
 
 /*
  * An apple http stream consists of a playlist with media segment files,
@@ -62,6 +71,20 @@ struct segment {
     uint8_t iv[16];
 };
 
+/*
+ * A segment downloaded ahead of the demuxer by the prefetch thread of a
+ * variant. The data grows while the download is in progress and the
+ * demuxer may already read it; done is set once the download is over.
+ */
+struct prefetched_segment {
+    int seq_no;
+    uint8_t *data;
+    unsigned int size, allocated_size;
+    unsigned int pos;
+    int done;
+    int error;
+};
+
 /*
  * Each variant has its own demuxer. If it currently is active,
  * it has an open AVIOContext too, and potentially an AVPacket
@@ -90,9 +113,40 @@ struct variant {
 
     char key_url[MAX_URL_SIZE];
     uint8_t key[16];
+
+    AVProgram *program;
+
+#if HAVE_THREADS
+    /* Segments are downloaded in order by the prefetch thread, starting
+     * at prefetch_seq_no. The queue is flushed and the generation bumped
+     * whenever the demuxer needs another segment than the queue head, so
+     * that the thread drops the download in progress. */
+    int prefetch_started;
+    pthread_t prefetch_thread;
+    pthread_mutex_t prefetch_mutex;
+    pthread_cond_t prefetch_cond_thread;
+    pthread_cond_t prefetch_cond_demuxer;
+    AVIOInterruptCB prefetch_interrupt_callback;
+    struct prefetched_segment **prefetched;
+    int nb_prefetched;
+    struct prefetched_segment *cur_prefetched;
+    int prefetch_seq_no;
+    int prefetch_generation;
+    int download_generation;
+    int prefetch_abort;
+    int prefetch_error;
+
+    /* download statistics of the prefetch thread */
+    int64_t dl_bytes;
+    int64_t dl_time;
+    int64_t dl_latency;
+    int dl_segments;
+    int underruns;
+#endif
 };
 
 typedef struct HLSContext {
+    const AVClass *class;
     AVFormatContext *ctx;
     int n_variants;
     struct variant **variants;
@@ -104,6 +158,7 @@ typedef struct HLSContext {
     int seek_flags;
     AVIOInterruptCB *interrupt_callback;
     AVDictionary *avio_opts;
+    int prefetch;
 } HLSContext;
 
 static int read_chomp_line(AVIOContext *s, char *buf, int maxlen)
@@ -123,11 +178,55 @@ static void free_segment_list(struct variant *var)
     var->n_segments = 0;
 }
 
+#if HAVE_THREADS
+static void free_prefetched(struct variant *var)
+{
+    int i;
+    for (i = 0; i < var->nb_prefetched; i++) {
+        av_free(var->prefetched[i]->data);
+        av_free(var->prefetched[i]);
+    }
+    var->nb_prefetched  = 0;
+    var->cur_prefetched = NULL;
+}
+
+static void stop_prefetch(struct variant *var)
+{
+    if (!var->prefetch_started)
+        return;
+
+    pthread_mutex_lock(&var->prefetch_mutex);
+    var->prefetch_abort = 1;
+    pthread_cond_signal(&var->prefetch_cond_thread);
+    pthread_mutex_unlock(&var->prefetch_mutex);
+
+    pthread_join(var->prefetch_thread, NULL);
+
+    if (var->dl_segments)
+        av_log(var->parent, AV_LOG_VERBOSE,
+               "Variant %d: %d segments prefetched, %"PRId64" bytes, "
+               "%"PRId64" bytes/s, %"PRId64" ms average latency, "
+               "%d underruns\n", var->index, var->dl_segments, var->dl_bytes,
+               var->dl_time ? var->dl_bytes * AV_TIME_BASE / var->dl_time : 0,
+               var->dl_latency / var->dl_segments / 1000, var->underruns);
+
+    free_prefetched(var);
+    av_freep(&var->prefetched);
+    pthread_cond_destroy(&var->prefetch_cond_demuxer);
+    pthread_cond_destroy(&var->prefetch_cond_thread);
+    pthread_mutex_destroy(&var->prefetch_mutex);
+    var->prefetch_started = 0;
+}
+#endif
+
 static void free_variant_list(HLSContext *c)
 {
     int i;
     for (i = 0; i < c->n_variants; i++) {
         struct variant *var = c->variants[i];
+#if HAVE_THREADS
+        stop_prefetch(var);
+#endif
         free_segment_list(var);
         av_packet_unref(&var->pkt);
         av_free(var->pb.buffer);
@@ -213,21 +312,43 @@ static int open_in(HLSContext *c, AVIOContext **in, const char *url)
     return ret;
 }
 
+/*
+ * Segments downloaded by the prefetch threads are opened with a custom
+ * interrupt callback, so they bypass the io_open callback of the context;
+ * prefetching is only enabled if that callback is the default one.
+ */
 static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
-                    const AVDictionary *opts)
+                    const AVDictionary *opts, const AVIOInterruptCB *int_cb)
 {
     AVDictionary *tmp = NULL;
     int ret;
 
     av_dict_copy(&tmp, opts, 0);
 
-    ret = s->io_open(s, pb, url, AVIO_FLAG_READ, &tmp);
+    if (int_cb) {
+        if (s->protocol_whitelist)
+            av_dict_set(&tmp, "protocol_whitelist", s->protocol_whitelist, 0);
+        if (s->protocol_blacklist)
+            av_dict_set(&tmp, "protocol_blacklist", s->protocol_blacklist, 0);
+        ret = avio_open2(pb, url, AVIO_FLAG_READ, int_cb, &tmp);
+    } else {
+        ret = s->io_open(s, pb, url, AVIO_FLAG_READ, &tmp);
+    }
 
     av_dict_free(&tmp);
 
     return ret;
 }
 
+static void close_url(AVFormatContext *s, AVIOContext **pb,
+                      const AVIOInterruptCB *int_cb)
+{
+    if (int_cb)
+        avio_closep(pb);
+    else
+        ff_format_io_close(s, pb);
+}
+
 static int parse_playlist(HLSContext *c, const char *url,
                           struct variant *var, AVIOContext *in)
 {
@@ -358,25 +479,26 @@ fail:
     return ret;
 }
 
-static int open_input(struct variant *var)
+static int open_input(struct variant *var, const struct segment *seg,
+                      AVIOContext **in, const AVIOInterruptCB *int_cb)
 {
     HLSContext *c = var->parent->priv_data;
-    struct segment *seg = var->segments[var->cur_seq_no - var->start_seq_no];
     if (seg->key_type == KEY_NONE) {
-        return open_url(var->parent, &var->input, seg->url, c->avio_opts);
+        return open_url(var->parent, in, seg->url, c->avio_opts, int_cb);
     } else if (seg->key_type == KEY_AES_128) {
         AVDictionary *opts = NULL;
         char iv[33], key[33], url[MAX_URL_SIZE];
         int ret;
         if (strcmp(seg->key, var->key_url)) {
             AVIOContext *pb;
-            if (open_url(var->parent, &pb, seg->key, c->avio_opts) == 0) {
+            if (open_url(var->parent, &pb, seg->key, c->avio_opts,
+                         int_cb) == 0) {
                 ret = avio_read(pb, var->key, sizeof(var->key));
                 if (ret != sizeof(var->key)) {
                     av_log(NULL, AV_LOG_ERROR, "Unable to read key file %s\n",
                            seg->key);
                 }
-                ff_format_io_close(var->parent, &pb);
+                close_url(var->parent, &pb, int_cb);
             } else {
                 av_log(NULL, AV_LOG_ERROR, "Unable to open key file %s\n",
                        seg->key);
@@ -395,13 +517,274 @@ static int open_input(struct variant *var)
         av_dict_set(&opts, "key", key, 0);
         av_dict_set(&opts, "iv", iv, 0);
 
-        ret = open_url(var->parent, &var->input, url, opts);
+        ret = open_url(var->parent, in, url, opts, int_cb);
         av_dict_free(&opts);
         return ret;
     }
     return AVERROR(ENOSYS);
 }
 
+#if HAVE_THREADS
+static int prefetch_interrupt_cb(void *arg)
+{
+    struct variant *var = arg;
+    HLSContext *c = var->parent->priv_data;
+    int abort_request;
+
+    pthread_mutex_lock(&var->prefetch_mutex);
+    abort_request = var->prefetch_abort ||
+                    var->download_generation != var->prefetch_generation;
+    pthread_mutex_unlock(&var->prefetch_mutex);
+
+    return abort_request || ff_check_interrupt(c->interrupt_callback);
+}
+
+/*
+ * Download a segment into pseg. Returns with the mutex held; pseg must
+ * not be touched anymore if the generation changed in the meantime, since
+ * the demuxer has freed it then.
+ */
+static void download_segment(struct variant *var, const struct segment *seg,
+                             struct prefetched_segment *pseg, uint8_t *buf)
+{
+    AVIOContext *in = NULL;
+    int64_t start = av_gettime_relative(), latency;
+    int generation = var->download_generation;
+    int ret;
+
+    ret = open_input(var, seg, &in, &var->prefetch_interrupt_callback);
+    latency = av_gettime_relative() - start;
+
+    pthread_mutex_lock(&var->prefetch_mutex);
+    if (ret < 0) {
+        if (generation == var->prefetch_generation) {
+            pseg->error = ret;
+            pseg->done  = 1;
+        }
+        return;
+    }
+
+    while (generation == var->prefetch_generation) {
+        pthread_mutex_unlock(&var->prefetch_mutex);
+        ret = avio_read(in, buf, PREFETCH_CHUNK_SIZE);
+        pthread_mutex_lock(&var->prefetch_mutex);
+        if (generation != var->prefetch_generation)
+            break;
+
+        if (ret > 0 && pseg->size + ret > pseg->allocated_size) {
+            uint8_t *data = av_fast_realloc(pseg->data, &pseg->allocated_size,
+                                            FFMAX(pseg->size + ret,
+                                                  2 * pseg->allocated_size));
+            if (!data) {
+                ret = AVERROR(ENOMEM);
+            } else {
+                pseg->data = data;
+            }
+        }
+        if (ret <= 0) {
+            if (ret < 0 && ret != AVERROR_EOF)
+                av_log(var->parent, AV_LOG_WARNING,
+                       "Failed to download segment %d of variant %d\n",
+                       pseg->seq_no, var->index);
+            pseg->done = 1;
+            var->dl_bytes   += pseg->size;
+            var->dl_time    += av_gettime_relative() - start;
+            var->dl_latency += latency;
+            var->dl_segments++;
+            av_log(var->parent, AV_LOG_DEBUG,
+                   "Prefetched segment %d of variant %d: %u bytes in "
+                   "%"PRId64" ms, %"PRId64" ms latency\n", pseg->seq_no,
+                   var->index, pseg->size,
+                   (av_gettime_relative() - start) / 1000, latency / 1000);
+            break;
+        }
+        memcpy(pseg->data + pseg->size, buf, ret);
+        pseg->size += ret;
+        pthread_cond_signal(&var->prefetch_cond_demuxer);
+    }
+
+    pthread_mutex_unlock(&var->prefetch_mutex);
+    avio_closep(&in);
+    pthread_mutex_lock(&var->prefetch_mutex);
+}
+
+static void *prefetch_thread(void *arg)
+{
+    struct variant *var = arg;
+    HLSContext *c = var->parent->priv_data;
+    struct prefetched_segment *pseg;
+    struct segment *seg;
+    uint8_t *buf;
+    int idx;
+
+    seg = av_malloc(sizeof(*seg));
+    buf = av_malloc(PREFETCH_CHUNK_SIZE);
+
+    pthread_mutex_lock(&var->prefetch_mutex);
+    if (!seg || !buf)
+        var->prefetch_error = AVERROR(ENOMEM);
+    while (!var->prefetch_abort && !var->prefetch_error) {
+        /* only segments present in the current playlist are fetched, the
+         * demuxer wakes us up after reloading it */
+        idx = var->prefetch_seq_no - var->start_seq_no;
+        if (var->nb_prefetched >= c->prefetch ||
+            idx < 0 || idx >= var->n_segments) {
+            pthread_cond_wait(&var->prefetch_cond_thread,
+                              &var->prefetch_mutex);
+            continue;
+        }
+
+        pseg = av_mallocz(sizeof(*pseg));
+        if (!pseg) {
+            var->prefetch_error = AVERROR(ENOMEM);
+            break;
+        }
+        pseg->seq_no = var->prefetch_seq_no++;
+        var->prefetched[var->nb_prefetched++] = pseg;
+        var->download_generation = var->prefetch_generation;
+        *seg = *var->segments[idx];
+        pthread_mutex_unlock(&var->prefetch_mutex);
+
+        download_segment(var, seg, pseg, buf);
+        pthread_cond_signal(&var->prefetch_cond_demuxer);
+    }
+    pthread_cond_signal(&var->prefetch_cond_demuxer);
+    pthread_mutex_unlock(&var->prefetch_mutex);
+
+    av_free(seg);
+    av_free(buf);
+
+    return NULL;
+}
+
+static int start_prefetch(struct variant *var)
+{
+    HLSContext *c = var->parent->priv_data;
+    int ret;
+
+    var->prefetched = av_mallocz_array(c->prefetch, sizeof(*var->prefetched));
+    if (!var->prefetched)
+        return AVERROR(ENOMEM);
+
+    var->prefetch_seq_no = var->cur_seq_no;
+    var->prefetch_abort  = 0;
+    var->prefetch_error  = 0;
+    var->prefetch_interrupt_callback.callback = prefetch_interrupt_cb;
+    var->prefetch_interrupt_callback.opaque   = var;
+
+    pthread_mutex_init(&var->prefetch_mutex, NULL);
+    pthread_cond_init(&var->prefetch_cond_thread, NULL);
+    pthread_cond_init(&var->prefetch_cond_demuxer, NULL);
+
+    ret = pthread_create(&var->prefetch_thread, NULL, prefetch_thread, var);
+    if (ret) {
+        av_log(var->parent, AV_LOG_ERROR, "pthread_create failed\n");
+        pthread_cond_destroy(&var->prefetch_cond_demuxer);
+        pthread_cond_destroy(&var->prefetch_cond_thread);
+        pthread_mutex_destroy(&var->prefetch_mutex);
+        av_freep(&var->prefetched);
+        return AVERROR(ret);
+    }
+    var->prefetch_started = 1;
+
+    return 0;
+}
+
+/*
+ * Make the prefetched copy of the current segment the input of the variant,
+ * restarting the downloads from it if it is not at the head of the queue.
+ */
+static int open_prefetched(struct variant *var)
+{
+    struct prefetched_segment *pseg;
+    int ret = 0;
+
+    if (!var->prefetch_started && (ret = start_prefetch(var)) < 0)
+        return ret;
+
+    pthread_mutex_lock(&var->prefetch_mutex);
+    if (!var->nb_prefetched ||
+        var->prefetched[0]->seq_no != var->cur_seq_no) {
+        free_prefetched(var);
+        var->prefetch_seq_no = var->cur_seq_no;
+        var->prefetch_generation++;
+    }
+    /* the playlist may have been reloaded as well */
+    pthread_cond_signal(&var->prefetch_cond_thread);
+
+    while (!var->nb_prefetched && !var->prefetch_error)
+        pthread_cond_wait(&var->prefetch_cond_demuxer, &var->prefetch_mutex);
+
+    if (var->prefetch_error) {
+        ret = var->prefetch_error;
+    } else {
+        pseg = var->prefetched[0];
+        if (pseg->error < 0) {
+            ret = pseg->error;
+            free_prefetched(var);
+        } else {
+            var->cur_prefetched = pseg;
+        }
+    }
+    pthread_mutex_unlock(&var->prefetch_mutex);
+
+    return ret;
+}
+
+static int read_prefetched(struct variant *var, uint8_t *buf, int buf_size)
+{
+    struct prefetched_segment *pseg = var->cur_prefetched;
+    int waited = 0, ret;
+
+    pthread_mutex_lock(&var->prefetch_mutex);
+    while (pseg->pos == pseg->size && !pseg->done && !var->prefetch_error) {
+        if (!waited++)
+            var->underruns++;
+        pthread_cond_wait(&var->prefetch_cond_demuxer, &var->prefetch_mutex);
+    }
+    ret = FFMIN(buf_size, pseg->size - pseg->pos);
+    memcpy(buf, pseg->data + pseg->pos, ret);
+    pseg->pos += ret;
+    pthread_mutex_unlock(&var->prefetch_mutex);
+
+    return ret;
+}
+
+/*
+ * Drop the current segment from the queue and export the download
+ * statistics of the variant.
+ */
+static void close_prefetched(struct variant *var)
+{
+    struct prefetched_segment *pseg = var->cur_prefetched;
+    int64_t bitrate = 0, latency = 0;
+
+    pthread_mutex_lock(&var->prefetch_mutex);
+    var->nb_prefetched--;
+    memmove(var->prefetched, var->prefetched + 1,
+            var->nb_prefetched * sizeof(*var->prefetched));
+    var->cur_prefetched = NULL;
+    pthread_cond_signal(&var->prefetch_cond_thread);
+
+    if (var->dl_time)
+        bitrate = var->dl_bytes * 8 * AV_TIME_BASE / var->dl_time;
+    if (var->dl_segments)
+        latency = var->dl_latency / var->dl_segments / 1000;
+    pthread_mutex_unlock(&var->prefetch_mutex);
+
+    av_free(pseg->data);
+    av_free(pseg);
+
+    if (var->program) {
+        char str[32];
+        snprintf(str, sizeof(str), "%"PRId64, bitrate);
+        av_dict_set(&var->program->metadata, "download_bitrate", str, 0);
+        snprintf(str, sizeof(str), "%"PRId64, latency);
+        av_dict_set(&var->program->metadata, "download_latency", str, 0);
+    }
+}
+#endif
+
 static int read_data(void *opaque, uint8_t *buf, int buf_size)
 {
     struct variant *v = opaque;
@@ -409,7 +792,11 @@ static int read_data(void *opaque, uint8_t *buf, int buf_size)
     int ret, i;
 
 restart:
+#if HAVE_THREADS
+    if (!v->input && !v->cur_prefetched) {
+#else
     if (!v->input) {
+#endif
         /* If this is a live stream and the reload interval has elapsed since
          * the last playlist reload, reload the variant playlists now. */
         int64_t reload_interval = v->n_segments > 0 ?
@@ -419,7 +806,17 @@ restart:
 reload:
         if (!v->finished &&
             av_gettime_relative() - v->last_load_time >= reload_interval) {
-            if ((ret = parse_playlist(c, v->url, v, NULL)) < 0)
+#if HAVE_THREADS
+            /* the prefetch thread reads the segment list */
+            if (v->prefetch_started)
+                pthread_mutex_lock(&v->prefetch_mutex);
+#endif
+            ret = parse_playlist(c, v->url, v, NULL);
+#if HAVE_THREADS
+            if (v->prefetch_started)
+                pthread_mutex_unlock(&v->prefetch_mutex);
+#endif
+            if (ret < 0)
                 return ret;
             /* If we need to reload the playlist again below (if
              * there's still no more segments), switch to a reload
@@ -444,14 +841,30 @@ reload:
             goto reload;
         }
 
-        ret = open_input(v);
+#if HAVE_THREADS
+        if (c->prefetch)
+            ret = open_prefetched(v);
+        else
+#endif
+        ret = open_input(v, v->segments[v->cur_seq_no - v->start_seq_no],
+                         &v->input, NULL);
         if (ret < 0)
             return ret;
     }
-    ret = avio_read(v->input, buf, buf_size);
-    if (ret > 0)
-        return ret;
-    ff_format_io_close(c->ctx, &v->input);
+#if HAVE_THREADS
+    if (v->cur_prefetched) {
+        ret = read_prefetched(v, buf, buf_size);
+        if (ret > 0)
+            return ret;
+        close_prefetched(v);
+    } else
+#endif
+    {
+        ret = avio_read(v->input, buf, buf_size);
+        if (ret > 0)
+            return ret;
+        ff_format_io_close(c->ctx, &v->input);
+    }
     v->cur_seq_no++;
 
     c->end_of_segment = 1;
@@ -469,6 +882,9 @@ reload:
     if (!v->needed) {
         av_log(v->parent, AV_LOG_INFO, "No longer receiving variant %d\n",
                v->index);
+#if HAVE_THREADS
+        stop_prefetch(v);
+#endif
         return AVERROR_EOF;
     }
     goto restart;
@@ -513,11 +929,28 @@ static int hls_read_header(AVFormatContext *s)
     c->ctx                = s;
     c->interrupt_callback = &s->interrupt_callback;
 
+#if !HAVE_THREADS
+    if (c->prefetch) {
+        av_log(s, AV_LOG_WARNING,
+               "Segment prefetching requires threading support\n");
+        c->prefetch = 0;
+    }
+#endif
+    if (c->prefetch && !ff_format_io_open_is_default(s)) {
+        av_log(s, AV_LOG_WARNING,
+               "Segment prefetching is disabled with a custom io_open "
+               "callback\n");
+        c->prefetch = 0;
+    }
+
     if ((ret = parse_playlist(c, s->filename, NULL, s->pb)) < 0)
         goto fail;
 
     if ((ret = save_avio_options(s)) < 0)
         goto fail;
+    /* segments are usually fetched from the same few servers */
+    if ((ret = av_dict_set(&c->avio_opts, "reuse_connections", "1", 0)) < 0)
+        goto fail;
 
     if (c->n_variants == 0) {
         av_log(NULL, AV_LOG_WARNING, "Empty playlist\n");
@@ -606,6 +1039,7 @@ static int hls_read_header(AVFormatContext *s)
         if (!program)
             goto fail;
         av_dict_set(&program->metadata, "variant_bitrate", bitrate_str, 0);
+        v->program = program;
 
         /* Create new AVStreams for each stream in this variant */
         for (j = 0; j < v->ctx->nb_streams; j++) {
@@ -662,6 +1096,9 @@ static int recheck_discard_flags(AVFormatContext *s, int first)
         } else if (first && !v->cur_needed && v->needed) {
             if (v->input)
                 ff_format_io_close(s, &v->input);
+#if HAVE_THREADS
+            stop_prefetch(v);
+#endif
             v->needed = 0;
             changed = 1;
             av_log(s, AV_LOG_INFO, "No longer receiving variant %d\n", i);
@@ -810,6 +1247,10 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
                       0 : c->first_timestamp;
         if (var->input)
             ff_format_io_close(s, &var->input);
+#if HAVE_THREADS
+        if (var->cur_prefetched)
+            close_prefetched(var);
+#endif
         av_packet_unref(&var->pkt);
         reset_packet(&var->pkt);
         var->pb.eof_reached = 0;
@@ -847,6 +1288,20 @@ static int hls_probe(AVProbeData *p)
     return 0;
 }
 
+#define OFFSET(x) offsetof(HLSContext, x)
+#define D AV_OPT_FLAG_DECODING_PARAM
+static const AVOption options[] = {
+    { "prefetch_segments", "Number of segments downloaded ahead by a thread for each variant, 0 to disable", OFFSET(prefetch), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 64, D },
+    { NULL }
+};
+
+static const AVClass hls_class = {
+    .class_name = "hls demuxer",
+    .item_name  = av_default_item_name,
+    .option     = options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
 AVInputFormat ff_hls_demuxer = {
     .name           = "hls,applehttp",
     .long_name      = NULL_IF_CONFIG_SMALL("Apple HTTP Live Streaming"),
@@ -856,4 +1311,5 @@ AVInputFormat ff_hls_demuxer = {
     .read_packet    = hls_read_packet,
     .read_close     = hls_close,
     .read_seek      = hls_read_seek,
+    .priv_class     = &hls_class,
 };
@@ -27,6 +27,8 @@
 
 #include "libavutil/avstring.h"
 #include "libavutil/opt.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
 
 #include "avformat.h"
 #include "http.h"
@@ -45,15 +47,42 @@
 #define BUFFER_SIZE   MAX_URL_SIZE
 #define MAX_REDIRECTS 8
 
+#define POOL_MAX_CONNECTIONS 16
+/* servers commonly drop idle connections after 5 to 15 seconds */
+#define POOL_IDLE_TIMEOUT    (5 * 1000000)
+
+/**
+ * A connection to a server or a proxy that can outlive the HTTPContext
+ * that opened it. The lower protocols call the interrupt callback of the
+ * current user through it.
+ */
+typedef struct HTTPConnection {
+    URLContext *hd;
+    /* lower protocol URL, e.g. tls://host:443 */
+    char key[1024];
+    AVIOInterruptCB interrupt_callback;
+    int64_t idle_since;
+    struct HTTPConnection *next;
+} HTTPConnection;
+
+/* idle connections, most recently used first */
+static HTTPConnection *connection_pool;
+static AVMutex pool_mutex = AV_MUTEX_INITIALIZER;
+
 typedef struct HTTPContext {
     const AVClass *class;
     URLContext *hd;
+    /* set if hd belongs to a connection that may be pooled */
+    HTTPConnection *conn;
     unsigned char buffer[BUFFER_SIZE], *buf_ptr, *buf_end;
     int line_count;
     int http_code;
     /* Used if "Transfer-Encoding: chunked" otherwise -1. */
     int64_t chunksize;
     int64_t off, end_off, filesize;
+    /* offset following the body of the current response, -1 if unknown */
+    int64_t body_end;
+    int64_t content_length;
     char *location;
     HTTPAuthState auth_state;
     HTTPAuthState proxy_auth_state;
@@ -71,6 +100,13 @@ typedef struct HTTPContext {
     int end_header;
     /* A flag which indicates if we use persistent connections. */
     int multiple_requests;
+    /* Set if the server keeps the connection open after the response. */
+    int keep_alive;
+    int reuse_connections;
+    int64_t request_size;
+    int pipeline;
+    /* Set if the request for the next range was sent already. */
+    int pending_request;
     uint8_t *post_data;
     int post_datalen;
     int icy;
@@ -103,6 +139,9 @@ static const AVOption options[] = {
     { "user_agent", "override User-Agent header", OFFSET(user_agent), AV_OPT_TYPE_STRING, { .str = DEFAULT_USER_AGENT }, 0, 0, D },
     { "user-agent", "override User-Agent header, for compatibility with ffmpeg", OFFSET(user_agent), AV_OPT_TYPE_STRING, { .str = DEFAULT_USER_AGENT }, 0, 0, D },
     { "multiple_requests", "use persistent connections", OFFSET(multiple_requests), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, D | E },
+    { "reuse_connections", "keep idle connections in a process-wide pool and reuse them", OFFSET(reuse_connections), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, D },
+    { "request_size", "read the resource with range requests of this size", OFFSET(request_size), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, D },
+    { "pipeline", "send the request for the next range before the current one completes", OFFSET(pipeline), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, D },
     { "post_data", "set custom HTTP post data", OFFSET(post_data), AV_OPT_TYPE_BINARY, .flags = D | E },
     { "mime_type", "export the MIME type", OFFSET(mime_type), AV_OPT_TYPE_STRING, { 0 }, 0, 0, AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     { "icy", "request ICY metadata", OFFSET(icy), AV_OPT_TYPE_INT, { .i64 = 1 }, 0, 1, D },
@@ -123,6 +162,173 @@ static const AVOption options[] = {
 static int http_connect(URLContext *h, const char *path, const char *local_path,
                         const char *hoststr, const char *auth,
                         const char *proxyauth, int *new_location);
+static int http_send_request(URLContext *h, const char *path,
+                             const char *local_path, const char *hoststr,
+                             const char *auth, const char *proxyauth,
+                             int64_t off, int *send_expect_100);
+
+static int connection_interrupt_cb(void *opaque)
+{
+    HTTPConnection *conn = opaque;
+    return ff_check_interrupt(&conn->interrupt_callback);
+}
+
+static void connection_free(HTTPConnection *conn)
+{
+    ffurl_close(conn->hd);
+    av_free(conn);
+}
+
+/* must be called with pool_mutex held */
+static void pool_expire(int64_t now)
+{
+    HTTPConnection **p = &connection_pool, *conn;
+    int nb_conns = 0;
+
+    while ((conn = *p)) {
+        if (now - conn->idle_since > POOL_IDLE_TIMEOUT ||
+            nb_conns >= POOL_MAX_CONNECTIONS) {
+            *p = conn->next;
+            connection_free(conn);
+        } else {
+            p = &conn->next;
+            nb_conns++;
+        }
+    }
+}
+
+static HTTPConnection *pool_get(const char *key)
+{
+    HTTPConnection **p, *conn;
+    struct pollfd pfd = { .events = POLLIN };
+
+    ff_mutex_lock(&pool_mutex);
+    pool_expire(av_gettime_relative());
+    for (p = &connection_pool; (conn = *p); p = &conn->next) {
+        if (!strcmp(conn->key, key)) {
+            *p = conn->next;
+            break;
+        }
+    }
+    ff_mutex_unlock(&pool_mutex);
+
+    if (conn) {
+        /* an idle connection that became readable was closed by the server */
+        pfd.fd = ffurl_get_file_handle(conn->hd);
+        if (pfd.fd < 0 || poll(&pfd, 1, 0)) {
+            connection_free(conn);
+            conn = NULL;
+        }
+    }
+    return conn;
+}
+
+static void pool_put(HTTPConnection *conn)
+{
+    conn->interrupt_callback.callback = NULL;
+    conn->interrupt_callback.opaque   = NULL;
+    conn->idle_since                  = av_gettime_relative();
+
+    ff_mutex_lock(&pool_mutex);
+    conn->next      = connection_pool;
+    connection_pool = conn;
+    pool_expire(conn->idle_since);
+    ff_mutex_unlock(&pool_mutex);
+}
+
+void ff_http_close_idle_connections(void)
+{
+    HTTPConnection *conn;
+
+    ff_mutex_lock(&pool_mutex);
+    while ((conn = connection_pool)) {
+        connection_pool = conn->next;
+        connection_free(conn);
+    }
+    ff_mutex_unlock(&pool_mutex);
+}
+
+/**
+ * Open the connection to the server or the proxy, taking an idle one from
+ * the pool if possible.
+ *
+ * @return 1 if an idle connection was reused, 0 if a new one was opened,
+ *         a negative error code on failure
+ */
+static int http_open_lower(URLContext *h, const char *url,
+                           AVDictionary **options)
+{
+    HTTPContext *s = h->priv_data;
+    HTTPConnection *conn;
+    AVIOInterruptCB int_cb;
+    int err;
+
+    if (!s->reuse_connections)
+        return ffurl_open(&s->hd, url, AVIO_FLAG_READ_WRITE,
+                          &h->interrupt_callback, options, h->protocols, h);
+
+    if ((conn = pool_get(url))) {
+        av_log(h, AV_LOG_DEBUG, "Reusing connection to %s\n", url);
+        err = 1;
+    } else {
+        conn = av_mallocz(sizeof(*conn));
+        if (!conn)
+            return AVERROR(ENOMEM);
+        av_strlcpy(conn->key, url, sizeof(conn->key));
+        int_cb.callback = connection_interrupt_cb;
+        int_cb.opaque   = conn;
+        err = ffurl_open(&conn->hd, url, AVIO_FLAG_READ_WRITE,
+                         &int_cb, options, h->protocols, h);
+        if (err < 0) {
+            av_free(conn);
+            return err;
+        }
+    }
+    conn->interrupt_callback = h->interrupt_callback;
+    s->conn = conn;
+    s->hd   = conn->hd;
+    return err;
+}
+
+/**
+ * Close the connection, or return it to the pool if reuse is set and
+ * the connection can carry another request.
+ */
+static void http_close_lower(URLContext *h, URLContext *hd,
+                             HTTPConnection *conn, int reuse)
+{
+    if (!conn) {
+        ffurl_close(hd);
+    } else if (reuse) {
+        av_log(h, AV_LOG_DEBUG, "Keeping the connection to %s\n", conn->key);
+        pool_put(conn);
+    } else {
+        connection_free(conn);
+    }
+}
+
+static void http_close_cnx(URLContext *h)
+{
+    HTTPContext *s = h->priv_data;
+
+    if (s->hd)
+        http_close_lower(h, s->hd, s->conn, 0);
+    s->hd              = NULL;
+    s->conn            = NULL;
+    s->pending_request = 0;
+}
+
+/* return non zero if the response was entirely read and the server keeps
+ * the connection open */
+static int http_cnx_reusable(URLContext *h)
+{
+    HTTPContext *s = h->priv_data;
+
+    return s->hd && s->keep_alive && !s->willclose && !s->pending_request &&
+           !(h->flags & AVIO_FLAG_WRITE) && !s->post_data &&
+           s->body_end >= 0 && s->off == s->body_end &&
+           s->buf_ptr == s->buf_end;
+}
 
 void ff_http_init_auth_state(URLContext *dest, const URLContext *src)
 {
@@ -141,7 +347,7 @@ static int http_open_cnx_internal(URLContext *h, AVDictionary **options)
     char auth[1024], proxyauth[1024] = "";
     char path1[MAX_URL_SIZE];
     char buf[1024], urlbuf[MAX_URL_SIZE];
-    int port, use_proxy, err, location_changed = 0;
+    int port, use_proxy, err, location_changed = 0, reused = 0;
     HTTPContext *s = h->priv_data;
 
     av_url_split(proto, sizeof(proto), auth, sizeof(auth),
@@ -180,17 +386,37 @@ static int http_open_cnx_internal(URLContext *h, AVDictionary **options)
     ff_url_join(buf, sizeof(buf), lower_proto, NULL, hostname, port, NULL);
 
     if (!s->hd) {
-        err = ffurl_open(&s->hd, buf, AVIO_FLAG_READ_WRITE,
-                         &h->interrupt_callback, options, h->protocols, h);
+        err = http_open_lower(h, buf, options);
         if (err < 0)
             return err;
+        reused = err;
     }
 
     err = http_connect(h, path, local_path, hoststr,
                        auth, proxyauth, &location_changed);
+    if (err < 0 && reused && !s->line_count) {
+        /* the server closed the idle connection in the meantime */
+        http_close_cnx(h);
+        if ((err = http_open_lower(h, buf, options)) < 0)
+            return err;
+        err = http_connect(h, path, local_path, hoststr,
+                           auth, proxyauth, &location_changed);
+    }
     if (err < 0)
         return err;
 
+    /* let the server send the next range right after the current one */
+    if (s->pipeline && s->request_size && s->http_code == 206 &&
+        s->keep_alive && !s->willclose && s->body_end >= 0 &&
+        s->body_end < s->filesize && !(h->flags & AVIO_FLAG_WRITE) &&
+        !s->post_data) {
+        if (http_send_request(h, path, local_path, hoststr, auth, proxyauth,
+                              s->body_end, NULL) < 0)
+            s->willclose = 1;
+        else
+            s->pending_request = 1;
+    }
+
     return location_changed;
 }
 
@@ -212,8 +438,7 @@ redo:
     if (s->http_code == 401) {
         if ((cur_auth_type == HTTP_AUTH_NONE || s->auth_state.stale) &&
             s->auth_state.auth_type != HTTP_AUTH_NONE && attempts < 4) {
-            ffurl_close(s->hd);
-            s->hd = NULL;
+            http_close_cnx(h);
             goto redo;
         } else
             goto fail;
@@ -221,8 +446,7 @@ redo:
     if (s->http_code == 407) {
         if ((cur_proxy_auth_type == HTTP_AUTH_NONE || s->proxy_auth_state.stale) &&
             s->proxy_auth_state.auth_type != HTTP_AUTH_NONE && attempts < 4) {
-            ffurl_close(s->hd);
-            s->hd = NULL;
+            http_close_cnx(h);
             goto redo;
         } else
             goto fail;
@@ -231,8 +455,7 @@ redo:
          s->http_code == 303 || s->http_code == 307) &&
         location_changed == 1) {
         /* url moved, get next */
-        ffurl_close(s->hd);
-        s->hd = NULL;
+        http_close_cnx(h);
         if (redirects++ >= MAX_REDIRECTS)
             return AVERROR(EIO);
         /* Restart the authentication process with the new target, which
@@ -245,9 +468,7 @@ redo:
     return 0;
 
 fail:
-    if (s->hd)
-        ffurl_close(s->hd);
-    s->hd = NULL;
+    http_close_cnx(h);
     if (location_changed < 0)
         return location_changed;
     return AVERROR(EIO);
@@ -281,13 +502,15 @@ static int http_open(URLContext *h, const char *uri, int flags,
     h->is_streamed = 1;
 
     s->filesize = -1;
+    s->body_end = -1;
     s->location = av_strdup(uri);
     if (!s->location)
         return AVERROR(ENOMEM);
     if (options)
         av_dict_copy(&s->chained_options, *options, 0);
 
-    if (s->headers) {
+    /* an empty string, as forwarded by nested demuxers, means no headers */
+    if (s->headers && *s->headers) {
         int len = strlen(s->headers);
         if (len < 2 || strcmp("\r\n", s->headers + len - 2)) {
             av_log(h, AV_LOG_WARNING,
@@ -463,6 +686,8 @@ static int process_line(URLContext *h, char *line, int line_count,
 
     p = line;
     if (line_count == 0) {
+        /* HTTP/1.1 connections are persistent unless stated otherwise */
+        s->keep_alive = av_strstart(p, "HTTP/1.1", NULL);
         while (!av_isspace(*p) && *p != '\0')
             p++;
         while (av_isspace(*p))
@@ -488,8 +713,10 @@ static int process_line(URLContext *h, char *line, int line_count,
             if ((ret = parse_location(s, p)) < 0)
                 return ret;
             *new_location = 1;
-        } else if (!av_strcasecmp(tag, "Content-Length") && s->filesize == -1) {
-            s->filesize = strtoll(p, NULL, 10);
+        } else if (!av_strcasecmp(tag, "Content-Length")) {
+            s->content_length = strtoll(p, NULL, 10);
+            if (s->filesize == -1)
+                s->filesize = s->content_length;
         } else if (!av_strcasecmp(tag, "Content-Range")) {
             parse_content_range(h, p);
         } else if (!av_strcasecmp(tag, "Accept-Ranges") &&
@@ -508,6 +735,8 @@ static int process_line(URLContext *h, char *line, int line_count,
         } else if (!av_strcasecmp(tag, "Connection")) {
             if (!strcmp(p, "close"))
                 s->willclose = 1;
+            else if (!av_strcasecmp(p, "keep-alive"))
+                s->keep_alive = 1;
         } else if (!av_strcasecmp(tag, "Content-Type")) {
             av_free(s->mime_type);
             s->mime_type = av_strdup(p);
@@ -538,7 +767,9 @@ static int http_read_header(URLContext *h, int *new_location)
     char line[MAX_URL_SIZE];
     int err = 0;
 
-    s->chunksize = -1;
+    s->chunksize      = -1;
+    s->content_length = -1;
+    s->keep_alive     = 0;
 
     for (;;) {
         if ((err = http_get_line(s, line, sizeof(line))) < 0)
@@ -554,18 +785,25 @@ static int http_read_header(URLContext *h, int *new_location)
         s->line_count++;
     }
 
+    /* the body must not be read past, the connection may carry another
+     * response after it */
+    s->body_end = s->chunksize < 0 && s->content_length >= 0 ?
+                  s->off + s->content_length : -1;
+
     return err;
 }
 
-static int http_connect(URLContext *h, const char *path, const char *local_path,
-                        const char *hoststr, const char *auth,
-                        const char *proxyauth, int *new_location)
+static int http_send_request(URLContext *h, const char *path,
+                             const char *local_path, const char *hoststr,
+                             const char *auth, const char *proxyauth,
+                             int64_t off, int *send_expect_100_out)
 {
     HTTPContext *s = h->priv_data;
     int post, err;
     char headers[HTTP_HEADERS_SIZE] = "";
+    char request[BUFFER_SIZE];
     char *authstr = NULL, *proxyauthstr = NULL;
-    int64_t off = s->off;
+    int64_t end_off = s->end_off;
     int len = 0;
     const char *method;
     int send_expect_100 = 0;
@@ -612,11 +850,14 @@ static int http_connect(URLContext *h, const char *path, const char *local_path,
     // since it allows us to detect more reliably if a (non-conforming)
     // server supports seeking by analysing the reply headers.
     if (!has_header(s->headers, "\r\nRange: ") && !post) {
+        if (s->request_size)
+            end_off = end_off ? FFMIN(end_off, off + s->request_size) :
+                                off + s->request_size;
         len += av_strlcatf(headers + len, sizeof(headers) - len,
-                           "Range: bytes=%"PRId64"-", s->off);
-        if (s->end_off)
+                           "Range: bytes=%"PRId64"-", off);
+        if (end_off)
             len += av_strlcatf(headers + len, sizeof(headers) - len,
-                               "%"PRId64, s->end_off - 1);
+                               "%"PRId64, end_off - 1);
         len += av_strlcpy(headers + len, "\r\n",
                           sizeof(headers) - len);
     }
@@ -625,7 +866,7 @@ static int http_connect(URLContext *h, const char *path, const char *local_path,
                            "Expect: 100-continue\r\n");
 
     if (!has_header(s->headers, "\r\nConnection: ")) {
-        if (s->multiple_requests)
+        if (s->multiple_requests || s->reuse_connections || s->request_size)
             len += av_strlcpy(headers + len, "Connection: keep-alive\r\n",
                               sizeof(headers) - len);
         else
@@ -651,7 +892,7 @@ static int http_connect(URLContext *h, const char *path, const char *local_path,
     if (s->headers)
         av_strlcpy(headers + len, s->headers, sizeof(headers) - len);
 
-    snprintf(s->buffer, sizeof(s->buffer),
+    snprintf(request, sizeof(request),
              "%s %s HTTP/1.1\r\n"
              "%s"
              "%s"
@@ -667,21 +908,48 @@ static int http_connect(URLContext *h, const char *path, const char *local_path,
 
     av_freep(&authstr);
     av_freep(&proxyauthstr);
-    if ((err = ffurl_write(s->hd, s->buffer, strlen(s->buffer))) < 0)
+    if ((err = ffurl_write(s->hd, request, strlen(request))) < 0)
         return err;
 
     if (s->post_data)
         if ((err = ffurl_write(s->hd, s->post_data, s->post_datalen)) < 0)
             return err;
 
-    /* init input buffer */
-    s->buf_ptr          = s->buffer;
-    s->buf_end          = s->buffer;
+    if (send_expect_100_out)
+        *send_expect_100_out = send_expect_100;
+    return 0;
+}
+
+static int http_connect(URLContext *h, const char *path, const char *local_path,
+                        const char *hoststr, const char *auth,
+                        const char *proxyauth, int *new_location)
+{
+    HTTPContext *s = h->priv_data;
+    int64_t off = s->off;
+    int post, err, send_expect_100 = 0;
+
+    if (s->pending_request) {
+        /* the request was sent along with the previous one, and the start
+         * of the response may be buffered already */
+        s->pending_request = 0;
+    } else {
+        err = http_send_request(h, path, local_path, hoststr, auth, proxyauth,
+                                off, &send_expect_100);
+        if (err < 0)
+            return err;
+
+        /* init input buffer */
+        s->buf_ptr = s->buffer;
+        s->buf_end = s->buffer;
+    }
+    post = (h->flags & AVIO_FLAG_WRITE) || s->post_data;
+
     s->line_count       = 0;
     s->off              = 0;
     s->icy_data_read    = 0;
     s->filesize         = -1;
     s->willclose        = 0;
+    s->body_end         = -1;
     s->end_chunked_post = 0;
     s->end_header       = 0;
 #if CONFIG_ZLIB
@@ -703,10 +971,38 @@ static int http_connect(URLContext *h, const char *path, const char *local_path,
     return (off == s->off) ? 0 : -1;
 }
 
+/* request the range following the current response */
+static int http_next_range(URLContext *h)
+{
+    HTTPContext *s = h->priv_data;
+    AVDictionary *options = NULL;
+    int ret;
+
+    if (!s->keep_alive || s->willclose)
+        http_close_cnx(h);
+
+    av_dict_copy(&options, s->chained_options, 0);
+    ret = http_open_cnx(h, &options);
+    av_dict_free(&options);
+    return ret;
+}
+
 static int http_buf_read(URLContext *h, uint8_t *buf, int size)
 {
     HTTPContext *s = h->priv_data;
-    int len;
+    int len, err;
+
+    if (s->body_end >= 0 && s->off >= s->body_end) {
+        if (!s->request_size || s->filesize < 0 || s->off >= s->filesize)
+            return AVERROR_EOF;
+        if ((err = http_next_range(h)) < 0)
+            return err;
+        if (s->body_end >= 0 && s->off >= s->body_end)
+            return AVERROR_EOF;
+    }
+    if (s->body_end >= 0)
+        size = FFMIN(size, s->body_end - s->off);
+
     /* read bytes from input buffer first */
     len = s->buf_end - s->buf_ptr;
     if (len > 0) {
@@ -954,7 +1250,8 @@ static int http_close(URLContext *h)
         ret = http_shutdown(h, h->flags);
 
     if (s->hd)
-        ffurl_close(s->hd);
+        http_close_lower(h, s->hd, s->conn,
+                         s->reuse_connections && http_cnx_reusable(h));
     av_dict_free(&s->chained_options);
     return ret;
 }
@@ -963,7 +1260,9 @@ static int64_t http_seek(URLContext *h, int64_t off, int whence)
 {
     HTTPContext *s = h->priv_data;
     URLContext *old_hd = s->hd;
-    int64_t old_off = s->off;
+    HTTPConnection *old_conn = s->conn;
+    int64_t old_off = s->off, old_body_end = s->body_end;
+    int old_pending = s->pending_request, old_reusable;
     uint8_t old_buf[BUFFER_SIZE];
     int old_buf_size, ret;
     AVDictionary *options = NULL;
@@ -978,8 +1277,11 @@ static int64_t http_seek(URLContext *h, int64_t off, int whence)
 
     /* we save the old context in case the seek fails */
     old_buf_size = s->buf_end - s->buf_ptr;
+    old_reusable = s->reuse_connections && http_cnx_reusable(h);
     memcpy(old_buf, s->buf_ptr, old_buf_size);
-    s->hd = NULL;
+    s->hd              = NULL;
+    s->conn            = NULL;
+    s->pending_request = 0;
     if (whence == SEEK_CUR)
         off += s->off;
     else if (whence == SEEK_END)
@@ -991,14 +1293,17 @@ static int64_t http_seek(URLContext *h, int64_t off, int whence)
     if ((ret = http_open_cnx(h, &options)) < 0) {
         av_dict_free(&options);
         memcpy(s->buffer, old_buf, old_buf_size);
-        s->buf_ptr = s->buffer;
-        s->buf_end = s->buffer + old_buf_size;
-        s->hd      = old_hd;
-        s->off     = old_off;
+        s->buf_ptr         = s->buffer;
+        s->buf_end         = s->buffer + old_buf_size;
+        s->hd              = old_hd;
+        s->conn            = old_conn;
+        s->off             = old_off;
+        s->body_end        = old_body_end;
+        s->pending_request = old_pending;
         return ret;
     }
     av_dict_free(&options);
-    ffurl_close(old_hd);
+    http_close_lower(h, old_hd, old_conn, old_reusable);
     return off;
 }
 
@@ -47,4 +47,10 @@ void ff_http_init_auth_state(URLContext *dest, const URLContext *src);
  */
 int ff_http_do_new_request(URLContext *h, const char *uri);
 
+/**
+ * Close the idle connections kept by the contexts that had the
+ * reuse_connections option set.
+ */
+void ff_http_close_idle_connections(void);
+
 #endif /* AVFORMAT_HTTP_H */
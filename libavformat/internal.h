@@ -50,6 +50,12 @@ struct AVFormatInternal {
      */
     int nb_interleaved_streams;
 
+    /**
+     * Number of streams with packets in the interleaving queue.
+     * Muxing only.
+     */
+    int nb_buffered_streams;
+
     /**
      * This buffer is only needed when packets were already buffered but
      * not decoded, for example to get the codec parameters in MPEG
@@ -372,6 +378,14 @@ int ff_add_param_change(AVPacket *pkt, int32_t channels,
  */
 int ff_framehash_write_header(AVFormatContext *s);
 
+/**
+ * Like av_get_packet(), but if the data is memory mapped the packet may
+ * reference the mapping instead of a copy. Such a packet shares its buffer
+ * with the data that follows in the file, so it must not be written to,
+ * grown or shrunk by the caller.
+ */
+int ff_get_mapped_packet(AVIOContext *s, AVPacket *pkt, int size);
+
 /**
  * Read a transport packet from a media file.
  *
@@ -444,6 +458,13 @@ static inline int ff_rename(const char *oldpath, const char *newpath)
     return 0;
 }
 
+/**
+ * Check whether the AVFormatContext.io_open callback is the default one,
+ * which opens the URL with avio_open2() and the interrupt callback of the
+ * context.
+ */
+int ff_format_io_open_is_default(AVFormatContext *s);
+
 /**
  * A wrapper around AVFormatContext.io_close that should be used
  * instead of calling the pointer directly.
@@ -99,6 +99,32 @@ typedef struct MOVSbgp {
     unsigned int index;
 } MOVSbgp;
 
+/**
+ * Position reached in the sample tables while building the index, so that
+ * the building can be resumed when the index is built on demand.
+ */
+typedef struct MOVIndexState {
+    unsigned int max_entries; ///< maximum number of index entries
+    int by_chunk;             ///< old uncompressed audio chunk demuxing
+    unsigned int chunk;       ///< current chunk
+    int in_chunk;             ///< the current chunk has been entered
+    unsigned int chunk_sample;///< samples already indexed in the chunk
+    unsigned int sample;      ///< current sample
+    unsigned int stts_index;
+    unsigned int stts_sample;
+    unsigned int stsc_index;
+    unsigned int stss_index;
+    unsigned int stps_index;
+    unsigned int rap_group_index;
+    unsigned int rap_group_sample;
+    unsigned int distance;    ///< distance from the last keyframe
+    int key_off;
+    int64_t offset;           ///< position of the current sample
+    int64_t dts;              ///< dts of the current sample
+    uint64_t stream_size;
+    int done;                 ///< the index is complete
+} MOVIndexState;
+
 typedef struct MOVStreamContext {
     AVIOContext *pb;
     int ffindex;          ///< AVStream index
@@ -126,6 +152,9 @@ typedef struct MOVStreamContext {
     int time_scale;
     int64_t time_offset;  ///< time offset of the first edit list entry
     int current_sample;
+    int64_t next_sample_key[2]; ///< position and dts of the current sample
+    int sample_heap_index[2];   ///< index in the sample heaps, -1 if absent
+    MOVIndexState index_state;
     unsigned int bytes_per_frame;
     unsigned int samples_per_frame;
     int dv_audio_container;
@@ -176,8 +205,17 @@ typedef struct MOVContext {
     int export_all;
     int export_xmp;
     int enable_drefs;
+    int lazy_index;       ///< build the indexes while reading
 
     int32_t movie_display_matrix[3][3]; ///< display matrix from mvhd
+
+    /**
+     * Indices of the streams with samples left, as binary heaps ordered by
+     * the position and by the dts of their current sample.
+     */
+    int *sample_heap[2];
+    int nb_sample_heap[2];
+    int sample_heap_dirty; ///< the heaps must be rebuilt before use
 } MOVContext;
 
 int ff_mp4_read_descr_len(AVIOContext *pb);
@@ -94,6 +94,7 @@ typedef struct EbmlList {
 
 typedef struct EbmlBin {
     int      size;
+    AVBufferRef *buf;
     uint8_t *data;
     int64_t  pos;
 } EbmlBin;
@@ -769,18 +770,31 @@ static int ebml_read_ascii(AVIOContext *pb, int size, char **str)
  */
 static int ebml_read_binary(AVIOContext *pb, int length, EbmlBin *bin)
 {
-    av_free(bin->data);
+    int ret;
+
+    av_buffer_unref(&bin->buf);
+    bin->data = NULL;
     bin->size = 0;
 
-    if (!(bin->data = av_mallocz(length + AV_INPUT_BUFFER_PADDING_SIZE)))
+    bin->pos = avio_tell(pb);
+    ret = ffio_read_mapped(pb, length, &bin->buf, &bin->data);
+    if (ret >= 0) {
+        bin->size = length;
+        return 0;
+    }
+    if (ret != AVERROR(ENOSYS))
+        return AVERROR(EIO);
+
+    if (!(bin->buf = av_buffer_alloc(length + AV_INPUT_BUFFER_PADDING_SIZE)))
         return AVERROR(ENOMEM);
+    memset(bin->buf->data + length, 0, AV_INPUT_BUFFER_PADDING_SIZE);
 
-    bin->pos  = avio_tell(pb);
-    if (avio_read(pb, bin->data, length) != length) {
-        av_freep(&bin->data);
+    if (avio_read(pb, bin->buf->data, length) != length) {
+        av_buffer_unref(&bin->buf);
         return AVERROR(EIO);
     }
 
+    bin->data = bin->buf->data;
     bin->size = length;
 
     return 0;
@@ -995,7 +1009,8 @@ static void ebml_free(EbmlSyntax *syntax, void *data)
             av_freep(data_off);
             break;
         case EBML_BIN:
-            av_freep(&((EbmlBin *) data_off)->data);
+            av_buffer_unref(&((EbmlBin *) data_off)->buf);
+            ((EbmlBin *) data_off)->data = NULL;
             break;
         case EBML_NEST:
             if (syntax[i].list_elem_size) {
@@ -1766,8 +1781,18 @@ static int matroska_parse_tracks(AVFormatContext *s)
                            "Failed to decode codec private data\n");
                 }
 
-                if (codec_priv != track->codec_priv.data)
-                    av_free(codec_priv);
+                if (codec_priv != track->codec_priv.data) {
+                    av_buffer_unref(&track->codec_priv.buf);
+                    if (track->codec_priv.data) {
+                        track->codec_priv.buf = av_buffer_create(track->codec_priv.data,
+                                                                 track->codec_priv.size + AV_INPUT_BUFFER_PADDING_SIZE,
+                                                                 NULL, NULL, 0);
+                        if (!track->codec_priv.buf) {
+                            av_freep(&track->codec_priv.data);
+                            track->codec_priv.size = 0;
+                        }
+                    }
+                }
             }
         }
 
@@ -2503,7 +2528,7 @@ fail:
 
 static int matroska_parse_frame(MatroskaDemuxContext *matroska,
                                 MatroskaTrack *track, AVStream *st,
-                                uint8_t *data, int pkt_size,
+                                AVBufferRef *buf, uint8_t *data, int pkt_size,
                                 uint64_t timecode, uint64_t duration,
                                 int64_t pos, int is_keyframe)
 {
@@ -2539,23 +2564,35 @@ static int matroska_parse_frame(MatroskaDemuxContext *matroska,
         av_freep(&pkt_data);
         return AVERROR(ENOMEM);
     }
-    /* XXX: prevent data copy... */
-    if (av_new_packet(pkt, pkt_size + offset) < 0) {
-        av_free(pkt);
-        av_freep(&pkt_data);
-        return AVERROR(ENOMEM);
-    }
 
-    if (st->codecpar->codec_id == AV_CODEC_ID_PRORES) {
-        uint8_t *buf = pkt->data;
-        bytestream_put_be32(&buf, pkt_size);
-        bytestream_put_be32(&buf, MKBETAG('i', 'c', 'p', 'f'));
-    }
+    /* subtitle packets are rewritten and merged in place */
+    if (buf && pkt_data == data && !offset &&
+        track->type != MATROSKA_TRACK_TYPE_SUBTITLE) {
+        av_init_packet(pkt);
+        if (!(pkt->buf = av_buffer_ref(buf))) {
+            av_free(pkt);
+            return AVERROR(ENOMEM);
+        }
+        pkt->data = data;
+        pkt->size = pkt_size;
+    } else {
+        if (av_new_packet(pkt, pkt_size + offset) < 0) {
+            av_free(pkt);
+            av_freep(&pkt_data);
+            return AVERROR(ENOMEM);
+        }
 
-    memcpy(pkt->data + offset, pkt_data, pkt_size);
+        if (st->codecpar->codec_id == AV_CODEC_ID_PRORES) {
+            uint8_t *hdr = pkt->data;
+            bytestream_put_be32(&hdr, pkt_size);
+            bytestream_put_be32(&hdr, MKBETAG('i', 'c', 'p', 'f'));
+        }
 
-    if (pkt_data != data)
-        av_free(pkt_data);
+        memcpy(pkt->data + offset, pkt_data, pkt_size);
+
+        if (pkt_data != data)
+            av_free(pkt_data);
+    }
 
     pkt->flags        = is_keyframe;
     pkt->stream_index = st->index;
@@ -2596,7 +2633,8 @@ fail:
     return res;
 }
 
-static int matroska_parse_block(MatroskaDemuxContext *matroska, uint8_t *data,
+static int matroska_parse_block(MatroskaDemuxContext *matroska,
+                                AVBufferRef *buf, uint8_t *data,
                                 int size, int64_t pos, uint64_t cluster_time,
                                 uint64_t block_duration, int is_keyframe,
                                 int64_t cluster_pos)
@@ -2686,7 +2724,11 @@ static int matroska_parse_block(MatroskaDemuxContext *matroska, uint8_t *data,
             if (res)
                 goto end;
         } else {
-            res = matroska_parse_frame(matroska, track, st, data, lace_size[n],
+            /* only the last lace is followed by the padding of the block,
+             * the others are copied */
+            res = matroska_parse_frame(matroska, track, st,
+                                       n == laces - 1 ? buf : NULL,
+                                       data, lace_size[n],
                                        timecode, duration, pos,
                                        !n ? is_keyframe : 0);
             if (res)
@@ -2745,7 +2787,8 @@ static int matroska_parse_cluster_incremental(MatroskaDemuxContext *matroska)
             int is_keyframe = blocks[i].non_simple ? !blocks[i].reference : -1;
             if (!blocks[i].non_simple)
                 blocks[i].duration = AV_NOPTS_VALUE;
-            res = matroska_parse_block(matroska, blocks[i].bin.data,
+            res = matroska_parse_block(matroska, blocks[i].bin.buf,
+                                       blocks[i].bin.data,
                                        blocks[i].bin.size, blocks[i].bin.pos,
                                        matroska->current_cluster.timecode,
                                        blocks[i].duration, is_keyframe,
@@ -2780,7 +2823,8 @@ static int matroska_parse_cluster(MatroskaDemuxContext *matroska)
             int is_keyframe = blocks[i].non_simple ? !blocks[i].reference : -1;
             if (!blocks[i].non_simple)
                 blocks[i].duration = AV_NOPTS_VALUE;
-            res = matroska_parse_block(matroska, blocks[i].bin.data,
+            res = matroska_parse_block(matroska, blocks[i].bin.buf,
+                                       blocks[i].bin.data,
                                        blocks[i].bin.size, blocks[i].bin.pos,
                                        cluster.timecode, blocks[i].duration,
                                        is_keyframe, pos);
@@ -2288,110 +2288,229 @@ static int mov_read_sbgp(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     return pb->eof_reached ? AVERROR_EOF : 0;
 }
 
+/**
+ * Extend the index of a stream until it has nb_entries entries or the end
+ * of the sample tables is reached.
+ */
+static void mov_extend_index(MOVContext *mov, AVStream *st, unsigned int nb_entries)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVIndexState *idx = &sc->index_state;
+    unsigned int nb_alloc = idx->max_entries;
+
+    if (idx->done || st->nb_index_entries >= nb_entries)
+        return;
+
+    /* when building the index on demand, grow it progressively */
+    if (mov->lazy_index)
+        nb_alloc = FFMIN(nb_alloc, FFMAX(nb_entries, st->nb_index_entries +
+                                         st->nb_index_entries / 4 + 256));
+    if (nb_alloc * sizeof(*st->index_entries) > st->index_entries_allocated_size) {
+        if (av_reallocp_array(&st->index_entries, nb_alloc,
+                              sizeof(*st->index_entries)) < 0) {
+            st->nb_index_entries = 0;
+            idx->done = 1;
+            return;
+        }
+        st->index_entries_allocated_size = nb_alloc * sizeof(*st->index_entries);
+    }
+
+    if (!idx->by_chunk) {
+        int rap_group_present = sc->rap_group_count && sc->rap_group;
+
+        while (st->nb_index_entries < nb_entries) {
+            unsigned int sample_size;
+            int keyframe = 0;
+
+            if (!idx->in_chunk) {
+                if (idx->chunk >= sc->chunk_count) {
+                    idx->done = 1;
+                    if (st->duration > 0 && !mov->lazy_index)
+                        st->codecpar->bit_rate = idx->stream_size*8*sc->time_scale/st->duration;
+                    return;
+                }
+                idx->offset = sc->chunk_offsets[idx->chunk];
+                while (mov_stsc_index_valid(idx->stsc_index, sc->stsc_count) &&
+                    idx->chunk + 1 == sc->stsc_data[idx->stsc_index + 1].first)
+                    idx->stsc_index++;
+                idx->chunk_sample = 0;
+                idx->in_chunk     = 1;
+            }
+            if (idx->chunk_sample >= sc->stsc_data[idx->stsc_index].count) {
+                idx->chunk++;
+                idx->in_chunk = 0;
+                continue;
+            }
+            if (idx->sample >= sc->sample_count) {
+                av_log(mov->fc, AV_LOG_ERROR, "wrong sample count\n");
+                idx->done = 1;
+                return;
+            }
+
+            if (!sc->keyframe_absent && (!sc->keyframe_count || idx->sample+idx->key_off == sc->keyframes[idx->stss_index])) {
+                keyframe = 1;
+                if (idx->stss_index + 1 < sc->keyframe_count)
+                    idx->stss_index++;
+            } else if (sc->stps_count && idx->sample+idx->key_off == sc->stps_data[idx->stps_index]) {
+                keyframe = 1;
+                if (idx->stps_index + 1 < sc->stps_count)
+                    idx->stps_index++;
+            }
+            if (rap_group_present && idx->rap_group_index < sc->rap_group_count) {
+                if (sc->rap_group[idx->rap_group_index].index > 0)
+                    keyframe = 1;
+                if (++idx->rap_group_sample == sc->rap_group[idx->rap_group_index].count) {
+                    idx->rap_group_sample = 0;
+                    idx->rap_group_index++;
+                }
+            }
+            if (keyframe)
+                idx->distance = 0;
+            sample_size = sc->sample_size > 0 ? sc->sample_size : sc->sample_sizes[idx->sample];
+            if (sc->pseudo_stream_id == -1 ||
+               sc->stsc_data[idx->stsc_index].id - 1 == sc->pseudo_stream_id) {
+                AVIndexEntry *e = &st->index_entries[st->nb_index_entries++];
+                e->pos = idx->offset;
+                e->timestamp = idx->dts;
+                e->size = sample_size;
+                e->min_distance = idx->distance;
+                e->flags = keyframe ? AVINDEX_KEYFRAME : 0;
+                av_log(mov->fc, AV_LOG_TRACE, "AVIndex stream %d, sample %u, offset %"PRIx64", dts %"PRId64", "
+                       "size %u, distance %u, keyframe %d\n", st->index, idx->sample,
+                       idx->offset, idx->dts, sample_size, idx->distance, keyframe);
+            }
+
+            idx->offset += sample_size;
+            idx->stream_size += sample_size;
+            idx->dts += sc->stts_data[idx->stts_index].duration;
+            idx->distance++;
+            idx->stts_sample++;
+            idx->sample++;
+            idx->chunk_sample++;
+            if (idx->stts_index + 1 < sc->stts_count && idx->stts_sample == sc->stts_data[idx->stts_index].count) {
+                idx->stts_sample = 0;
+                idx->stts_index++;
+            }
+        }
+    } else {
+        while (st->nb_index_entries < nb_entries) {
+            AVIndexEntry *e;
+            unsigned size, samples, chunk_samples;
+
+            if (!idx->in_chunk) {
+                if (idx->chunk >= sc->chunk_count) {
+                    idx->done = 1;
+                    return;
+                }
+                idx->offset = sc->chunk_offsets[idx->chunk];
+                if (mov_stsc_index_valid(idx->stsc_index, sc->stsc_count) &&
+                    idx->chunk + 1 == sc->stsc_data[idx->stsc_index + 1].first)
+                    idx->stsc_index++;
+                idx->chunk_sample = 0;
+                idx->in_chunk     = 1;
+            }
+            chunk_samples = sc->stsc_data[idx->stsc_index].count - idx->chunk_sample;
+            if (!chunk_samples) {
+                idx->chunk++;
+                idx->in_chunk = 0;
+                continue;
+            }
+
+            if (sc->samples_per_frame > 1 && !sc->bytes_per_frame) {
+                avpriv_request_sample(mov->fc,
+                       "Zero bytes per frame, but %d samples per frame",
+                       sc->samples_per_frame);
+                idx->done = 1;
+                return;
+            }
+
+            if (sc->samples_per_frame >= 160) { // gsm
+                samples = sc->samples_per_frame;
+                size = sc->bytes_per_frame;
+            } else {
+                if (sc->samples_per_frame > 1) {
+                    samples = FFMIN((1024 / sc->samples_per_frame)*
+                                    sc->samples_per_frame, chunk_samples);
+                    size = (samples / sc->samples_per_frame) * sc->bytes_per_frame;
+                } else {
+                    samples = FFMIN(1024, chunk_samples);
+                    size = samples * sc->sample_size;
+                }
+            }
+
+            if (st->nb_index_entries >= idx->max_entries) {
+                av_log(mov->fc, AV_LOG_ERROR, "wrong chunk count %u\n", idx->max_entries);
+                idx->done = 1;
+                return;
+            }
+            e = &st->index_entries[st->nb_index_entries++];
+            e->pos = idx->offset;
+            e->timestamp = idx->dts;
+            e->size = size;
+            e->min_distance = 0;
+            e->flags = AVINDEX_KEYFRAME;
+            av_log(mov->fc, AV_LOG_TRACE, "AVIndex stream %d, chunk %u, offset %"PRIx64", dts %"PRId64", "
+                   "size %u, duration %u\n", st->index, idx->chunk, idx->offset, idx->dts,
+                   size, samples);
+
+            idx->offset += size;
+            idx->dts += samples;
+            idx->chunk_sample += samples;
+        }
+    }
+}
+
+/**
+ * Extend the index of a stream until it covers the given timestamp and
+ * reaches a keyframe after it.
+ */
+static void mov_extend_index_to(MOVContext *mov, AVStream *st, int64_t timestamp)
+{
+    MOVStreamContext *sc = st->priv_data;
+
+    while (!sc->index_state.done) {
+        if (st->nb_index_entries) {
+            AVIndexEntry *e = &st->index_entries[st->nb_index_entries - 1];
+            if (e->timestamp >= timestamp && e->flags & AVINDEX_KEYFRAME)
+                break;
+        }
+        mov_extend_index(mov, st, st->nb_index_entries + 1);
+    }
+}
+
 static void mov_build_index(MOVContext *mov, AVStream *st)
 {
     MOVStreamContext *sc = st->priv_data;
-    int64_t current_offset;
-    int64_t current_dts = 0;
-    unsigned int stts_index = 0;
-    unsigned int stsc_index = 0;
-    unsigned int stss_index = 0;
-    unsigned int stps_index = 0;
-    unsigned int i, j;
-    uint64_t stream_size = 0;
+    MOVIndexState *idx = &sc->index_state;
+    unsigned int i;
+
+    idx->done = 1;
 
     /* adjust first dts according to edit list */
     if (sc->time_offset && mov->time_scale > 0) {
         if (sc->time_offset < 0)
             sc->time_offset = av_rescale(sc->time_offset, sc->time_scale, mov->time_scale);
-        current_dts = -sc->time_offset;
+        idx->dts = -sc->time_offset;
     }
 
     /* only use old uncompressed audio chunk demuxing when stts specifies it */
     if (!(st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
           sc->stts_count == 1 && sc->stts_data[0].duration == 1)) {
-        unsigned int current_sample = 0;
-        unsigned int stts_sample = 0;
-        unsigned int sample_size;
-        unsigned int distance = 0;
-        unsigned int rap_group_index = 0;
-        unsigned int rap_group_sample = 0;
-        int rap_group_present = sc->rap_group_count && sc->rap_group;
-        int key_off = (sc->keyframes && sc->keyframes[0] > 0) || (sc->stps_data && sc->stps_data[0] > 0);
-
-        current_dts -= sc->dts_shift;
+        idx->key_off = (sc->keyframes && sc->keyframes[0] > 0) || (sc->stps_data && sc->stps_data[0] > 0);
+        idx->dts -= sc->dts_shift;
 
         if (!sc->sample_count)
             return;
         if (sc->sample_count >= UINT_MAX / sizeof(*st->index_entries) - st->nb_index_entries)
             return;
-        if (av_reallocp_array(&st->index_entries,
-                              st->nb_index_entries + sc->sample_count,
-                              sizeof(*st->index_entries)) < 0) {
-            st->nb_index_entries = 0;
-            return;
-        }
-        st->index_entries_allocated_size = (st->nb_index_entries + sc->sample_count) * sizeof(*st->index_entries);
-
-        for (i = 0; i < sc->chunk_count; i++) {
-            current_offset = sc->chunk_offsets[i];
-            while (mov_stsc_index_valid(stsc_index, sc->stsc_count) &&
-                i + 1 == sc->stsc_data[stsc_index + 1].first)
-                stsc_index++;
-            for (j = 0; j < sc->stsc_data[stsc_index].count; j++) {
-                int keyframe = 0;
-                if (current_sample >= sc->sample_count) {
-                    av_log(mov->fc, AV_LOG_ERROR, "wrong sample count\n");
-                    return;
-                }
-
-                if (!sc->keyframe_absent && (!sc->keyframe_count || current_sample+key_off == sc->keyframes[stss_index])) {
-                    keyframe = 1;
-                    if (stss_index + 1 < sc->keyframe_count)
-                        stss_index++;
-                } else if (sc->stps_count && current_sample+key_off == sc->stps_data[stps_index]) {
-                    keyframe = 1;
-                    if (stps_index + 1 < sc->stps_count)
-                        stps_index++;
-                }
-                if (rap_group_present && rap_group_index < sc->rap_group_count) {
-                    if (sc->rap_group[rap_group_index].index > 0)
-                        keyframe = 1;
-                    if (++rap_group_sample == sc->rap_group[rap_group_index].count) {
-                        rap_group_sample = 0;
-                        rap_group_index++;
-                    }
-                }
-                if (keyframe)
-                    distance = 0;
-                sample_size = sc->sample_size > 0 ? sc->sample_size : sc->sample_sizes[current_sample];
-                if (sc->pseudo_stream_id == -1 ||
-                   sc->stsc_data[stsc_index].id - 1 == sc->pseudo_stream_id) {
-                    AVIndexEntry *e = &st->index_entries[st->nb_index_entries++];
-                    e->pos = current_offset;
-                    e->timestamp = current_dts;
-                    e->size = sample_size;
-                    e->min_distance = distance;
-                    e->flags = keyframe ? AVINDEX_KEYFRAME : 0;
-                    av_log(mov->fc, AV_LOG_TRACE, "AVIndex stream %d, sample %u, offset %"PRIx64", dts %"PRId64", "
-                           "size %u, distance %u, keyframe %d\n", st->index, current_sample,
-                           current_offset, current_dts, sample_size, distance, keyframe);
-                }
+        idx->max_entries = st->nb_index_entries + sc->sample_count;
 
-                current_offset += sample_size;
-                stream_size += sample_size;
-                current_dts += sc->stts_data[stts_index].duration;
-                distance++;
-                stts_sample++;
-                current_sample++;
-                if (stts_index + 1 < sc->stts_count && stts_sample == sc->stts_data[stts_index].count) {
-                    stts_sample = 0;
-                    stts_index++;
-                }
-            }
-        }
-        if (st->duration > 0)
+        if (mov->lazy_index && st->duration > 0) {
+            uint64_t stream_size = sc->sample_size > 0 ?
+                                   (uint64_t)sc->sample_size * sc->sample_count :
+                                   sc->data_size;
             st->codecpar->bit_rate = stream_size*8*sc->time_scale/st->duration;
+        }
     } else {
         unsigned chunk_samples, total = 0;
 
@@ -2425,67 +2544,13 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
         av_log(mov->fc, AV_LOG_TRACE, "chunk count %u\n", total);
         if (total >= UINT_MAX / sizeof(*st->index_entries) - st->nb_index_entries)
             return;
-        if (av_reallocp_array(&st->index_entries,
-                              st->nb_index_entries + total,
-                              sizeof(*st->index_entries)) < 0) {
-            st->nb_index_entries = 0;
-            return;
-        }
-        st->index_entries_allocated_size = (st->nb_index_entries + total) * sizeof(*st->index_entries);
-
-        // populate index
-        for (i = 0; i < sc->chunk_count; i++) {
-            current_offset = sc->chunk_offsets[i];
-            if (mov_stsc_index_valid(stsc_index, sc->stsc_count) &&
-                i + 1 == sc->stsc_data[stsc_index + 1].first)
-                stsc_index++;
-            chunk_samples = sc->stsc_data[stsc_index].count;
-
-            while (chunk_samples > 0) {
-                AVIndexEntry *e;
-                unsigned size, samples;
-
-                if (sc->samples_per_frame > 1 && !sc->bytes_per_frame) {
-                    avpriv_request_sample(mov->fc,
-                           "Zero bytes per frame, but %d samples per frame",
-                           sc->samples_per_frame);
-                    return;
-                }
-
-                if (sc->samples_per_frame >= 160) { // gsm
-                    samples = sc->samples_per_frame;
-                    size = sc->bytes_per_frame;
-                } else {
-                    if (sc->samples_per_frame > 1) {
-                        samples = FFMIN((1024 / sc->samples_per_frame)*
-                                        sc->samples_per_frame, chunk_samples);
-                        size = (samples / sc->samples_per_frame) * sc->bytes_per_frame;
-                    } else {
-                        samples = FFMIN(1024, chunk_samples);
-                        size = samples * sc->sample_size;
-                    }
-                }
-
-                if (st->nb_index_entries >= total) {
-                    av_log(mov->fc, AV_LOG_ERROR, "wrong chunk count %u\n", total);
-                    return;
-                }
-                e = &st->index_entries[st->nb_index_entries++];
-                e->pos = current_offset;
-                e->timestamp = current_dts;
-                e->size = size;
-                e->min_distance = 0;
-                e->flags = AVINDEX_KEYFRAME;
-                av_log(mov->fc, AV_LOG_TRACE, "AVIndex stream %d, chunk %u, offset %"PRIx64", dts %"PRId64", "
-                       "size %u, duration %u\n", st->index, i, current_offset, current_dts,
-                       size, samples);
-
-                current_offset += size;
-                current_dts += samples;
-                chunk_samples -= samples;
-            }
-        }
+        idx->max_entries = st->nb_index_entries + total;
+        idx->by_chunk    = 1;
     }
+
+    idx->done = 0;
+    if (!mov->lazy_index)
+        mov_extend_index(mov, st, UINT_MAX);
 }
 
 static int mov_open_dref(AVFormatContext *s, AVIOContext **pb, char *src,
@@ -2625,7 +2690,9 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
         break;
     }
 
-    /* Do not need those anymore. */
+    /* Do not need those anymore, unless the index is built while reading. */
+    if (!sc->index_state.done)
+        return 0;
     av_freep(&sc->chunk_offsets);
     av_freep(&sc->sample_sizes);
     av_freep(&sc->keyframes);
@@ -2977,6 +3044,8 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     sc = st->priv_data;
     if (sc->pseudo_stream_id+1 != frag->stsd_id)
         return 0;
+    /* the fragment samples are appended after the ones of the moov */
+    mov_extend_index(c, st, UINT_MAX);
     avio_r8(pb); /* version */
     flags = avio_rb24(pb);
     entries = avio_rb32(pb);
@@ -3664,6 +3733,7 @@ static void mov_read_chapters(AVFormatContext *s)
     st->discard = AVDISCARD_ALL;
     sc = st->priv_data;
     cur_pos = avio_tell(sc->pb);
+    mov_extend_index(mov, st, UINT_MAX);
 
     for (i = 0; i < st->nb_index_entries; i++) {
         AVIndexEntry *sample = &st->index_entries[i];
@@ -3712,6 +3782,124 @@ finish:
     avio_seek(sc->pb, cur_pos, SEEK_SET);
 }
 
+enum {
+    SAMPLE_HEAP_POS,
+    SAMPLE_HEAP_DTS,
+};
+
+static int sample_heap_less(AVFormatContext *s, int heap, int a, int b)
+{
+    MOVStreamContext *sa = s->streams[a]->priv_data;
+    MOVStreamContext *sb = s->streams[b]->priv_data;
+
+    if (sa->next_sample_key[heap] != sb->next_sample_key[heap])
+        return sa->next_sample_key[heap] < sb->next_sample_key[heap];
+    return a < b;
+}
+
+static void sample_heap_set(AVFormatContext *s, int heap, int i, int stream)
+{
+    MOVContext *mov = s->priv_data;
+    MOVStreamContext *sc = s->streams[stream]->priv_data;
+
+    mov->sample_heap[heap][i]   = stream;
+    sc->sample_heap_index[heap] = i;
+}
+
+/* Restore the heap property after the key of the entry i changed. */
+static void sample_heap_sift(AVFormatContext *s, int heap, int i)
+{
+    MOVContext *mov = s->priv_data;
+    int *h = mov->sample_heap[heap];
+    int n  = mov->nb_sample_heap[heap];
+    int stream = h[i], child;
+
+    while (i > 0 && sample_heap_less(s, heap, stream, h[(i - 1) / 2])) {
+        sample_heap_set(s, heap, i, h[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    while ((child = 2 * i + 1) < n) {
+        if (child + 1 < n && sample_heap_less(s, heap, h[child + 1], h[child]))
+            child++;
+        if (!sample_heap_less(s, heap, h[child], stream))
+            break;
+        sample_heap_set(s, heap, i, h[child]);
+        i = child;
+    }
+    sample_heap_set(s, heap, i, stream);
+}
+
+static void sample_heap_update(AVFormatContext *s, int heap, int stream,
+                               int present)
+{
+    MOVContext *mov = s->priv_data;
+    MOVStreamContext *sc = s->streams[stream]->priv_data;
+    int i = sc->sample_heap_index[heap];
+
+    if (present && i < 0) {
+        i = mov->nb_sample_heap[heap]++;
+        sample_heap_set(s, heap, i, stream);
+    } else if (!present && i >= 0) {
+        int last = mov->sample_heap[heap][--mov->nb_sample_heap[heap]];
+        sc->sample_heap_index[heap] = -1;
+        if (last == stream)
+            return;
+        sample_heap_set(s, heap, i, last);
+    } else if (!present) {
+        return;
+    }
+    sample_heap_sift(s, heap, i);
+}
+
+/*
+ * Update the position of a stream in the sample heaps after its current
+ * sample changed. The position heap only holds the streams stored in the
+ * main file.
+ */
+static void mov_update_next_sample(AVFormatContext *s, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int present;
+
+    if (sc->current_sample >= st->nb_index_entries)
+        mov_extend_index(s->priv_data, st, sc->current_sample + 1);
+
+    present = sc->pb && sc->current_sample >= 0 &&
+                  sc->current_sample < st->nb_index_entries;
+
+    if (present) {
+        AVIndexEntry *sample = &st->index_entries[sc->current_sample];
+        sc->next_sample_key[SAMPLE_HEAP_POS] = sample->pos;
+        sc->next_sample_key[SAMPLE_HEAP_DTS] = av_rescale(sample->timestamp,
+                                                          AV_TIME_BASE,
+                                                          sc->time_scale);
+    }
+    sample_heap_update(s, SAMPLE_HEAP_POS, st->index, present && sc->pb == s->pb);
+    sample_heap_update(s, SAMPLE_HEAP_DTS, st->index, present);
+}
+
+static int mov_init_sample_heaps(AVFormatContext *s)
+{
+    MOVContext *mov = s->priv_data;
+    int i, j;
+
+    for (j = 0; j < 2; j++) {
+        mov->sample_heap[j] = av_malloc_array(s->nb_streams,
+                                              sizeof(*mov->sample_heap[j]));
+        if (!mov->sample_heap[j])
+            return AVERROR(ENOMEM);
+        mov->nb_sample_heap[j] = 0;
+    }
+    for (i = 0; i < s->nb_streams; i++) {
+        MOVStreamContext *sc = s->streams[i]->priv_data;
+        sc->sample_heap_index[SAMPLE_HEAP_POS] = -1;
+        sc->sample_heap_index[SAMPLE_HEAP_DTS] = -1;
+    }
+    mov->sample_heap_dirty = 1;
+
+    return 0;
+}
+
 static int mov_read_close(AVFormatContext *s)
 {
     MOVContext *mov = s->priv_data;
@@ -3754,6 +3942,8 @@ static int mov_read_close(AVFormatContext *s)
     }
 
     av_freep(&mov->trex_data);
+    av_freep(&mov->sample_heap[SAMPLE_HEAP_POS]);
+    av_freep(&mov->sample_heap[SAMPLE_HEAP_DTS]);
 
     return 0;
 }
@@ -3789,6 +3979,11 @@ static int mov_read_header(AVFormatContext *s)
     if ((pb->seekable & AVIO_SEEKABLE_NORMAL) && mov->chapter_track > 0)
         mov_read_chapters(s);
 
+    if ((err = mov_init_sample_heaps(s)) < 0) {
+        mov_read_close(s);
+        return err;
+    }
+
     for (i = 0; i < s->nb_streams; i++) {
         AVStream *st = s->streams[i];
         MOVStreamContext *sc = st->priv_data;
@@ -3861,30 +4056,43 @@ static int mov_read_header(AVFormatContext *s)
     return 0;
 }
 
+/*
+ * The samples are read in file order, unless the stream with the lowest dts
+ * is more than a second late, in which case it is served first. Streams
+ * stored in other files are read in dts order.
+ */
 static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
 {
-    AVIndexEntry *sample = NULL;
-    int64_t best_dts = INT64_MAX;
+    MOVContext *mov = s->priv_data;
+    MOVStreamContext *by_pos = NULL, *by_dts = NULL, *sc;
     int i;
-    for (i = 0; i < s->nb_streams; i++) {
-        AVStream *avst = s->streams[i];
-        MOVStreamContext *msc = avst->priv_data;
-        if (msc->pb && msc->current_sample < avst->nb_index_entries) {
-            AVIndexEntry *current_sample = &avst->index_entries[msc->current_sample];
-            int64_t dts = av_rescale(current_sample->timestamp, AV_TIME_BASE, msc->time_scale);
-            av_log(s, AV_LOG_TRACE, "stream %d, sample %d, dts %"PRId64"\n", i, msc->current_sample, dts);
-            if (!sample || (!(s->pb->seekable & AVIO_SEEKABLE_NORMAL) && current_sample->pos < sample->pos) ||
-                ((s->pb->seekable & AVIO_SEEKABLE_NORMAL) &&
-                 ((msc->pb != s->pb && dts < best_dts) || (msc->pb == s->pb &&
-                 ((FFABS(best_dts - dts) <= AV_TIME_BASE && current_sample->pos < sample->pos) ||
-                  (FFABS(best_dts - dts) > AV_TIME_BASE && dts < best_dts)))))) {
-                sample = current_sample;
-                best_dts = dts;
-                *st = avst;
-            }
-        }
+
+    if (mov->sample_heap_dirty) {
+        for (i = 0; i < s->nb_streams; i++)
+            mov_update_next_sample(s, s->streams[i]);
+        mov->sample_heap_dirty = 0;
     }
-    return sample;
+
+    if (mov->nb_sample_heap[SAMPLE_HEAP_POS])
+        by_pos = s->streams[mov->sample_heap[SAMPLE_HEAP_POS][0]]->priv_data;
+    if (mov->nb_sample_heap[SAMPLE_HEAP_DTS])
+        by_dts = s->streams[mov->sample_heap[SAMPLE_HEAP_DTS][0]]->priv_data;
+
+    sc = by_pos ? by_pos : by_dts;
+    if (by_pos && by_dts != by_pos &&
+        (s->pb->seekable & AVIO_SEEKABLE_NORMAL)) {
+        int64_t pos_dts = by_pos->next_sample_key[SAMPLE_HEAP_DTS];
+        int64_t dts     = by_dts->next_sample_key[SAMPLE_HEAP_DTS];
+        if (by_dts->pb != s->pb ? dts < pos_dts : pos_dts - dts > AV_TIME_BASE)
+            sc = by_dts;
+    }
+    if (!sc)
+        return NULL;
+
+    *st = s->streams[sc->ffindex];
+    av_log(s, AV_LOG_TRACE, "stream %d, sample %d, dts %"PRId64"\n",
+           sc->ffindex, sc->current_sample, sc->next_sample_key[SAMPLE_HEAP_DTS]);
+    return &(*st)->index_entries[sc->current_sample];
 }
 
 static int mov_change_extradata(MOVStreamContext *sc, AVPacket *pkt)
@@ -3928,12 +4136,17 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
         if (mov_read_default(mov, s->pb, (MOVAtom){ AV_RL32("root"), INT64_MAX }) < 0 ||
             s->pb->eof_reached)
             return AVERROR_EOF;
+        /* the fragments added samples to the indexes */
+        mov->sample_heap_dirty = 1;
         av_log(s, AV_LOG_TRACE, "read fragments, offset 0x%"PRIx64"\n", avio_tell(s->pb));
         goto retry;
     }
     sc = st->priv_data;
     /* must be done just before reading, to avoid infinite loop on sample */
     sc->current_sample++;
+    mov_update_next_sample(s, st);
+    /* the index may have been reallocated while extending it */
+    sample = &st->index_entries[sc->current_sample - 1];
 
     if (st->discard != AVDISCARD_ALL) {
         if (avio_seek(sc->pb, sample->pos, SEEK_SET) != sample->pos) {
@@ -3941,7 +4154,11 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
                    sc->ffindex, sample->pos);
             return AVERROR_INVALIDDATA;
         }
-        ret = av_get_packet(sc->pb, pkt, sample->size);
+        /* the DV demuxer takes over the packet data */
+        if (mov->dv_demux && sc->dv_audio_container)
+            ret = av_get_packet(sc->pb, pkt, sample->size);
+        else
+            ret = ff_get_mapped_packet(sc->pb, pkt, sample->size);
         if (ret < 0)
             return ret;
         if (sc->has_palette) {
@@ -4017,6 +4234,7 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
     int sample, time_sample;
     unsigned int i;
 
+    mov_extend_index_to(s->priv_data, st, timestamp);
     sample = av_index_search_timestamp(st, timestamp, flags);
     av_log(s, AV_LOG_TRACE, "stream %d, timestamp %"PRId64", sample %d\n", st->index, timestamp, sample);
     if (sample < 0 && st->nb_index_entries && timestamp < st->index_entries[0].timestamp)
@@ -4070,6 +4288,7 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
     sample = mov_seek_stream(s, st, sample_time, flags);
     if (sample < 0)
         return sample;
+    mc->sample_heap_dirty = 1;
 
     if (mc->seek_individually) {
         /* adjust seek timestamp to found sample timestamp */
@@ -4100,6 +4319,7 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
             if (sc->ffindex == stream_index && sc->current_sample == sample)
                 break;
             sc->current_sample++;
+            mov_update_next_sample(s, st);
         }
     }
     return 0;
@@ -4118,6 +4338,8 @@ static const AVOption mov_options[] = {
         AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, .flags = FLAGS },
     { "enable_drefs", "Enable external track support.", OFFSET(enable_drefs),
         AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, .flags = FLAGS },
+    { "lazy_index", "Build the sample index while reading instead of when opening",
+        OFFSET(lazy_index), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, .flags = FLAGS },
     { NULL },
 };
 
@@ -75,6 +75,8 @@ static const AVOption options[] = {
     { "brand",    "Override major brand", offsetof(MOVMuxContext, major_brand),   AV_OPT_TYPE_STRING, {.str = NULL}, .flags = AV_OPT_FLAG_ENCODING_PARAM },
     { "use_editlist", "use edit list", offsetof(MOVMuxContext, use_editlist), AV_OPT_TYPE_INT, {.i64 = -1}, -1, 1, AV_OPT_FLAG_ENCODING_PARAM},
     { "fragment_index", "Fragment number of the next fragment", offsetof(MOVMuxContext, fragments), AV_OPT_TYPE_INT, {.i64 = 1}, 1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM},
+    { "moov_size", "Space reserved for the moov atom at the beginning of the file", offsetof(MOVMuxContext, moov_size), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM },
+    { "moov_duration", "Expected duration in seconds, used to estimate the space reserved for the moov atom", offsetof(MOVMuxContext, moov_duration), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM },
     { "frag_interleave", "Interleave samples within fragments (max number of consecutive samples, lower is tighter interleaving, but with more overhead)", offsetof(MOVMuxContext, frag_interleave), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM },
     { NULL },
 };
@@ -3917,6 +3919,44 @@ static int mov_create_dvd_sub_decoder_specific_info(MOVTrack *track,
     return 0;
 }
 
+/*
+ * Upper bound of the size of the moov atom of a file lasting duration
+ * seconds. Every packet is stored as a chunk of its own, so it may need an
+ * entry in each of the stco/co64, stsz, stts, ctts and stss tables.
+ */
+static int64_t estimate_moov_size(AVFormatContext *s, int duration)
+{
+    AVDictionaryEntry *t = NULL;
+    int64_t size = 4096;
+    int i;
+
+    while ((t = av_dict_get(s->metadata, "", t, AV_DICT_IGNORE_SUFFIX)))
+        size += strlen(t->key) + strlen(t->value) + 32;
+
+    for (i = 0; i < s->nb_streams; i++) {
+        AVStream *st           = s->streams[i];
+        AVCodecParameters *par = st->codecpar;
+        AVRational rate        = { 2, 1 };
+        int entry_size         = 20;
+
+        if (par->codec_type == AVMEDIA_TYPE_VIDEO) {
+            rate       = st->avg_frame_rate.num && st->avg_frame_rate.den ?
+                         st->avg_frame_rate : (AVRational){ 60, 1 };
+            entry_size = 32;
+        } else if (par->codec_type == AVMEDIA_TYPE_AUDIO && par->sample_rate) {
+            int frame_size = av_get_audio_frame_duration2(par, 0);
+            rate = (AVRational){ par->sample_rate,
+                                 frame_size > 0 ? frame_size : 1024 };
+        }
+
+        size += 2048 + par->extradata_size;
+        size += av_rescale_rnd(duration, (int64_t)rate.num * entry_size,
+                               rate.den, AV_ROUND_UP);
+    }
+
+    return size;
+}
+
 static int mov_write_header(AVFormatContext *s)
 {
     AVIOContext *pb = s->pb;
@@ -4128,6 +4168,21 @@ static int mov_write_header(AVFormatContext *s)
     } else {
         if (mov->flags & FF_MOV_FLAG_FASTSTART)
             mov->reserved_header_pos = avio_tell(pb);
+
+        mov->reserved_moov_size = mov->moov_size;
+        if (!mov->reserved_moov_size && mov->moov_duration)
+            mov->reserved_moov_size = FFMIN(estimate_moov_size(s, mov->moov_duration),
+                                            INT_MAX);
+        if (mov->reserved_moov_size) {
+            /* the moov atom and a free atom must fit in the reserved space */
+            mov->reserved_moov_size  = FFMAX(mov->reserved_moov_size, 16);
+            mov->reserved_header_pos = avio_tell(pb);
+            av_log(s, AV_LOG_VERBOSE, "Reserving %d bytes for the moov atom\n",
+                   mov->reserved_moov_size);
+            avio_wb32(pb, mov->reserved_moov_size);
+            ffio_wfourcc(pb, "free");
+            ffio_fill(pb, 0, mov->reserved_moov_size - 8);
+        }
         mov_write_mdat_tag(pb, mov);
     }
 
@@ -4211,8 +4266,10 @@ static int compute_moov_size(AVFormatContext *s)
     if (moov_size < 0)
         return moov_size;
 
+    /* the data is moved by the part of the moov atom that does not fit in
+     * the space reserved for it */
     for (i = 0; i < mov->nb_streams; i++)
-        mov->tracks[i].data_offset += moov_size;
+        mov->tracks[i].data_offset += moov_size - mov->reserved_moov_size;
 
     moov_size2 = get_moov_size(s);
     if (moov_size2 < 0)
@@ -4242,9 +4299,11 @@ static int compute_sidx_size(AVFormatContext *s)
     return sidx_size;
 }
 
+#define SHIFT_BLOCK_SIZE (1 << 20)
+
 static int shift_data(AVFormatContext *s)
 {
-    int ret = 0, moov_size;
+    int ret = 0, moov_size, shift, block_size;
     MOVMuxContext *mov = s->priv_data;
     int64_t pos, pos_end = avio_tell(s->pb);
     uint8_t *buf, *read_buf[2];
@@ -4258,12 +4317,17 @@ static int shift_data(AVFormatContext *s)
         moov_size = compute_moov_size(s);
     if (moov_size < 0)
         return moov_size;
+    shift = moov_size - mov->reserved_moov_size;
 
-    buf = av_malloc(moov_size * 2);
+    /* a block is written once the next one is read, so it can not be
+     * smaller than the shift; larger blocks mean less round trips between
+     * the two contexts */
+    block_size = FFMAX(shift, SHIFT_BLOCK_SIZE);
+    buf = av_malloc(block_size * 2LL);
     if (!buf)
         return AVERROR(ENOMEM);
     read_buf[0] = buf;
-    read_buf[1] = buf + moov_size;
+    read_buf[1] = buf + block_size;
 
     /* Shift the data: the AVIO context of the output can only be used for
      * writing, so we re-open the same output, but for reading. It also avoids
@@ -4281,16 +4345,17 @@ static int shift_data(AVFormatContext *s)
     pos_end = avio_tell(s->pb);
     avio_seek(s->pb, mov->reserved_header_pos + moov_size, SEEK_SET);
 
-    /* start reading at where the new moov will be placed */
-    avio_seek(read_pb, mov->reserved_header_pos, SEEK_SET);
+    /* start reading after the space reserved for the new moov */
+    avio_seek(read_pb, mov->reserved_header_pos + mov->reserved_moov_size,
+              SEEK_SET);
     pos = avio_tell(read_pb);
 
 #define READ_BLOCK do {                                                             \
-    read_size[read_buf_id] = avio_read(read_pb, read_buf[read_buf_id], moov_size);  \
+    read_size[read_buf_id] = avio_read(read_pb, read_buf[read_buf_id], block_size); \
     read_buf_id ^= 1;                                                               \
 } while (0)
 
-    /* shift data by chunk of at most moov_size */
+    /* shift data by chunk of block_size */
     READ_BLOCK;
     do {
         int n;
@@ -4303,11 +4368,51 @@ static int shift_data(AVFormatContext *s)
     } while (pos < pos_end);
     ff_format_io_close(s, &read_pb);
 
+    av_log(s, AV_LOG_INFO, "Moved %"PRId64" bytes of data by %d bytes\n",
+           pos_end - mov->reserved_header_pos - mov->reserved_moov_size, shift);
+
 end:
     av_free(buf);
     return ret;
 }
 
+/*
+ * Write the moov atom in the space reserved for it, followed by a free atom
+ * covering the rest. Returns 0 if it does not fit.
+ */
+static int write_reserved_moov(AVFormatContext *s)
+{
+    MOVMuxContext *mov = s->priv_data;
+    AVIOContext *pb = s->pb;
+    int64_t pos = avio_tell(pb);
+    int moov_size;
+
+    moov_size = get_moov_size(s);
+    if (moov_size < 0)
+        return moov_size;
+
+    if (moov_size != mov->reserved_moov_size &&
+        moov_size + 8 > mov->reserved_moov_size) {
+        av_log(s, AV_LOG_WARNING, "The %d bytes reserved are not enough for "
+               "the %d bytes moov atom\n", mov->reserved_moov_size, moov_size);
+        /* a remainder too small for a free atom can not be filled, the
+         * free atom is shifted along with the data instead */
+        if (moov_size < mov->reserved_moov_size)
+            mov->reserved_moov_size = 0;
+        return 0;
+    }
+
+    avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
+    mov_write_moov_tag(pb, mov, s);
+    if (moov_size < mov->reserved_moov_size) {
+        avio_wb32(pb, mov->reserved_moov_size - moov_size);
+        ffio_wfourcc(pb, "free");
+    }
+    avio_seek(pb, pos, SEEK_SET);
+
+    return 1;
+}
+
 static int mov_write_trailer(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -4345,7 +4450,11 @@ static int mov_write_trailer(AVFormatContext *s)
         }
         avio_seek(pb, moov_pos, SEEK_SET);
 
-        if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+        if (mov->reserved_moov_size)
+            res = write_reserved_moov(s);
+        if (res) {
+            res = FFMIN(res, 0);
+        } else if (mov->flags & FF_MOV_FLAG_FASTSTART) {
             av_log(s, AV_LOG_INFO, "Starting second pass: moving the moov atom to the beginning of the file\n");
             res = shift_data(s);
             if (res == 0) {
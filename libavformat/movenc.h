@@ -169,6 +169,9 @@ typedef struct MOVMuxContext {
     int first_trun;
 
     int64_t reserved_header_pos;
+    int reserved_moov_size;
+    int moov_size;
+    int moov_duration;
 
     char *major_brand;
 
@@ -494,8 +494,10 @@ int ff_interleave_add_packet(AVFormatContext *s, AVPacket *pkt,
 
     if (s->streams[pkt->stream_index]->last_in_packet_buffer) {
         next_point = &(s->streams[pkt->stream_index]->last_in_packet_buffer->next);
-    } else
+    } else {
         next_point = &s->internal->packet_buffer;
+        s->internal->nb_buffered_streams++;
+    }
 
     if (*next_point) {
         if (compare(s, &s->internal->packet_buffer_end->pkt, pkt)) {
@@ -538,34 +540,27 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
                                  AVPacket *pkt, int flush)
 {
     AVPacketList *pktl;
-    int stream_count = 0;
-    int i, ret;
+    int stream_count;
+    int ret;
 
     if (pkt) {
         if ((ret = ff_interleave_add_packet(s, pkt, interleave_compare_dts)) < 0)
             return ret;
     }
 
+    stream_count = s->internal->nb_buffered_streams;
+
     if (s->max_interleave_delta > 0 && s->internal->packet_buffer && !flush) {
-        AVPacket *top_pkt = &s->internal->packet_buffer->pkt;
-        int64_t delta_dts = INT64_MIN;
+        /* the queue is sorted by dts, so its last packet is the one with the
+         * largest dts among the last packets of all the streams */
+        AVPacket *top_pkt  = &s->internal->packet_buffer->pkt;
+        AVPacket *last_pkt = &s->internal->packet_buffer_end->pkt;
         int64_t top_dts = av_rescale_q(top_pkt->dts,
                                        s->streams[top_pkt->stream_index]->time_base,
                                        AV_TIME_BASE_Q);
-
-        for (i = 0; i < s->nb_streams; i++) {
-            int64_t last_dts;
-            const AVPacketList *last = s->streams[i]->last_in_packet_buffer;
-
-            if (!last)
-                continue;
-
-            last_dts = av_rescale_q(last->pkt.dts,
-                                    s->streams[i]->time_base,
-                                    AV_TIME_BASE_Q);
-            delta_dts = FFMAX(delta_dts, last_dts - top_dts);
-            stream_count++;
-        }
+        int64_t delta_dts = av_rescale_q(last_pkt->dts,
+                                         s->streams[last_pkt->stream_index]->time_base,
+                                         AV_TIME_BASE_Q) - top_dts;
 
         if (delta_dts > s->max_interleave_delta) {
             av_log(s, AV_LOG_DEBUG,
@@ -574,12 +569,8 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
                    delta_dts, s->max_interleave_delta);
             flush = 1;
         }
-    } else {
-        for (i = 0; i < s->nb_streams; i++)
-            stream_count += !!s->streams[i]->last_in_packet_buffer;
     }
 
-
     if (stream_count && (s->internal->nb_interleaved_streams == stream_count || flush)) {
         pktl = s->internal->packet_buffer;
         *out = pktl->pkt;
@@ -588,8 +579,10 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
         if (!s->internal->packet_buffer)
             s->internal->packet_buffer_end = NULL;
 
-        if (s->streams[out->stream_index]->last_in_packet_buffer == pktl)
+        if (s->streams[out->stream_index]->last_in_packet_buffer == pktl) {
             s->streams[out->stream_index]->last_in_packet_buffer = NULL;
+            s->internal->nb_buffered_streams--;
+        }
         av_freep(&pktl);
         return 1;
     } else {
@@ -1832,10 +1832,7 @@ static int mxf_write_footer(AVFormatContext *s)
 
 static int mxf_interleave_get_packet(AVFormatContext *s, AVPacket *out, AVPacket *pkt, int flush)
 {
-    int i, stream_count = 0;
-
-    for (i = 0; i < s->nb_streams; i++)
-        stream_count += !!s->streams[i]->last_in_packet_buffer;
+    int stream_count = s->internal->nb_buffered_streams;
 
     if (stream_count && (s->nb_streams == stream_count || flush)) {
         AVPacketList *pktl = s->internal->packet_buffer;
@@ -1853,8 +1850,10 @@ static int mxf_interleave_get_packet(AVFormatContext *s, AVPacket *out, AVPacket
             while (pktl) {
                 AVPacketList *next = pktl->next;
 
-                if(s->streams[pktl->pkt.stream_index]->last_in_packet_buffer == pktl)
+                if(s->streams[pktl->pkt.stream_index]->last_in_packet_buffer == pktl) {
                     s->streams[pktl->pkt.stream_index]->last_in_packet_buffer= NULL;
+                    s->internal->nb_buffered_streams--;
+                }
                 av_packet_unref(&pktl->pkt);
                 av_freep(&pktl);
                 pktl = next;
@@ -1872,8 +1871,10 @@ static int mxf_interleave_get_packet(AVFormatContext *s, AVPacket *out, AVPacket
         *out = pktl->pkt;
         av_log(s, AV_LOG_TRACE, "out st:%d dts:%"PRId64"\n", (*out).stream_index, (*out).dts);
         s->internal->packet_buffer = pktl->next;
-        if(s->streams[pktl->pkt.stream_index]->last_in_packet_buffer == pktl)
+        if(s->streams[pktl->pkt.stream_index]->last_in_packet_buffer == pktl) {
             s->streams[pktl->pkt.stream_index]->last_in_packet_buffer= NULL;
+            s->internal->nb_buffered_streams--;
+        }
         if(!s->internal->packet_buffer)
             s->internal->packet_buffer_end= NULL;
         av_freep(&pktl);
@@ -23,6 +23,8 @@
 
 #include "url.h"
 
+extern const URLProtocol ff_async_protocol;
+extern const URLProtocol ff_cache_protocol;
 extern const URLProtocol ff_concat_protocol;
 extern const URLProtocol ff_crypto_protocol;
 extern const URLProtocol ff_ffrtmpcrypt_protocol;
@@ -37,6 +37,16 @@ int ff_raw_read_partial_packet(AVFormatContext *s, AVPacket *pkt)
 
     size = RAW_PACKET_SIZE;
 
+    pkt->pos = avio_tell(s->pb);
+    ret = ffio_read_mapped(s->pb, size, &pkt->buf, &pkt->data);
+    if (ret >= 0) {
+        pkt->stream_index = 0;
+        pkt->size         = ret;
+        return ret;
+    }
+    if (ret != AVERROR(ENOSYS))
+        return ret;
+
     if (av_new_packet(pkt, size) < 0)
         return AVERROR(ENOMEM);
 
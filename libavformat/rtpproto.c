@@ -229,6 +229,8 @@ static void build_udp_url(RTPContext *s,
                           const char *exclude_sources)
 {
     ff_url_join(buf, buf_size, "udp", NULL, hostname, port, NULL);
+    /* the sockets are polled and read directly */
+    url_add_option(buf, buf_size, "fifo_size=0");
     if (local_port >= 0)
         url_add_option(buf, buf_size, "localport=%d", local_port);
     if (s->ttl >= 0)
@@ -0,0 +1,164 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "libavutil/lfg.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+
+#include "libavformat/avformat.h"
+#include "libavformat/avio.h"
+
+#define FILE_SIZE (1 << 20)
+#define MAX_READ  (1 << 16)
+
+static int write_failures;
+
+static void log_callback(void *avcl, int level, const char *fmt, va_list vl)
+{
+    if (!strcmp(fmt, "Failed to write to the cache file\n"))
+        write_failures++;
+}
+
+static int check_reads(AVIOContext *pb, const uint8_t *ref, AVLFG *lfg,
+                       int nb_reads)
+{
+    uint8_t *buf = av_malloc(MAX_READ);
+    int i, ret = 0;
+
+    if (!buf)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < nb_reads; i++) {
+        int64_t pos = av_lfg_get(lfg) % FILE_SIZE;
+        int size    = av_lfg_get(lfg) % MAX_READ + 1;
+        int len;
+
+        size = FFMIN(size, FILE_SIZE - pos);
+        if (avio_seek(pb, pos, SEEK_SET) != pos) {
+            printf("seek to %"PRId64" failed\n", pos);
+            ret = -1;
+            break;
+        }
+        len = avio_read(pb, buf, size);
+        if (len != size || memcmp(buf, ref + pos, size)) {
+            printf("read of %d bytes at %"PRId64" mismatched\n", size, pos);
+            ret = -1;
+            break;
+        }
+    }
+
+    av_free(buf);
+    return ret;
+}
+
+/* The cache file is the only unlinked regular file this process has open. */
+static int find_cache_fd(void)
+{
+    struct stat st;
+    int fd;
+
+    for (fd = 3; fd < 1024; fd++)
+        if (!fstat(fd, &st) && S_ISREG(st.st_mode) && !st.st_nlink)
+            return fd;
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "cache-test.data";
+    char url[1024], broken[1024];
+    AVIOContext *pb = NULL;
+    uint8_t *ref;
+    AVLFG lfg, replay;
+    FILE *f;
+    int64_t hits;
+    int i, fd, wronly, ret = 1;
+
+    av_log_set_callback(log_callback);
+    av_register_all();
+    av_lfg_init(&lfg, 0xcace);
+
+    ref = av_malloc(FILE_SIZE);
+    if (!ref)
+        return 1;
+    for (i = 0; i < FILE_SIZE; i++)
+        ref[i] = av_lfg_get(&lfg);
+
+    f = fopen(path, "wb");
+    if (!f || fwrite(ref, 1, FILE_SIZE, f) != FILE_SIZE) {
+        printf("cannot write %s\n", path);
+        goto end;
+    }
+    fclose(f);
+
+    snprintf(url, sizeof(url), "cache:file:%s", path);
+    if (avio_open2(&pb, url, AVIO_FLAG_READ, NULL, NULL) < 0) {
+        printf("cannot open %s\n", url);
+        goto end;
+    }
+
+    replay = lfg;
+    if (check_reads(pb, ref, &lfg, 200) < 0)
+        goto end;
+    printf("random reads: ok\n");
+
+    if (av_opt_get_int(pb, "cache_hit", AV_OPT_SEARCH_CHILDREN, &hits) < 0 ||
+        !hits) {
+        printf("no read was served from the cache\n");
+        goto end;
+    }
+    printf("cache hits: yes\n");
+
+    /* Make the cache file unreadable, but still writable, and repeat the
+     * same reads: the cached ranges must be fetched again from the nested
+     * resource without being added to the cache a second time. */
+    fd = find_cache_fd();
+    snprintf(broken, sizeof(broken), "%s.wronly", path);
+    wronly = open(broken, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0 || wronly < 0 || dup2(wronly, fd) < 0) {
+        printf("cannot replace the cache file\n");
+        goto end;
+    }
+    close(wronly);
+    unlink(broken);
+
+    if (check_reads(pb, ref, &replay, 200) < 0)
+        goto end;
+    printf("reads with a broken cache: ok\n");
+    printf("cache write failures: %d\n", write_failures);
+
+    ret = write_failures != 0;
+end:
+    avio_closep(&pb);
+    unlink(path);
+    av_free(ref);
+    return ret;
+}
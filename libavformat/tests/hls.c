@@ -0,0 +1,210 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Splits a transport stream into the segments of a HLS playlist and checks
+ * that the demuxer returns the same packets with and without segment
+ * prefetching, with a custom io_open callback and with a discarded variant.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/crc.h"
+#include "libavutil/dict.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+
+#include "libavformat/avformat.h"
+
+#define NB_SEGMENTS 5
+#define TS_PACKET_SIZE 188
+
+static int nb_opens;
+
+static int counting_io_open(AVFormatContext *s, AVIOContext **pb,
+                            const char *url, int flags, AVDictionary **opts)
+{
+    nb_opens++;
+    return avio_open2(pb, url, flags, &s->interrupt_callback, opts);
+}
+
+static int write_file(const char *filename, const void *buf, size_t size)
+{
+    FILE *f = fopen(filename, "wb");
+    int ret = 0;
+
+    if (!f || fwrite(buf, 1, size, f) != size)
+        ret = -1;
+    if (f && fclose(f))
+        ret = -1;
+    if (ret < 0)
+        printf("cannot write %s\n", filename);
+    return ret;
+}
+
+static int write_playlists(const char *prefix, const uint8_t *data, int size)
+{
+    const char *name = strrchr(prefix, '/') ? strrchr(prefix, '/') + 1 : prefix;
+    int nb_packets = size / TS_PACKET_SIZE, pos = 0, i;
+    char filename[1024], playlist[4096];
+    int len;
+
+    len = snprintf(playlist, sizeof(playlist),
+                   "#EXTM3U\n#EXT-X-TARGETDURATION:1\n#EXT-X-MEDIA-SEQUENCE:0\n");
+    for (i = 0; i < NB_SEGMENTS; i++) {
+        int end = (int64_t)nb_packets * (i + 1) / NB_SEGMENTS * TS_PACKET_SIZE;
+
+        if (i == NB_SEGMENTS - 1)
+            end = size;
+        snprintf(filename, sizeof(filename), "%s-%d.ts", prefix, i);
+        if (write_file(filename, data + pos, end - pos) < 0)
+            return -1;
+        len += snprintf(playlist + len, sizeof(playlist) - len,
+                        "#EXTINF:1,\n%s-%d.ts\n", name, i);
+        pos = end;
+    }
+    len += snprintf(playlist + len, sizeof(playlist) - len,
+                    "#EXT-X-ENDLIST\n");
+    snprintf(filename, sizeof(filename), "%s.m3u8", prefix);
+    if (write_file(filename, playlist, len) < 0)
+        return -1;
+
+    len = snprintf(playlist, sizeof(playlist),
+                   "#EXTM3U\n"
+                   "#EXT-X-STREAM-INF:BANDWIDTH=200000\n%s.m3u8\n"
+                   "#EXT-X-STREAM-INF:BANDWIDTH=100000\n%s.m3u8\n",
+                   name, name);
+    snprintf(filename, sizeof(filename), "%s-master.m3u8", prefix);
+    return write_file(filename, playlist, len);
+}
+
+/* Checksum all the packets returned by the demuxer. */
+static int demux(const char *url, const char *prefetch, int custom_io,
+                 int discard_variant, int *nb_packets, uint32_t *crc)
+{
+    const AVCRC *table = av_crc_get_table(AV_CRC_32_IEEE_LE);
+    AVFormatContext *ctx = avformat_alloc_context();
+    AVDictionary *opts = NULL;
+    AVPacket pkt;
+    uint8_t buf[20];
+    int i, ret;
+
+    if (!ctx)
+        return AVERROR(ENOMEM);
+    if (custom_io)
+        ctx->io_open = counting_io_open;
+    av_dict_set(&opts, "prefetch_segments", prefetch, 0);
+    ret = avformat_open_input(&ctx, url, NULL, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        printf("cannot open %s\n", url);
+        return ret;
+    }
+
+    for (i = 0; i < ctx->nb_streams; i++)
+        if (ctx->streams[i]->id == discard_variant)
+            ctx->streams[i]->discard = AVDISCARD_ALL;
+
+    *nb_packets = 0;
+    *crc        = 0;
+    while ((ret = av_read_frame(ctx, &pkt)) >= 0) {
+        AV_WL32(buf,      pkt.stream_index);
+        AV_WL64(buf +  4, pkt.pts);
+        AV_WL64(buf + 12, pkt.dts);
+        *crc = av_crc(table, *crc, buf, sizeof(buf));
+        *crc = av_crc(table, *crc, pkt.data, pkt.size);
+        (*nb_packets)++;
+        av_packet_unref(&pkt);
+    }
+
+    avformat_close_input(&ctx);
+    return ret == AVERROR_EOF ? 0 : ret;
+}
+
+int main(int argc, char **argv)
+{
+    char url[1024], master[1024];
+    uint8_t *data = NULL;
+    uint32_t crc, ref_crc;
+    int nb_packets, ref_nb_packets, size, ret = 1;
+    FILE *f;
+
+    if (argc < 3) {
+        printf("usage: %s <input.ts> <output prefix>\n", argv[0]);
+        return 1;
+    }
+
+    av_register_all();
+
+    f = fopen(argv[1], "rb");
+    if (!f) {
+        printf("cannot open %s\n", argv[1]);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = av_malloc(size);
+    if (!data || fread(data, 1, size, f) != size) {
+        printf("cannot read %s\n", argv[1]);
+        fclose(f);
+        goto end;
+    }
+    fclose(f);
+
+    if (write_playlists(argv[2], data, size) < 0)
+        goto end;
+    snprintf(url,    sizeof(url),    "%s.m3u8",        argv[2]);
+    snprintf(master, sizeof(master), "%s-master.m3u8", argv[2]);
+
+    if (demux(url, "0", 0, -1, &ref_nb_packets, &ref_crc) < 0)
+        goto end;
+    printf("playlist: %d packets, crc 0x%08x\n", ref_nb_packets, ref_crc);
+
+    if (demux(url, "2", 0, -1, &nb_packets, &crc) < 0)
+        goto end;
+    printf("prefetch: %s\n", nb_packets == ref_nb_packets && crc == ref_crc ?
+                             "same packets" : "mismatch");
+    if (nb_packets != ref_nb_packets || crc != ref_crc)
+        goto end;
+
+    /* the playlist and every segment must go through the callback */
+    if (demux(url, "2", 1, -1, &nb_packets, &crc) < 0)
+        goto end;
+    printf("prefetch with io_open: %s, %d opens\n",
+           nb_packets == ref_nb_packets && crc == ref_crc ?
+           "same packets" : "mismatch", nb_opens);
+    if (nb_packets != ref_nb_packets || crc != ref_crc ||
+        nb_opens != NB_SEGMENTS + 1)
+        goto end;
+
+    if (demux(master, "2", 0, 1, &nb_packets, &crc) < 0)
+        goto end;
+    printf("prefetch with a discarded variant: %s\n",
+           nb_packets == ref_nb_packets && crc == ref_crc ?
+           "same packets" : "mismatch");
+    if (nb_packets != ref_nb_packets || crc != ref_crc)
+        goto end;
+
+    ret = 0;
+end:
+    av_free(data);
+    return ret;
+}
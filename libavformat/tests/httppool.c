@@ -0,0 +1,261 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Reads a resource from a local HTTP/1.1 keep-alive server in the ways the
+ * http protocol can reuse its connections, and checks that all of them went
+ * through a single connection.
+ */
+
+#include "config.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/dict.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+
+#include "libavformat/avformat.h"
+#include "libavformat/avio.h"
+#include "libavformat/network.h"
+
+#define FILE_SIZE   300000
+#define MAX_CLIENTS 8
+
+typedef struct Client {
+    int fd;
+    char buf[4096];
+    int len;
+} Client;
+
+static uint8_t *file;
+static int listen_fd;
+static int nb_connections;
+static int quit;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int send_all(int fd, const void *buf, int size)
+{
+    const uint8_t *p = buf;
+
+    while (size > 0) {
+        int ret = send(fd, p, size, 0);
+        if (ret <= 0)
+            return -1;
+        p    += ret;
+        size -= ret;
+    }
+    return 0;
+}
+
+/* Answer the complete requests in the client buffer. */
+static int serve_requests(Client *c)
+{
+    char *end, *range, header[256];
+    int64_t start, last;
+
+    while ((end = strstr(c->buf, "\r\n\r\n"))) {
+        *end  = 0;
+        start = 0;
+        last  = FILE_SIZE - 1;
+        if ((range = av_stristr(c->buf, "\r\nRange: bytes="))) {
+            start = strtoll(range + 15, &range, 10);
+            if (*range == '-' && range[1] >= '0' && range[1] <= '9')
+                last = FFMIN(strtoll(range + 1, NULL, 10), FILE_SIZE - 1);
+        }
+        if (start >= FILE_SIZE)
+            return -1;
+
+        if (av_stristr(c->buf, "\r\nRange: "))
+            snprintf(header, sizeof(header),
+                     "HTTP/1.1 206 Partial Content\r\n"
+                     "Content-Range: bytes %"PRId64"-%"PRId64"/%d\r\n",
+                     start, last, FILE_SIZE);
+        else
+            snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\n");
+        av_strlcatf(header, sizeof(header),
+                    "Accept-Ranges: bytes\r\n"
+                    "Content-Length: %"PRId64"\r\n"
+                    "Connection: keep-alive\r\n\r\n", last - start + 1);
+        if (send_all(c->fd, header, strlen(header)) < 0 ||
+            send_all(c->fd, file + start, last - start + 1) < 0)
+            return -1;
+
+        end    += 4;
+        c->len -= end - c->buf;
+        memmove(c->buf, end, c->len + 1);
+    }
+    return 0;
+}
+
+static void *server_thread(void *arg)
+{
+    Client clients[MAX_CLIENTS];
+    struct pollfd pfd[MAX_CLIENTS + 1];
+    int i, n, nb_clients = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&mutex);
+        n = quit;
+        pthread_mutex_unlock(&mutex);
+        if (n)
+            break;
+
+        pfd[0].fd     = listen_fd;
+        pfd[0].events = POLLIN;
+        for (i = 0; i < nb_clients; i++) {
+            pfd[i + 1].fd     = clients[i].fd;
+            pfd[i + 1].events = POLLIN;
+        }
+        if (poll(pfd, nb_clients + 1, 100) <= 0)
+            continue;
+
+        for (i = nb_clients - 1; i >= 0; i--) {
+            Client *c = &clients[i];
+
+            if (!pfd[i + 1].revents)
+                continue;
+            n = recv(c->fd, c->buf + c->len, sizeof(c->buf) - 1 - c->len, 0);
+            if (n > 0) {
+                c->len        += n;
+                c->buf[c->len] = 0;
+            }
+            if (n <= 0 || serve_requests(c) < 0) {
+                closesocket(c->fd);
+                *c = clients[--nb_clients];
+            }
+        }
+
+        if (pfd[0].revents && nb_clients < MAX_CLIENTS) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd >= 0) {
+                clients[nb_clients].fd     = fd;
+                clients[nb_clients].len    = 0;
+                clients[nb_clients].buf[0] = 0;
+                nb_clients++;
+                pthread_mutex_lock(&mutex);
+                nb_connections++;
+                pthread_mutex_unlock(&mutex);
+            }
+        }
+    }
+
+    for (i = 0; i < nb_clients; i++)
+        closesocket(clients[i].fd);
+    return NULL;
+}
+
+static int check_read(AVIOContext *pb)
+{
+    uint8_t buf[4096];
+    int pos = 0;
+
+    while (pos < FILE_SIZE) {
+        int len = avio_read(pb, buf, FFMIN(FILE_SIZE - pos, sizeof(buf)));
+        if (len <= 0 || memcmp(buf, file + pos, len))
+            return -1;
+        pos += len;
+    }
+    return 0;
+}
+
+static int test(const char *url, const char *name, const char *opts)
+{
+    AVIOContext *pb = NULL;
+    AVDictionary *options = NULL;
+    int ret;
+
+    av_dict_parse_string(&options, opts, "=", ":", 0);
+    ret = avio_open2(&pb, url, AVIO_FLAG_READ, NULL, &options);
+    av_dict_free(&options);
+    if (ret < 0) {
+        printf("%s: cannot open %s\n", name, url);
+        return ret;
+    }
+
+    ret = check_read(pb);
+    avio_closep(&pb);
+
+    printf("%s: %s\n", name, ret < 0 ? "mismatch" : "ok");
+    return ret;
+}
+
+int main(void)
+{
+    struct sockaddr_in addr = { 0 };
+    socklen_t addrlen = sizeof(addr);
+    pthread_t thread;
+    char url[100];
+    AVLFG lfg;
+    int i, ret = 0;
+
+    av_register_all();
+    avformat_network_init();
+    av_lfg_init(&lfg, 0x7e57);
+
+    file = av_malloc(FILE_SIZE);
+    if (!file)
+        return 1;
+    for (i = 0; i < FILE_SIZE; i++)
+        file[i] = av_lfg_get(&lfg);
+
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0 ||
+        bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+        listen(listen_fd, MAX_CLIENTS) ||
+        getsockname(listen_fd, (struct sockaddr *)&addr, &addrlen)) {
+        printf("cannot listen on the loopback interface\n");
+        return 1;
+    }
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/file",
+             ntohs(addr.sin_port));
+    if (pthread_create(&thread, NULL, server_thread, NULL)) {
+        closesocket(listen_fd);
+        return 1;
+    }
+
+    for (i = 0; i < 3 && !ret; i++)
+        ret = test(url, "sequential read", "reuse_connections=1");
+    if (!ret)
+        ret = test(url, "range requests",
+                   "reuse_connections=1:request_size=65536");
+    if (!ret)
+        ret = test(url, "pipelined range requests",
+                   "reuse_connections=1:request_size=65536:pipeline=1");
+
+    /* drops the idle connections */
+    avformat_network_deinit();
+
+    pthread_mutex_lock(&mutex);
+    quit = 1;
+    pthread_mutex_unlock(&mutex);
+    pthread_join(thread, NULL);
+    closesocket(listen_fd);
+
+    printf("connections: %d\n", nb_connections);
+
+    av_free(file);
+    return ret < 0 || nb_connections != 1;
+}
@@ -77,6 +77,11 @@ int num_warnings;
 
 int check_faults;
 
+int seekable;
+uint8_t *mem_buf;
+int mem_size, mem_alloc;
+int64_t mem_pos;
+
 
 static void count_warnings(void *avcl, int level, const char *fmt, va_list vl)
 {
@@ -90,6 +95,12 @@ static void init_count_warnings(void)
     num_warnings = 0;
 }
 
+static void print_moved(void *avcl, int level, const char *fmt, va_list vl)
+{
+    if (!strncmp(fmt, "Moved ", 6))
+        vprintf(fmt, vl);
+}
+
 static void reset_count_warnings(void)
 {
     av_log_set_callback(av_log_default_callback);
@@ -133,6 +144,92 @@ static int io_write_data_type(void *opaque, uint8_t *buf, int size,
     return io_write(opaque, buf, size);
 }
 
+/* Seekable output into mem_buf, with the position pointed to by opaque,
+ * for the files that are not written in a single pass. */
+static int mem_write(void *opaque, uint8_t *buf, int size)
+{
+    int64_t *pos = opaque;
+    if (*pos + size > mem_alloc) {
+        int alloc = FFMAX(*pos + size, 2 * mem_alloc);
+        if (av_reallocp(&mem_buf, alloc) < 0)
+            return AVERROR(ENOMEM);
+        mem_alloc = alloc;
+    }
+    memcpy(mem_buf + *pos, buf, size);
+    *pos += size;
+    mem_size = FFMAX(mem_size, *pos);
+    return size;
+}
+
+static int mem_read(void *opaque, uint8_t *buf, int size)
+{
+    int64_t *pos = opaque;
+    size = FFMIN(size, mem_size - *pos);
+    if (size <= 0)
+        return AVERROR_EOF;
+    memcpy(buf, mem_buf + *pos, size);
+    *pos += size;
+    return size;
+}
+
+static int64_t mem_seek(void *opaque, int64_t offset, int whence)
+{
+    int64_t *pos = opaque;
+    switch (whence) {
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        offset += *pos;
+        break;
+    case SEEK_END:
+        offset += mem_size;
+        break;
+    case AVSEEK_SIZE:
+        return mem_size;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (offset < 0 || offset > mem_size)
+        return AVERROR(EINVAL);
+    *pos = offset;
+    return offset;
+}
+
+static AVIOContext *mem_open_read(void)
+{
+    int64_t *pos = av_mallocz(sizeof(*pos));
+    uint8_t *buf = av_malloc(4096);
+    AVIOContext *pb = NULL;
+    if (pos && buf)
+        pb = avio_alloc_context(buf, 4096, 0, pos, mem_read, NULL, mem_seek);
+    if (!pb) {
+        av_free(pos);
+        av_free(buf);
+    }
+    return pb;
+}
+
+static void mem_close_read(AVIOContext **pb)
+{
+    av_freep(&(*pb)->opaque);
+    av_freep(&(*pb)->buffer);
+    avio_context_free(pb);
+}
+
+static int io_open(AVFormatContext *s, AVIOContext **pb, const char *url,
+                   int flags, AVDictionary **options)
+{
+    if (flags != AVIO_FLAG_READ)
+        return AVERROR(EINVAL);
+    *pb = mem_open_read();
+    return *pb ? 0 : AVERROR(ENOMEM);
+}
+
+static void io_close(AVFormatContext *s, AVIOContext *pb)
+{
+    mem_close_read(&pb);
+}
+
 static void init_out(const char *name)
 {
     char buf[100];
@@ -146,11 +243,19 @@ static void init_out(const char *name)
             perror(buf);
     }
     out_size = 0;
+    mem_size = 0;
+    mem_pos  = 0;
 }
 
 static void close_out(void)
 {
     int i;
+    if (seekable) {
+        av_md5_update(md5, mem_buf, mem_size);
+        out_size = mem_size;
+        if (out)
+            fwrite(mem_buf, 1, mem_size, out);
+    }
     av_md5_final(md5, hash);
     for (i = 0; i < HASH_SIZE; i++)
         printf("%02x", hash[i]);
@@ -184,10 +289,17 @@ static void init_fps(int bf, int audio_preroll, int fps)
     ctx->oformat = av_guess_format(format, NULL, NULL);
     if (!ctx->oformat)
         exit(1);
-    ctx->pb = avio_alloc_context(iobuf, iobuf_size, AVIO_FLAG_WRITE, NULL, NULL, io_write, NULL);
+    if (seekable) {
+        ctx->pb = avio_alloc_context(iobuf, iobuf_size, AVIO_FLAG_WRITE, &mem_pos, NULL, mem_write, mem_seek);
+        ctx->io_open  = io_open;
+        ctx->io_close = io_close;
+    } else {
+        ctx->pb = avio_alloc_context(iobuf, iobuf_size, AVIO_FLAG_WRITE, NULL, NULL, io_write, NULL);
+    }
     if (!ctx->pb)
         exit(1);
-    ctx->pb->write_data_type = io_write_data_type;
+    if (!seekable)
+        ctx->pb->write_data_type = io_write_data_type;
     ctx->flags |= AVFMT_FLAG_BITEXACT;
 
     st = avformat_new_stream(ctx, NULL);
@@ -343,6 +455,51 @@ static void finish(void)
     ctx = NULL;
 }
 
+/* Print the top level atoms of the file written in mem_buf. */
+static void print_atoms(void)
+{
+    int64_t pos = 0;
+    printf("%s:", cur_name);
+    while (pos + 8 <= mem_size) {
+        uint32_t size = AV_RB32(mem_buf + pos);
+        printf(" %.4s", (const char *)mem_buf + pos + 4);
+        if (size < 8)
+            break;
+        pos += size;
+    }
+    printf("\n");
+}
+
+/* Hash the packets demuxed from the file written in mem_buf. */
+static void hash_packets(uint8_t *packets_hash)
+{
+    AVFormatContext *ic = avformat_alloc_context();
+    AVIOContext *pb = mem_open_read();
+    AVPacket pkt;
+    uint8_t buf[20];
+
+    if (!ic || !pb)
+        exit(1);
+    ic->pb = pb;
+    if (avformat_open_input(&ic, "", NULL, NULL) < 0) {
+        check(0, "Unable to demux %s", cur_name);
+        mem_close_read(&pb);
+        return;
+    }
+    av_md5_init(md5);
+    while (av_read_frame(ic, &pkt) >= 0) {
+        AV_WB32(buf,      pkt.stream_index);
+        AV_WB64(buf +  4, pkt.pts);
+        AV_WB64(buf + 12, pkt.dts);
+        av_md5_update(md5, buf, sizeof(buf));
+        av_md5_update(md5, pkt.data, pkt.size);
+        av_packet_unref(&pkt);
+    }
+    av_md5_final(md5, packets_hash);
+    avformat_close_input(&ic);
+    mem_close_read(&pb);
+}
+
 static void help(void)
 {
     printf("movenc-test [-w]\n"
@@ -761,7 +918,53 @@ int main(int argc, char **argv)
     finish();
     close_out();
 
+    // Write a non-fragmented file with space reserved for the moov atom
+    // before the mdat. The moov atom fits and is written there, followed
+    // by a free atom covering the rest of the reserved space.
+    format = "mp4";
+    seekable = 1;
+    init_out("moov-size");
+    av_dict_set(&opts, "moov_size", "4096", 0);
+    init(1, 1);
+    mux_gops(2);
+    finish();
+    close_out();
+    print_atoms();
+    hash_packets(header);
+
+    // Reserve too little space, without faststart: the moov atom is written
+    // at the end and the reserved space is kept as a free atom.
+    init_count_warnings();
+    init_out("moov-size-too-small");
+    av_dict_set(&opts, "moov_size", "100", 0);
+    init(1, 1);
+    mux_gops(2);
+    finish();
+    reset_count_warnings();
+    close_out();
+    print_atoms();
+    check(num_warnings > 0, "No warning printed for a too small moov_size");
+    hash_packets(content);
+    check(!memcmp(header, content, HASH_SIZE), "Packets differ from the reserved moov case");
+
+    // Reserve too little space, with faststart: the data is moved by the
+    // part of the moov atom that does not fit in the reserved space.
+    av_log_set_callback(print_moved);
+    init_out("moov-size-too-small-faststart");
+    av_dict_set(&opts, "moov_size", "100", 0);
+    av_dict_set(&opts, "movflags", "faststart", 0);
+    init(1, 1);
+    mux_gops(2);
+    finish();
+    reset_count_warnings();
+    close_out();
+    print_atoms();
+    hash_packets(content);
+    check(!memcmp(header, content, HASH_SIZE), "Packets differ from the reserved moov case");
+    seekable = 0;
+
     av_free(md5);
+    av_freep(&mem_buf);
 
     return check_faults > 0 ? 1 : 0;
 }
@@ -0,0 +1,205 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Sends datagrams over the loopback interface to the udp protocol and
+ * checks what comes out of its circular receive buffer, when it is large
+ * enough and when it overruns.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+
+#include "libavformat/avformat.h"
+#include "libavformat/network.h"
+#include "libavformat/url.h"
+
+#define MAX_SIZE 1400
+
+static const URLProtocol **protocols;
+static int send_fd;
+
+/* The datagram n is made of (n * 37) % MAX_SIZE + 4 bytes of a pattern
+ * starting with n. */
+static int datagram_size(int n)
+{
+    return n * 37 % MAX_SIZE + 4;
+}
+
+static void fill_datagram(uint8_t *buf, int n)
+{
+    int i, size = datagram_size(n);
+
+    AV_WB32(buf, n);
+    for (i = 4; i < size; i++)
+        buf[i] = n + i;
+}
+
+/* Send the datagrams first to first + nb - 1 to port, a few at a time so
+ * that the receive thread can read them in batches. */
+static int send_datagrams(int port, int first, int nb)
+{
+    struct sockaddr_in addr = { 0 };
+    uint8_t buf[MAX_SIZE + 4];
+    int i;
+
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = htons(port);
+    for (i = first; i < first + nb; i++) {
+        fill_datagram(buf, i);
+        if (sendto(send_fd, buf, datagram_size(i), 0,
+                   (struct sockaddr *)&addr, sizeof(addr)) != datagram_size(i))
+            return -1;
+        if (i % 8 == 7)
+            av_usleep(2000);
+    }
+    return 0;
+}
+
+static URLContext *open_receiver(const char *opts, int flags, int *port)
+{
+    URLContext *h = NULL;
+    char url[100];
+
+    snprintf(url, sizeof(url), "udp://:0?buffer_size=425984&%s", opts);
+    if (ffurl_open(&h, url, AVIO_FLAG_READ | flags, NULL, NULL,
+                   protocols, NULL) < 0) {
+        printf("cannot open %s\n", url);
+        return NULL;
+    }
+    *port = ff_udp_get_local_port(h);
+    return h;
+}
+
+/* Read a datagram and return its number, -1 if it is corrupted or the
+ * error code of the read. */
+static int read_datagram(URLContext *h)
+{
+    uint8_t buf[MAX_SIZE + 4], ref[MAX_SIZE + 4];
+    int n, len = ffurl_read(h, buf, sizeof(buf));
+
+    if (len < 4)
+        return len < 0 ? len : -1;
+    n = AV_RB32(buf);
+    fill_datagram(ref, n);
+    if (n < 0 || len != datagram_size(n) || memcmp(buf, ref, len))
+        return -1;
+    return n;
+}
+
+/* Everything sent must be received in order. */
+static int test_fifo(void)
+{
+    URLContext *h;
+    int i, port, ret = 0;
+
+    if (!(h = open_receiver("fifo_size=1024", 0, &port)))
+        return -1;
+    if (send_datagrams(port, 0, 200) < 0)
+        ret = -1;
+    for (i = 0; i < 200 && !ret; i++)
+        if (read_datagram(h) != i)
+            ret = -1;
+    ffurl_close(h);
+
+    printf("fifo: %s\n", ret ? "mismatch" : "200 datagrams received");
+    return ret;
+}
+
+/* Only the datagram that fits in the buffer must be returned, the rest is
+ * dropped while nothing is read. */
+static int test_overrun_nonfatal(void)
+{
+    URLContext *h;
+    int port, ret = 0;
+
+    if (!(h = open_receiver("fifo_size=6&overrun_nonfatal=1",
+                            AVIO_FLAG_NONBLOCK, &port)))
+        return -1;
+    if (send_datagrams(port, 30, 40) < 0)
+        ret = -1;
+    av_usleep(200000);
+    if (!ret && read_datagram(h) != 30)
+        ret = -1;
+    if (!ret && read_datagram(h) != AVERROR(EAGAIN))
+        ret = -1;
+
+    /* the buffer keeps receiving once there is room again */
+    if (!ret && send_datagrams(port, 100, 1) < 0)
+        ret = -1;
+    av_usleep(200000);
+    if (!ret && read_datagram(h) != 100)
+        ret = -1;
+    ffurl_close(h);
+
+    printf("overrun_nonfatal: %s\n", ret ? "mismatch" : "datagrams dropped");
+    return ret;
+}
+
+/* The reads must fail once the buffered datagrams are consumed. */
+static int test_overrun(void)
+{
+    URLContext *h;
+    int port, ret = 0;
+
+    if (!(h = open_receiver("fifo_size=6", 0, &port)))
+        return -1;
+    if (send_datagrams(port, 30, 3) < 0)
+        ret = -1;
+    av_usleep(200000);
+    if (!ret && read_datagram(h) != 30)
+        ret = -1;
+    if (!ret && read_datagram(h) != AVERROR(EIO))
+        ret = -1;
+    ffurl_close(h);
+
+    printf("overrun: %s\n", ret ? "mismatch" : "read error");
+    return ret;
+}
+
+int main(void)
+{
+    int ret;
+
+    av_log_set_level(AV_LOG_QUIET);
+    av_register_all();
+    avformat_network_init();
+
+    protocols = ffurl_get_protocols(NULL, NULL);
+    send_fd   = socket(AF_INET, SOCK_DGRAM, 0);
+    if (!protocols || send_fd < 0) {
+        printf("cannot create a socket\n");
+        return 1;
+    }
+
+    ret = test_fifo();
+    if (!ret)
+        ret = test_overrun_nonfatal();
+    if (!ret)
+        ret = test_overrun();
+
+    closesocket(send_fd);
+    av_freep(&protocols);
+    avformat_network_deinit();
+    return !!ret;
+}
@@ -26,9 +26,11 @@
 
 #define _DEFAULT_SOURCE
 #define _BSD_SOURCE     /* Needed for using struct ip_mreq with recent glibc */
+#define _GNU_SOURCE     /* Needed for recvmmsg() */
 
 #include "avformat.h"
 #include "avio_internal.h"
+#include "libavutil/fifo.h"
 #include "libavutil/parseutils.h"
 #include "libavutil/avstring.h"
 #include "libavutil/opt.h"
@@ -37,6 +39,12 @@
 #include "os_support.h"
 #include "url.h"
 
+#if HAVE_PTHREADS
+#include <pthread.h>
+#elif HAVE_W32THREADS
+#include "compat/w32pthreads.h"
+#endif
+
 #ifndef IPV6_ADD_MEMBERSHIP
 #define IPV6_ADD_MEMBERSHIP IPV6_JOIN_GROUP
 #define IPV6_DROP_MEMBERSHIP IPV6_LEAVE_GROUP
@@ -57,11 +65,33 @@ typedef struct UDPContext {
     char *localaddr;
     char *sources;
     char *block;
+
+    int fifo_size;
+    int overrun_nonfatal;
+    int overruns;
+#if HAVE_THREADS
+    /* circular receive buffer, filled by the receive thread with
+     * the length of each datagram followed by its payload */
+    AVFifoBuffer *fifo;
+    uint8_t *recv_buf;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int thread_started;
+    int close_req;
+    int fifo_error;
+#endif
 } UDPContext;
 
 #define UDP_TX_BUF_SIZE 32768
 #define UDP_MAX_PKT_SIZE 65536
 
+#if HAVE_RECVMMSG
+#define UDP_RECV_BATCH 8
+#else
+#define UDP_RECV_BATCH 1
+#endif
+
 #define OFFSET(x) offsetof(UDPContext, x)
 #define D AV_OPT_FLAG_DECODING_PARAM
 #define E AV_OPT_FLAG_ENCODING_PARAM
@@ -75,6 +105,9 @@ static const AVOption options[] = {
     { "localaddr",      "Local address",                                   OFFSET(localaddr),      AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
     { "sources",        "Source list",                                     OFFSET(sources),        AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
     { "block",          "Block list",                                      OFFSET(block),          AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
+    { "fifo_size",      "Receive circular buffer size (in 188 byte units, 0 to disable)", OFFSET(fifo_size), AV_OPT_TYPE_INT, { .i64 = 7 * 4096 }, 0, INT_MAX / 188, .flags = D },
+    { "overrun_nonfatal", "Drop packets instead of failing on receive buffer overrun", OFFSET(overrun_nonfatal), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, .flags = D },
+    { "overruns",       "Number of packets dropped on receive buffer overrun", OFFSET(overruns),      AV_OPT_TYPE_INT,    { .i64 = 0 },      0, INT_MAX, .flags = D | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     { NULL }
 };
 
@@ -437,6 +470,95 @@ static int parse_source_list(char *buf, char **sources, int *num_sources,
     return 0;
 }
 
+#if HAVE_THREADS
+/**
+ * Receive up to UDP_RECV_BATCH pending datagrams into recv_buf.
+ * @return the number of datagrams received or a negative error code
+ */
+static int udp_recv_batch(UDPContext *s, int *lens)
+{
+#if HAVE_RECVMMSG
+    struct mmsghdr msgs[UDP_RECV_BATCH] = { { { 0 } } };
+    struct iovec iov[UDP_RECV_BATCH];
+    int i, n;
+
+    for (i = 0; i < UDP_RECV_BATCH; i++) {
+        iov[i].iov_base           = s->recv_buf + i * UDP_MAX_PKT_SIZE;
+        iov[i].iov_len            = UDP_MAX_PKT_SIZE;
+        msgs[i].msg_hdr.msg_iov    = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    n = recvmmsg(s->udp_fd, msgs, UDP_RECV_BATCH, 0, NULL);
+    if (n < 0)
+        return ff_neterrno();
+    for (i = 0; i < n; i++)
+        lens[i] = msgs[i].msg_len;
+    return n;
+#else
+    int ret = recv(s->udp_fd, s->recv_buf, UDP_MAX_PKT_SIZE, 0);
+    if (ret < 0)
+        return ff_neterrno();
+    lens[0] = ret;
+    return 1;
+#endif
+}
+
+static void *circular_buffer_task(void *arg)
+{
+    URLContext *h = arg;
+    UDPContext *s = h->priv_data;
+    int lens[UDP_RECV_BATCH];
+    int i, n, dropped;
+
+    pthread_mutex_lock(&s->mutex);
+    while (!s->close_req) {
+        pthread_mutex_unlock(&s->mutex);
+        n = ff_network_wait_fd(s->udp_fd, 0);
+        if (n >= 0)
+            n = udp_recv_batch(s, lens);
+        pthread_mutex_lock(&s->mutex);
+
+        if (n < 0) {
+            if (n != AVERROR(EAGAIN) && n != AVERROR(EINTR)) {
+                s->fifo_error = n;
+                break;
+            }
+            /* wake up a blocked reader so that it can check for interrupts */
+            pthread_cond_signal(&s->cond);
+            continue;
+        }
+
+        dropped = 0;
+        for (i = 0; i < n; i++) {
+            if (av_fifo_space(s->fifo) < lens[i] + (int)sizeof(lens[i])) {
+                if (!s->overrun_nonfatal) {
+                    av_log(h, AV_LOG_ERROR, "Receive buffer overrun. Increase "
+                           "fifo_size or set overrun_nonfatal to drop packets "
+                           "instead.\n");
+                    s->fifo_error = AVERROR(EIO);
+                    goto end;
+                }
+                dropped++;
+                continue;
+            }
+            av_fifo_generic_write(s->fifo, &lens[i], sizeof(lens[i]), NULL);
+            av_fifo_generic_write(s->fifo, s->recv_buf + i * UDP_MAX_PKT_SIZE,
+                                  lens[i], NULL);
+        }
+        if (dropped) {
+            av_log(h, s->overruns ? AV_LOG_DEBUG : AV_LOG_WARNING,
+                   "Receive buffer overrun, %d packets dropped\n", dropped);
+            s->overruns += dropped;
+        }
+        pthread_cond_signal(&s->cond);
+    }
+end:
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+    return NULL;
+}
+#endif
+
 /* put it in UDP context */
 /* return non zero if error */
 static int udp_open(URLContext *h, const char *uri, int flags)
@@ -513,6 +635,12 @@ static int udp_open(URLContext *h, const char *uri, int flags)
                                   FF_ARRAY_ELEMS(exclude_sources)))
                 goto fail;
         }
+        if (av_find_info_tag(buf, sizeof(buf), "fifo_size", p)) {
+            s->fifo_size = strtol(buf, NULL, 10);
+        }
+        if (av_find_info_tag(buf, sizeof(buf), "overrun_nonfatal", p)) {
+            s->overrun_nonfatal = strtol(buf, NULL, 10);
+        }
     }
 
     /* fill the dest addr */
@@ -630,7 +758,33 @@ static int udp_open(URLContext *h, const char *uri, int flags)
         av_freep(&exclude_sources[i]);
 
     s->udp_fd = udp_fd;
+
+#if HAVE_THREADS
+    if (!is_output && s->fifo_size > 0) {
+        s->fifo     = av_fifo_alloc(FFMIN(s->fifo_size, INT_MAX / 188) * 188);
+        s->recv_buf = av_malloc(UDP_RECV_BATCH * UDP_MAX_PKT_SIZE);
+        if (!s->fifo || !s->recv_buf)
+            goto thread_fail;
+
+        pthread_mutex_init(&s->mutex, NULL);
+        pthread_cond_init(&s->cond, NULL);
+        if (pthread_create(&s->thread, NULL, circular_buffer_task, h)) {
+            av_log(h, AV_LOG_ERROR, "pthread_create failed\n");
+            pthread_cond_destroy(&s->cond);
+            pthread_mutex_destroy(&s->mutex);
+            goto thread_fail;
+        }
+        s->thread_started = 1;
+    }
+#endif
+
     return 0;
+#if HAVE_THREADS
+ thread_fail:
+    av_fifo_free(s->fifo);
+    s->fifo = NULL;
+    av_freep(&s->recv_buf);
+#endif
  fail:
     if (udp_fd >= 0)
         closesocket(udp_fd);
@@ -646,6 +800,29 @@ static int udp_read(URLContext *h, uint8_t *buf, int size)
     UDPContext *s = h->priv_data;
     int ret;
 
+#if HAVE_THREADS
+    if (s->thread_started) {
+        int len;
+
+        pthread_mutex_lock(&s->mutex);
+        /* the receive thread signals at least every POLLING_TIME ms, so
+         * returning EAGAIN afterwards lets the caller check for interrupts */
+        if (!av_fifo_size(s->fifo) && !s->fifo_error &&
+            !(h->flags & AVIO_FLAG_NONBLOCK))
+            pthread_cond_wait(&s->cond, &s->mutex);
+        if (av_fifo_size(s->fifo)) {
+            av_fifo_generic_read(s->fifo, &len, sizeof(len), NULL);
+            ret = FFMIN(len, size);
+            av_fifo_generic_read(s->fifo, buf, ret, NULL);
+            av_fifo_drain(s->fifo, len - ret);
+        } else {
+            ret = s->fifo_error ? s->fifo_error : AVERROR(EAGAIN);
+        }
+        pthread_mutex_unlock(&s->mutex);
+        return ret;
+    }
+#endif
+
     if (!(h->flags & AVIO_FLAG_NONBLOCK)) {
         ret = ff_network_wait_fd(s->udp_fd, 0);
         if (ret < 0)
@@ -680,6 +857,22 @@ static int udp_close(URLContext *h)
 {
     UDPContext *s = h->priv_data;
 
+#if HAVE_THREADS
+    if (s->thread_started) {
+        pthread_mutex_lock(&s->mutex);
+        s->close_req = 1;
+        pthread_mutex_unlock(&s->mutex);
+        pthread_join(s->thread, NULL);
+        pthread_cond_destroy(&s->cond);
+        pthread_mutex_destroy(&s->mutex);
+    }
+    av_fifo_free(s->fifo);
+    av_freep(&s->recv_buf);
+    if (s->overruns)
+        av_log(h, AV_LOG_WARNING, "%d packets dropped on receive buffer overrun\n",
+               s->overruns);
+#endif
+
     if (s->is_multicast && (h->flags & AVIO_FLAG_READ))
         udp_leave_multicast_group(s->udp_fd, (struct sockaddr *)&s->dest_addr);
     closesocket(s->udp_fd);
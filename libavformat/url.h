@@ -27,6 +27,7 @@
 #include "avio.h"
 #include "libavformat/version.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/dict.h"
 #include "libavutil/log.h"
 
@@ -89,6 +90,7 @@ typedef struct URLProtocol {
     const AVClass *priv_data_class;
     int flags;
     int (*url_check)(URLContext *h, int mask);
+    int (*url_get_mapping)(URLContext *h, AVBufferRef **buf);
 } URLProtocol;
 
 /**
@@ -221,6 +223,15 @@ int ffurl_get_file_handle(URLContext *h);
  */
 int ffurl_get_multi_file_handle(URLContext *h, int **handles, int *numhandles);
 
+/**
+ * Return a memory mapping of the whole resource, if the protocol keeps one.
+ * Byte n of the resource is at (*buf)->data[n].
+ *
+ * @param buf set to a new reference to the mapping on success
+ * @return 0 on success, AVERROR(ENOSYS) if the resource is not mapped
+ */
+int ffurl_get_mapping(URLContext *h, AVBufferRef **buf);
+
 /**
  * Signal the URLContext that we are done reading or writing the stream.
  *
@@ -41,6 +41,8 @@
 
 #include "audiointerleave.h"
 #include "avformat.h"
+#include "avio_internal.h"
+#include "http.h"
 #include "id3v2.h"
 #include "internal.h"
 #include "metadata.h"
@@ -124,6 +126,26 @@ int av_get_packet(AVIOContext *s, AVPacket *pkt, int size)
     return append_packet_chunked(s, pkt, size);
 }
 
+int ff_get_mapped_packet(AVIOContext *s, AVPacket *pkt, int size)
+{
+    int ret;
+
+    av_init_packet(pkt);
+    pkt->data = NULL;
+    pkt->size = 0;
+    pkt->pos  = avio_tell(s);
+
+    ret = ffio_read_mapped(s, size, &pkt->buf, &pkt->data);
+    if (ret >= 0) {
+        pkt->size = ret;
+        return ret;
+    }
+    if (ret != AVERROR(ENOSYS))
+        return ret;
+
+    return append_packet_chunked(s, pkt, size);
+}
+
 int av_append_packet(AVIOContext *s, AVPacket *pkt, int size)
 {
     if (!pkt->size)
@@ -845,6 +867,13 @@ static int parse_packet(AVFormatContext *s, AVPacket *pkt, int stream_index)
         if (!out_pkt.size)
             continue;
 
+        /* the parser returned the input as is, pass its buffer on
+         * instead of copying it */
+        if (out_pkt.data == pkt->data && out_pkt.size == pkt->size) {
+            out_pkt.buf = pkt->buf;
+            pkt->buf    = NULL;
+        }
+
         if (pkt->side_data) {
             out_pkt.side_data       = pkt->side_data;
             out_pkt.side_data_elems = pkt->side_data_elems;
@@ -885,7 +914,7 @@ static int parse_packet(AVFormatContext *s, AVPacket *pkt, int stream_index)
 
         if ((ret = add_to_pktbuf(&s->internal->parse_queue, &out_pkt,
                                  &s->internal->parse_queue_end,
-                                 1))) {
+                                 !out_pkt.buf))) {
             av_packet_unref(&out_pkt);
             goto fail;
         }
@@ -3224,6 +3253,9 @@ int avformat_network_init(void)
 int avformat_network_deinit(void)
 {
 #if CONFIG_NETWORK
+#if CONFIG_HTTP_PROTOCOL || CONFIG_HTTPS_PROTOCOL
+    ff_http_close_idle_connections();
+#endif
     ff_network_close();
     ff_tls_deinit();
 #endif
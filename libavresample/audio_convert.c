@@ -311,6 +311,45 @@ AudioConvert *ff_audio_convert_alloc(AVAudioResampleContext *avr,
     return ac;
 }
 
+typedef struct ConvertThreadArg {
+    conv_func_flat *convert;
+    AudioData *out;
+    AudioData *in;
+    const int *channel_map;
+    int planes;
+    int len;
+} ConvertThreadArg;
+
+static void convert_planes(void *priv, int jobnr, int nb_jobs)
+{
+    ConvertThreadArg *t = priv;
+    int p_start = t->planes *  jobnr      / nb_jobs;
+    int p_end   = t->planes * (jobnr + 1) / nb_jobs;
+    int p;
+
+    for (p = p_start; p < p_end; p++) {
+        if (!t->channel_map)
+            t->convert(t->out->data[p], t->in->data[p], t->len);
+        else if (t->channel_map[p] >= 0)
+            t->convert(t->out->data[p], t->in->data[t->channel_map[p]], t->len);
+    }
+}
+
+/* convert each plane separately, splitting the planes across the worker
+   threads if there are any */
+static void convert_flat(AudioConvert *ac, conv_func_flat *convert,
+                         AudioData *out, AudioData *in,
+                         const int *channel_map, int len)
+{
+    ConvertThreadArg t = { convert, out, in, channel_map, ac->planes, len };
+
+    if (HAVE_THREADS && ac->avr->thread && ac->planes > 1)
+        avpriv_slicethread_execute(ac->avr->thread, convert_planes, &t,
+                                   FFMIN(ac->planes, ac->avr->thread_count));
+    else
+        convert_planes(&t, 0, 1);
+}
+
 int ff_audio_convert(AudioConvert *ac, AudioData *out, AudioData *in)
 {
     int use_generic = 1;
@@ -355,9 +394,7 @@ int ff_audio_convert(AudioConvert *ac, AudioData *out, AudioData *in)
                 conv_func_flat *convert = use_generic ? ac->conv_flat_generic :
                                                         ac->conv_flat;
 
-                for (p = 0; p < ac->planes; p++)
-                    if (map->channel_map[p] >= 0)
-                        convert(out->data[p], in->data[map->channel_map[p]], len);
+                convert_flat(ac, convert, out, in, map->channel_map, len);
             } else {
                 uint8_t *data[AVRESAMPLE_MAX_CHANNELS];
                 conv_func_deinterleave *convert = use_generic ?
@@ -384,13 +421,8 @@ int ff_audio_convert(AudioConvert *ac, AudioData *out, AudioData *in)
         case CONV_FUNC_TYPE_FLAT: {
             if (!in->is_planar)
                 len *= in->channels;
-            if (use_generic) {
-                for (p = 0; p < ac->planes; p++)
-                    ac->conv_flat_generic(out->data[p], in->data[p], len);
-            } else {
-                for (p = 0; p < ac->planes; p++)
-                    ac->conv_flat(out->data[p], in->data[p], len);
-            }
+            convert_flat(ac, use_generic ? ac->conv_flat_generic : ac->conv_flat,
+                         out, in, NULL, len);
             break;
         }
         case CONV_FUNC_TYPE_INTERLEAVE:
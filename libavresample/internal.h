@@ -25,6 +25,7 @@
 #include "libavutil/log.h"
 #include "libavutil/opt.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/slicethread.h"
 #include "avresample.h"
 
 typedef struct AudioData AudioData;
@@ -105,6 +106,10 @@ struct AVAudioResampleContext {
     int use_channel_map;
     enum RemapPoint remap_point;
     ChannelMapInfo ch_map_info;
+
+    int nb_threads;                 /**< number of threads requested by the user (0 = autodetect) */
+    int thread_count;               /**< number of worker threads running   */
+    AVSliceThread *thread;          /**< worker threads for per-channel jobs */
 };
 
 
@@ -19,6 +19,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
+
 #include "libavutil/common.h"
 #include "libavutil/libm.h"
 #include "libavutil/log.h"
@@ -331,6 +333,29 @@ static int resample(ResampleContext *c, void *dst, const void *src,
     return dst_index;
 }
 
+typedef struct ResampleThreadArg {
+    ResampleContext *c;
+    AudioData *dst;
+    int nearest_neighbour;
+} ResampleThreadArg;
+
+static void resample_channels(void *priv, int jobnr, int nb_jobs)
+{
+    ResampleThreadArg *t = priv;
+    ResampleContext *c   = t->c;
+    int channels = c->buffer->channels;
+    int ch_start = channels *  jobnr      / nb_jobs;
+    int ch_end   = channels * (jobnr + 1) / nb_jobs;
+    int ch;
+
+    for (ch = ch_start; ch < ch_end; ch++) {
+        resample(c, (void *)t->dst->data[ch],
+                 (const void *)c->buffer->data[ch], NULL,
+                 c->buffer->nb_samples, t->dst->allocated_samples,
+                 0, t->nearest_neighbour);
+    }
+}
+
 int ff_audio_resample(ResampleContext *c, AudioData *dst, AudioData *src)
 {
     int ch, in_samples, in_leftover, consumed = 0, out_samples = 0;
@@ -413,11 +438,24 @@ int ff_audio_resample(ResampleContext *c, AudioData *dst, AudioData *src)
     }
 
     /* resample each channel plane */
-    for (ch = 0; ch < c->buffer->channels; ch++) {
-        out_samples = resample(c, (void *)dst->data[ch],
-                               (const void *)c->buffer->data[ch], &consumed,
+    if (HAVE_THREADS && c->avr->thread && c->buffer->channels > 1) {
+        ResampleThreadArg t = { c, dst, nearest_neighbour };
+
+        /* all channels start from the same state, so they can be resampled
+           concurrently and the state is then advanced once for all of them */
+        avpriv_slicethread_execute(c->avr->thread, resample_channels, &t,
+                                   FFMIN(c->buffer->channels,
+                                         c->avr->thread_count));
+        out_samples = resample(c, NULL, NULL, &consumed,
                                c->buffer->nb_samples, dst->allocated_samples,
-                               ch + 1 == c->buffer->channels, nearest_neighbour);
+                               1, nearest_neighbour);
+    } else {
+        for (ch = 0; ch < c->buffer->channels; ch++) {
+            out_samples = resample(c, (void *)dst->data[ch],
+                                   (const void *)c->buffer->data[ch], &consumed,
+                                   c->buffer->nb_samples, dst->allocated_samples,
+                                   ch + 1 == c->buffer->channels, nearest_neighbour);
+        }
     }
     if (out_samples < 0) {
         av_log(c->avr, AV_LOG_ERROR, "error during resampling\n");
@@ -18,7 +18,10 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
+
 #include "libavutil/common.h"
+#include "libavutil/cpu.h"
 #include "libavutil/dict.h"
 #include "libavutil/error.h"
 #include "libavutil/frame.h"
@@ -247,6 +250,20 @@ int avresample_open(AVAudioResampleContext *avr)
         }
     }
 
+    /* start the worker threads for the per-channel stages */
+    avr->thread_count = 1;
+    if (HAVE_THREADS && avr->nb_threads != 1 &&
+        (avr->resample_needed || avr->in_convert_needed ||
+         avr->out_convert_needed)) {
+        int nb_threads = avr->nb_threads ? avr->nb_threads : av_cpu_count();
+        nb_threads = FFMIN(nb_threads, FFMAX(avr->in_channels, avr->out_channels));
+        ret = avpriv_slicethread_create(&avr->thread, nb_threads);
+        if (ret < 0)
+            goto error;
+        avr->thread_count = ret;
+        av_log(avr, AV_LOG_DEBUG, "Using %d threads\n", avr->thread_count);
+    }
+
     return 0;
 
 error:
@@ -271,6 +288,7 @@ void avresample_close(AVAudioResampleContext *avr)
     ff_audio_resample_free(&avr->resample);
     ff_audio_mix_free(&avr->am);
     av_freep(&avr->mix_matrix);
+    avpriv_slicethread_free(&avr->thread);
 
     avr->use_channel_map = 0;
 }
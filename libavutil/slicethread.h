@@ -0,0 +1,60 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_SLICETHREAD_H
+#define AVUTIL_SLICETHREAD_H
+
+/**
+ * @file
+ * A pool of worker threads running the jobs of one task at a time, shared
+ * by the slice threading implementations of the libraries.
+ */
+
+typedef struct AVSliceThread AVSliceThread;
+
+/**
+ * A function executed by the worker threads for each job.
+ *
+ * @param priv  the opaque pointer passed to avpriv_slicethread_execute()
+ * @param jobnr index of the job being executed, 0 <= jobnr < nb_jobs
+ */
+typedef void (avpriv_slicethread_func)(void *priv, int jobnr, int nb_jobs);
+
+/**
+ * Start a pool of nb_threads worker threads.
+ *
+ * @param pctx set to the new pool, or to NULL if no thread was started
+ * @return the number of threads started, 1 if nb_threads is at most 1 or
+ *         threading is not supported, or a negative AVERROR code
+ */
+int avpriv_slicethread_create(AVSliceThread **pctx, int nb_threads);
+
+/**
+ * Run func nb_jobs times on the worker threads and wait for completion.
+ * Only one task may be executed at a time on a pool.
+ */
+void avpriv_slicethread_execute(AVSliceThread *ctx,
+                                avpriv_slicethread_func *func,
+                                void *priv, int nb_jobs);
+
+/**
+ * Stop the worker threads and free the pool.
+ */
+void avpriv_slicethread_free(AVSliceThread **pctx);
+
+#endif /* AVUTIL_SLICETHREAD_H */
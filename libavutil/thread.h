@@ -33,6 +33,7 @@
 #endif
 
 #define AVMutex pthread_mutex_t
+#define AV_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
 
 #define ff_mutex_init    pthread_mutex_init
 #define ff_mutex_lock    pthread_mutex_lock
@@ -47,6 +48,7 @@
 #else
 
 #define AVMutex char
+#define AV_MUTEX_INITIALIZER 0
 
 static inline int ff_mutex_init(AVMutex *mutex, const void *attr){ return 0; }
 static inline int ff_mutex_lock(AVMutex *mutex){ return 0; }
@@ -388,6 +388,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     const int chrSrcSliceH           = AV_CEIL_RSHIFT(srcSliceH,   c->chrSrcVSubSample);
     int should_dither                = is9_15BPS(c->srcFormat) ||
                                        is16BPS(c->srcFormat);
+    const int dstYEnd                = c->sliceDstY + c->sliceDstH;
     int lastDstY;
 
     /* vars which will change and which we need to store back in the context */
@@ -437,7 +438,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     if (srcSliceY == 0) {
         lumBufIndex  = -1;
         chrBufIndex  = -1;
-        dstY         = 0;
+        dstY         = c->sliceDstY;
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
@@ -447,7 +448,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     }
     lastDstY = dstY;
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < dstYEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         uint8_t *dest[4]  = {
             dst[0] + dstStride[0] * dstY,
@@ -720,6 +721,52 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     return dstY - lastDstY;
 }
 
+#if HAVE_THREADS
+typedef struct SliceArgs {
+    SwsContext *c;
+    const uint8_t **src;
+    int *srcStride;
+    uint8_t **dst;
+    int *dstStride;
+} SliceArgs;
+
+static void scale_band(void *priv, int jobnr, int nb_jobs)
+{
+    const SliceArgs *a = priv;
+    SwsContext *c      = a->c;
+    SwsContext *s      = c->slice_ctx[jobnr];
+    const int align    = 1 << c->chrDstVSubSample;
+    int y0 = ((int64_t)c->dstH *  jobnr      / nb_jobs) & ~(align - 1);
+    int y1 = ((int64_t)c->dstH * (jobnr + 1) / nb_jobs) & ~(align - 1);
+    const uint8_t *src[4] = { a->src[0], a->src[1], a->src[2], a->src[3] };
+    uint8_t *dst[4]       = { a->dst[0], a->dst[1], a->dst[2], a->dst[3] };
+    int srcStride[4]      = { a->srcStride[0], a->srcStride[1],
+                              a->srcStride[2], a->srcStride[3] };
+    int dstStride[4]      = { a->dstStride[0], a->dstStride[1],
+                              a->dstStride[2], a->dstStride[3] };
+
+    if (jobnr == nb_jobs - 1)
+        y1 = c->dstH;
+
+    memcpy(s->pal_yuv, c->pal_yuv, sizeof(c->pal_yuv));
+    memcpy(s->pal_rgb, c->pal_rgb, sizeof(c->pal_rgb));
+
+    s->sliceDstY = y0;
+    s->sliceDstH = y1 - y0;
+    s->swscale(s, src, srcStride, 0, c->srcH, dst, dstStride);
+}
+
+int ff_sws_scale_threaded(SwsContext *c, const uint8_t *src[], int srcStride[],
+                          uint8_t *dst[], int dstStride[])
+{
+    SliceArgs args = { c, src, srcStride, dst, dstStride };
+
+    avpriv_slicethread_execute(c->thread, scale_band, &args, c->nb_slice_ctx);
+
+    return c->dstH;
+}
+#endif /* HAVE_THREADS */
+
 static av_cold void sws_init_swscale(SwsContext *c)
 {
     enum AVPixelFormat srcFormat = c->srcFormat;
@@ -30,6 +30,7 @@
 #include "libavutil/pixfmt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/ppc/util_altivec.h"
+#include "libavutil/slicethread.h"
 
 #define STR(s) AV_TOSTRING(s) // AV_STRINGIFY is too long
 
@@ -283,6 +284,21 @@ typedef struct SwsContext {
     int sliceDir;                 ///< Direction that slices are fed to the scaler (1 = top-to-bottom, -1 = bottom-to-top).
     double param[2];              ///< Input parameters for scaling algorithms that need them.
 
+    /**
+     * @name Slice threading.
+     * A threaded context owns one child context per thread. Each child has
+     * its own line buffers and dither state and produces one horizontal
+     * band of the destination image from the whole source image.
+     */
+    //@{
+    int nb_threads;               ///< Number of threads requested by the user (0 = autodetect).
+    struct SwsContext **slice_ctx; ///< Child contexts, one per band of the destination image.
+    int nb_slice_ctx;             ///< Number of child contexts in slice_ctx.
+    AVSliceThread *thread;        ///< Worker threads running the child contexts.
+    int sliceDstY;                ///< First destination line produced by a full-frame scale.
+    int sliceDstH;                ///< Number of destination lines produced by a full-frame scale.
+    //@}
+
     uint32_t pal_yuv[256];
     uint32_t pal_rgb[256];
 
@@ -547,6 +563,13 @@ int ff_yuv2rgb_c_init_tables(SwsContext *c, const int inv_table[4],
 void ff_yuv2rgb_init_tables_ppc(SwsContext *c, const int inv_table[4],
                                 int brightness, int contrast, int saturation);
 
+/**
+ * Scale a whole frame, splitting the destination image into horizontal
+ * bands that are processed concurrently by the slice contexts.
+ */
+int ff_sws_scale_threaded(SwsContext *c, const uint8_t *src[], int srcStride[],
+                          uint8_t *dst[], int dstStride[]);
+
 void updateMMXDitherTables(SwsContext *c, int dstY, int lumBufIndex, int chrBufIndex,
                            int lastInLumBuf, int lastInChrBuf);
 
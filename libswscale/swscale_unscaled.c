@@ -1312,6 +1312,10 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
         if (srcSliceY + srcSliceH == c->srcH)
             c->sliceDir = 0;
 
+        if (HAVE_THREADS && c->nb_slice_ctx && srcSliceY == 0 &&
+            srcSliceH == c->srcH)
+            return ff_sws_scale_threaded(c, src2, srcStride2, dst2, dstStride2);
+
         return c->swscale(c, src2, srcStride2, srcSliceY, srcSliceH, dst2,
                           dstStride2);
     } else {
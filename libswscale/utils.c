@@ -810,6 +810,8 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
 {
     const AVPixFmtDescriptor *desc_dst = av_pix_fmt_desc_get(c->dstFormat);
     const AVPixFmtDescriptor *desc_src = av_pix_fmt_desc_get(c->srcFormat);
+    int i;
+
     memcpy(c->srcColorspaceTable, inv_table, sizeof(int) * 4);
     memcpy(c->dstColorspaceTable, table, sizeof(int) * 4);
 
@@ -818,6 +820,12 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     c->saturation = saturation;
     c->srcRange   = srcRange;
     c->dstRange   = dstRange;
+
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_setColorspaceDetails(c->slice_ctx[i], inv_table, srcRange,
+                                 table, dstRange,
+                                 brightness, contrast, saturation);
+
     if (isYUV(c->dstFormat) || isGray(c->dstFormat))
         return -1;
 
@@ -884,6 +892,60 @@ SwsContext *sws_alloc_context(void)
     return c;
 }
 
+static av_cold int init_slice_threads(SwsContext *c, SwsFilter *srcFilter,
+                                      SwsFilter *dstFilter)
+{
+    int nb_threads = c->nb_threads;
+    int i, ret;
+
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+    // very short bands would mostly re-scale the vertical filter overlap
+    nb_threads = FFMIN(nb_threads, c->dstH / 16);
+    if (nb_threads <= 1)
+        return 0;
+
+    c->slice_ctx = av_mallocz(sizeof(*c->slice_ctx) * nb_threads);
+    if (!c->slice_ctx)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < nb_threads; i++) {
+        SwsContext *s = sws_alloc_context();
+        if (!s)
+            return AVERROR(ENOMEM);
+        c->slice_ctx[c->nb_slice_ctx++] = s;
+
+        s->flags     = c->flags;
+        s->srcW      = c->srcW;
+        s->srcH      = c->srcH;
+        s->dstW      = c->dstW;
+        s->dstH      = c->dstH;
+        s->srcFormat = c->srcFormat;
+        s->dstFormat = c->dstFormat;
+        s->param[0]  = c->param[0];
+        s->param[1]  = c->param[1];
+        sws_setColorspaceDetails(s, c->srcColorspaceTable, c->srcRange,
+                                 c->dstColorspaceTable, c->dstRange,
+                                 c->brightness, c->contrast, c->saturation);
+
+        ret = sws_init_context(s, srcFilter, dstFilter);
+        if (ret < 0)
+            return ret;
+    }
+
+    ret = avpriv_slicethread_create(&c->thread, nb_threads);
+    if (ret < 0)
+        return ret;
+    if (ret <= 1) {
+        for (i = 0; i < c->nb_slice_ctx; i++)
+            sws_freeContext(c->slice_ctx[i]);
+        av_freep(&c->slice_ctx);
+        c->nb_slice_ctx = 0;
+    }
+
+    return 0;
+}
+
 av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                              SwsFilter *dstFilter)
 {
@@ -898,10 +960,23 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     int dst_stride        = FFALIGN(dstW * sizeof(int16_t) + 16, 16);
     int dst_stride_px     = dst_stride >> 1;
     int flags, cpu_flags;
-    enum AVPixelFormat srcFormat = c->srcFormat;
-    enum AVPixelFormat dstFormat = c->dstFormat;
-    const AVPixFmtDescriptor *desc_src = av_pix_fmt_desc_get(srcFormat);
-    const AVPixFmtDescriptor *desc_dst = av_pix_fmt_desc_get(dstFormat);
+    enum AVPixelFormat srcFormat, dstFormat;
+    const AVPixFmtDescriptor *desc_src, *desc_dst;
+
+    /* contexts set up through the AVOptions API get the same JPEG range
+     * and default colorspace handling as the ones from sws_getContext() */
+    c->srcRange |= handle_jpeg(&c->srcFormat);
+    c->dstRange |= handle_jpeg(&c->dstFormat);
+    if (!c->contrast && !c->saturation && !c->dstFormatBpp)
+        sws_setColorspaceDetails(c, ff_yuv2rgb_coeffs[SWS_CS_DEFAULT],
+                                 c->srcRange,
+                                 ff_yuv2rgb_coeffs[SWS_CS_DEFAULT],
+                                 c->dstRange, 0, 1 << 16, 1 << 16);
+
+    srcFormat = c->srcFormat;
+    dstFormat = c->dstFormat;
+    desc_src  = av_pix_fmt_desc_get(srcFormat);
+    desc_dst  = av_pix_fmt_desc_get(dstFormat);
 
     cpu_flags = av_get_cpu_flags();
     flags     = c->flags;
@@ -960,6 +1035,9 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
         return AVERROR(EINVAL);
     }
 
+    c->sliceDstY = 0;
+    c->sliceDstH = dstH;
+
     if (!dstFilter)
         dstFilter = &dummyFilter;
     if (!srcFilter)
@@ -1334,6 +1412,10 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     }
 
     c->swscale = ff_getSwsFunc(c);
+
+    if (HAVE_THREADS && c->nb_threads != 1)
+        return init_slice_threads(c, srcFilter, dstFilter);
+
     return 0;
 fail: // FIXME replace things by appropriate error codes
     return -1;
@@ -1705,6 +1787,11 @@ void sws_freeContext(SwsContext *c)
     if (!c)
         return;
 
+    avpriv_slicethread_free(&c->thread);
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_freeContext(c->slice_ctx[i]);
+    av_freep(&c->slice_ctx);
+
     if (c->lumPixBuf) {
         for (i = 0; i < c->vLumBufSize; i++)
             av_freep(&c->lumPixBuf[i]);
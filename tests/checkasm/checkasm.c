@@ -77,6 +77,9 @@ static const struct {
     { "dcadsp", checkasm_check_dcadsp },
     { "synth_filter", checkasm_check_synth_filter },
 #endif
+#if CONFIG_FLACDSP
+    { "flacdsp", checkasm_check_flacdsp },
+#endif
 #if CONFIG_FMTCONVERT
     { "fmtconvert", checkasm_check_fmtconvert },
 #endif
@@ -93,6 +96,8 @@ static const struct {
     { "hevc_add_res", checkasm_check_hevc_add_res },
     { "hevc_idct", checkasm_check_hevc_idct },
     { "hevc_mc", checkasm_check_hevc_mc },
+    { "hevc_pred", checkasm_check_hevc_pred },
+    { "hevc_sao", checkasm_check_hevc_sao },
 #endif
 #if CONFIG_HUFFYUVDSP
     { "huffyuvdsp", checkasm_check_huffyuvdsp },
@@ -0,0 +1,74 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Libav; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavcodec/flacdsp.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+
+#define BUF_SIZE 256
+
+/* Signed residuals of 2 to 32 bits, centered on zero. */
+#define randomize_residual(buf, len)                                    \
+    do {                                                                \
+        int i, bits = 2 + rnd() % 31;                                   \
+        for (i = 0; i < len; i++)                                       \
+            buf[i] = (int32_t)(rnd() << (32 - bits)) >> (32 - bits);    \
+    } while (0)
+
+static void check_sum_residual(void)
+{
+    LOCAL_ALIGNED_16(int32_t, res, [BUF_SIZE + 3]);
+    int len;
+
+    declare_func(uint64_t, const int32_t *res, int len);
+
+    /* Every length, so that all the leftover sample counts of the vector
+     * loops are covered, at unaligned offsets. */
+    for (len = 0; len <= BUF_SIZE; len++) {
+        int offset = len & 3;
+        uint64_t sum0, sum1;
+
+        randomize_residual(res, BUF_SIZE + 3);
+        sum0 = call_ref(res + offset, len);
+        sum1 = call_new(res + offset, len);
+        if (sum0 != sum1)
+            fail();
+    }
+
+    /* the extreme values */
+    for (len = 0; len < BUF_SIZE + 3; len++)
+        res[len] = len & 1 ? INT32_MIN : INT32_MAX;
+    if (call_ref(res, BUF_SIZE + 3) != call_new(res, BUF_SIZE + 3))
+        fail();
+
+    randomize_residual(res, BUF_SIZE);
+    bench_new(res, BUF_SIZE);
+}
+
+void checkasm_check_flacdsp(void)
+{
+    FLACDSPContext c;
+
+    ff_flacdsp_init(&c, AV_SAMPLE_FMT_S16, 16);
+
+    if (check_func(c.sum_residual, "flac_sum_residual"))
+        check_sum_residual();
+
+    report("sum_residual");
+}
@@ -0,0 +1,191 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Libav; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/intreadwrite.h"
+
+#include "libavcodec/hevcdec.h"
+
+#include "checkasm.h"
+
+#define BUF_SIZE (32 * 32 * 2)
+#define EDGE_SIZE (2 * 32 + 16)
+
+#define randomize_pixels(buf, size, bit_depth)                          \
+    do {                                                                \
+        int j;                                                          \
+        if (bit_depth > 8) {                                            \
+            for (j = 0; j < size; j++)                                  \
+                AV_WN16A(buf + j * 2, rnd() & ((1 << bit_depth) - 1));  \
+        } else {                                                        \
+            for (j = 0; j < size; j++)                                  \
+                buf[j] = rnd();                                         \
+        }                                                               \
+    } while (0)
+
+#define fill_max(buf, size, bit_depth)                                  \
+    do {                                                                \
+        int j;                                                          \
+        for (j = 0; j < size; j++) {                                    \
+            if (bit_depth > 8)                                          \
+                AV_WN16A(buf + j * 2, (1 << bit_depth) - 1);            \
+            else                                                        \
+                buf[j] = 0xFF;                                          \
+        }                                                               \
+    } while (0)
+
+static void check_pred_planar(HEVCPredContext *h, int bit_depth)
+{
+    LOCAL_ALIGNED(32, uint8_t, top,  [EDGE_SIZE * 2]);
+    LOCAL_ALIGNED(32, uint8_t, left, [EDGE_SIZE * 2]);
+    LOCAL_ALIGNED(32, uint8_t, dst0, [BUF_SIZE]);
+    LOCAL_ALIGNED(32, uint8_t, dst1, [BUF_SIZE]);
+    int pixel_size = bit_depth > 8 ? 2 : 1;
+    int i;
+
+    declare_func(void, uint8_t *src, const uint8_t *top,
+                 const uint8_t *left, ptrdiff_t stride);
+
+    for (i = 2; i <= 5; i++) {
+        int size = 1 << i;
+
+        if (check_func(h->pred_planar[i - 2], "hevc_pred_planar_%dx%d_%d", size, size, bit_depth)) {
+            randomize_pixels(top,  EDGE_SIZE, bit_depth);
+            randomize_pixels(left, EDGE_SIZE, bit_depth);
+            randomize_pixels(dst0, BUF_SIZE / pixel_size, bit_depth);
+            memcpy(dst1, dst0, BUF_SIZE);
+
+            call_ref(dst0, top + pixel_size, left + pixel_size, size);
+            call_new(dst1, top + pixel_size, left + pixel_size, size);
+            if (memcmp(dst0, dst1, BUF_SIZE))
+                fail();
+            bench_new(dst1, top + pixel_size, left + pixel_size, size);
+        }
+    }
+}
+
+static void check_pred_dc(HEVCPredContext *h, int bit_depth)
+{
+    LOCAL_ALIGNED(32, uint8_t, top,  [EDGE_SIZE * 2]);
+    LOCAL_ALIGNED(32, uint8_t, left, [EDGE_SIZE * 2]);
+    LOCAL_ALIGNED(32, uint8_t, dst0, [BUF_SIZE]);
+    LOCAL_ALIGNED(32, uint8_t, dst1, [BUF_SIZE]);
+    int pixel_size = bit_depth > 8 ? 2 : 1;
+    int i, c_idx;
+
+    declare_func(void, uint8_t *src, const uint8_t *top, const uint8_t *left,
+                 ptrdiff_t stride, int log2_size, int c_idx);
+
+    for (i = 2; i <= 5; i++) {
+        int size = 1 << i;
+
+        for (c_idx = 0; c_idx <= 1; c_idx++) {
+            if (check_func(h->pred_dc, "hevc_pred_dc_%dx%d_%s_%d", size, size,
+                           c_idx ? "chroma" : "luma", bit_depth)) {
+                randomize_pixels(top,  EDGE_SIZE, bit_depth);
+                randomize_pixels(left, EDGE_SIZE, bit_depth);
+                randomize_pixels(dst0, BUF_SIZE / pixel_size, bit_depth);
+                memcpy(dst1, dst0, BUF_SIZE);
+
+                call_ref(dst0, top + pixel_size, left + pixel_size, size, i, c_idx);
+                call_new(dst1, top + pixel_size, left + pixel_size, size, i, c_idx);
+                if (memcmp(dst0, dst1, BUF_SIZE))
+                    fail();
+                bench_new(dst1, top + pixel_size, left + pixel_size, size, i, c_idx);
+            }
+        }
+    }
+}
+
+static void check_pred_angular(HEVCPredContext *h, int bit_depth)
+{
+    LOCAL_ALIGNED(32, uint8_t, top,  [EDGE_SIZE * 2]);
+    LOCAL_ALIGNED(32, uint8_t, left, [EDGE_SIZE * 2]);
+    LOCAL_ALIGNED(32, uint8_t, dst0, [BUF_SIZE]);
+    LOCAL_ALIGNED(32, uint8_t, dst1, [BUF_SIZE]);
+    int pixel_size = bit_depth > 8 ? 2 : 1;
+    int i, k, mode, c_idx;
+
+    declare_func(void, uint8_t *src, const uint8_t *top, const uint8_t *left,
+                 ptrdiff_t stride, int c_idx, int mode);
+
+    for (i = 2; i <= 5; i++) {
+        int size = 1 << i;
+
+        if (check_func(h->pred_angular[i - 2], "hevc_pred_angular_%dx%d_%d",
+                       size, size, bit_depth)) {
+            /* every mode, with random edges and with the edges at the
+             * maximum value, which the edge filter of modes 10 and 26
+             * has to clip */
+            for (k = 0; k < 2; k++) {
+                for (mode = 2; mode <= 34; mode++) {
+                    for (c_idx = 0; c_idx <= 1; c_idx++) {
+                        if (k) {
+                            fill_max(top,  EDGE_SIZE, bit_depth);
+                            fill_max(left, EDGE_SIZE, bit_depth);
+                            /* a dark corner, for the steepest gradient */
+                            memset(top,  0, pixel_size);
+                            memset(left, 0, pixel_size);
+                        } else {
+                            randomize_pixels(top,  EDGE_SIZE, bit_depth);
+                            randomize_pixels(left, EDGE_SIZE, bit_depth);
+                        }
+                        randomize_pixels(dst0, BUF_SIZE / pixel_size, bit_depth);
+                        memcpy(dst1, dst0, BUF_SIZE);
+
+                        call_ref(dst0, top + pixel_size, left + pixel_size, size, c_idx, mode);
+                        call_new(dst1, top + pixel_size, left + pixel_size, size, c_idx, mode);
+                        if (memcmp(dst0, dst1, BUF_SIZE))
+                            fail();
+                    }
+                }
+            }
+            bench_new(dst1, top + pixel_size, left + pixel_size, size, 0, 20);
+        }
+    }
+}
+
+void checkasm_check_hevc_pred(void)
+{
+    int bit_depth;
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        HEVCPredContext h;
+
+        ff_hevc_pred_init(&h, bit_depth);
+        check_pred_planar(&h, bit_depth);
+    }
+    report("pred_planar");
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        HEVCPredContext h;
+
+        ff_hevc_pred_init(&h, bit_depth);
+        check_pred_dc(&h, bit_depth);
+    }
+    report("pred_dc");
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        HEVCPredContext h;
+
+        ff_hevc_pred_init(&h, bit_depth);
+        check_pred_angular(&h, bit_depth);
+    }
+    report("pred_angular");
+}
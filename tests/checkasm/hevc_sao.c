@@ -0,0 +1,147 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Libav; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/intreadwrite.h"
+
+#include "libavcodec/hevcdsp.h"
+
+#include "checkasm.h"
+
+/* the SIMD versions read past the end of the rows, and the edge filters
+ * read one pixel around the block */
+#define SAO_STRIDE 256
+#define SAO_ROWS   (64 + 2)
+#define SAO_OFFSET (SAO_STRIDE + 32)
+
+static const int sao_widths[] = { 4, 7, 8, 13, 16, 31, 32, 48, 64 };
+
+#define randomize_pixels(buf, size, bit_depth)                          \
+    do {                                                                \
+        int j;                                                          \
+        if (bit_depth > 8) {                                            \
+            for (j = 0; j < size / 2; j++)                              \
+                AV_WN16A(buf + j * 2, rnd() & ((1 << bit_depth) - 1));  \
+        } else {                                                        \
+            for (j = 0; j < size; j++)                                  \
+                buf[j] = rnd();                                         \
+        }                                                               \
+    } while (0)
+
+static void randomize_offsets(int16_t *sao_offset_val, int bit_depth)
+{
+    int i, max = (1 << (FFMIN(bit_depth, 10) - 5)) - 1;
+
+    sao_offset_val[0] = 0;
+    for (i = 1; i < 5; i++)
+        sao_offset_val[i] = (int)(rnd() % (2 * max + 1)) - max;
+}
+
+static void check_sao_band(HEVCDSPContext h, int bit_depth)
+{
+    LOCAL_ALIGNED(32, uint8_t, src,  [SAO_STRIDE * SAO_ROWS]);
+    LOCAL_ALIGNED(32, uint8_t, dst0, [SAO_STRIDE * SAO_ROWS]);
+    LOCAL_ALIGNED(32, uint8_t, dst1, [SAO_STRIDE * SAO_ROWS]);
+    int16_t sao_offset_val[5];
+    int i, j;
+
+    declare_func(void, uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                 const int16_t *sao_offset_val, int sao_left_class,
+                 int width, int height);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(sao_widths); i++) {
+        int width = sao_widths[i];
+
+        if (check_func(h.sao_band_filter, "hevc_sao_band_%d_%d", width, bit_depth)) {
+            for (j = 0; j < 4; j++) {
+                int left_class = rnd() & 31;
+
+                randomize_pixels(src, SAO_STRIDE * SAO_ROWS, bit_depth);
+                randomize_pixels(dst0, SAO_STRIDE * SAO_ROWS, bit_depth);
+                memcpy(dst1, dst0, SAO_STRIDE * SAO_ROWS);
+                randomize_offsets(sao_offset_val, bit_depth);
+
+                call_ref(dst0 + SAO_OFFSET, src + SAO_OFFSET, SAO_STRIDE,
+                         sao_offset_val, left_class, width, 64);
+                call_new(dst1 + SAO_OFFSET, src + SAO_OFFSET, SAO_STRIDE,
+                         sao_offset_val, left_class, width, 64);
+                if (memcmp(dst0, dst1, SAO_STRIDE * SAO_ROWS))
+                    fail();
+            }
+            bench_new(dst1 + SAO_OFFSET, src + SAO_OFFSET, SAO_STRIDE,
+                      sao_offset_val, 0, width, 64);
+        }
+    }
+}
+
+static void check_sao_edge(HEVCDSPContext h, int bit_depth)
+{
+    LOCAL_ALIGNED(32, uint8_t, src,  [SAO_STRIDE * SAO_ROWS]);
+    LOCAL_ALIGNED(32, uint8_t, dst0, [SAO_STRIDE * SAO_ROWS]);
+    LOCAL_ALIGNED(32, uint8_t, dst1, [SAO_STRIDE * SAO_ROWS]);
+    int16_t sao_offset_val[5];
+    int i, eo_class;
+
+    declare_func(void, uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                 const int16_t *sao_offset_val, int sao_eo_class,
+                 int width, int height);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(sao_widths); i++) {
+        int width = sao_widths[i];
+
+        if (check_func(h.sao_edge_filter, "hevc_sao_edge_%d_%d", width, bit_depth)) {
+            for (eo_class = 0; eo_class < 4; eo_class++) {
+                randomize_pixels(src, SAO_STRIDE * SAO_ROWS, bit_depth);
+                randomize_pixels(dst0, SAO_STRIDE * SAO_ROWS, bit_depth);
+                memcpy(dst1, dst0, SAO_STRIDE * SAO_ROWS);
+                randomize_offsets(sao_offset_val, bit_depth);
+
+                call_ref(dst0 + SAO_OFFSET, src + SAO_OFFSET, SAO_STRIDE,
+                         sao_offset_val, eo_class, width, 64);
+                call_new(dst1 + SAO_OFFSET, src + SAO_OFFSET, SAO_STRIDE,
+                         sao_offset_val, eo_class, width, 64);
+                if (memcmp(dst0, dst1, SAO_STRIDE * SAO_ROWS))
+                    fail();
+            }
+            bench_new(dst1 + SAO_OFFSET, src + SAO_OFFSET, SAO_STRIDE,
+                      sao_offset_val, 0, width, 64);
+        }
+    }
+}
+
+void checkasm_check_hevc_sao(void)
+{
+    int bit_depth;
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_sao_band(h, bit_depth);
+    }
+    report("sao_band");
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_sao_edge(h, bit_depth);
+    }
+    report("sao_edge");
+}
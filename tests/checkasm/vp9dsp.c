@@ -557,8 +557,72 @@ static void check_mc(void)
     report("mc");
 }
 
+static void check_ipred(void)
+{
+    static const char *const mode_names[N_INTRA_PRED_MODES] = {
+        [VERT_PRED]            = "vert",
+        [HOR_PRED]             = "hor",
+        [DC_PRED]              = "dc",
+        [DIAG_DOWN_LEFT_PRED]  = "diag_downleft",
+        [DIAG_DOWN_RIGHT_PRED] = "diag_downright",
+        [VERT_RIGHT_PRED]      = "vert_right",
+        [HOR_DOWN_PRED]        = "hor_down",
+        [VERT_LEFT_PRED]       = "vert_left",
+        [HOR_UP_PRED]          = "hor_up",
+        [TM_VP8_PRED]          = "tm",
+        [LEFT_DC_PRED]         = "dc_left",
+        [TOP_DC_PRED]          = "dc_top",
+        [DC_128_PRED]          = "dc_128",
+        [DC_127_PRED]          = "dc_127",
+        [DC_129_PRED]          = "dc_129",
+    };
+
+    LOCAL_ALIGNED_32(uint8_t, a_buf, [64 * 2]);
+    LOCAL_ALIGNED_32(uint8_t, l, [32 * 2]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [32 * 32 * 2]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [32 * 32 * 2]);
+    /* the top edge is read from a[-1] up to a[2 * size - 1] */
+    uint8_t *a = &a_buf[32];
+    VP9DSPContext dsp;
+    int tx, mode, edge, n;
+    declare_func(void, uint8_t *dst, ptrdiff_t stride,
+                 const uint8_t *left, const uint8_t *top);
+
+    ff_vp9dsp_init(&dsp);
+
+    for (tx = TX_4X4; tx < N_TXFM_SIZES; tx++) {
+        int size = 4 << tx;
+
+        for (mode = 0; mode < N_INTRA_PRED_MODES; mode++) {
+            if (check_func(dsp.intra_pred[tx][mode], "vp9_%s_%dx%d_ipred",
+                           mode_names[mode], size, size)) {
+                /* random edges, then edges alternating between the
+                 * extreme values and saturated ones, which catch rounding
+                 * and overflow errors in the filters */
+                for (edge = 0; edge < 3; edge++) {
+                    for (n = 0; n < 64 * 2; n++)
+                        a_buf[n] = edge == 0 ? rnd() : edge == 1 ? -(n & 1) : 0xFF;
+                    for (n = 0; n < 32 * 2; n++)
+                        l[n] = edge == 0 ? rnd() : edge == 1 ? -(~n & 1) : 0xFF;
+                    for (n = 0; n < 32 * 32 * 2; n++)
+                        dst0[n] = dst1[n] = rnd();
+
+                    call_ref(dst0, size * SIZEOF_PIXEL, l, a);
+                    call_new(dst1, size * SIZEOF_PIXEL, l, a);
+                    if (memcmp(dst0, dst1, size * size * SIZEOF_PIXEL))
+                        fail();
+                }
+
+                bench_new(dst1, size * SIZEOF_PIXEL, l, a);
+            }
+        }
+    }
+    report("ipred");
+}
+
 void checkasm_check_vp9dsp(void)
 {
+    check_ipred();
     check_itxfm();
     check_loopfilter();
     check_mc();
@@ -234,6 +234,19 @@ lavf_video(){
     do_avconv_crc $file $DEC_OPTS -i $target_path/$file $1
 }
 
+async_write(){
+    fmt=$1
+    src=$(target_path $2)
+    shift 2
+    file=${outdir}/${test}.${fmt}
+    cleanfiles="$file $file.async"
+    run_avconv $DEC_OPTS -i $src $ENC_OPTS -c copy -f $fmt -y $(target_path $file) || return
+    run_avconv $DEC_OPTS -i $src $ENC_OPTS -c copy $* -f $fmt -y async:file:$(target_path $file.async) || return
+    do_md5sum $file
+    echo $(wc -c $file)
+    cmp $file $file.async
+}
+
 pixfmt_conversion(){
     conversion="${test#pixfmt-}"
     outdir="tests/data/pixfmt"
@@ -106,3 +106,20 @@ FATE_SAMPLES_AVCONV += $(FATE_AAC_ALL)
 
 fate-aac: $(FATE_AAC_ALL)
 fate-aac-latm: $(FATE_AAC_LATM-yes)
+
+# the channel elements searched in parallel must give the same bitstream as
+# the serial encoder
+define AAC_ENCODE
+FATE_AAC_ENCODE += fate-aac-encode-$(1) fate-aac-encode-$(1)-threads
+fate-aac-encode-$(1) fate-aac-encode-$(1)-threads: tests/data/asynth-44100-$(2).wav
+fate-aac-encode-$(1):         CMD = framecrc -i $(TARGET_PATH)/tests/data/asynth-44100-$(2).wav -c:a aac -strict experimental -b:a $(3) -threads 1
+fate-aac-encode-$(1)-threads: CMD = framecrc -i $(TARGET_PATH)/tests/data/asynth-44100-$(2).wav -c:a aac -strict experimental -b:a $(3) -threads 4 -thread_type slice
+fate-aac-encode-$(1)-threads: REF = $(SRC_PATH)/tests/ref/fate/aac-encode-$(1)
+endef
+
+$(eval $(call AAC_ENCODE,stereo,2,128k))
+$(eval $(call AAC_ENCODE,5.1,6,384k))
+
+FATE_AAC_ENCODE-$(call ALLYES, WAV_DEMUXER PCM_S16LE_DECODER AAC_ENCODER FRAMECRC_MUXER) += $(FATE_AAC_ENCODE)
+FATE_AVCONV += $(FATE_AAC_ENCODE-yes)
+fate-aac-encode: $(FATE_AAC_ENCODE-yes)
@@ -0,0 +1,35 @@
+# Demux files written by other tests through the async read-ahead protocol,
+# which must return the same packets and seek results as the file protocol.
+
+FATE_ASYNC-$(call ENCDEC2, MPEG4, MP2,      MATROSKA) += lavf-mkv
+FATE_ASYNC-$(call ENCDEC2, MPEG4, PCM_ALAW, MOV)      += lavf-mov
+
+fate-async-lavf-mkv fate-async-seek-lavf-mkv: SRC = lavf/lavf.mkv
+fate-async-lavf-mov fate-async-seek-lavf-mov: SRC = lavf/lavf.mov
+
+FATE_ASYNC      = $(FATE_ASYNC-yes:%=fate-async-%)
+FATE_ASYNC_SEEK = $(FATE_ASYNC-yes:%=fate-async-seek-%)
+
+$(FATE_ASYNC): CMD = framecrc -i async:file:$(TARGET_PATH)/tests/data/$(SRC) -c copy
+$(FATE_ASYNC): fate-async-%: fate-%
+
+$(FATE_ASYNC_SEEK): libavformat/tests/seek$(EXESUF)
+$(FATE_ASYNC_SEEK): CMD = run libavformat/tests/seek$(EXESUF) async:file:$(TARGET_PATH)/tests/data/$(SRC)
+$(FATE_ASYNC_SEEK): REF = $(SRC_PATH)/tests/ref/seek/$(@:fate-async-seek-%=%)
+$(FATE_ASYNC_SEEK): fate-async-seek-%: fate-%
+
+# Remux the same files through async:, with a buffer small enough for the
+# writes to wait for the thread; the output must be the same as when
+# writing to the file directly, including the headers patched by seeking.
+FATE_ASYNC_WRITE-$(call ALLYES, MATROSKA_DEMUXER MATROSKA_MUXER) += fate-async-write-mkv
+FATE_ASYNC_WRITE-$(call ALLYES, MOV_DEMUXER MOV_MUXER)           += fate-async-write-mov
+
+fate-async-write-mkv: fate-lavf-mkv
+fate-async-write-mkv: CMD = async_write matroska tests/data/lavf/lavf.mkv -buffer_size 65536
+fate-async-write-mov: fate-lavf-mov
+fate-async-write-mov: CMD = async_write mov tests/data/lavf/lavf.mov -buffer_size 65536
+
+FATE_ASYNC_ALL = $(FATE_ASYNC) $(FATE_ASYNC_SEEK) $(FATE_ASYNC_WRITE-yes)
+
+FATE_AVCONV-$(call ALLYES, ASYNC_PROTOCOL FILE_PROTOCOL) += $(FATE_ASYNC_ALL)
+fate-async: $(FATE_ASYNC_ALL)
@@ -2,6 +2,7 @@ FATE_CHECKASM = fate-checkasm-audiodsp                                  \
                 fate-checkasm-blockdsp                                  \
                 fate-checkasm-bswapdsp                                  \
                 fate-checkasm-dcadsp                                    \
+                fate-checkasm-flacdsp                                   \
                 fate-checkasm-fmtconvert                                \
                 fate-checkasm-h264dsp                                   \
                 fate-checkasm-h264pred                                  \
@@ -9,6 +10,8 @@ FATE_CHECKASM = fate-checkasm-audiodsp                                  \
                 fate-checkasm-hevc_add_res                              \
                 fate-checkasm-hevc_idct                                 \
                 fate-checkasm-hevc_mc                                   \
+                fate-checkasm-hevc_pred                                 \
+                fate-checkasm-hevc_sao                                  \
                 fate-checkasm-huffyuvdsp                                \
                 fate-checkasm-synth_filter                              \
                 fate-checkasm-v210enc                                   \
@@ -41,6 +41,12 @@ fate-filter-hqdn3d: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf hqdn3d
 FATE_FILTER_VSYNTH-$(CONFIG_INTERLACE_FILTER) += fate-filter-interlace
 fate-filter-interlace: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf interlace
 
+FATE_FILTER_VSYNTH-$(call ALLYES, FORMAT_FILTER LUTRGB_FILTER) += fate-filter-lutrgb
+fate-filter-lutrgb: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf format=rgb24,lutrgb=r=negval:g=val/2:b=clipval*2
+
+FATE_FILTER_VSYNTH-$(CONFIG_LUTYUV_FILTER) += fate-filter-lutyuv
+fate-filter-lutyuv: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf lutyuv=y=val*2:u=negval:v=maxval-val/2
+
 FATE_FILTER_VSYNTH-$(CONFIG_NEGATE_FILTER) += fate-filter-negate
 fate-filter-negate: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf negate
 
@@ -163,6 +169,61 @@ fate-filter-pixfmts-vflip: CMD = pixfmts
 $(FATE_FILTER_PIXFMTS): libavfilter/tests/filtfmts$(EXESUF)
 FATE_FILTER_VSYNTH-$(CONFIG_FORMAT_FILTER) += $(FATE_FILTER_PIXFMTS)
 
+# the slice threaded filters must give the same output with several threads
+FATE_FILTER_THREADS-$(CONFIG_BOXBLUR_FILTER) += fate-filter-boxblur-threads
+fate-filter-boxblur-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 3 -vf boxblur=2:1
+fate-filter-boxblur-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-boxblur
+
+FATE_FILTER_THREADS-$(CONFIG_DRAWBOX_FILTER) += fate-filter-drawbox-threads
+fate-filter-drawbox-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 3 -vf drawbox=10:20:200:60:red@0.5
+fate-filter-drawbox-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-drawbox
+
+FATE_FILTER_THREADS-$(CONFIG_GRADFUN_FILTER) += fate-filter-gradfun-threads
+fate-filter-gradfun-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 3 -vf gradfun
+fate-filter-gradfun-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-gradfun
+
+FATE_FILTER_THREADS-$(CONFIG_HQDN3D_FILTER) += fate-filter-hqdn3d-threads
+fate-filter-hqdn3d-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 3 -vf hqdn3d
+fate-filter-hqdn3d-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-hqdn3d
+
+FATE_FILTER_THREADS-$(call ALLYES, FORMAT_FILTER LUTRGB_FILTER) += fate-filter-lutrgb-threads
+fate-filter-lutrgb-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 3 -vf format=rgb24,lutrgb=r=negval:g=val/2:b=clipval*2
+fate-filter-lutrgb-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-lutrgb
+
+FATE_FILTER_THREADS-$(CONFIG_LUTYUV_FILTER) += fate-filter-lutyuv-threads
+fate-filter-lutyuv-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 3 -vf lutyuv=y=val*2:u=negval:v=maxval-val/2
+fate-filter-lutyuv-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-lutyuv
+
+FATE_FILTER_THREADS-$(CONFIG_OVERLAY_FILTER) += fate-filter-overlay-threads
+fate-filter-overlay-threads: tests/data/filtergraphs/overlay
+fate-filter-overlay-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -c:v pgmyuv -i $(SRC) -filter_threads 3 -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/overlay
+fate-filter-overlay-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-overlay
+
+FATE_FILTER_THREADS-$(CONFIG_TRANSPOSE_FILTER) += fate-filter-transpose-threads
+fate-filter-transpose-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 3 -vf transpose
+fate-filter-transpose-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-transpose
+
+FATE_FILTER_THREADS-$(CONFIG_UNSHARP_FILTER) += fate-filter-unsharp-threads
+fate-filter-unsharp-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 3 -vf unsharp
+fate-filter-unsharp-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-unsharp
+
+FATE_FILTER_VSYNTH-yes += $(FATE_FILTER_THREADS-yes)
+fate-filter-threads: $(FATE_FILTER_THREADS-yes)
+
+# the branches after a split run in their own threads with the frame thread
+# type and must give the output of the single threaded graph
+define FILTER_BRANCHES
+FATE_FILTER_BRANCHES += fate-filter-branches-$(1)
+fate-filter-branches-$(1): tests/data/filtergraphs/branches
+fate-filter-branches-$(1): CMD = framecrc -c:v pgmyuv -i $$(SRC) -frames:v 10 -filter_threads $(1) -filter_thread_type slice+frame -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/branches -map [oa] -map [ob] -map [oc]
+fate-filter-branches-$(1): REF = $(SRC_PATH)/tests/ref/fate/filter-branches
+endef
+
+$(foreach N,1 2 3 4,$(eval $(call FILTER_BRANCHES,$(N))))
+
+FATE_FILTER_VSYNTH-$(call ALLYES, SPLIT_FILTER SCALE_FILTER HFLIP_FILTER FORMAT_FILTER) += $(FATE_FILTER_BRANCHES)
+fate-filter-branches: $(FATE_FILTER_BRANCHES)
+
 
 $(FATE_FILTER_VSYNTH-yes): $(VREF)
 $(FATE_FILTER_VSYNTH-yes): SRC = $(TARGET_PATH)/tests/vsynth1/%02d.pgm
@@ -152,8 +152,18 @@ FATE_HEVC += fate-hevc-conformance-$(1)
 fate-hevc-conformance-$(1): CMD = framecrc -vsync 0 -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt yuv420p10le
 endef
 
+# the streams using WPP or tiles are decoded again with slice threads,
+# which must give the same frames
+define FATE_HEVC_TEST_SLICETHREAD
+FATE_HEVC += fate-hevc-conformance-slicethread-$(1)
+fate-hevc-conformance-slicethread-$(1): CMD = framecrc -vsync 0 -threads 4 -thread_type slice -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt $(2)
+fate-hevc-conformance-slicethread-$(1): REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(1)
+endef
+
 $(foreach N,$(HEVC_SAMPLES),$(eval $(call FATE_HEVC_TEST,$(N))))
 $(foreach N,$(HEVC_SAMPLES_10BIT),$(eval $(call FATE_HEVC_TEST_10BIT,$(N))))
+$(foreach N,$(filter ENTP_% TILES_% WPP_%,$(HEVC_SAMPLES)),$(eval $(call FATE_HEVC_TEST_SLICETHREAD,$(N),yuv420p)))
+$(foreach N,$(filter WPP_%,$(HEVC_SAMPLES_10BIT)),$(eval $(call FATE_HEVC_TEST_SLICETHREAD,$(N),yuv420p10le)))
 
 fate-hevc-paramchange-yuv420p-yuv420p10: CMD = framecrc -vsync 0 -i $(TARGET_SAMPLES)/hevc/paramchange_yuv420p_yuv420p10.hevc
 FATE_HEVC += fate-hevc-paramchange-yuv420p-yuv420p10
@@ -12,6 +12,10 @@ FATE_LIBAVCODEC-$(CONFIG_IIRFILTER) += fate-iirfilter
 fate-iirfilter: libavcodec/tests/iirfilter$(EXESUF)
 fate-iirfilter: CMD = run libavcodec/tests/iirfilter
 
+FATE_LIBAVCODEC-$(CONFIG_MJPEG_DECODER) += fate-mjpeg-restart-slices
+fate-mjpeg-restart-slices: libavcodec/tests/mjpegdec$(EXESUF)
+fate-mjpeg-restart-slices: CMD = run libavcodec/tests/mjpegdec
+
 FATE_LIBAVCODEC-$(CONFIG_MPEGVIDEO) += fate-mpeg12framerate
 fate-mpeg12framerate: libavcodec/tests/mpeg12framerate$(EXESUF)
 fate-mpeg12framerate: CMD = run libavcodec/tests/mpeg12framerate
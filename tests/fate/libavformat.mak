@@ -1,3 +1,24 @@
+FATE_LIBAVFORMAT-$(call ALLYES, CACHE_PROTOCOL FILE_PROTOCOL) += fate-cache
+fate-cache: libavformat/tests/cache$(EXESUF)
+fate-cache: CMD = run libavformat/tests/cache tests/data/fate/cache.data
+
+# splits the transport stream written by fate-lavf-ts into HLS segments
+FATE_HLS-$(call ENCDEC2, MPEG2VIDEO, MP2, MPEGTS) += fate-hls-prefetch
+fate-hls-prefetch: libavformat/tests/hls$(EXESUF) fate-lavf-ts
+fate-hls-prefetch: CMD = run libavformat/tests/hls $(TARGET_PATH)/tests/data/lavf/lavf.ts tests/data/fate/hls-prefetch
+
+FATE_AVCONV-$(call ALLYES, HLS_DEMUXER FILE_PROTOCOL) += $(FATE_HLS-yes)
+
+FATE_HTTP-$(CONFIG_HTTP_PROTOCOL) += fate-http-pool
+fate-http-pool: libavformat/tests/httppool$(EXESUF)
+fate-http-pool: CMD = run libavformat/tests/httppool
+
+FATE_UDP-$(CONFIG_UDP_PROTOCOL) += fate-udp-fifo
+fate-udp-fifo: libavformat/tests/udp$(EXESUF)
+fate-udp-fifo: CMD = run libavformat/tests/udp
+
+FATE_LIBAVFORMAT-$(HAVE_PTHREADS) += $(FATE_HTTP-yes) $(FATE_UDP-yes)
+
 FATE_LIBAVFORMAT-$(CONFIG_NETWORK) += fate-noproxy
 fate-noproxy: libavformat/tests/noproxy$(EXESUF)
 fate-noproxy: CMD = run libavformat/tests/noproxy
@@ -64,5 +64,19 @@ FATE_LAVR_RESAMPLE-$(call FILTERDEMDECENCMUX, RESAMPLE, WAV, PCM_S16LE, PCM_S16L
 fate-lavr-resample: $(FATE_LAVR_RESAMPLE-yes)
 FATE_LAVR += $(FATE_LAVR_RESAMPLE-yes)
 
+# the per-channel stages must give the same output with any thread count
+define LAVR_THREADS
+FATE_LAVR_THREADS += fate-lavr-threads-$(1)
+fate-lavr-threads-$(1): tests/data/asynth-44100-8.wav
+fate-lavr-threads-$(1): CMD = framecrc -i $(TARGET_PATH)/tests/data/asynth-44100-8.wav -af atrim=end_sample=10240,resample=threads=$(1):internal_sample_fmt=fltp,aformat=sample_fmts=s16:sample_rates=48000
+fate-lavr-threads-$(1): REF = $(SRC_PATH)/tests/ref/fate/lavr-threads
+endef
+
+$(foreach N,1 2 4 8,$(eval $(call LAVR_THREADS,$(N))))
+
+FATE_LAVR_THREADS-$(call FILTERDEMDECENCMUX, ATRIM RESAMPLE AFORMAT, WAV, PCM_S16LE, PCM_S16LE, FRAMECRC) += $(FATE_LAVR_THREADS)
+fate-lavr-threads: $(FATE_LAVR_THREADS-yes)
+FATE_AVCONV += $(FATE_LAVR_THREADS-yes)
+
 FATE_SAMPLES_AVCONV += $(FATE_LAVR)
-fate-lavr: $(FATE_LAVR)
+fate-lavr: $(FATE_LAVR) $(FATE_LAVR_THREADS-yes)
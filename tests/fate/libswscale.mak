@@ -0,0 +1,15 @@
+# the bands scaled by each thread must give the same output with any thread
+# count, for the planar and the packed output paths
+define SWS_THREADS
+FATE_SWS_THREADS += fate-sws-threads-$(1)
+fate-sws-threads-$(1): CMD = framecrc -c:v pgmyuv -i $(TARGET_PATH)/tests/vsynth1/%02d.pgm -frames:v 5 -vf scale=w=251:h=189:flags=bicubic:threads=$(1),scale=w=320:h=241:flags=lanczos:threads=$(1),format=yuv444p,scale=w=176:h=144:threads=$(1),format=rgb24
+fate-sws-threads-$(1): REF = $(SRC_PATH)/tests/ref/fate/sws-threads
+endef
+
+$(foreach N,1 2 3 4 8,$(eval $(call SWS_THREADS,$(N))))
+
+$(FATE_SWS_THREADS): $(VREF)
+
+FATE_SWS_THREADS-$(call ALLYES, IMAGE2_DEMUXER PGMYUV_DECODER SCALE_FILTER FORMAT_FILTER RAWVIDEO_ENCODER FRAMECRC_MUXER) += $(FATE_SWS_THREADS)
+FATE_AVCONV += $(FATE_SWS_THREADS-yes)
+fate-sws-threads: $(FATE_SWS_THREADS-yes)
@@ -0,0 +1,20 @@
+# Demux files written by other tests through the memory-mapped input path,
+# which must return the same packets as the buffered one.
+
+FATE_MMAP-$(call ENCDEC,  FLAC,                  FLAC)     += acodec-flac
+FATE_MMAP-$(call ENCDEC2, MPEG4,      MP2,       MATROSKA) += lavf-mkv
+FATE_MMAP-$(call ENCDEC2, MPEG4,      PCM_ALAW,  MOV)      += lavf-mov
+FATE_MMAP-$(call ENCDEC,  MPEG2VIDEO, MPEG2VIDEO MPEGVIDEO) += vsynth1-mpeg2
+
+fate-mmap-acodec-flac:   SRC = fate/acodec-flac.flac
+fate-mmap-lavf-mkv:      SRC = lavf/lavf.mkv
+fate-mmap-lavf-mov:      SRC = lavf/lavf.mov
+fate-mmap-vsynth1-mpeg2: SRC = fate/vsynth1-mpeg2.mpeg2video
+
+FATE_MMAP = $(FATE_MMAP-yes:%=fate-mmap-%)
+
+$(FATE_MMAP): CMD = framecrc -mmap 1 -i $(TARGET_PATH)/tests/data/$(SRC) -c copy
+$(FATE_MMAP): fate-mmap-%: fate-%
+
+FATE_AVCONV += $(FATE_MMAP)
+fate-mmap: $(FATE_MMAP)
@@ -18,4 +18,18 @@ fate-mov-stereo3d: CMD = probestream type $(TARGET_SAMPLES)/mov/spherical.mov
 
 $(FATE_MOV): avprobe$(EXESUF)
 FATE_SAMPLES-$(call ALLYES, AVPROBE MOV_DEMUXER) += $(FATE_MOV)
-fate-mov: $(FATE_MOV)
+
+# Demux the file written by fate-lavf-mov with the index built while reading,
+# which must give the same packets and seek results.
+FATE_MOV_LAZY_INDEX-$(call ENCDEC2, MPEG4, PCM_ALAW, MOV) += fate-mov-lazy-index \
+                                                            fate-mov-lazy-index-seek
+fate-mov-lazy-index: CMD = framecrc -lazy_index 1 -i $(TARGET_PATH)/tests/data/lavf/lavf.mov -c copy
+
+fate-mov-lazy-index-seek: libavformat/tests/seek$(EXESUF)
+fate-mov-lazy-index-seek: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.mov -lazy_index 1
+fate-mov-lazy-index-seek: REF = $(SRC_PATH)/tests/ref/seek/lavf-mov
+
+$(FATE_MOV_LAZY_INDEX-yes): fate-lavf-mov
+FATE_AVCONV += $(FATE_MOV_LAZY_INDEX-yes)
+
+fate-mov: $(FATE_MOV) $(FATE_MOV_LAZY_INDEX-yes)
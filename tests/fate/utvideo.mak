@@ -66,6 +66,9 @@ fate-utvideoenc_yuv422_median: OPTS = -pix_fmt yuv422p -pred median
 FATE_UTVIDEOENC += fate-utvideoenc_yuv422_none
 fate-utvideoenc_yuv422_none: OPTS = -pix_fmt yuv422p -pred none
 
+FATE_UTVIDEOENC += fate-utvideoenc_yuv422_median_thread
+fate-utvideoenc_yuv422_median_thread: OPTS = -pix_fmt yuv422p -pred median -slices 4 -threads 3 -thread_type slice
+
 $(FATE_UTVIDEOENC): $(VREF)
 
 FATE_AVCONV-$(call ENCMUX, UTVIDEO, AVI) += $(FATE_UTVIDEOENC)
@@ -56,10 +56,12 @@ fate-vsynth%-dv-50:              ENCOPTS = -dct int -s pal -pix_fmt yuv422p \
 fate-vsynth%-dv-50:              DECOPTS = -sws_flags neighbor
 fate-vsynth%-dv-50:              FMT     = dv
 
-FATE_VCODEC-$(call ENCDEC, FFV1, AVI)   += ffv1
+FATE_VCODEC-$(call ENCDEC, FFV1, AVI)   += ffv1 ffv1-thread
 fate-vsynth%-ffv1:               ENCOPTS = -slices 4 -strict -2
+fate-vsynth%-ffv1-thread:        ENCOPTS = -g 1 -threads 3 -thread_type frame
 
-FATE_VCODEC-$(call ENCDEC, FFVHUFF, AVI) += ffvhuff
+FATE_VCODEC-$(call ENCDEC, FFVHUFF, AVI) += ffvhuff ffvhuff-thread
+fate-vsynth%-ffvhuff-thread:     ENCOPTS = -threads 3 -thread_type frame
 
 FATE_VCODEC-$(call ENCDEC, FLASHSV, FLV) += flashsv
 fate-vsynth%-flashsv:            ENCOPTS = -sws_flags neighbor+full_chroma_int
@@ -86,8 +88,9 @@ FATE_VCODEC-$(call ENCDEC, JPEGLS, AVI) += jpegls
 fate-vsynth%-jpegls:             ENCOPTS = -sws_flags neighbor+full_chroma_int
 fate-vsynth%-jpegls:             DECOPTS = -sws_flags area
 
-FATE_VCODEC-$(call ENCDEC, LJPEG MJPEG, AVI) += ljpeg
+FATE_VCODEC-$(call ENCDEC, LJPEG MJPEG, AVI) += ljpeg ljpeg-thread
 fate-vsynth%-ljpeg:              ENCOPTS = -strict -1
+fate-vsynth%-ljpeg-thread:       ENCOPTS = -strict -1 -threads 3 -thread_type frame
 
 FATE_VCODEC-$(call ENCDEC, MJPEG, AVI)  += mjpeg
 fate-vsynth%-mjpeg:              ENCOPTS = -qscale 9 -pix_fmt yuvj420p
@@ -189,6 +192,9 @@ fate-vsynth%-msmpeg4:            ENCOPTS = -qscale 10
 FATE_VCODEC-$(call ENCDEC, MSMPEG4V2, AVI) += msmpeg4v2
 fate-vsynth%-msmpeg4v2:          ENCOPTS = -qscale 10
 
+FATE_VCODEC-$(call ENCDEC, PNG, AVI)    += png-thread
+fate-vsynth%-png-thread:         THREADS = 3
+
 FATE_VCODEC-$(call ENCDEC, PRORES, MOV) += prores
 fate-vsynth%-prores:             ENCOPTS = -profile hq
 fate-vsynth%-prores:             FMT     = mov
@@ -110,6 +110,7 @@ $(eval $(call FATE_VP9_SUITE,tiling-pedestrian,$(1),$(2)))
 endef
 
 $(eval $(call FATE_VP9_FULL))
+$(eval $(call FATE_VP9_FULL,-slicethread,-threads 4 -thread_type slice))
 
 FATE_SAMPLES_AVCONV-$(CONFIG_VP9_DECODER) += $(FATE_VP9-yes)
 fate-vp9: $(FATE_VP9-yes)